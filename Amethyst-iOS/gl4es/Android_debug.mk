@@ -64,6 +64,7 @@ LOCAL_SRC_FILES := \
 	src/gl/render.c \
 	src/gl/shader.c \
 	src/gl/shaderconv.c \
+	src/gl/shaderconv_cache.c \
 	src/gl/shader_hacks.c \
 	src/gl/stack.c \
 	src/gl/stencil.c \
@@ -78,6 +79,7 @@ LOCAL_SRC_FILES := \
 	src/gl/texture_3d.c \
 	src/gl/uniform.c \
 	src/gl/vertexattrib.c \
+	src/gl/workers.c \
 	src/gl/wrap/gl4eswraps.c \
 	src/gl/wrap/gles.c \
 	src/gl/wrap/glstub.c \
@@ -3,9 +3,97 @@
 #include "debug.h"
 #include "enum_info.h"
 #include "glcase.h"
+#include "init.h"
 #include "light.h"
+#include "simd.h"
 #include "state.h"
 
+#ifdef GL4ES_SIMD
+static inline simd_f4 simd_load_fl(uintptr_t p) {
+    return simd_load_f((const void*)p);
+}
+static inline simd_f4 simd_load_ub(uintptr_t p) {
+    uint32_t w; memcpy(&w, (const void*)p, 4);
+    return simd_cvt_ub4(w);
+}
+static inline simd_f4 simd_load_b(uintptr_t p) {
+    uint32_t w; memcpy(&w, (const void*)p, 4);
+    return simd_cvt_b4(w);
+}
+static inline simd_f4 simd_load_us(uintptr_t p) {
+    uint64_t q; memcpy(&q, (const void*)p, 8);
+    return simd_cvt_us4(q);
+}
+static inline simd_f4 simd_load_s(uintptr_t p) {
+    uint64_t q; memcpy(&q, (const void*)p, 8);
+    return simd_cvt_s4(q);
+}
+
+#define SIMD_TOFLOAT_LOOP(LOAD)                             \
+    for (GLsizei i = 0; i < n; i++) {                       \
+        simd_f4 v = LOAD(in);                               \
+        if (mul != 0.0f) v = simd_mul_f(v, vmul);           \
+        if (div != 0.0f) v = simd_div_f(v, vdiv);           \
+        simd_store_f(out, simd_select(mask, v, vpad));      \
+        out += to_width;                                    \
+        in += stride;                                       \
+    }
+
+// Convert count elements of width components of type from into to_width floats,
+// optionally multiplied by mul and/or divided by div (same operations as the scalar code),
+// and with missing components taken from pad.
+// 4 components are always read and written, so unless width and to_width are both 4,
+// the last element is left to the scalar code.
+// Return the number of elements done.
+static GLsizei simd_copy_to_float(uintptr_t in, GLenum from, GLsizei width, GLsizei stride,
+                                  GLsizei to_width, GLfloat mul, GLfloat div, const GLfloat *pad,
+                                  GLsizei count, GLfloat *out) {
+    if (globals4es.nosimd || width < 1 || to_width < 2 || to_width > 4 || width > to_width)
+        return 0;
+    GLsizei esize = gl_sizeof(from);
+    GLsizei n = count;
+    if (width < 4 || to_width < 4) {
+        if (4 * esize > stride + width * esize)
+            return 0;
+        n = count - 1;
+    }
+    if (n <= 0)
+        return 0;
+    if (mul == 1.0f)
+        mul = 0.0f;    // the compiler drops x*1.0f in the scalar code too (matters only for signaling NaN)
+    const simd_m4 mask = simd_lanemask(width);
+    const simd_f4 vpad = simd_load_f(pad);
+    const simd_f4 vmul = simd_set1_f(mul);
+    const simd_f4 vdiv = simd_set1_f(div ? div : 1.0f);
+    switch (from) {
+        case GL_FLOAT:          SIMD_TOFLOAT_LOOP(simd_load_fl); break;
+        case GL_UNSIGNED_BYTE:  SIMD_TOFLOAT_LOOP(simd_load_ub); break;
+        case GL_BYTE:           SIMD_TOFLOAT_LOOP(simd_load_b); break;
+        case GL_UNSIGNED_SHORT: SIMD_TOFLOAT_LOOP(simd_load_us); break;
+        case GL_SHORT:          SIMD_TOFLOAT_LOOP(simd_load_s); break;
+        default:
+            return 0;
+    }
+    return n;
+}
+#undef SIMD_TOFLOAT_LOOP
+
+// BGRA unsigned byte -> RGBA float normalized, all elements are done
+static GLsizei simd_copy_bgra(uintptr_t in, GLint stride, GLsizei count, GLfloat *out) {
+    if (globals4es.nosimd)
+        return 0;
+    const simd_f4 d = simd_set1_f(1.0f/255.0f);
+    for (GLsizei i = 0; i < count; i++) {
+        uint32_t w; memcpy(&w, (const void*)in, 4);
+        w = (w&0xff00ff00u) | ((w>>16)&0x000000ffu) | ((w&0x000000ffu)<<16);
+        simd_store_f(out, simd_mul_f(simd_cvt_ub4(w), d));
+        out += 4;
+        in += stride;
+    }
+    return count;
+}
+#endif // GL4ES_SIMD
+
 GLvoid *copy_gl_array(const GLvoid *src,
                       GLenum from, GLsizei width, GLsizei stride,
                       GLenum to, GLsizei to_width, GLsizei skip, GLsizei count, void* dst) {
@@ -35,8 +123,18 @@ GLvoid *copy_gl_array(const GLvoid *src,
     // so we leave it in a uintptr_t and cast after incrementing
     uintptr_t in = (uintptr_t)src;
     in += stride*skip;
+    void *optr = dst;
+#ifdef GL4ES_SIMD
+    if (to == GL_FLOAT) {
+        static const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        GLsizei done = simd_copy_to_float(in, from, width, stride, to_width, 0.0f, 0.0f, zero, count-skip, (GLfloat*)dst);
+        in += stride*done;
+        optr = (GLfloat*)dst + to_width*done;
+        skip += done;
+    }
+#endif
     if (from == to && to_width >= width) {
-        GL_TYPE_SWITCH(out, dst, to,
+        GL_TYPE_SWITCH(out, optr, to,
             for (int i = skip; i < count; i++) {
                 memcpy(out, (GLvoid *)in, from_size);
                 for (int j = width; j < to_width; j++) {
@@ -50,7 +148,7 @@ GLvoid *copy_gl_array(const GLvoid *src,
                 return NULL;
         )
     } else {
-        GL_TYPE_SWITCH(out, dst, to,
+        GL_TYPE_SWITCH(out, optr, to,
             for (int i = skip; i < count; i++) {
                 GL_TYPE_SWITCH(input, in, from,
                     for (int j = 0; j < width; j++) {
@@ -93,6 +191,15 @@ GLvoid *copy_gl_array_texcoord(const GLvoid *src,
     uintptr_t in = (uintptr_t)src;
     in += stride*skip;
     GLfloat* out = (GLfloat*)dst;
+#ifdef GL4ES_SIMD
+    {
+        static const GLfloat pad[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        GLsizei done = simd_copy_to_float(in, from, width, stride, to_width, 0.0f, 0.0f, pad, count-skip, out);
+        in += stride*done;
+        out += to_width*done;
+        skip += done;
+    }
+#endif
     if (from == GL_FLOAT && to_width >= width) {
         for (int i = skip; i < count; i++) {
             GLfloat* input = (GLfloat*)in;
@@ -148,6 +255,15 @@ GLvoid *copy_gl_array_quickconvert(const GLvoid *src,
     int j;
     
     GLfloat *out = (GLfloat*)dst;
+#ifdef GL4ES_SIMD
+    {
+        static const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        GLsizei done = simd_copy_to_float(in, from, 4, stride, 4, 1.0f/gl_max_value(from), 0.0f, zero, count-skip, out);
+        in += stride*done;
+        out += 4*done;
+        skip += done;
+    }
+#endif
     GL_TYPE_SWITCH2(input, in, from,
         const GLfloat maxf = 1.0f/gl_max_value(from);
         for (int i = skip; i < count; i++)
@@ -202,8 +318,20 @@ GLvoid *copy_gl_array_convert(const GLvoid *src,
     uintptr_t in = (uintptr_t)src;
     in += stride*skip;
     int j;
+    void *optr = dst;
+#ifdef GL4ES_SIMD
+    if (to == GL_FLOAT && from != GL_FLOAT && to_width >= width) {
+        // same as the scalar code: in*1.0f/max, 0 padding and filler on the last component
+        GLfloat pad[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        pad[to_width-1] = *(GLfloat*)filler;
+        GLsizei done = simd_copy_to_float(in, from, width, stride, to_width, 0.0f, (GLfloat)gl_max_value(from), pad, count-skip, (GLfloat*)dst);
+        in += stride*done;
+        optr = (GLfloat*)dst + to_width*done;
+        skip += done;
+    }
+#endif
     if (from == to && to_width >= width) {
-        GL_TYPE_SWITCH(out, dst, to,
+        GL_TYPE_SWITCH(out, optr, to,
             for (int i = skip; i < count; i++) {
                 memcpy(out, (GLvoid *)in, from_size);
                 for (j = width; j < to_width-1; j++) {
@@ -220,7 +348,7 @@ GLvoid *copy_gl_array_convert(const GLvoid *src,
                 return NULL;
         )
     } else {
-        GL_TYPE_SWITCH_MAX(out, dst, to,
+        GL_TYPE_SWITCH_MAX(out, optr, to,
             GL_TYPE_SWITCH2(input, in, from,
                 const GLuint maxf = gl_max_value(from);
                 for (int i = skip; i < count; i++)
@@ -422,11 +550,86 @@ GLfloat *copy_eval_float2(GLenum target, GLint ustride, GLint uorder,
     return out;
 }
 
+#ifdef GL4ES_SIMD
+// min/max of the first n indices (n multiple of 8)
+static void simd_minmax_us(const GLushort *indices, GLsizei n, GLsizei *max, GLsizei *min) {
+#ifdef GL4ES_SIMD_NEON64
+    uint16x8_t vmin = vdupq_n_u16(0xffff), vmax = vdupq_n_u16(0);
+    for (GLsizei i = 0; i < n; i += 8) {
+        uint16x8_t v = vld1q_u16(indices + i);
+        vmin = vminq_u16(vmin, v);
+        vmax = vmaxq_u16(vmax, v);
+    }
+    *min = vminvq_u16(vmin);
+    *max = vmaxvq_u16(vmax);
+#else
+    // no unsigned 16bits min/max in SSE2, so bias to signed
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    __m128i vmin = _mm_set1_epi16(0x7fff), vmax = _mm_set1_epi16((short)0x8000);
+    for (GLsizei i = 0; i < n; i += 8) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(indices + i)), bias);
+        vmin = _mm_min_epi16(vmin, v);
+        vmax = _mm_max_epi16(vmax, v);
+    }
+    GLshort lmin[8], lmax[8];
+    _mm_storeu_si128((__m128i*)lmin, vmin);
+    _mm_storeu_si128((__m128i*)lmax, vmax);
+    GLsizei mi = lmin[0], ma = lmax[0];
+    for (int j = 1; j < 8; j++) {
+        if (lmin[j] < mi) mi = lmin[j];
+        if (lmax[j] > ma) ma = lmax[j];
+    }
+    *min = mi + 0x8000;
+    *max = ma + 0x8000;
+#endif
+}
+// same for GLuint indices, that are compared as GLsizei like in the scalar code
+static void simd_minmax_ui(const GLuint *indices, GLsizei n, GLsizei *max, GLsizei *min) {
+#ifdef GL4ES_SIMD_NEON64
+    int32x4_t vmin = vdupq_n_s32(0x7fffffff), vmax = vdupq_n_s32(-0x7fffffff-1);
+    for (GLsizei i = 0; i < n; i += 8) {
+        int32x4_t v0 = vreinterpretq_s32_u32(vld1q_u32(indices + i));
+        int32x4_t v1 = vreinterpretq_s32_u32(vld1q_u32(indices + i + 4));
+        vmin = vminq_s32(vmin, vminq_s32(v0, v1));
+        vmax = vmaxq_s32(vmax, vmaxq_s32(v0, v1));
+    }
+    *min = vminvq_s32(vmin);
+    *max = vmaxvq_s32(vmax);
+#else
+    __m128i vmin = _mm_set1_epi32(0x7fffffff), vmax = _mm_set1_epi32(-0x7fffffff-1);
+    for (GLsizei i = 0; i < n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(indices + i));
+        __m128i m = _mm_cmpgt_epi32(vmin, v);
+        vmin = _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, vmin));
+        m = _mm_cmpgt_epi32(v, vmax);
+        vmax = _mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, vmax));
+    }
+    GLint lmin[4], lmax[4];
+    _mm_storeu_si128((__m128i*)lmin, vmin);
+    _mm_storeu_si128((__m128i*)lmax, vmax);
+    GLsizei mi = lmin[0], ma = lmax[0];
+    for (int j = 1; j < 4; j++) {
+        if (lmin[j] < mi) mi = lmin[j];
+        if (lmax[j] > ma) ma = lmax[j];
+    }
+    *min = mi;
+    *max = ma;
+#endif
+}
+#endif // GL4ES_SIMD
+
 void getminmax_indices_us(const GLushort *indices, GLsizei *max, GLsizei *min, GLsizei count) {
     if (!count) return;
     *max = indices[0];
     *min = indices[0];
-    for (int i = 1; i < count; i++) {
+    int i = 1;
+#ifdef GL4ES_SIMD
+    if (count >= 16 && !globals4es.nosimd) {
+        i = count & ~7;
+        simd_minmax_us(indices, i, max, min);
+    }
+#endif
+    for (; i < count; i++) {
         GLsizei n = indices[i];
         if( n < *min) *min = n;
         if (n > *max) *max = n;
@@ -443,7 +646,14 @@ void getminmax_indices_ui(const GLuint *indices, GLsizei *max, GLsizei *min, GLs
     if (!count) return;
     *max = indices[0];
     *min = indices[0];
-    for (int i = 1; i < count; i++) {
+    int i = 1;
+#ifdef GL4ES_SIMD
+    if (count >= 16 && !globals4es.nosimd) {
+        i = count & ~7;
+        simd_minmax_ui(indices, i, max, min);
+    }
+#endif
+    for (; i < count; i++) {
         GLsizei n = indices[i];
         if( n < *min) *min = n;
         if (n > *max) *max = n;
@@ -456,6 +666,40 @@ void normalize_indices_ui(GLuint *indices, GLsizei *max, GLsizei *min, GLsizei c
     }
 }
 
+void getminmax_indices_buffer(glbuffer_t *buff, GLenum type, const GLvoid *indices, GLsizei *max, GLsizei *min, GLsizei count) {
+    // only indices that are inside an unmapped buffer can be cached, the buffer generation tracks the changes
+    if (buff && buff->data && !buff->mapped && buff->generation
+        && (uintptr_t)indices >= (uintptr_t)buff->data
+        && (uintptr_t)indices + count*gl_sizeof(type) <= (uintptr_t)buff->data + buff->size) {
+        uintptr_t offset = (uintptr_t)indices - (uintptr_t)buff->data;
+        for (int i = 0; i < INDICES_RANGE_CACHE; i++) {
+            indices_range_t *r = &buff->ranges[i];
+            if (r->generation == buff->generation && r->offset == offset && r->count == count && r->type == type) {
+                *max = r->max;
+                *min = r->min;
+                return;
+            }
+        }
+        if (type == GL_UNSIGNED_INT)
+            getminmax_indices_ui((const GLuint*)indices, max, min, count);
+        else
+            getminmax_indices_us((const GLushort*)indices, max, min, count);
+        indices_range_t *r = &buff->ranges[buff->ranges_next];
+        buff->ranges_next = (buff->ranges_next + 1) % INDICES_RANGE_CACHE;
+        r->generation = buff->generation;
+        r->type = type;
+        r->offset = offset;
+        r->count = count;
+        r->max = *max;
+        r->min = *min;
+        return;
+    }
+    if (type == GL_UNSIGNED_INT)
+        getminmax_indices_ui((const GLuint*)indices, max, min, count);
+    else
+        getminmax_indices_us((const GLushort*)indices, max, min, count);
+}
+
 void *copy_gl_array_bgra(void* dest, const void *ptr, GLint stride, GLsizei width, GLsizei skip, GLsizei count) {
 	// this one only convert from BGRA (unsigned byte) to RGBA FLOAT
     GLubyte* src = (GLubyte*)ptr;
@@ -471,6 +715,14 @@ void *copy_gl_array_bgra(void* dest, const void *ptr, GLint stride, GLsizei widt
     GLfloat* dst = dest;
     src += skip*(stride);
 
+#ifdef GL4ES_SIMD
+    {
+        GLsizei done = simd_copy_bgra((uintptr_t)src, stride, count-skip, dst);
+        src += stride*done;
+        dst += 4*done;
+        skip += done;
+    }
+#endif
     static const float d = 1.0f/255.0f;
     for (int i=skip; i<count; i++) {
         #if defined(__ARM_NEON__) && !defined(__APPLE__)
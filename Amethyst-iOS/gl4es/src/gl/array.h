@@ -11,6 +11,10 @@ GLvoid *copy_gl_array(const GLvoid *src,
 GLvoid *copy_gl_array_convert(const GLvoid *src,
 					  GLenum from, GLsizei width, GLsizei stride,
 					  GLenum to, GLsizei to_width, GLsizei skip, GLsizei count, GLvoid* filler, void* dst);
+
+GLvoid *copy_gl_array_texcoord(const GLvoid *src,
+                      GLenum from, GLsizei width, GLsizei stride,
+                      GLsizei to_width, GLsizei skip, GLsizei count, void* dst);
 	
 GLvoid *copy_gl_pointer(vertexattrib_t *ptr, GLsizei width, GLsizei skip, GLsizei count);
 GLvoid *copy_gl_pointer_color(vertexattrib_t *ptr, GLsizei width, GLsizei skip, GLsizei count);
@@ -29,6 +33,8 @@ void normalize_indices_us(GLushort *indices, GLsizei *max, GLsizei *min, GLsizei
 void getminmax_indices_us(const GLushort *indices, GLsizei *max, GLsizei *min, GLsizei count);
 void normalize_indices_ui(GLuint *indices, GLsizei *max, GLsizei *min, GLsizei count);
 void getminmax_indices_ui(const GLuint *indices, GLsizei *max, GLsizei *min, GLsizei count);
+// same as above, but cache the result when indices are inside buff (usualy the bound GL_ELEMENT_ARRAY_BUFFER)
+void getminmax_indices_buffer(glbuffer_t *buff, GLenum type, const GLvoid *indices, GLsizei *max, GLsizei *min, GLsizei count);
 
 GLfloat *copy_eval_double1(GLenum target, GLint ustride, GLint uorder, const GLdouble *points);
 GLfloat *copy_eval_float1(GLenum target, GLint ustride, GLint uorder, const GLfloat *points);
@@ -36,6 +36,7 @@ void gl4es_glBlendFuncSeparate(GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfac
         return; // no change...
 
     FLUSH_BEGINEND;
+    attrib_changed(GL_COLOR_BUFFER_BIT);
 
 #ifndef PANDORA
     if(gles_glBlendFuncSeparate==NULL) {
@@ -80,6 +81,7 @@ void gl4es_glBlendFunc(GLenum sfactor, GLenum dfactor) {
         return; // already set
 
     FLUSH_BEGINEND;
+    attrib_changed(GL_COLOR_BUFFER_BIT);
 
     LOAD_GLES(glBlendFunc);
     LOAD_GLES2_OR_OES(glBlendFuncSeparate);
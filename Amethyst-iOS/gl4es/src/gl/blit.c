@@ -20,6 +20,74 @@
 void pushViewport(GLint x, GLint y, GLsizei width, GLsizei height);
 void popViewport();
 
+static void blit_mode_gles1(GLint mode) {
+    gl4es_glDisable(GL_LIGHTING);
+    gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    gl4es_glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    switch (mode) {
+        case BLIT_OPAQUE:
+            gl4es_glDisable(GL_ALPHA_TEST);
+            gl4es_glDisable(GL_BLEND);
+            break;
+        case BLIT_ALPHA:
+			gl4es_glEnable(GL_ALPHA_TEST);
+			gl4es_glAlphaFunc(GL_GREATER, 0.0f);
+            break;
+        case BLIT_COLOR:
+            break;
+    }
+}
+
+static void blit_arrays_gles1(const GLfloat* vert, const GLfloat* tex, GLenum prim, int count,
+    GLfloat vpwidth, GLfloat vpheight) {
+    LOAD_GLES(glClientActiveTexture);
+    LOAD_GLES(glVertexPointer);
+    LOAD_GLES(glTexCoordPointer);
+    LOAD_GLES(glDrawArrays);
+
+    GLfloat old_projection[16], old_modelview[16], old_texture[16];
+    int customvp = (vpwidth>0.0);
+
+    gl4es_glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT | GL_CLIENT_PIXEL_STORE_BIT);
+    gl4es_glGetFloatv(GL_TEXTURE_MATRIX, old_texture);
+    gl4es_glGetFloatv(GL_PROJECTION_MATRIX, old_projection);
+    gl4es_glGetFloatv(GL_MODELVIEW_MATRIX, old_modelview);
+    gl4es_glMatrixMode(GL_TEXTURE);
+    gl4es_glLoadIdentity();
+    gl4es_glMatrixMode(GL_PROJECTION);
+    gl4es_glLoadIdentity();
+    gl4es_glMatrixMode(GL_MODELVIEW);
+    gl4es_glLoadIdentity();
+
+    if(customvp)
+        pushViewport(0,0,vpwidth, vpheight);
+    
+    fpe_glEnableClientState(GL_VERTEX_ARRAY);
+    gles_glVertexPointer(2, GL_FLOAT, 0, vert);
+    fpe_glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    gles_glTexCoordPointer(2, GL_FLOAT, 0, tex);
+    for (int a=1; a <hardext.maxtex; a++)
+        if(glstate->gleshard->vertexattrib[ATT_MULTITEXCOORD0+a].enabled) {
+            gles_glClientActiveTexture(GL_TEXTURE0 + a);
+            fpe_glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        }
+    gles_glClientActiveTexture(GL_TEXTURE0);
+    fpe_glDisableClientState(GL_COLOR_ARRAY);
+    fpe_glDisableClientState(GL_NORMAL_ARRAY);
+    gles_glDrawArrays(prim, 0, count);
+
+    if(customvp)
+        popViewport();
+
+    gl4es_glPopClientAttrib();
+    gl4es_glMatrixMode(GL_TEXTURE);
+    gl4es_glLoadMatrixf(old_texture);
+    gl4es_glMatrixMode(GL_MODELVIEW);
+    gl4es_glLoadMatrixf(old_modelview);
+    gl4es_glMatrixMode(GL_PROJECTION);
+    gl4es_glLoadMatrixf(old_projection);
+}
+
 void gl4es_blitTexture_gles1(GLuint texture,
     GLfloat sx, GLfloat sy,
     GLfloat width, GLfloat height, 
@@ -30,29 +98,13 @@ void gl4es_blitTexture_gles1(GLuint texture,
 
     LOAD_GLES(glClientActiveTexture);
 
-    GLfloat old_projection[16], old_modelview[16], old_texture[16];
-
     int customvp = (vpwidth>0.0);
     int drawtexok = (hardext.drawtex) && (zoomx==1.0f) && (zoomy==1.0f);
 
     GLuint old_cli = glstate->texture.client;
     if (old_cli!=0) gles_glClientActiveTexture(GL_TEXTURE0);
 
-    gl4es_glDisable(GL_LIGHTING);
-    gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    gl4es_glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-    switch (mode) {
-        case BLIT_OPAQUE:
-            gl4es_glDisable(GL_ALPHA_TEST);
-            gl4es_glDisable(GL_BLEND);
-            break;
-        case BLIT_ALPHA:
-			gl4es_glEnable(GL_ALPHA_TEST);
-			gl4es_glAlphaFunc(GL_GREATER, 0.0f);
-            break;
-        case BLIT_COLOR:
-            break;
-    }
+    blit_mode_gles1(mode);
 
     if(drawtexok) {
         LOAD_GLES_OES(glDrawTexf);
@@ -67,10 +119,6 @@ void gl4es_blitTexture_gles1(GLuint texture,
         // then draw it
         gles_glDrawTexf(x+dx, y+dy, 0.0f, width, height);
     } else {
-        LOAD_GLES(glVertexPointer);
-        LOAD_GLES(glTexCoordPointer);
-        LOAD_GLES(glDrawArrays);
-
         GLfloat w2 = 2.0f / (customvp?vpwidth:glstate->raster.viewport.width);
         GLfloat h2 = 2.0f / (customvp?vpheight:glstate->raster.viewport.height);
         GLfloat blit_x1=roundf(x);
@@ -94,44 +142,7 @@ void gl4es_blitTexture_gles1(GLuint texture,
             sw, rh
         };
 
-        gl4es_glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT | GL_CLIENT_PIXEL_STORE_BIT);
-        gl4es_glGetFloatv(GL_TEXTURE_MATRIX, old_texture);
-        gl4es_glGetFloatv(GL_PROJECTION_MATRIX, old_projection);
-        gl4es_glGetFloatv(GL_MODELVIEW_MATRIX, old_modelview);
-        gl4es_glMatrixMode(GL_TEXTURE);
-        gl4es_glLoadIdentity();
-        gl4es_glMatrixMode(GL_PROJECTION);
-        gl4es_glLoadIdentity();
-        gl4es_glMatrixMode(GL_MODELVIEW);
-        gl4es_glLoadIdentity();
-
-        if(customvp)
-            pushViewport(0,0,vpwidth, vpheight);
-        
-        fpe_glEnableClientState(GL_VERTEX_ARRAY);
-        gles_glVertexPointer(2, GL_FLOAT, 0, blit_vert);
-        fpe_glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        gles_glTexCoordPointer(2, GL_FLOAT, 0, blit_tex);
-        for (int a=1; a <hardext.maxtex; a++)
-            if(glstate->gleshard->vertexattrib[ATT_MULTITEXCOORD0+a].enabled) {
-                gles_glClientActiveTexture(GL_TEXTURE0 + a);
-                fpe_glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-            }
-        gles_glClientActiveTexture(GL_TEXTURE0);
-        fpe_glDisableClientState(GL_COLOR_ARRAY);
-        fpe_glDisableClientState(GL_NORMAL_ARRAY);
-        gles_glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-        if(customvp)
-            popViewport();
-
-        gl4es_glPopClientAttrib();
-        gl4es_glMatrixMode(GL_TEXTURE);
-        gl4es_glLoadMatrixf(old_texture);
-        gl4es_glMatrixMode(GL_MODELVIEW);
-        gl4es_glLoadMatrixf(old_modelview);
-        gl4es_glMatrixMode(GL_PROJECTION);
-        gl4es_glLoadMatrixf(old_projection);
+        blit_arrays_gles1(blit_vert, blit_tex, GL_TRIANGLE_FAN, 4, vpwidth, vpheight);
     }
 
     if (old_cli!=0) gles_glClientActiveTexture(GL_TEXTURE0+old_cli);
@@ -141,10 +152,12 @@ void gl4es_blitTexture_gles1(GLuint texture,
 const char _blit_vsh[] = "#version 100                  \n" \
 "attribute highp vec2 aPosition;                        \n" \
 "attribute highp vec2 aTexCoord;                        \n" \
+"uniform highp vec4 uPosRect;                           \n" \
+"uniform highp vec4 uTexRect;                           \n" \
 "varying mediump vec2 vTexCoord;                        \n" \
 "void main(){                                           \n" \
-"gl_Position = vec4(aPosition.x, aPosition.y, 0.0, 1.0);\n" \
-"vTexCoord = aTexCoord;                                 \n" \
+"gl_Position = vec4(aPosition*uPosRect.zw+uPosRect.xy, 0.0, 1.0);\n" \
+"vTexCoord = aTexCoord*uTexRect.zw+uTexRect.xy;         \n" \
 "}                                                      \n";
 
 const char _blit_fsh[] = "#version 100                  \n" \
@@ -154,15 +167,6 @@ const char _blit_fsh[] = "#version 100                  \n" \
 "gl_FragColor = texture2D(uTex, vTexCoord);             \n" \
 "}                                                      \n";
 
-const char _blit_vsh_alpha[] = "#version 100            \n" \
-"attribute highp vec2 aPosition;                        \n" \
-"attribute highp vec2 aTexCoord;                        \n" \
-"varying mediump vec2 vTexCoord;                        \n" \
-"void main(){                                           \n" \
-"gl_Position = vec4(aPosition.x, aPosition.y, 0.0, 1.0);\n" \
-"vTexCoord = aTexCoord;                                 \n" \
-"}                                                      \n";
-
 const char _blit_fsh_alpha[] = "#version 100            \n" \
 "uniform sampler2D uTex;                                \n" \
 "varying mediump vec2 vTexCoord;                        \n" \
@@ -172,6 +176,145 @@ const char _blit_fsh_alpha[] = "#version 100            \n" \
 "gl_FragColor = p;                                      \n" \
 "}                                                      \n";
 
+static const GLfloat blit_quad[] = {0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,  0.0f, 1.0f};
+static const GLfloat blit_identity[] = {0.0f, 0.0f, 1.0f, 1.0f};
+
+static GLuint blit_shader(GLenum type, const char* source, const char* what) {
+    LOAD_GLES2(glCreateShader);
+    LOAD_GLES2(glShaderSource);
+    LOAD_GLES2(glCompileShader);
+    LOAD_GLES2(glGetShaderiv);
+    GLint success;
+    GLuint shader = gles_glCreateShader(type);
+    gles_glShaderSource(shader, 1, &source, NULL);
+    gles_glCompileShader(shader);
+    gles_glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        LOAD_GLES(glGetShaderInfoLog);
+        LOAD_GLES2(glDeleteShader);
+        char log[400];
+        gles_glGetShaderInfoLog(shader, 399, NULL, log);
+        SHUT_LOGE("Failed to produce blit %s shader.\n%s", what, log);
+        gles_glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static int init_blit_gles2() {
+    if(glstate->blit)
+        return 1;
+    LOAD_GLES(glGenBuffers);
+    LOAD_GLES(glBindBuffer);
+    LOAD_GLES(glBufferData);
+
+    GLuint vertexshader = blit_shader(GL_VERTEX_SHADER, _blit_vsh, "vertex");
+    if(!vertexshader)
+        return 0;
+    glstate->blit = (glesblit_t*)malloc(sizeof(glesblit_t));
+    memset(glstate->blit, 0, sizeof(glesblit_t));
+    glstate->blit->vertexshader = vertexshader;
+    // the quad never changes, the blit rectangle is in the uniforms
+    gles_glGenBuffers(1, &glstate->blit->quad);
+    gles_glBindBuffer(GL_ARRAY_BUFFER, glstate->blit->quad);
+    gles_glBufferData(GL_ARRAY_BUFFER, sizeof(blit_quad), blit_quad, GL_STATIC_DRAW);
+    gles_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return 1;
+}
+
+void free_blit(glesblit_t *blit) {
+    if(!blit)
+        return;
+    LOAD_GLES2(glDeleteProgram);
+    LOAD_GLES2(glDeleteShader);
+    LOAD_GLES(glDeleteBuffers);
+    for (int i=0; i<2; ++i) {
+        if(blit->prog[i].program)
+            gles_glDeleteProgram(blit->prog[i].program);
+        if(blit->prog[i].pixelshader && blit->prog[i].pixelshader!=(GLuint)-1)
+            gles_glDeleteShader(blit->prog[i].pixelshader);
+    }
+    gles_glDeleteShader(blit->vertexshader);
+    if(blit->quad)
+        gles_glDeleteBuffers(1, &blit->quad);
+    free(blit);
+}
+
+static blitprogram_t* blit_program(int alpha) {
+    blitprogram_t *prog = &glstate->blit->prog[alpha];
+    if(prog->program)
+        return prog;
+    if(prog->pixelshader)
+        return NULL;    // already failed
+    LOAD_GLES2(glBindAttribLocation);
+    LOAD_GLES2(glAttachShader);
+    LOAD_GLES2(glCreateProgram);
+    LOAD_GLES2(glDeleteProgram);
+    LOAD_GLES2(glLinkProgram);
+    LOAD_GLES2(glGetProgramiv);
+    LOAD_GLES(glGetUniformLocation);
+    LOAD_GLES2(glUniform1i);
+    LOAD_GLES2(glUniform4fv);
+    LOAD_GLES2(glUseProgram);
+
+    prog->pixelshader = blit_shader(GL_FRAGMENT_SHADER, (alpha)?_blit_fsh_alpha:_blit_fsh, (alpha)?"with alpha fragment":"fragment");
+    if(!prog->pixelshader) {
+        prog->pixelshader = (GLuint)-1;
+        return NULL;
+    }
+    GLint success;
+    GLuint program = gles_glCreateProgram();
+    gles_glBindAttribLocation( program, 0, "aPosition" );
+    gles_glBindAttribLocation( program, 1, "aTexCoord" );
+    gles_glAttachShader( program, prog->pixelshader );
+    gles_glAttachShader( program, glstate->blit->vertexshader );
+    gles_glLinkProgram( program );
+    gles_glGetProgramiv( program, GL_LINK_STATUS, &success );
+    if( !success )
+    {
+        SHUT_LOGE("Failed to link blit program.\n");
+        gles_glDeleteProgram(program);
+        return NULL;
+    }
+    prog->program = program;
+    prog->pos = gles_glGetUniformLocation( program, "uPosRect" );
+    prog->tex = gles_glGetUniformLocation( program, "uTexRect" );
+    memcpy(prog->posrect, blit_identity, sizeof(blit_identity));
+    memcpy(prog->texrect, blit_identity, sizeof(blit_identity));
+    GLuint oldprog = glstate->gleshard->program;
+    gles_glUseProgram( program );
+    gles_glUniform1i( gles_glGetUniformLocation( program, "uTex" ), 0 );
+    gles_glUniform4fv( prog->pos, 1, prog->posrect );
+    gles_glUniform4fv( prog->tex, 1, prog->texrect );
+    gles_glUseProgram(oldprog);
+    return prog;
+}
+
+static void blit_rect(GLint loc, GLfloat* cache, const GLfloat* rect) {
+    if(memcmp(cache, rect, 4*sizeof(GLfloat))) {
+        LOAD_GLES2(glUniform4fv);
+        memcpy(cache, rect, 4*sizeof(GLfloat));
+        gles_glUniform4fv(loc, 1, cache);
+    }
+}
+
+// posrect and texrect are offset (xy) and scale (zw) applied to vert and tex
+static void blit_arrays_gles2(GLuint buffer, const GLfloat* vert, const GLfloat* tex, const GLfloat* posrect, const GLfloat* texrect,
+    GLenum prim, int count, GLint mode) {
+    LOAD_GLES(glDrawArrays);
+
+    blitprogram_t *prog = blit_program((mode==BLIT_ALPHA)?1:0);
+    if(!prog)
+        return;
+
+    realize_blitenv(prog->program, buffer, vert, tex);
+    blit_rect(prog->pos, prog->posrect, posrect);
+    blit_rect(prog->tex, prog->texrect, texrect);
+
+    gles_glDrawArrays(prim, 0, count);
+}
+
 void gl4es_blitTexture_gles2(GLuint texture,
     GLfloat sx, GLfloat sy,
     GLfloat width, GLfloat height, 
@@ -180,121 +323,8 @@ void gl4es_blitTexture_gles2(GLuint texture,
     GLfloat vpwidth, GLfloat vpheight, 
     GLfloat x, GLfloat y, GLint mode) {
 
-    LOAD_GLES(glDrawArrays);
-
-    if(!glstate->blit) {
-        LOAD_GLES2(glCreateShader);
-        LOAD_GLES2(glShaderSource);
-        LOAD_GLES2(glCompileShader);
-        LOAD_GLES2(glGetShaderiv);
-        LOAD_GLES2(glBindAttribLocation);
-        LOAD_GLES2(glAttachShader);
-        LOAD_GLES2(glCreateProgram);
-        LOAD_GLES2(glLinkProgram);
-        LOAD_GLES2(glGetProgramiv);
-        LOAD_GLES(glGetUniformLocation);
-        LOAD_GLES2(glUniform1i);
-        LOAD_GLES2(glUseProgram);
-
-        glstate->blit = (glesblit_t*)malloc(sizeof(glesblit_t));
-        memset(glstate->blit, 0, sizeof(glesblit_t));
-
-        GLint success;
-        const char *src[1];
-        src[0] = _blit_fsh;
-        glstate->blit->pixelshader = gles_glCreateShader( GL_FRAGMENT_SHADER );
-        gles_glShaderSource( glstate->blit->pixelshader, 1, (const char**) src, NULL );
-        gles_glCompileShader( glstate->blit->pixelshader );
-        gles_glGetShaderiv( glstate->blit->pixelshader, GL_COMPILE_STATUS, &success );
-        if (!success)
-        {
-            LOAD_GLES(glGetShaderInfoLog);
-            char log[400];
-            gles_glGetShaderInfoLog(glstate->blit->pixelshader_alpha, 399, NULL, log);
-            SHUT_LOGE("Failed to produce blit fragment shader.\n%s", log);
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-    
-        src[0] = _blit_fsh_alpha;
-        glstate->blit->pixelshader_alpha = gles_glCreateShader( GL_FRAGMENT_SHADER );
-        gles_glShaderSource( glstate->blit->pixelshader_alpha, 1, (const char**) src, NULL );
-        gles_glCompileShader( glstate->blit->pixelshader_alpha );
-        gles_glGetShaderiv( glstate->blit->pixelshader_alpha, GL_COMPILE_STATUS, &success );
-        if (!success)
-        {
-            LOAD_GLES(glGetShaderInfoLog);
-            char log[400];
-            gles_glGetShaderInfoLog(glstate->blit->pixelshader_alpha, 399, NULL, log);
-            SHUT_LOGE("Failed to produce blit with alpha fragment shader.\n%s", log);
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-    
-        src[0] = _blit_vsh;
-        glstate->blit->vertexshader = gles_glCreateShader( GL_VERTEX_SHADER );
-        gles_glShaderSource( glstate->blit->vertexshader, 1, (const char**) src, NULL );
-        gles_glCompileShader( glstate->blit->vertexshader );
-        gles_glGetShaderiv( glstate->blit->vertexshader, GL_COMPILE_STATUS, &success );
-        if( !success )
-        {
-            LOAD_GLES(glGetShaderInfoLog);
-            char log[400];
-            gles_glGetShaderInfoLog(glstate->blit->pixelshader_alpha, 399, NULL, log);
-            SHUT_LOGE("Failed to produce blit vertex shader.\n%s", log);
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-    
-        src[0] = _blit_vsh_alpha;
-        glstate->blit->vertexshader_alpha = gles_glCreateShader( GL_VERTEX_SHADER );
-        gles_glShaderSource( glstate->blit->vertexshader_alpha, 1, (const char**) src, NULL );
-        gles_glCompileShader( glstate->blit->vertexshader_alpha );
-        gles_glGetShaderiv( glstate->blit->vertexshader_alpha, GL_COMPILE_STATUS, &success );
-        if( !success )
-        {
-            LOAD_GLES(glGetShaderInfoLog);
-            char log[400];
-            gles_glGetShaderInfoLog(glstate->blit->pixelshader_alpha, 399, NULL, log);
-            SHUT_LOGE("Failed to produce blit with alpha vertex shader.\n%s", log);
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-
-        glstate->blit->program = gles_glCreateProgram();
-        gles_glBindAttribLocation( glstate->blit->program, 0, "aPosition" );
-        gles_glBindAttribLocation( glstate->blit->program, 1, "aTexCoord" );
-        gles_glAttachShader( glstate->blit->program, glstate->blit->pixelshader );
-        gles_glAttachShader( glstate->blit->program, glstate->blit->vertexshader );
-        gles_glLinkProgram( glstate->blit->program );
-        gles_glGetProgramiv( glstate->blit->program, GL_LINK_STATUS, &success );
-        if( !success )
-        {
-            SHUT_LOGE("Failed to link blit program.\n");
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-        GLuint oldprog = glstate->gleshard->program;
-        gles_glUseProgram(glstate->blit->program);
-        gles_glUniform1i( gles_glGetUniformLocation( glstate->blit->program, "uTex" ), 0 );
-
-        glstate->blit->program_alpha = gles_glCreateProgram();
-        gles_glBindAttribLocation( glstate->blit->program_alpha, 0, "aPosition" );
-        gles_glBindAttribLocation( glstate->blit->program_alpha, 1, "aTexCoord" );
-        gles_glAttachShader( glstate->blit->program_alpha, glstate->blit->pixelshader_alpha );
-        gles_glAttachShader( glstate->blit->program_alpha, glstate->blit->vertexshader_alpha );
-        gles_glLinkProgram( glstate->blit->program_alpha );
-        gles_glGetProgramiv( glstate->blit->program_alpha, GL_LINK_STATUS, &success );
-        if( !success )
-        {
-            SHUT_LOGE("Failed to link blit program.\n");
-            free(glstate->blit);
-            glstate->blit = NULL;
-        }
-        gles_glUseProgram(glstate->blit->program_alpha);
-        gles_glUniform1i( gles_glGetUniformLocation( glstate->blit->program_alpha, "uTex" ), 0 );
-        gles_glUseProgram(oldprog);
-    }
+    if(!init_blit_gles2())
+        return;
 
     int customvp = (vpwidth>0.0);
     GLfloat w2 = 2.0f / (customvp?vpwidth:glstate->raster.viewport.width);
@@ -303,69 +333,72 @@ void gl4es_blitTexture_gles2(GLuint texture,
     GLfloat blit_x2=roundf(x+width*zoomx);
     GLfloat blit_y1=roundf(y);
     GLfloat blit_y2=roundf(y+height*zoomy);
-    GLfloat *vert = glstate->blit->vert;
-    GLfloat *tex = glstate->blit->tex;
-    vert[0] = blit_x1*w2-1.0f;  vert[1] = blit_y1*h2-1.0f;
-    vert[2] = blit_x2*w2-1.0f;  vert[3] = vert[1];
-    vert[4] = vert[2];          vert[5] = blit_y2*h2-1.0f;
-    vert[6] = vert[0];          vert[7] = vert[5];
-    GLfloat sw = sx/nwidth;
-    GLfloat sh = sy/nheight;
-    GLfloat rw = (sx+width)/nwidth;
-    GLfloat rh = (sy+height)/nheight;
-    tex[0] = sw;  tex[1] = sh;
-    tex[2] = rw;  tex[3] = sh;
-    tex[4] = rw;  tex[5] = rh;
-    tex[6] = sw;  tex[7] = rh;
-    gl4es_glDisable(GL_BLEND);
-    int alpha = 0;
-    switch (mode) {
-        case BLIT_OPAQUE:
-            //gl4es_glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-            break;
-        case BLIT_ALPHA:
-            alpha = 1;
-            break;
-        case BLIT_COLOR:
-            //gl4es_glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-            break;
-    }
-
-    realize_blitenv(alpha);
-
-    gles_glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    GLfloat posrect[4] = {
+        blit_x1*w2-1.0f, blit_y1*h2-1.0f,
+        (blit_x2-blit_x1)*w2, (blit_y2-blit_y1)*h2
+    };
+    GLfloat texrect[4] = {
+        sx/nwidth, sy/nheight,
+        width/nwidth, height/nheight
+    };
+    blit_arrays_gles2(glstate->blit->quad, NULL, NULL, posrect, texrect, GL_TRIANGLE_FAN, 4, mode);
 }
 
-void gl4es_blitTexture(GLuint texture, 
-    GLfloat sx, GLfloat sy, 
-    GLfloat width, GLfloat height, 
-    GLfloat nwidth, GLfloat nheight, 
-    GLfloat zoomx, GLfloat zoomy, 
-    GLfloat vpwidth, GLfloat vpheight, 
-    GLfloat x, GLfloat y, GLint mode) {
-//printf("blitTexture(%d, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %d) customvp=%d, vp=%d/%d/%d/%d\n", texture, sx, sy, width, height, nwidth, nheight, zoomx, zoomy, vpwidth, vpheight, x, y, mode, (vpwidth>0.0), glstate->raster.viewport.x, glstate->raster.viewport.y, glstate->raster.viewport.width, glstate->raster.viewport.height);
+typedef struct {
+    GLint   depthwrite;
+    int     tex;
+    // ES1 only
+    GLenum  envmode;    // not in the GL_TEXTURE_BIT of glPushAttrib
+    // ES2 only
+    GLboolean depth_test, cull_face, stencil_test, blend;
+} blitsave_t;
+
+static void blit_begin(GLuint texture, blitsave_t* save) {
     LOAD_GLES(glBindTexture);
     LOAD_GLES(glActiveTexture);
     LOAD_GLES(glEnable);
     LOAD_GLES(glDisable);
+    LOAD_GLES(glDepthMask);
 
     realize_textures(1);
 
-    gl4es_glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT | GL_TRANSFORM_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+    if(hardext.esversion==1) {
+        gl4es_glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT | GL_TRANSFORM_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+        save->envmode = glstate->texenv[glstate->texture.active].env.mode;
+    }
 
     if(glstate->gleshard->active) {
         glstate->gleshard->active = 0;
         gles_glActiveTexture(GL_TEXTURE0);
     }
 
-    GLint depthwrite = glstate->depth.mask;
+    save->depthwrite = glstate->depth.mask;
 
-    gl4es_glDisable(GL_DEPTH_TEST);
-    gl4es_glDisable(GL_CULL_FACE);
-    gl4es_glDisable(GL_STENCIL_TEST);
+    if(hardext.esversion==1) {
+        gl4es_glDisable(GL_DEPTH_TEST);
+        gl4es_glDisable(GL_CULL_FACE);
+        gl4es_glDisable(GL_STENCIL_TEST);
 
-    if(depthwrite)
-        gl4es_glDepthMask(GL_FALSE);
+        if(save->depthwrite)
+            gl4es_glDepthMask(GL_FALSE);
+    } else {
+        // the blit program doesn't use anything else, so only turn off in hardware what is on
+        // and put it back in blit_end, the glstate is left untouched
+        save->depth_test = glstate->enable.depth_test;
+        save->cull_face = glstate->enable.cull_face;
+        save->stencil_test = glstate->enable.stencil_test;
+        save->blend = glstate->enable.blend;
+        if(save->depth_test)
+            gles_glDisable(GL_DEPTH_TEST);
+        if(save->cull_face)
+            gles_glDisable(GL_CULL_FACE);
+        if(save->stencil_test)
+            gles_glDisable(GL_STENCIL_TEST);
+        if(save->blend)
+            gles_glDisable(GL_BLEND);
+        if(save->depthwrite)
+            gles_glDepthMask(GL_FALSE);
+    }
 
 #ifdef TEXSTREAM
     if(glstate->bound_stream[0] && hardext.esversion==1) {
@@ -374,28 +407,30 @@ void gl4es_blitTexture(GLuint texture,
         DeactivateStreaming();
     }
 #endif
-    int tmp = glstate->enable.texture[0];
+    save->tex = glstate->enable.texture[0];
 
     if(glstate->actual_tex2d[0] != texture)
         gles_glBindTexture(GL_TEXTURE_2D, texture);
 
     if(hardext.esversion==1) {
-        if(!IS_TEX2D(tmp))
+        if(!IS_TEX2D(save->tex))
             gles_glEnable(GL_TEXTURE_2D);
-        if(IS_CUBE_MAP(tmp))
+        if(IS_CUBE_MAP(save->tex))
             gles_glDisable(GL_TEXTURE_CUBE_MAP);
+    }
+}
 
-        gl4es_blitTexture_gles1(texture, sx, sy, width, height, 
-                                nwidth, nheight, zoomx, zoomy, 
-                                vpwidth, vpheight, x, y, mode);
-        if(!IS_TEX2D(tmp))
+static void blit_end(GLuint texture, blitsave_t* save) {
+    LOAD_GLES(glBindTexture);
+    LOAD_GLES(glEnable);
+    LOAD_GLES(glDisable);
+    LOAD_GLES(glDepthMask);
+
+    if(hardext.esversion==1) {
+        if(!IS_TEX2D(save->tex))
             gles_glDisable(GL_TEXTURE_2D);
-        if(IS_CUBE_MAP(tmp))
+        if(IS_CUBE_MAP(save->tex))
             gles_glEnable(GL_TEXTURE_CUBE_MAP);
-    } else {
-        gl4es_blitTexture_gles2(texture, sx, sy, width, height, 
-            nwidth, nheight, zoomx, zoomy, 
-            vpwidth, vpheight, x, y, mode);
     }
 
     // All the previous states are Pushed / Poped anyway...
@@ -410,8 +445,65 @@ void gl4es_blitTexture(GLuint texture,
     if (glstate->actual_tex2d[0] != texture) 
         gles_glBindTexture(GL_TEXTURE_2D, glstate->actual_tex2d[0]);
 
-    if(depthwrite)
-        gl4es_glDepthMask(GL_TRUE);
+    if(hardext.esversion==1) {
+        if(save->depthwrite)
+            gl4es_glDepthMask(GL_TRUE);
+
+        gl4es_glPopAttrib();
+        if(glstate->texenv[glstate->texture.active].env.mode != save->envmode)
+            gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, save->envmode);
+    } else {
+        if(save->depth_test)
+            gles_glEnable(GL_DEPTH_TEST);
+        if(save->cull_face)
+            gles_glEnable(GL_CULL_FACE);
+        if(save->stencil_test)
+            gles_glEnable(GL_STENCIL_TEST);
+        if(save->blend)
+            gles_glEnable(GL_BLEND);
+        if(save->depthwrite)
+            gles_glDepthMask(GL_TRUE);
+    }
+}
+
+void gl4es_blitTexture(GLuint texture, 
+    GLfloat sx, GLfloat sy, 
+    GLfloat width, GLfloat height, 
+    GLfloat nwidth, GLfloat nheight, 
+    GLfloat zoomx, GLfloat zoomy, 
+    GLfloat vpwidth, GLfloat vpheight, 
+    GLfloat x, GLfloat y, GLint mode) {
+//printf("blitTexture(%d, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %d) customvp=%d, vp=%d/%d/%d/%d\n", texture, sx, sy, width, height, nwidth, nheight, zoomx, zoomy, vpwidth, vpheight, x, y, mode, (vpwidth>0.0), glstate->raster.viewport.x, glstate->raster.viewport.y, glstate->raster.viewport.width, glstate->raster.viewport.height);
+    blitsave_t save;
+    blit_begin(texture, &save);
+
+    if(hardext.esversion==1) {
+        gl4es_blitTexture_gles1(texture, sx, sy, width, height, 
+                                nwidth, nheight, zoomx, zoomy, 
+                                vpwidth, vpheight, x, y, mode);
+    } else {
+        gl4es_blitTexture_gles2(texture, sx, sy, width, height, 
+            nwidth, nheight, zoomx, zoomy, 
+            vpwidth, vpheight, x, y, mode);
+    }
+
+    blit_end(texture, &save);
+}
+
+void gl4es_blitTextureArrays(GLuint texture, const GLfloat* vert, const GLfloat* tex, GLenum prim, int count, GLint mode) {
+    blitsave_t save;
+    blit_begin(texture, &save);
 
-    gl4es_glPopAttrib();
-}
\ No newline at end of file
+    if(hardext.esversion==1) {
+        LOAD_GLES(glClientActiveTexture);
+        GLuint old_cli = glstate->texture.client;
+        if (old_cli!=0) gles_glClientActiveTexture(GL_TEXTURE0);
+        blit_mode_gles1(mode);
+        blit_arrays_gles1(vert, tex, prim, count, 0, 0);
+        if (old_cli!=0) gles_glClientActiveTexture(GL_TEXTURE0+old_cli);
+    } else if(init_blit_gles2()) {
+        blit_arrays_gles2(0, vert, tex, blit_identity, blit_identity, prim, count, mode);
+    }
+
+    blit_end(texture, &save);
+}
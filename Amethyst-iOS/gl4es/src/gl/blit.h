@@ -15,4 +15,11 @@ void gl4es_blitTexture(GLuint texture,
     GLfloat vpwidth, GLfloat vpheight, 
     GLfloat x, GLfloat y, GLint mode);
 
+// same, but draw count vertices of prim, with vert already in normalized device coordinates of the current viewport
+void gl4es_blitTextureArrays(GLuint texture, const GLfloat* vert, const GLfloat* tex, GLenum prim, int count, GLint mode);
+
+// delete the GLES2 blit programs and quad, the context of the state must be current
+struct glesblit_s;
+void free_blit(struct glesblit_s *blit);
+
 #endif // _GL4ES_BLIT_H_
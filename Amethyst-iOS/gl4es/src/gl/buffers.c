@@ -120,6 +120,9 @@ void gl4es_glGenBuffers(GLsizei n, GLuint * buffers) {
         buff->access = GL_READ_WRITE;
         buff->mapped = 0;
         buff->real_buffer = 0;
+        buff->generation = 1;
+        buff->ranges_next = 0;
+        memset(buff->ranges, 0, sizeof(buff->ranges));
     }
 }
 
@@ -154,6 +157,9 @@ void gl4es_glBindBuffer(GLenum target, GLuint buffer) {
             buff->access = GL_READ_WRITE;
             buff->mapped = 0;
             buff->real_buffer = 0;
+            buff->generation = 1;
+            buff->ranges_next = 0;
+            memset(buff->ranges, 0, sizeof(buff->ranges));
         } else {
             buff = kh_value(list, k);
             buff->type = target;    //TODO: check if old binding?
@@ -215,6 +221,7 @@ void gl4es_glBufferData(GLenum target, GLsizeiptr size, const GLvoid * data, GLe
     buff->access = GL_READ_WRITE;
     if (data)
         memcpy(buff->data, data, size);
+    ++buff->generation;
     noerrorShim();
 }
 
@@ -259,6 +266,7 @@ void gl4es_glNamedBufferData(GLuint buffer, GLsizeiptr size, const GLvoid * data
     buff->access = GL_READ_WRITE;
     if (data)
         memcpy(buff->data, data, size);
+    ++buff->generation;
     noerrorShim();
 }
 
@@ -293,6 +301,7 @@ void gl4es_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, cons
     }
         
     memcpy(buff->data + offset, data, size);
+    ++buff->generation;
     noerrorShim();
 }
 void gl4es_glNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const GLvoid * data) {
@@ -316,6 +325,7 @@ void gl4es_glNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size,
         gles_glBindBuffer(buff->type, 0);
     }
     memcpy(buff->data + offset, data, size);
+    ++buff->generation;
     noerrorShim();
 }
 
@@ -512,6 +522,7 @@ GLboolean gl4es_glUnmapBuffer(GLenum target) {
     if (buff->mapped) {
 		buff->mapped = 0;
         buff->ranged = 0;
+        ++buff->generation;     // content may have been changed while mapped
 		return GL_TRUE;
 	}
 	return GL_FALSE;
@@ -542,6 +553,7 @@ GLboolean gl4es_glUnmapNamedBuffer(GLuint buffer) {
 	if (buff->mapped) {
 		buff->mapped = 0;
         buff->ranged = 0;
+        ++buff->generation;     // content may have been changed while mapped
 		return GL_TRUE;
 	}
 	return GL_FALSE;
@@ -6,6 +6,18 @@
 #include "gles.h"
 
 // VBO *****************
+// min/max of indices found in an element buffer, for a given generation of its content
+typedef struct {
+    GLuint      generation;     // 0 means unused
+    GLenum      type;
+    uintptr_t   offset;
+    GLsizei     count;
+    GLsizei     min;
+    GLsizei     max;
+} indices_range_t;
+
+#define INDICES_RANGE_CACHE 4
+
 typedef struct {
     GLuint      buffer;
     GLuint      real_buffer;
@@ -18,6 +30,9 @@ typedef struct {
     GLintptr    offset;
     GLsizeiptr  length;
     GLvoid     *data;
+    GLuint      generation;     // incremented each time data is (or may have been) modified
+    int         ranges_next;
+    indices_range_t ranges[INDICES_RANGE_CACHE];
 } glbuffer_t;
 
 KHASH_MAP_DECLARE_INT(buff, glbuffer_t *);
@@ -346,3 +346,218 @@ void DecompressBlockDXT3(uint32_t x, uint32_t y, uint32_t width,
 
 #define STB_DXT_IMPLEMENTATION
 #include "stb_dxt_104.h"
+
+/*
+gl4es addition: whole image decompression, by rows of blocks.
+
+The color (and DXT5 alpha) palette is computed once per block, with the same
+formulas as above, and the pixels are expanded from it. Output, including
+the simpleAlpha / complexAlpha flags, is the same as calling DecompressBlockDXTn
+on every block, in order. Rows of blocks are independent (as long as width
+is a multiple of 4), so different ranges can be decoded in parallel.
+*/
+#include "init.h"
+#include "simd.h"
+
+static void BlockPalette(const uint8_t* block, int allow3, uint32_t* pal)
+{
+	uint32_t temp;
+	uint16_t color0, color1;
+	uint8_t r0, g0, b0, r1, g1, b1;
+
+	color0 = *(const uint16_t*)(block);
+	color1 = *(const uint16_t*)(block + 2);
+
+	temp = (color0 >> 11) * 255 + 16;
+	r0 = (uint8_t)((temp/32 + temp)/32);
+	temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
+	g0 = (uint8_t)((temp/64 + temp)/64);
+	temp = (color0 & 0x001F) * 255 + 16;
+	b0 = (uint8_t)((temp/32 + temp)/32);
+
+	temp = (color1 >> 11) * 255 + 16;
+	r1 = (uint8_t)((temp/32 + temp)/32);
+	temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
+	g1 = (uint8_t)((temp/64 + temp)/64);
+	temp = (color1 & 0x001F) * 255 + 16;
+	b1 = (uint8_t)((temp/32 + temp)/32);
+
+	pal[0] = PackRGBA(r0, g0, b0, 0);
+	pal[1] = PackRGBA(r1, g1, b1, 0);
+	if (!allow3 || color0 > color1) {
+		pal[2] = PackRGBA((2*r0+r1)/3, (2*g0+g1)/3, (2*b0+b1)/3, 0);
+		pal[3] = PackRGBA((r0+2*r1)/3, (g0+2*g1)/3, (b0+2*b1)/3, 0);
+	} else {
+		pal[2] = PackRGBA((r0+r1)/2, (g0+g1)/2, (b0+b1)/2, 0);
+		pal[3] = 0;
+	}
+}
+
+/* DXT5 alpha palette, already shifted in the alpha byte */
+static void AlphaPalette(uint8_t alpha0, uint8_t alpha1, uint32_t* apal)
+{
+	int alphaCode;
+	apal[0] = (uint32_t)alpha0 << 24;
+	apal[1] = (uint32_t)alpha1 << 24;
+	for (alphaCode = 2; alphaCode < 8; ++alphaCode) {
+		uint8_t finalAlpha;
+		if (alpha0 > alpha1) {
+			finalAlpha = (uint8_t)(((8-alphaCode)*alpha0 + (alphaCode-1)*alpha1)/7);
+		} else {
+			if (alphaCode == 6) {
+				finalAlpha = 0;
+			} else if (alphaCode == 7) {
+				finalAlpha = 255;
+			} else {
+				finalAlpha = (uint8_t)(((6-alphaCode)*alpha0 + (alphaCode-1)*alpha1)/5);
+			}
+		}
+		apal[alphaCode] = (uint32_t)finalAlpha << 24;
+	}
+}
+
+/* alpha byte of the 16 pixels of a block */
+static void BlockAlpha(int dxt, const uint8_t* block, uint32_t* alpha)
+{
+	int i;
+	if (dxt == 1) {
+		for (i = 0; i < 16; ++i)
+			alpha[i] = 0xff000000u;
+	} else if (dxt == 3) {
+		for (i = 0; i < 16; ++i)
+			alpha[i] = (uint32_t)(((block[i>>1] >> ((i&1)*4)) & 0xF) * 17) << 24;
+	} else {
+		uint32_t apal[8];
+		uint64_t bits = 0;
+		AlphaPalette(block[0], block[1], apal);
+		for (i = 0; i < 6; ++i)
+			bits |= (uint64_t)block[2+i] << (8*i);
+		for (i = 0; i < 16; ++i)
+			alpha[i] = apal[(bits >> (3*i)) & 0x07];
+	}
+}
+
+#ifdef GL4ES_SIMD
+#ifdef GL4ES_SIMD_NEON64
+typedef uint32x4_t dxt_u4;
+static inline dxt_u4 dxt_set1(uint32_t v) { return vdupq_n_u32(v); }
+static inline dxt_u4 dxt_load(const uint32_t* p) { return vld1q_u32(p); }
+static inline void dxt_store(uint32_t* p, dxt_u4 v) { vst1q_u32(p, v); }
+static inline dxt_u4 dxt_and(dxt_u4 a, dxt_u4 b) { return vandq_u32(a, b); }
+static inline dxt_u4 dxt_or(dxt_u4 a, dxt_u4 b) { return vorrq_u32(a, b); }
+static inline dxt_u4 dxt_andnot(dxt_u4 m, dxt_u4 a) { return vbicq_u32(a, m); }
+static inline dxt_u4 dxt_eq(dxt_u4 a, dxt_u4 b) { return vceqq_u32(a, b); }
+static inline dxt_u4 dxt_alpha(dxt_u4 a) { return vshrq_n_u32(a, 24); }
+/* the 4 2 bits codes of a row, in each lane */
+static inline dxt_u4 dxt_codes(uint32_t rowbits) {
+	static const int32_t shifts[4] = {0, -2, -4, -6};
+	return vandq_u32(vshlq_u32(vdupq_n_u32(rowbits), vld1q_s32(shifts)), vdupq_n_u32(3));
+}
+static inline int dxt_any(dxt_u4 a) { return vmaxvq_u32(a)!=0; }
+#else
+typedef __m128i dxt_u4;
+static inline dxt_u4 dxt_set1(uint32_t v) { return _mm_set1_epi32((int)v); }
+static inline dxt_u4 dxt_load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void dxt_store(uint32_t* p, dxt_u4 v) { _mm_storeu_si128((__m128i*)p, v); }
+static inline dxt_u4 dxt_and(dxt_u4 a, dxt_u4 b) { return _mm_and_si128(a, b); }
+static inline dxt_u4 dxt_or(dxt_u4 a, dxt_u4 b) { return _mm_or_si128(a, b); }
+static inline dxt_u4 dxt_andnot(dxt_u4 m, dxt_u4 a) { return _mm_andnot_si128(m, a); }
+static inline dxt_u4 dxt_eq(dxt_u4 a, dxt_u4 b) { return _mm_cmpeq_epi32(a, b); }
+static inline dxt_u4 dxt_alpha(dxt_u4 a) { return _mm_srli_epi32(a, 24); }
+/* the 4 2 bits codes of a row, in each lane (rowbits<<(6-2*i), using a 16bits multiply, then >>6) */
+static inline dxt_u4 dxt_codes(uint32_t rowbits) {
+	const __m128i v = _mm_mullo_epi16(_mm_set1_epi32((int)rowbits), _mm_set_epi32(1, 4, 16, 64));
+	return _mm_and_si128(_mm_srli_epi32(v, 6), _mm_set1_epi32(3));
+}
+static inline int dxt_any(dxt_u4 a) { return _mm_movemask_epi8(a)!=0; }
+#endif
+
+static void DecompressBlocksSIMD(int dxt, uint32_t width, const uint8_t* block, uint32_t by0, uint32_t by1,
+	int transparent0, int* simpleAlpha, int* complexAlpha, uint32_t* image)
+{
+	const uint32_t bw = (width+3)/4;
+	const int colorofs = (dxt==1)?0:8;
+	const dxt_u4 opaque_black = dxt_set1(0xff000000u);
+	const dxt_u4 zero = dxt_set1(0), full = dxt_set1(0xff);
+	const dxt_u4 c1 = dxt_set1(1), c2 = dxt_set1(2), c3 = dxt_set1(3);
+	dxt_u4 simple = zero, notcomplex = dxt_set1(0xffffffffu);
+	uint32_t by, bx;
+	int j;
+	for (by = by0; by < by1; ++by) {
+		for (bx = 0; bx < bw; ++bx) {
+			uint32_t pal[4], alpha[16];
+			uint32_t* output = image + bx*4 + by*4*width;
+			const uint32_t code = *(const uint32_t*)(block + colorofs + 4);
+			BlockPalette(block + colorofs, dxt!=5, pal);
+			BlockAlpha(dxt, block, alpha);
+			const dxt_u4 p0 = dxt_set1(pal[0]), p1 = dxt_set1(pal[1]), p2 = dxt_set1(pal[2]), p3 = dxt_set1(pal[3]);
+			for (j = 0; j < 4; ++j) {
+				const dxt_u4 codes = dxt_codes((code >> (8*j)) & 0xff);
+				dxt_u4 c = dxt_andnot(dxt_or(dxt_eq(codes, c1), dxt_or(dxt_eq(codes, c2), dxt_eq(codes, c3))), p0);
+				c = dxt_or(c, dxt_and(dxt_eq(codes, c1), p1));
+				c = dxt_or(c, dxt_and(dxt_eq(codes, c2), p2));
+				c = dxt_or(c, dxt_and(dxt_eq(codes, c3), p3));
+				c = dxt_or(c, dxt_load(alpha + j*4));
+				if (transparent0 && dxt!=5)
+					c = dxt_andnot(dxt_eq(c, opaque_black), c);
+				const dxt_u4 a = dxt_alpha(c);
+				const dxt_u4 a0 = dxt_eq(a, zero);
+				simple = dxt_or(simple, a0);
+				notcomplex = dxt_and(notcomplex, dxt_or(a0, dxt_eq(a, full)));
+				dxt_store(output + j*width, c);
+			}
+			block += (dxt==1)?8:16;
+		}
+	}
+	if (dxt_any(simple))
+		*simpleAlpha = 1;
+	if (dxt_any(dxt_andnot(notcomplex, dxt_set1(0xffffffffu))))
+		*complexAlpha = 1;
+}
+#endif
+
+/*
+void DecompressBlocksDXT(): Decompresses the rows of blocks [by0, by1[ of a DXTn (dxt = 1, 3 or 5) image.
+
+uint32_t width:					width of the texture being decompressed.
+const uint8_t *data:			pointer to the first block of the image.
+uint32_t *image:				pointer to the whole decompressed image.
+*/
+void DecompressBlocksDXT(int dxt, uint32_t width, const uint8_t* data, uint32_t by0, uint32_t by1,
+	int transparent0, int* simpleAlpha, int* complexAlpha, uint32_t* image)
+{
+	const uint32_t bw = (width+3)/4;
+	const int blocksize = (dxt==1)?8:16;
+	const int colorofs = (dxt==1)?0:8;
+	const uint8_t* block = data + by0*bw*blocksize;
+	uint32_t by, bx;
+	int i, j;
+#ifdef GL4ES_SIMD
+	if (!globals4es.nosimd) {
+		DecompressBlocksSIMD(dxt, width, block, by0, by1, transparent0, simpleAlpha, complexAlpha, image);
+		return;
+	}
+#endif
+	for (by = by0; by < by1; ++by) {
+		for (bx = 0; bx < bw; ++bx) {
+			uint32_t pal[4], alpha[16];
+			uint32_t* output = image + bx*4 + by*4*width;
+			const uint32_t code = *(const uint32_t*)(block + colorofs + 4);
+			BlockPalette(block + colorofs, dxt!=5, pal);
+			BlockAlpha(dxt, block, alpha);
+			for (j = 0; j < 4; ++j) {
+				for (i = 0; i < 4; ++i) {
+					uint32_t finalColor = pal[(code >> 2*(4*j+i)) & 0x03] | alpha[j*4+i];
+					if (transparent0 && dxt!=5 && finalColor==0xff000000)
+						finalColor = 0;
+					if (!(finalColor>>24))
+						*simpleAlpha = 1;
+					else if ((finalColor>>24)<0xff)
+						*complexAlpha = 1;
+					output[j*width + i] = finalColor;
+				}
+			}
+			block += blocksize;
+		}
+	}
+}
@@ -16,4 +16,9 @@ void DecompressBlockDXT5(uint32_t x, uint32_t y, uint32_t width,
 	int transparent0, int* simpleAlpha, int *complexAlpha,
 	uint32_t* image);
 
+// Whole image version, for the rows of blocks [by0, by1[ (dxt is 1, 3 or 5).
+// Same output as calling DecompressBlockDXTn on each block, in order.
+void DecompressBlocksDXT(int dxt, uint32_t width, const uint8_t* data, uint32_t by0, uint32_t by1,
+	int transparent0, int* simpleAlpha, int* complexAlpha, uint32_t* image);
+
 #endif // _GL4ES_DECOMPRESS_H_
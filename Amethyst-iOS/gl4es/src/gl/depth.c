@@ -12,6 +12,7 @@ void gl4es_glDepthFunc(GLenum func) {
     if (glstate->depth.func == func)
         return;
     FLUSH_BEGINEND;
+    attrib_changed(GL_DEPTH_BUFFER_BIT);
     glstate->depth.func = func;
     LOAD_GLES(glDepthFunc);
     errorGL();
@@ -26,6 +27,7 @@ void gl4es_glDepthMask(GLboolean flag) {
     if (glstate->depth.mask == flag)
         return;
     FLUSH_BEGINEND;
+    attrib_changed(GL_DEPTH_BUFFER_BIT);
     glstate->depth.mask = flag;
     LOAD_GLES(glDepthMask);
     errorGL();
@@ -46,6 +48,7 @@ void gl4es_glDepthRangef(GLclampf near, GLclampf far) {
     if ((glstate->depth.near == near) && (glstate->depth.far == far))
         return;
     FLUSH_BEGINEND;
+    attrib_changed(GL_VIEWPORT_BIT);
     glstate->depth.near = near;
     glstate->depth.far = far;
     LOAD_GLES(glDepthRangef);
@@ -59,6 +62,7 @@ void gl4es_glClearDepthf(GLclampf depth) {
         PUSH_IF_COMPILING(glClearDepthf);
     }
     noerrorShim();
+    attrib_changed(GL_DEPTH_BUFFER_BIT);
     glstate->depth.clear = depth;
     LOAD_GLES(glClearDepthf);
     errorGL();
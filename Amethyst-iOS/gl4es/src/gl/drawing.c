@@ -258,20 +258,33 @@ static inline bool should_intercept_render(GLenum mode) {
     return (
         (glstate->vao->vertexattrib[ATT_VERTEX].enabled && ! valid_vertex_type(glstate->vao->vertexattrib[ATT_VERTEX].type)) ||
         (mode == GL_LINES && glstate->enable.line_stipple) ||
+        // strips and loops only go to the list path to be stippled, which is never done for a GLSL program
+        ((mode == GL_LINE_STRIP || mode == GL_LINE_LOOP) && glstate->enable.line_stipple && (hardext.esversion==1 || !glstate->glsl->program)) ||
         /*(mode == GL_QUADS) ||*/ (glstate->list.active && !glstate->list.pending)
     );
 }
 
 GLuint len_indices(const GLushort *sindices, const GLuint *iindices, GLsizei count) {
-    GLuint len = 0;
-    if (sindices) {
-        for (int i=0; i<count; i++)
-            if (len<sindices[i]) len = sindices[i]; // get the len of the arrays
-    } else {
-        for (int i=0; i<count; i++)
-            if (len<iindices[i]) len = iindices[i]; // get the len of the arrays
+    GLsizei max = 0, min = 0;
+    if (sindices)
+        getminmax_indices_buffer(glstate->vao->elements, GL_UNSIGNED_SHORT, sindices, &max, &min, count);
+    else
+        getminmax_indices_buffer(glstate->vao->elements, GL_UNSIGNED_INT, iindices, &max, &min, count);
+    return max+1;  // lenght is max(indices) + 1 !
+}
+
+// normalize a GLushort copy of indices, using the cached range of the element buffer they come from when possible
+static void normalize_indices_elements(GLushort *sindices, GLenum type, const GLvoid *indices, GLsizei *max, GLsizei *min, GLsizei count) {
+    glbuffer_t *elements = glstate->vao->elements;
+    if (elements && (type==GL_UNSIGNED_SHORT || type==GL_UNSIGNED_INT)) {
+        getminmax_indices_buffer(elements, type, elements->data + (uintptr_t)indices, max, min, count);
+        if (*min>=0 && *max<65536) {   // else the GLushort copy doesn't have the same range
+            for (int i=0; i<count; i++)
+                sindices[i] -= *min;
+            return;
+        }
     }
-    return len+1;  // lenght is max(indices) + 1 !
+    normalize_indices_us(sindices, max, min, count);
 }
 
 static void glDrawElementsCommon(GLenum mode, GLint first, GLsizei count, GLuint len, const GLushort *sindices, const GLuint *iindices, int instancecount) {
@@ -604,7 +617,7 @@ void gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
 
-        normalize_indices_us(sindices, &max, &min, count);
+        normalize_indices_elements(sindices, type, indices, &max, &min, count);
 
         if(globals4es.mergelist && list->stage>=STAGE_DRAW && is_list_compatible(list) && !list->use_glstate && sindices) {
             list = NewDrawStage(list, mode);
@@ -635,7 +648,7 @@ void gl4es_glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        normalize_indices_us(sindices, &max, &min, count);
+        normalize_indices_elements(sindices, type, indices, &max, &min, count);
         list = arrays_to_renderlist(list, mode, min, max + 1);
         list->indices = sindices;
         list->ilen = count;
@@ -938,7 +951,7 @@ void gl4es_glMultiDrawElements( GLenum mode, GLsizei *counts, GLenum type, const
                 sindices = (GLushort*)malloc(count*sizeof(GLushort));
                 memcpy(sindices, tmp, count*sizeof(GLushort));
             }
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min, max + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -963,7 +976,7 @@ void gl4es_glMultiDrawElements( GLenum mode, GLsizei *counts, GLenum type, const
                 sindices = (GLushort*)malloc(count*sizeof(GLushort));
                 memcpy(sindices, tmp, count*sizeof(GLushort));
             }
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             if(list) {
                 NewStage(list, STAGE_DRAW);
             }
@@ -1040,7 +1053,7 @@ void gl4es_glMultiDrawElementsBaseVertex( GLenum mode, GLsizei *counts, GLenum t
             NewStage(glstate->list.active, STAGE_DRAW);
             list = glstate->list.active;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min + basevertex[i], max + basevertex[i] + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -1059,7 +1072,7 @@ void gl4es_glMultiDrawElementsBaseVertex( GLenum mode, GLsizei *counts, GLenum t
             //TODO handling uint indices
             GLsizei min, max;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             if(list) {
                 NewStage(list, STAGE_DRAW);
             }
@@ -1139,7 +1152,7 @@ void gl4es_glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, con
             NewStage(glstate->list.active, STAGE_DRAW);
             list = glstate->list.active;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min + basevertex, max + basevertex + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -1159,7 +1172,7 @@ void gl4es_glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, con
             renderlist_t *list = NULL;
             GLsizei min, max;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min + basevertex, max + basevertex + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -1427,7 +1440,7 @@ void gl4es_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, cons
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        normalize_indices_us(sindices, &max, &min, count);
+        normalize_indices_elements(sindices, type, indices, &max, &min, count);
         list = arrays_to_renderlist(list, mode, min, max + 1);
         list->indices = sindices;
         list->ilen = count;
@@ -1453,7 +1466,7 @@ void gl4es_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, cons
             sindices = (GLushort*)malloc(count*sizeof(GLushort));
             memcpy(sindices, tmp, count*sizeof(GLushort));
         }
-        normalize_indices_us(sindices, &max, &min, count);
+        normalize_indices_elements(sindices, type, indices, &max, &min, count);
         list = arrays_to_renderlist(list, mode, min, max + 1);
         list->indices = sindices;
         list->ilen = count;
@@ -1522,7 +1535,7 @@ void gl4es_glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum
             NewStage(glstate->list.active, STAGE_DRAW);
             list = glstate->list.active;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min + basevertex, max + basevertex + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -1543,7 +1556,7 @@ void gl4es_glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum
             renderlist_t *list = NULL;
             GLsizei min, max;
 
-            normalize_indices_us(sindices, &max, &min, count);
+            normalize_indices_elements(sindices, type, indices, &max, &min, count);
             list = arrays_to_renderlist(list, mode, min + basevertex, max + basevertex + 1);
             list->indices = sindices;
             list->ilen = count;
@@ -267,11 +267,57 @@ static void proxy_glEnable(GLenum cap, bool enable, void (*next)(GLenum)) {
     #undef clientGO
 }
 
+// attribute groups that save the enable flag of cap (for glPopAttrib)
+static GLbitfield enable_attrib_groups(GLenum cap) {
+    switch(cap) {
+        case GL_ALPHA_TEST:
+        case GL_BLEND:
+        case GL_DITHER:
+        case GL_COLOR_LOGIC_OP:
+            return GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT;
+        case GL_DEPTH_TEST:
+            return GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT;
+        case GL_FOG:
+            return GL_ENABLE_BIT | GL_FOG_BIT;
+        case GL_LIGHTING:
+            return GL_ENABLE_BIT | GL_LIGHTING_BIT;
+        case GL_LINE_SMOOTH:
+        case GL_LINE_STIPPLE:
+            return GL_ENABLE_BIT | GL_LINE_BIT;
+        case GL_MULTISAMPLE:
+        case GL_SAMPLE_ALPHA_TO_COVERAGE:
+        case GL_SAMPLE_ALPHA_TO_ONE:
+        case GL_SAMPLE_COVERAGE:
+            return GL_ENABLE_BIT | GL_MULTISAMPLE_BIT;
+        case GL_POINT_SMOOTH:
+        case GL_POINT_SPRITE:
+            return GL_ENABLE_BIT | GL_POINT_BIT;
+        case GL_SCISSOR_TEST:
+            return GL_ENABLE_BIT | GL_SCISSOR_BIT;
+        case GL_STENCIL_TEST:
+            return GL_ENABLE_BIT | GL_STENCIL_BUFFER_BIT;
+        case GL_TEXTURE_GEN_S:
+        case GL_TEXTURE_GEN_T:
+        case GL_TEXTURE_GEN_R:
+        case GL_TEXTURE_GEN_Q:
+            return GL_ENABLE_BIT | GL_TEXTURE_BIT;
+        case GL_NORMALIZE:
+        case GL_RESCALE_NORMAL:
+            return GL_ENABLE_BIT | GL_TRANSFORM_BIT;
+    }
+    if(cap>=GL_LIGHT0 && cap<GL_LIGHT0+hardext.maxlights)
+        return GL_ENABLE_BIT | GL_LIGHTING_BIT;
+    if(cap>=GL_CLIP_PLANE0 && cap<GL_CLIP_PLANE0+hardext.maxplanes)
+        return GL_ENABLE_BIT | GL_TRANSFORM_BIT;
+    return GL_ENABLE_BIT;
+}
+
 void gl4es_glEnable(GLenum cap) {
     DBG(printf("glEnable(%s), glstate->list.pending=%d\n", PrintEnum(cap), glstate->list.pending);)
     if(!glstate->list.pending) {
 	    PUSH_IF_COMPILING(glEnable)
     }
+    attrib_changed(enable_attrib_groups(cap));
 #ifdef TEXSTREAM00
 	if (globals4es.texstream && (cap==GL_TEXTURE_2D)) {
         if (glstate->texture.bound[glstate->texture.active][ENABLED_TEX2D]->streamed)
@@ -292,6 +338,7 @@ void gl4es_glDisable(GLenum cap) {
     if(!glstate->list.pending) {
 	    PUSH_IF_COMPILING(glDisable)
     }
+    attrib_changed(enable_attrib_groups(cap));
         
 #ifdef TEXSTREAM00
 	if (globals4es.texstream && (cap==GL_TEXTURE_2D)) {
@@ -3,11 +3,15 @@
 
 #include "eval.h"
 
+#include "../glx/hardext.h"
 #include "math/eval.h"
 #include "wrap/gl4es.h"
 #include "array.h"
+#include "init.h"
+#include "list.h"
 #include "logs.h"
 #include "matvec.h"
+#include "simd.h"
 
 static inline map_state_t **get_map_pointer(GLenum target) {
     switch (target) {
@@ -198,6 +202,7 @@ void gl4es_glMapGrid1f(GLint un, GLfloat u1, GLfloat u2) {
    glstate->map_grid[0].n = un;
    glstate->map_grid[0]._1 = u1;
    glstate->map_grid[0]._2 = u2;
+   glstate->map_grid[0].d = (glstate->map_grid[0]._2 - glstate->map_grid[0]._1)/glstate->map_grid[0].n;
 }
 
 void gl4es_glMapGrid2f(GLint un, GLfloat u1, GLfloat u2,
@@ -224,30 +229,473 @@ void gl4es_glMapGrid2f(GLint un, GLfloat u1, GLfloat u2,
     glstate->map_grid[1].d = (glstate->map_grid[1]._2 - glstate->map_grid[1]._1)/glstate->map_grid[1].n;
 }
 
-static inline GLenum eval_mesh_prep(GLenum mode) {
-    if ((!glstate->map2.vertex4) && (!glstate->map2.vertex3)) {
+// return 0 if the mesh cannot be drawn (GL_POINTS is 0, so the primitive is returned in renderMode)
+static inline int eval_mesh_prep(GLenum mode, int dims, GLenum *renderMode) {
+    if ((dims==1) && (!glstate->map1.vertex4) && (!glstate->map1.vertex3)) {
+        return 0;
+    }
+    if ((dims==2) && (!glstate->map2.vertex4) && (!glstate->map2.vertex3)) {
         return 0;
     }
 
     switch (mode) {
-        case GL_POINT: return GL_POINTS;
-        case GL_LINE: return GL_LINE_STRIP;
-        case GL_FILL: return GL_TRIANGLE_STRIP;
-        case 0: return 1;
+        case GL_POINT: *renderMode = GL_POINTS; return 1;
+        case GL_LINE: *renderMode = GL_LINE_STRIP; return 1;
+        case GL_FILL: *renderMode = GL_TRIANGLE_STRIP; return 1;
         default:
             LOGE("unknown glEvalMesh mode: %x\n", mode);
             return 0;
     }
 }
 
+// Cache of glEvalMesh meshes: a mesh evaluated again (same maps, same grid, same mode) is drawn from
+// the renderlist built the previous time, uploaded once in VBOs. Like glDrawPixels images, meshes are
+// only cached the second time they are seen, so animated control points don't churn buffers.
+#define EM_CACHE_SIZE   (8*1024*1024)   // max size of the cached meshes, in bytes
+#define EM_CACHE_SEEN   256             // number of recent uncached meshes remembered (a model is many patches)
+
+enum { EM_COLOR=0, EM_NORMAL, EM_TEXTURE, EM_VERTEX, EM_MAX };
+
+typedef struct em_key_s {
+    uint64_t    hash;           // of the domains, orders and control points of the maps used
+    GLenum      mode;
+    GLint       dims;
+    GLint       i1, i2, j1, j2;
+    map_grid_t  grid[2];
+    GLint       width[EM_MAX];  // width of the maps used, 0 if none
+    GLint       auto_normal;
+} em_key_t;
+
+typedef struct em_entry_s {
+    em_key_t    key;
+    renderlist_t *list;
+    int         size;
+    struct em_entry_s *prev, *next;    // LRU list, most recent first
+} em_entry_t;
+
+static kh_inline khint32_t em_key_hash(em_key_t* k) { return (khint32_t)(k->hash^(k->hash>>32)); }
+#define em_key_equal(a, b) (memcmp(a, b, sizeof(em_key_t))==0)
+KHASH_INIT(emcache, em_key_t*, em_entry_t*, 1, em_key_hash, em_key_equal);
+
+typedef struct em_cache_s {
+    khash_t(emcache) *entries;
+    em_entry_t  *first, *last;
+    int         size;
+    uint64_t    seen[EM_CACHE_SEEN];
+    int         seen_idx;
+} em_cache_t;
+
+void free_eval_cache(em_cache_t *cache)
+{
+    if(!cache)
+        return;
+    em_entry_t *e = cache->first;
+    while(e) {
+        em_entry_t *next = e->next;
+        free_renderlist(e->list);
+        free(e);
+        e = next;
+    }
+    kh_destroy(emcache, cache->entries);
+    free(cache);
+}
+
+static uint64_t em_hash(const void* data, int size, uint64_t h)
+{
+    // 64bits FNV-1a, 8 bytes at a time
+    const uint8_t* p = (const uint8_t*)data;
+    while(size>=8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h^v)*0x100000001b3ULL;
+        h ^= h>>29;
+        p+=8; size-=8;
+    }
+    for (; size>0; --size)
+        h = (h^*(p++))*0x100000001b3ULL;
+    return h;
+}
+
+// pick the maps glEvalCoord would use, return 0 if the mesh cannot be built directly
+static int em_getmaps(int dims, map_statef_t **maps)
+{
+    map_states_t *m = (dims==1)?&glstate->map1:&glstate->map2;
+    #define ENABLED(name) (m->name && ((dims==1)?glstate->enable.map1_##name:glstate->enable.map2_##name))
+    if(ENABLED(index))
+        return 0;   // color index are not supported
+    maps[EM_COLOR] = ENABLED(color4)?(map_statef_t*)m->color4:NULL;
+    maps[EM_NORMAL] = (ENABLED(normal) && !glstate->enable.auto_normal)?(map_statef_t*)m->normal:NULL;
+    maps[EM_TEXTURE] = ENABLED(texture4)?(map_statef_t*)m->texture4:
+                       ENABLED(texture3)?(map_statef_t*)m->texture3:
+                       ENABLED(texture2)?(map_statef_t*)m->texture2:
+                       ENABLED(texture1)?(map_statef_t*)m->texture1:NULL;
+    maps[EM_VERTEX] = ENABLED(vertex4)?(map_statef_t*)m->vertex4:
+                      ENABLED(vertex3)?(map_statef_t*)m->vertex3:NULL;
+    #undef ENABLED
+    if(!maps[EM_VERTEX])
+        return 0;
+    for (int a=0; a<EM_MAX; ++a)
+        if(maps[a] && (maps[a]->type!=GL_FLOAT || !maps[a]->points
+         || maps[a]->u.order<1 || maps[a]->u.order>MAX_EVAL_ORDER
+         || (dims==2 && (maps[a]->v.order<1 || maps[a]->v.order>MAX_EVAL_ORDER))))
+            return 0;
+    return 1;
+}
+
+static void em_makekey(em_key_t *key, int dims, GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2, map_statef_t **maps)
+{
+    memset(key, 0, sizeof(em_key_t));    // no garbage in the padding, it's hashed and compared
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int a=0; a<EM_MAX; ++a) {
+        map_statef_t *map = maps[a];
+        if(!map)
+            continue;
+        key->width[a] = map->width;
+        h = em_hash(&map->u, sizeof(mapcoordf_t), h);
+        if(dims==2)
+            h = em_hash(&map->v, sizeof(mapcoordf_t), h);
+        // only the control net, the 2D maps have scratch space after it
+        h = em_hash(map->points, map->u.order*((dims==2)?map->v.order:1)*map->width*sizeof(GLfloat), h);
+    }
+    key->hash = h;
+    key->mode = mode;
+    key->dims = dims;
+    key->i1 = i1; key->i2 = i2;
+    memcpy(&key->grid[0], &glstate->map_grid[0], sizeof(map_grid_t));
+    if(dims==2) {
+        key->j1 = j1; key->j2 = j2;
+        memcpy(&key->grid[1], &glstate->map_grid[1], sizeof(map_grid_t));
+    }
+    key->auto_normal = (dims==2)?glstate->enable.auto_normal:0;
+}
+
+static void em_unlink(em_cache_t *cache, em_entry_t *e)
+{
+    if(e->prev) e->prev->next = e->next; else cache->first = e->next;
+    if(e->next) e->next->prev = e->prev; else cache->last = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void em_pushfront(em_cache_t *cache, em_entry_t *e)
+{
+    e->prev = NULL;
+    e->next = cache->first;
+    if(cache->first) cache->first->prev = e; else cache->last = e;
+    cache->first = e;
+}
+
+static em_entry_t* em_find(em_key_t *key)
+{
+    em_cache_t *cache = glstate->eval_cache;
+    if(!cache)
+        return NULL;
+    khint_t k = kh_get(emcache, cache->entries, key);
+    if(k==kh_end(cache->entries))
+        return NULL;
+    em_entry_t *e = kh_value(cache->entries, k);
+    if(cache->first!=e) {
+        em_unlink(cache, e);
+        em_pushfront(cache, e);
+    }
+    return e;
+}
+
+// return 1 if the mesh has been seen recently, and remember it else
+static int em_seen(em_key_t *key)
+{
+    em_cache_t *cache = glstate->eval_cache;
+    if(!cache) {
+        cache = glstate->eval_cache = (em_cache_t*)calloc(1, sizeof(em_cache_t));
+        cache->entries = kh_init(emcache);
+    }
+    uint64_t h = em_hash(key, sizeof(em_key_t), 0xcbf29ce484222325ULL);
+    for (int i=0; i<EM_CACHE_SEEN; ++i)
+        if(cache->seen[i]==h)
+            return 1;
+    cache->seen[cache->seen_idx] = h;
+    cache->seen_idx = (cache->seen_idx+1)%EM_CACHE_SEEN;
+    return 0;
+}
+
+static void em_add(em_entry_t *e)
+{
+    em_cache_t *cache = glstate->eval_cache;
+    renderlist_t *list = e->list;
+    e->size = list->len*(4+(list->color?4:0)+(list->normal?3:0)+(list->tex[0]?4:0))*sizeof(GLfloat) + list->ilen*sizeof(GLushort);
+    cache->size += e->size;
+    int ret;
+    khint_t k = kh_put(emcache, cache->entries, &e->key, &ret);
+    kh_value(cache->entries, k) = e;
+    em_pushfront(cache, e);
+    // evict the least recently used ones
+    while(cache->size>EM_CACHE_SIZE && cache->last!=e) {
+        em_entry_t *old = cache->last;
+        em_unlink(cache, old);
+        kh_del(emcache, cache->entries, kh_get(emcache, cache->entries, &old->key));
+        cache->size -= old->size;
+        free_renderlist(old->list);
+        free(old);
+    }
+}
+
+// Bernstein basis of degree order-1 at t, and the derivative direction without the degree factor
+// (as _math_de_casteljau_surf computes it) if db is not NULL
+static void em_basis(GLfloat t, int order, GLfloat *b, GLfloat *db)
+{
+    const GLfloat s = 1.0f - t;
+    b[0] = 1.0f;
+    if(db)
+        db[0] = 0.0f;
+    for (int n=1; n<order; ++n) {
+        if(db && n==order-1) {
+            // b holds the basis of degree order-2 here
+            db[0] = -b[0];
+            for (int i=1; i<n; ++i)
+                db[i] = b[i-1] - b[i];
+            db[n] = b[n-1];
+        }
+        b[n] = t*b[n-1];
+        for (int i=n-1; i>0; --i)
+            b[i] = t*b[i-1] + s*b[i];
+        b[0] = s*b[0];
+    }
+}
+
+// Evaluate one map on the nu*nv grid points, a row at a time: the control net is first reduced to a
+// curve in u for the row, then all the points of the row are accumulated on 4 floats lanes (one
+// simd_f4 per point when SIMD is available). Output is 4 floats per point (3 if stride is 3), padded
+// like glXXX3f would. If nrm is not NULL, the normals of the surface are computed too (for GL_AUTO_NORMAL).
+static void em_eval(map_statef_t *map, int dims, GLint i1, int nu, GLint j1, int nv, GLfloat *out, int stride, GLfloat *nrm)
+{
+    const int w = map->width;
+    const int uo = map->u.order;
+    const int vo = (dims==2)?map->v.order:1;
+    const GLfloat *cn = map->points;
+    const map_grid_t *gu = &glstate->map_grid[0];
+    const map_grid_t *gv = &glstate->map_grid[1];
+    // scratch: basis in u for all columns (+derivative), the curve of the row (+derivative in v), the row (+derivatives)
+    GLfloat *bu = (GLfloat*)malloc(sizeof(GLfloat)*(uo*nu*2 + uo*4*2 + nu*4*3));
+    GLfloat *dbu = bu + uo*nu;
+    GLfloat *q = dbu + uo*nu;
+    GLfloat *dq = q + uo*4;
+    GLfloat *row = dq + uo*4;
+    GLfloat *rdu = row + nu*4;
+    GLfloat *rdv = rdu + nu*4;
+    GLfloat b[MAX_EVAL_ORDER], db[MAX_EVAL_ORDER];
+    for (int c=0; c<nu; ++c) {
+        GLfloat uu = (gu->_1 + gu->d*(i1+c) - map->u._1) * map->u.d;
+        em_basis(uu, uo, b, nrm?db:NULL);
+        for (int i=0; i<uo; ++i) {
+            bu[i*nu+c] = b[i];
+            dbu[i*nu+c] = nrm?db[i]:0.0f;
+        }
+    }
+    for (int r=0; r<nv; ++r) {
+        // control polygon of the curve in u for this row
+        memset(q, 0, sizeof(GLfloat)*uo*4*2);
+        if(dims==2) {
+            GLfloat vv = (gv->_1 + gv->d*(j1+r) - map->v._1) * map->v.d;
+            em_basis(vv, vo, b, nrm?db:NULL);
+        } else
+            b[0] = 1.0f;
+        for (int i=0; i<uo; ++i)
+            for (int j=0; j<vo; ++j) {
+                const GLfloat *p = cn + (i*vo+j)*w;
+                for (int k=0; k<w; ++k) {
+                    q[i*4+k] += b[j]*p[k];
+                    if(nrm)
+                        dq[i*4+k] += db[j]*p[k];
+                }
+            }
+        // all the points of the row
+#ifdef GL4ES_SIMD
+        if(!globals4es.nosimd) {
+            // same sums in the same order as the scalar code, kept in registers for each point
+            for (int c=0; c<nu; ++c) {
+                simd_f4 p = simd_set1_f(0.0f);
+                for (int i=0; i<uo; ++i)
+                    p = simd_add_f(p, simd_mul_f(simd_set1_f(bu[i*nu+c]), simd_load_f(q+i*4)));
+                simd_store_f(row+c*4, p);
+            }
+            if(nrm)
+                for (int c=0; c<nu; ++c) {
+                    simd_f4 du = simd_set1_f(0.0f), dv = du;
+                    for (int i=0; i<uo; ++i) {
+                        du = simd_add_f(du, simd_mul_f(simd_set1_f(dbu[i*nu+c]), simd_load_f(q+i*4)));
+                        dv = simd_add_f(dv, simd_mul_f(simd_set1_f(bu[i*nu+c]), simd_load_f(dq+i*4)));
+                    }
+                    simd_store_f(rdu+c*4, du);
+                    simd_store_f(rdv+c*4, dv);
+                }
+        } else
+#endif
+        {
+            memset(row, 0, sizeof(GLfloat)*nu*4*(nrm?3:1));
+            for (int i=0; i<uo; ++i) {
+                const GLfloat *bi = bu+i*nu;
+                const GLfloat *qi = q+i*4;
+                for (int c=0; c<nu; ++c)
+                    for (int k=0; k<4; ++k)
+                        row[c*4+k] += bi[c]*qi[k];
+                if(nrm) {
+                    const GLfloat *dbi = dbu+i*nu;
+                    const GLfloat *dqi = dq+i*4;
+                    for (int c=0; c<nu; ++c)
+                        for (int k=0; k<4; ++k) {
+                            rdu[c*4+k] += dbi[c]*qi[k];
+                            rdv[c*4+k] += bi[c]*dqi[k];
+                        }
+                }
+            }
+        }
+        for (int c=0; c<nu; ++c) {
+            GLfloat *o = out + (r*nu+c)*stride;
+            memcpy(o, row+c*4, stride*sizeof(GLfloat));
+            if(w<4 && stride==4)
+                o[3] = 1.0f;
+            if(nrm) {
+                GLfloat *p = row+c*4;
+                GLfloat *du = rdu+c*4;
+                GLfloat *dv = rdv+c*4;
+                if(w == 4) {
+                    du[0] = du[0]*p[3] - du[3]*p[0];
+                    du[1] = du[1]*p[3] - du[3]*p[1];
+                    du[2] = du[2]*p[3] - du[3]*p[2];
+                    dv[0] = dv[0]*p[3] - dv[3]*p[0];
+                    dv[1] = dv[1]*p[3] - dv[3]*p[1];
+                    dv[2] = dv[2]*p[3] - dv[3]*p[2];
+                }
+                GLfloat *n = nrm + (r*nu+c)*3;
+                cross3(du, dv, n);
+                vector_normalize(n);
+            }
+        }
+    }
+    free(bu);
+}
+
+// build the mesh in a renderlist, return NULL if there is nothing to draw
+static renderlist_t* em_build(int dims, GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2, map_statef_t **maps)
+{
+    const int nu = i2-i1+1;
+    const int nv = (dims==2)?(j2-j1+1):1;
+    int ilen = 0;
+    GLenum glmode;
+    switch (mode) {
+        case GL_POINT:
+            glmode = GL_POINTS;
+            break;
+        case GL_LINE:
+            glmode = GL_LINES;
+            ilen = nv*(nu-1)*2 + ((dims==2)?nu*(nv-1)*2:0);
+            break;
+        default:
+            glmode = GL_TRIANGLES;
+            ilen = (nu-1)*(nv-1)*6;
+    }
+    if(mode!=GL_POINT && ilen<=0)
+        return NULL;
+    const int len = nu*nv;
+    renderlist_t *list = alloc_renderlist();
+    list->mode = list->mode_init = glmode;
+    list->mode_dimension = rendermode_dimensions(glmode);
+    list->len = list->cap = len;
+    list->vert = (GLfloat*)malloc(len*4*sizeof(GLfloat));
+    if(maps[EM_COLOR])
+        list->color = (GLfloat*)malloc(len*4*sizeof(GLfloat));
+    if(maps[EM_NORMAL] || (dims==2 && glstate->enable.auto_normal))
+        list->normal = (GLfloat*)malloc(len*3*sizeof(GLfloat));
+    if(maps[EM_TEXTURE]) {
+        list->tex[0] = (GLfloat*)malloc(len*4*sizeof(GLfloat));
+        list->maxtex = 1;
+    }
+    if(maps[EM_COLOR])
+        em_eval(maps[EM_COLOR], dims, i1, nu, j1, nv, list->color, 4, NULL);
+    if(maps[EM_NORMAL])
+        em_eval(maps[EM_NORMAL], dims, i1, nu, j1, nv, list->normal, 3, NULL);
+    if(maps[EM_TEXTURE])
+        em_eval(maps[EM_TEXTURE], dims, i1, nu, j1, nv, list->tex[0], 4, NULL);
+    em_eval(maps[EM_VERTEX], dims, i1, nu, j1, nv, list->vert, 4, (maps[EM_NORMAL])?NULL:list->normal);
+    if(ilen) {
+        GLushort *ind = list->indices = (GLushort*)malloc(ilen*sizeof(GLushort));
+        list->ilen = list->indice_cap = ilen;
+        if(glmode==GL_TRIANGLES) {
+            // same triangles, in the same order, as a GL_TRIANGLE_STRIP per row
+            for (int r=0; r<nv-1; ++r)
+                for (int c=0; c<nu-1; ++c) {
+                    GLushort a = r*nu+c, b = a+nu;
+                    *(ind++) = a; *(ind++) = b; *(ind++) = a+1;
+                    *(ind++) = a+1; *(ind++) = b; *(ind++) = b+1;
+                }
+        } else {
+            for (int r=0; r<nv; ++r)
+                for (int c=0; c<nu-1; ++c) {
+                    *(ind++) = r*nu+c; *(ind++) = r*nu+c+1;
+                }
+            if(dims==2)
+                for (int c=0; c<nu; ++c)
+                    for (int r=0; r<nv-1; ++r) {
+                        *(ind++) = r*nu+c; *(ind++) = (r+1)*nu+c;
+                    }
+        }
+    }
+    return end_renderlist(list);
+}
+
+// draw the mesh from the cache (or build it), return 0 if the immediate mode path is needed
+static int em_draw(int dims, GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2)
+{
+    if(glstate->list.compiling || hardext.esversion==1)
+        return 0;
+    if(dims==1 && mode==GL_FILL)
+        return 0;
+    map_statef_t *maps[EM_MAX];
+    if(!em_getmaps(dims, maps))
+        return 0;
+    if(i2<i1 || (dims==2 && j2<j1))
+        return 1;   // nothing to draw
+    if((i2-i1+1)*((dims==2)?(j2-j1+1):1)>65535)
+        return 0;   // too big for GLushort indices
+    FLUSH_BEGINEND;
+    if(glstate->list.active)
+        return 0;
+    em_key_t key;
+    em_makekey(&key, dims, mode, i1, i2, j1, j2, maps);
+    em_entry_t *cached = em_find(&key);
+    renderlist_t *list = cached?cached->list:NULL;
+    if(!cached) {
+        list = em_build(dims, mode, i1, i2, j1, j2, maps);
+        if(!list)
+            return 1;
+        // the stipple texture coordinates are generated (and freed) on the list itself
+        int stipple = glstate->enable.line_stipple && mode==GL_LINE;
+        if(!stipple && em_seen(&key)) {
+            // drawn again, so it will be cached this time
+            cached = (em_entry_t*)calloc(1, sizeof(em_entry_t));
+            memcpy(&cached->key, &key, sizeof(em_key_t));
+            cached->list = list;
+            list->name = 1;     // so the arrays and indices go in VBOs
+            em_add(cached);
+        }
+    }
+    draw_renderlist(list);
+    if(list->color)
+        gl4es_glColor4f(glstate->color[0], glstate->color[1], glstate->color[2], glstate->color[3]);
+    if(!cached)
+        free_renderlist(list);
+    return 1;
+}
+
 void gl4es_glEvalMesh1(GLenum mode, GLint i1, GLint i2) {
-    GLenum renderMode = eval_mesh_prep(mode);
-    if (! renderMode) {
+    GLenum renderMode;
+    if (! eval_mesh_prep(mode, 1, &renderMode)) {
         errorShim(GL_INVALID_ENUM);
         return;
     }
     
     noerrorShim();
+    if (em_draw(1, mode, i1, i2, 0, 0))
+        return;
     GLfloat u, du, u1;
     du = glstate->map_grid[0].d;
     u1 = glstate->map_grid[0]._1 + du*i1;
@@ -260,13 +708,15 @@ void gl4es_glEvalMesh1(GLenum mode, GLint i1, GLint i2) {
 }
 
 void gl4es_glEvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2) {
-    GLenum renderMode = eval_mesh_prep(mode);
-    if (! renderMode) {
+    GLenum renderMode;
+    if (! eval_mesh_prep(mode, 2, &renderMode)) {
         errorShim(GL_INVALID_ENUM);
         return;
     }
     
     noerrorShim();
+    if (em_draw(2, mode, i1, i2, j1, j2))
+        return;
     GLfloat u, du, u1, v, dv, v1;
     du = glstate->map_grid[0].d;
     dv = glstate->map_grid[1].d;
@@ -291,13 +741,14 @@ void gl4es_glEvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2) {
             gl4es_glEnd();
         }
         if (mode == GL_LINE) {
-            gl4es_glBegin(renderMode);
+            // one strip per column
             for (u = u1, i = i1; i <= i2; i++, u += du) {
+                gl4es_glBegin(renderMode);
                 for (v = v1, j = j1; j <= j2; j++, v += dv) {
                     gl4es_glEvalCoord2f(u, v);
                 }
+                gl4es_glEnd();
             }
-            gl4es_glEnd();
         }
     }
 }
@@ -26,6 +26,9 @@ void gl4es_glGetMapdv(GLenum target, GLenum query, GLdouble *v);
 void gl4es_glGetMapfv(GLenum target, GLenum query, GLfloat *v);
 void gl4es_glGetMapiv(GLenum target, GLenum query, GLint *v);
 
+struct em_cache_s;
+void free_eval_cache(struct em_cache_s *cache);
+
 typedef struct {
     GLenum type;
 } map_state_t;
@@ -18,7 +18,7 @@ void gl4es_glFogfv(GLenum pname, const GLfloat* params) {
             }
         else gl4es_flush();
     noerrorShim();
-    #define GO(A,name, size) if(memcmp(A glstate->fog.name, params, size)==0) return; else memcpy(A glstate->fog.name, params, size);
+    #define GO(A,name, size) if(memcmp(A glstate->fog.name, params, size)==0) return; else {attrib_changed(GL_FOG_BIT); memcpy(A glstate->fog.name, params, size);}
     switch (pname) {
         case GL_FOG_MODE:
             GO(&, mode, sizeof(GLfloat))
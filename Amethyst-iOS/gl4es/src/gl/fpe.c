@@ -127,6 +127,9 @@ void fpe_ReleventState_DefaultVertex(fpe_state_t *dest, fpe_state_t *src, shader
         dest->pointsprite_upper = 0;
         dest->pointsprite_coord = 0;
     }
+    // line stipple is only emulated for the fixed pipeline fragment shader
+    dest->stipple = 0;
+    dest->stipple_tmu = 0;
     // ARB_vertex_program and ARB_fragment_program
     dest->vertex_prg_id = 0;    // it's a default vertex program...
     if(!dest->fragment_prg_enable)
@@ -224,6 +227,10 @@ void fpe_ReleventState(fpe_state_t *dest, fpe_state_t *src, int fixed)
         dest->pointsprite_upper = 0;
         dest->pointsprite_coord = 0;
     }
+    if(!fixed)
+        dest->stipple = 0;
+    if(!dest->stipple)
+        dest->stipple_tmu = 0;
     // ARB_vertex_program and ARB_fragment_program
     if(!fixed || !dest->vertex_prg_enable)
         dest->vertex_prg_id = 0;
@@ -257,14 +264,11 @@ int fpe_IsEmpty(fpe_state_t *state) {
     return 1;
 }
 
-uniform_t* findUniform(khash_t(uniformlist) *uniforms, const char* name)
+uniform_t* findUniform(program_t *glprogram, const char* name)
 {
-    uniform_t *m;
-    khint_t k;
-    kh_foreach(uniforms, k, m,
-        if(!strcmp(m->name, name))
-            return m;
-    )
+    for (int i=0; i<glprogram->num_location; i++)
+        if(!strcmp(glprogram->uniform[i].name, name))
+            return &glprogram->uniform[i];
     return NULL;
 
 }
@@ -344,11 +348,20 @@ void fpe_oldprogram(fpe_state_t* state) {
 void fpe_program(int ispoint) {
     glstate->fpe_state->point = ispoint;
     fpe_state_t state;
-    fpe_ReleventState(&state, glstate->fpe_state, 1);
-    if(glstate->fpe==NULL || memcmp(&glstate->fpe->state, &state, sizeof(fpe_state_t))) {
-        // get cached fpe (or new one)
-        glstate->fpe = fpe_GetCache(glstate->fpe_cache, &state, 1);
-    }   
+    if(glstate->fpe && glstate->fpe_last_fixed && !memcmp(&glstate->fpe_last, glstate->fpe_state, sizeof(fpe_state_t))) {
+        // nothing changed since last draw, no need to filter and lookup the state again
+        memcpy(&state, &glstate->fpe->state, sizeof(fpe_state_t));
+    } else {
+        fpe_ReleventState(&state, glstate->fpe_state, 1);
+        if(glstate->fpe==NULL || memcmp(&glstate->fpe->state, &state, sizeof(fpe_state_t))) {
+            // get cached fpe (or new one)
+            glstate->fpe = fpe_GetCache(glstate->fpe_cache, &state, 1);
+        }
+        memcpy(&glstate->fpe_last, glstate->fpe_state, sizeof(fpe_state_t));
+        glstate->fpe_last_glsl = NULL;
+        glstate->fpe_last_custom = NULL;
+        glstate->fpe_last_fixed = 1;
+    }
     if(glstate->fpe->glprogram==NULL) {
         glstate->fpe->prog = gl4es_glCreateProgram();
         DBG(int from_psa = 1;)
@@ -472,19 +485,16 @@ program_t* fpe_CustomShader(program_t* glprogram, fpe_state_t* state)
         }
         // adjust the uniforms to point to father cache...
         {
-            khash_t(uniformlist) *father_uniforms = glprogram->uniform;
-            khash_t(uniformlist) *uniforms = fpe->glprogram->uniform;
-            uniform_t *m, *n;
-            khint_t k;
-            kh_foreach(uniforms, k, m,
+            for (int i=0; i<fpe->glprogram->num_location; i++) {
+                uniform_t *m = &fpe->glprogram->uniform[i];
                 if(!m->builtin) {
-                    n = findUniform(father_uniforms, m->name);
+                    uniform_t *n = findUniform(glprogram, m->name);
                     if(n) {
                         m->parent_offs = n->cache_offs;
                         m->parent_size = n->cache_size;
                     }
                 }
-            )
+            }
         }
         // all done
         DBG(printf("creating FPE Custom Program : %d(%p)\n", fpe->prog, fpe->glprogram);)
@@ -550,19 +560,16 @@ program_t* fpe_CustomShader_DefaultVertex(program_t* glprogram, fpe_state_t* sta
         }
         // adjust the uniforms to point to father cache...
         {
-            khash_t(uniformlist) *father_uniforms = glprogram->uniform;
-            khash_t(uniformlist) *uniforms = fpe->glprogram->uniform;
-            uniform_t *m, *n;
-            khint_t k;
-            kh_foreach(uniforms, k, m,
+            for (int i=0; i<fpe->glprogram->num_location; i++) {
+                uniform_t *m = &fpe->glprogram->uniform[i];
                 if(!m->builtin) {
-                    n = findUniform(father_uniforms, m->name);
+                    uniform_t *n = findUniform(glprogram, m->name);
                     if(n) {
                         m->parent_offs = n->cache_offs;
                         m->parent_size = n->cache_size;
                     }
                 }
-            )
+            }
         }
         // all done
         DBG(printf("creating FPE Custom Program : %d(%p)\n", fpe->prog, fpe->glprogram);)
@@ -573,12 +580,10 @@ program_t* fpe_CustomShader_DefaultVertex(program_t* glprogram, fpe_state_t* sta
 
 void fpe_SyncUniforms(uniformcache_t *cache, program_t* glprogram) {
     //TODO: Optimize this...
-    khash_t(uniformlist) *uniforms = glprogram->uniform;
-    uniform_t *m;
-    khint_t k;
     DBG(int cnt = 0;)
     // don't use m->size, as each element has it's own uniform...
-    kh_foreach(uniforms, k, m,
+    for (int i=0; i<glprogram->num_location; i++) {
+        uniform_t *m = &glprogram->uniform[i];
         if(m->parent_size) {
             DBG(++cnt;)
             switch(m->type) {
@@ -586,7 +591,7 @@ void fpe_SyncUniforms(uniformcache_t *cache, program_t* glprogram) {
                 case GL_FLOAT_VEC2:
                 case GL_FLOAT_VEC3:
                 case GL_FLOAT_VEC4:
-                    GoUniformfv(glprogram, m->id, n_uniform(m->type), 1, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
+                    GoUniformfv(glprogram, i, n_uniform(m->type), 1, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
                     break;
                 case GL_SAMPLER_2D:
                 case GL_SAMPLER_CUBE:
@@ -598,22 +603,22 @@ void fpe_SyncUniforms(uniformcache_t *cache, program_t* glprogram) {
                 case GL_BOOL_VEC2:
                 case GL_BOOL_VEC3:
                 case GL_BOOL_VEC4:
-                    GoUniformiv(glprogram, m->id, n_uniform(m->type), 1, (GLint*)((uintptr_t)cache->cache+m->parent_offs));
+                    GoUniformiv(glprogram, i, n_uniform(m->type), 1, (GLint*)((uintptr_t)cache->cache+m->parent_offs));
                     break;
                 case GL_FLOAT_MAT2:
-                    GoUniformMatrix2fv(glprogram, m->id, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
+                    GoUniformMatrix2fv(glprogram, i, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
                     break;
                 case GL_FLOAT_MAT3:
-                    GoUniformMatrix3fv(glprogram, m->id, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
+                    GoUniformMatrix3fv(glprogram, i, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
                     break;
                 case GL_FLOAT_MAT4:
-                    GoUniformMatrix4fv(glprogram, m->id, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
+                    GoUniformMatrix4fv(glprogram, i, 1, false, (GLfloat*)((uintptr_t)cache->cache+m->parent_offs));
                     break;
                 default:
                     printf("LIBGL: Warning, sync uniform on father/son program with unknown uniform type %s\n", PrintEnum(m->type));
             }
         }
-    );
+    }
     DBG(printf("Uniform sync'd with %d and father (%d uniforms)\n", glprogram->id, cnt);)
 }
 // ********* Fixed Pipeling function wrapper *********
@@ -1055,26 +1060,38 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
     // activate program if needed
     if(glstate->glsl->program) {
         // but first, check if some fixedpipeline state (like GL_ALPHA_TEST) need to alter the original program
-        fpe_state_t state;
-        fpe_ReleventState(&state, glstate->fpe_state, 0);
         GLuint program = glstate->glsl->program;
         program_t *glprogram = glstate->glsl->glprogram;
-        if(glprogram->default_vertex) {
-            fpe_state_t vertex_state;
-            fpe_ReleventState_DefaultVertex(&vertex_state, glstate->fpe_state, glprogram->default_need);
-            if(!glprogram->fpe_cache)
-                glprogram->fpe_cache = fpe_NewCache();
-            glprogram = fpe_CustomShader_DefaultVertex(glprogram, &vertex_state);    // fetch from cache if exist or create it
-            program = glprogram->id;
-        } else if(!fpe_IsEmpty(&state))
-        {
-            // need to create a new program for that...
-            DBG(printf("GLSL program %d need customization => ", program);)
-            if(!glprogram->fpe_cache)
-                glprogram->fpe_cache = fpe_NewCache();
-            glprogram = fpe_CustomShader(glprogram, &state);    // fetch from cache if exist or create it
+        if(glstate->fpe_last_custom && glstate->fpe_last_glsl==glprogram && glstate->fpe_last_generation==glstate->glsl->generation
+         && !memcmp(&glstate->fpe_last, glstate->fpe_state, sizeof(fpe_state_t))) {
+            // same program and nothing changed since last draw, reuse the customized program
+            glprogram = glstate->fpe_last_custom;
             program = glprogram->id;
-            DBG(printf("%d\n", program);)
+        } else {
+            fpe_state_t state;
+            fpe_ReleventState(&state, glstate->fpe_state, 0);
+            memcpy(&glstate->fpe_last, glstate->fpe_state, sizeof(fpe_state_t));
+            glstate->fpe_last_glsl = glprogram;
+            glstate->fpe_last_generation = glstate->glsl->generation;
+            glstate->fpe_last_fixed = 0;
+            if(glprogram->default_vertex) {
+                fpe_state_t vertex_state;
+                fpe_ReleventState_DefaultVertex(&vertex_state, glstate->fpe_state, glprogram->default_need);
+                if(!glprogram->fpe_cache)
+                    glprogram->fpe_cache = fpe_NewCache();
+                glprogram = fpe_CustomShader_DefaultVertex(glprogram, &vertex_state);    // fetch from cache if exist or create it
+                program = glprogram->id;
+            } else if(!fpe_IsEmpty(&state))
+            {
+                // need to create a new program for that...
+                DBG(printf("GLSL program %d need customization => ", program);)
+                if(!glprogram->fpe_cache)
+                    glprogram->fpe_cache = fpe_NewCache();
+                glprogram = fpe_CustomShader(glprogram, &state);    // fetch from cache if exist or create it
+                program = glprogram->id;
+                DBG(printf("%d\n", program);)
+            }
+            glstate->fpe_last_custom = glprogram;
         }
         if(glstate->gleshard->program != program)
         {
@@ -1126,6 +1143,7 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
             //gles_glFramebufferTexture2D(GL_FRAMEBUFFER, tex->binded_attachment, GL_TEXTURE_2D, 0, 0);
             gles_glBindFramebuffer(GL_FRAMEBUFFER, 0);
             gles_glBindFramebuffer(GL_FRAMEBUFFER, glstate->fbo.current_fb->id);
+            glstate->fbo.real_fb = glstate->fbo.current_fb->id;
             //gles_glFramebufferTexture2D(GL_FRAMEBUFFER, tex->binded_attachment, GL_TEXTURE_2D, tex->glname, 0);
         }
     }
@@ -1138,10 +1156,8 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP], 1, GL_FALSE, getMVPMat());
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_T], 1, GL_TRUE, getMVPMat());
             if(glprogram->builtin_matrix[MAT_MVP_I]!=-1 || glprogram->builtin_matrix[MAT_MVP_IT]!=-1) {
-                GLfloat invmat[16];
-                matrix_inverse(getMVPMat(), invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_I], 1, GL_FALSE, invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_IT], 1, GL_TRUE, invmat);
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_I], 1, GL_FALSE, getInvMVPMat());
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_MVP_IT], 1, GL_TRUE, getInvMVPMat());
             }
         }
         if(glprogram->builtin_matrix[MAT_MV]!=-1 || glprogram->builtin_matrix[MAT_MV_I]!=-1
@@ -1160,10 +1176,8 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P], 1, GL_FALSE, getPMat());
             GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_T], 1, GL_TRUE, getPMat());
             if(glprogram->builtin_matrix[MAT_P_I]!=-1 || glprogram->builtin_matrix[MAT_P_IT]!=-1) {
-                GLfloat invmat[16];
-                matrix_inverse(getPMat(), invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_I], 1, GL_FALSE, invmat);
-                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_IT], 1, GL_TRUE, invmat);
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_I], 1, GL_FALSE, getInvPMat());
+                GoUniformMatrix4fv(glprogram, glprogram->builtin_matrix[MAT_P_IT], 1, GL_TRUE, getInvPMat());
             }
         }
         //Normal matrix (mat3 version of transpose(inverse(gl_ModelViewMatrix)))
@@ -1203,89 +1217,49 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
             }
         }
     }
-    // set light and material if needed
-    if(glprogram->has_builtin_light)
+    // set light and material if needed, only when they changed since this program last got them
+    if(glprogram->has_builtin_light && glprogram->light_generation!=glstate->light.generation)
     {
+        const lightblock_t *lb = light_GetBlock();
         for (int i=0; i<MAX_LIGHT; i++) {
             if(glprogram->builtin_lights[i].has) {
-               GLfloat tmp[4];
                GoUniformfv(glprogram, glprogram->builtin_lights[i].ambient, 4, 1, glstate->light.lights[i].ambient);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].diffuse, 4, 1, glstate->light.lights[i].diffuse);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].specular, 4, 1, glstate->light.lights[i].specular);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].position, 4, 1, glstate->light.lights[i].position);
-               if(glprogram->builtin_lights[i].halfVector!=-1) { // not sure of this, isn't gl_Vertex need to be used at some point?
-                GLfloat tmp[4];
-                memcpy(tmp, glstate->light.lights[i].position, 4*sizeof(GLfloat));
-                vector4_normalize(tmp);
-                if(!glstate->light.local_viewer) {
-                    tmp[2]+=1.f;
-                    vector4_normalize(tmp);
-                }
-                GoUniformfv(glprogram, glprogram->builtin_lights[i].halfVector, 1, 1, tmp);
-               }
+               GoUniformfv(glprogram, glprogram->builtin_lights[i].halfVector, 4, 1, lb->halfVector[i]);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].spotDirection, 3, 1, glstate->light.lights[i].spotDirection);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].spotExponent, 1, 1, &glstate->light.lights[i].spotExponent);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].spotCutoff, 1, 1, &glstate->light.lights[i].spotCutoff);
-               if(!memcmp(&glprogram->builtin_lights[i].oldspotCutoff, &glstate->light.lights[i].spotCutoff, sizeof(GLfloat)))
-               {
-                    memcpy(&glprogram->builtin_lights[i].oldspotCutoff, &glstate->light.lights[i].spotCutoff, sizeof(GLfloat));
-                    glprogram->builtin_lights[i].oldspotCosCutoff = cosf(glstate->light.lights[i].spotCutoff*3.1415926535f/180.0f);
-               }
-               GoUniformfv(glprogram, glprogram->builtin_lights[i].spotCosCutoff, 1, 1, &glprogram->builtin_lights[i].oldspotCosCutoff);
+               GoUniformfv(glprogram, glprogram->builtin_lights[i].spotCosCutoff, 1, 1, &lb->spotCosCutoff[i]);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].constantAttenuation, 1, 1, &glstate->light.lights[i].constantAttenuation);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].linearAttenuation, 1, 1, &glstate->light.lights[i].linearAttenuation);
                GoUniformfv(glprogram, glprogram->builtin_lights[i].quadraticAttenuation, 1, 1, &glstate->light.lights[i].quadraticAttenuation);
             }
-            if(glprogram->builtin_lightprod[0][i].has) {
-                GLfloat tmp[4];
-                vector4_mult(glstate->material.front.ambient, glstate->light.lights[i].ambient, tmp); //TODO: Check that
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[0][i].ambient, 4, 1, tmp);
-                vector4_mult(glstate->material.front.diffuse, glstate->light.lights[i].diffuse, tmp);
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[0][i].diffuse, 4, 1, tmp);
-                vector4_mult(glstate->material.front.specular, glstate->light.lights[i].specular, tmp);
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[0][i].specular, 4, 1, tmp);
-            }
-            if(glprogram->builtin_lightprod[1][i].has) {
-                GLfloat tmp[4];
-                vector4_mult(glstate->material.back.ambient, glstate->light.lights[i].ambient, tmp); //TODO: Check that
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[1][i].ambient, 4, 1, tmp);
-                vector4_mult(glstate->material.back.diffuse, glstate->light.lights[i].diffuse, tmp);
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[1][i].diffuse, 4, 1, tmp);
-                vector4_mult(glstate->material.back.specular, glstate->light.lights[i].specular, tmp);
-                GoUniformfv(glprogram, glprogram->builtin_lightprod[1][i].specular, 4, 1, tmp);
-            }
+            for (int j=0; j<2; j++)
+                if(glprogram->builtin_lightprod[j][i].has) {
+                    GoUniformfv(glprogram, glprogram->builtin_lightprod[j][i].ambient, 4, 1, lb->lightprod[j][i][0]);
+                    GoUniformfv(glprogram, glprogram->builtin_lightprod[j][i].diffuse, 4, 1, lb->lightprod[j][i][1]);
+                    GoUniformfv(glprogram, glprogram->builtin_lightprod[j][i].specular, 4, 1, lb->lightprod[j][i][2]);
+                }
         }
         if(glprogram->builtin_lightmodel.ambient!=-1) {
             GoUniformfv(glprogram, glprogram->builtin_lightmodel.ambient, 4, 1, glstate->light.ambient);
         }
-        if(glprogram->builtin_material[0].has) {
-            GoUniformfv(glprogram, glprogram->builtin_material[0].emission, 4, 1, glstate->material.front.emission);
-            GoUniformfv(glprogram, glprogram->builtin_material[0].ambient, 4, 1, glstate->material.front.ambient);
-            GoUniformfv(glprogram, glprogram->builtin_material[0].diffuse, 4, 1, glstate->material.front.diffuse);
-            GoUniformfv(glprogram, glprogram->builtin_material[0].specular, 4, 1, glstate->material.front.specular);
-            GoUniformfv(glprogram, glprogram->builtin_material[0].shininess, 1, 1, &glstate->material.front.shininess);
-            GoUniformfv(glprogram, glprogram->builtin_material[0].alpha, 1, 1, &glstate->material.front.diffuse[3]);
-        }
-        if(glprogram->builtin_material[1].has) {
-            GoUniformfv(glprogram, glprogram->builtin_material[1].emission, 4, 1, glstate->material.back.emission);
-            GoUniformfv(glprogram, glprogram->builtin_material[1].ambient, 4, 1, glstate->material.back.ambient);
-            GoUniformfv(glprogram, glprogram->builtin_material[1].diffuse, 4, 1, glstate->material.back.diffuse);
-            GoUniformfv(glprogram, glprogram->builtin_material[1].specular, 4, 1, glstate->material.back.specular);
-            GoUniformfv(glprogram, glprogram->builtin_material[1].shininess, 1, 1, &glstate->material.back.shininess);
-            GoUniformfv(glprogram, glprogram->builtin_material[1].alpha, 1, 1, &glstate->material.back.diffuse[3]);
-        }
-        if(glprogram->builtin_lightmodelprod[0].sceneColor!=-1) {
-            GLfloat tmp[4];
-            vector4_mult(glstate->material.front.ambient, glstate->light.ambient, tmp);  //TODO: check that
-            vector4_add(tmp, glstate->material.front.emission, tmp);
-            GoUniformfv(glprogram, glprogram->builtin_lightmodelprod[0].sceneColor, 4, 1, tmp);
-        }
-        if(glprogram->builtin_lightmodelprod[1].sceneColor!=-1) {
-            GLfloat tmp[4];
-            vector4_mult(glstate->material.back.ambient, glstate->light.ambient, tmp);  //TODO: check that
-            vector4_add(tmp, glstate->material.back.emission, tmp);
-            GoUniformfv(glprogram, glprogram->builtin_lightmodelprod[1].sceneColor, 4, 1, tmp);
+        const material_t* mat[2] = {&glstate->material.front, &glstate->material.back};
+        for (int j=0; j<2; j++) {
+            if(glprogram->builtin_material[j].has) {
+                GoUniformfv(glprogram, glprogram->builtin_material[j].emission, 4, 1, mat[j]->emission);
+                GoUniformfv(glprogram, glprogram->builtin_material[j].ambient, 4, 1, mat[j]->ambient);
+                GoUniformfv(glprogram, glprogram->builtin_material[j].diffuse, 4, 1, mat[j]->diffuse);
+                GoUniformfv(glprogram, glprogram->builtin_material[j].specular, 4, 1, mat[j]->specular);
+                GoUniformfv(glprogram, glprogram->builtin_material[j].shininess, 1, 1, &mat[j]->shininess);
+                GoUniformfv(glprogram, glprogram->builtin_material[j].alpha, 1, 1, &mat[j]->diffuse[3]);
+            }
+            if(glprogram->builtin_lightmodelprod[j].sceneColor!=-1)
+                GoUniformfv(glprogram, glprogram->builtin_lightmodelprod[j].sceneColor, 4, 1, lb->sceneColor[j]);
         }
+        glprogram->light_generation = glstate->light.generation;
     }
     // Instance ID
     if(glprogram->builtin_instanceID!=-1)
@@ -1428,10 +1402,7 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
                     if(type==0) {
                         imin = first; imax = count;
                     } else {
-                        if(type==GL_UNSIGNED_INT)
-                            getminmax_indices_ui(indices, &imax, &imin, count);
-                        else
-                            getminmax_indices_us(indices, &imax, &imin, count);
+                        getminmax_indices_buffer(glstate->vao->elements, type, indices, &imax, &imin, count);
                         ++imax;
                     }
                     if(w->size==GL_BGRA) {
@@ -1517,17 +1488,19 @@ void realize_glenv(int ispoint, int first, int count, GLenum type, const void* i
     }
     if(old_buffer)
         gles_glBindBuffer(GL_ARRAY_BUFFER, 0);
-
+    // send all the uniforms changed since last draw
+    FlushUniforms(glprogram);
 }
 
-void realize_blitenv(int alpha) {
-    DBG(printf("realize_blitenv(%d)\n", alpha);)
+void realize_blitenv(GLuint program, GLuint buffer, const GLfloat* vert, const GLfloat* tex) {
+    DBG(printf("realize_blitenv(%u, %u, %p, %p)\n", program, buffer, vert, tex);)
     LOAD_GLES2(glUseProgram);
-    if(glstate->gleshard->program != ((alpha)?glstate->blit->program_alpha:glstate->blit->program)) {
-        glstate->gleshard->program = ((alpha)?glstate->blit->program_alpha:glstate->blit->program);
+    if(glstate->gleshard->program != program) {
+        glstate->gleshard->program = program;
         gles_glUseProgram(glstate->gleshard->program);
     }
     // set VertexAttrib if needed
+    int bound = 0;
     for(int i=0; i<hardext.maxvattrib; i++) {
         vertexattrib_t *v = &glstate->gleshard->vertexattrib[i];
         // enable / disable Array if needed
@@ -1542,22 +1515,32 @@ void realize_blitenv(int alpha) {
         }
         // check if new value has to be sent to hardware
         if(i<2) {
-            // array case
+            // array case, vert and tex are offsets in buffer if there is one
             if(v->size!=2 || v->type!=GL_FLOAT || v->normalized!=0 
-                || v->stride!=0 || v->pointer!=((i==0)?glstate->blit->vert:glstate->blit->tex) 
-                || v->buffer!=0) {
+                || v->stride!=0 || v->pointer!=((i==0)?vert:tex) 
+                || v->buffer!=0 || v->real_buffer!=buffer) {
                 v->size = 2;
                 v->type = GL_FLOAT;
                 v->normalized = 0;
                 v->stride = 0;
-                v->pointer = ((i==0)?glstate->blit->vert:glstate->blit->tex);
+                v->pointer = ((i==0)?vert:tex);
                 v->buffer = 0;
-                v->real_buffer = 0;
+                v->real_buffer = buffer;
+                v->real_pointer = (buffer)?v->pointer:0;
+                if(buffer && !bound) {
+                    LOAD_GLES(glBindBuffer);
+                    gles_glBindBuffer(GL_ARRAY_BUFFER, buffer);
+                    bound = 1;
+                }
                 LOAD_GLES2(glVertexAttribPointer);
                 gles_glVertexAttribPointer(i, v->size, v->type, v->normalized, v->stride, v->pointer);
             }
         }
     }
+    if(bound) {
+        LOAD_GLES(glBindBuffer);
+        gles_glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 }
 
 // ********* Builtin GL Uniform, VertexAttrib and co *********
@@ -1580,6 +1563,7 @@ void builtin_Init(program_t *glprogram) {
         glprogram->builtin_lights[i].linearAttenuation = -1;
         glprogram->builtin_lights[i].quadraticAttenuation = -1;
     }
+    glprogram->light_generation = 0;    // the light uniforms need to be set
     glprogram->builtin_lightmodel.ambient = -1;
     for (int i=0; i<2; i++) { // 0:Front, 1:Back
         glprogram->builtin_material[i].emission = -1;
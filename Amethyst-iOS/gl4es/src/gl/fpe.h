@@ -183,6 +183,8 @@ typedef struct fpe_state_s {
     unsigned int pointsprite:1;          // point sprite rendering
     unsigned int pointsprite_coord:1;    // point sprite coord replace
     unsigned int pointsprite_upper:1;    // if coord is upper left and not lower left
+    unsigned int stipple:1;              // line stipple, tested in the fragment shader
+    unsigned int stipple_tmu:4;          // TMU carrying the stipple distance
     unsigned int vertex_prg_enable:1;    // if vertex program is enabled
     unsigned int fragment_prg_enable:1;  // if fragment program is enabled
     uint16_t     vertex_prg_id;          // Id of vertex program currently binded (0 most of the time), 16bits is more than enough...
@@ -247,6 +249,6 @@ int builtin_CheckUniform(program_t *glprogram, char* name, GLint id, int size);
 int builtin_CheckVertexAttrib(program_t *glprogram, char* name, GLint id);
 
 void realize_glenv(int ispoint, int first, int count, GLenum type, const void* indices, scratch_t* scratch);
-void realize_blitenv(int alpha);
+void realize_blitenv(GLuint program, GLuint buffer, const GLfloat* vert, const GLfloat* tex);
 
 #endif // _GL4ES_FPE_H_
@@ -1,5 +1,10 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
+#if !defined(AMIGAOS4) && !defined(__EMSCRIPTEN__)
+#define PSA_THREAD
+#include <pthread.h>
+#endif
 
 #include "../glx/hardext.h"
 #include "init.h"
@@ -22,10 +27,20 @@ static const char PSA_SIGN[] = "GL4ES PrecompiledShaderArchive";
 
 static kh_inline khint_t _hash_fpe(fpe_state_t *p)
 {
-    const char* s = (const char*)p;
-	khint_t h = (khint_t)*s;
-	for (int i=1 ; i<sizeof(fpe_state_t); ++i) h = (h << 5) - h + (khint_t)*(++s);
-	return h;
+    // 64bits FNV-1a, 8 bytes at a time (fpe_state_t is a few hundred bytes)
+    const uint8_t* s = (const uint8_t*)p;
+    int size = sizeof(fpe_state_t);
+    uint64_t h = 0xcbf29ce484222325ULL;
+    while(size>=8) {
+        uint64_t v;
+        memcpy(&v, s, 8);
+        h = (h^v)*0x100000001b3ULL;
+        h ^= h>>29;
+        s+=8; size-=8;
+    }
+    while(size--)
+        h = (h^*(s++))*0x100000001b3ULL;
+    return (khint_t)(h^(h>>32));
 }
 
 #define kh_fpe_hash_func(key) _hash_fpe(key)
@@ -73,25 +88,93 @@ fpe_fpe_t *fpe_GetCache(fpe_cache_t *cur, fpe_state_t *state, int fixed) {
     }
 }
 
+// Precompiled Shader Archive
+// The file is a header (signature, version, sizeof(fpe_state_t), number of records) followed by the records
+// (state, binary format, binary size, binary). At load, only the states are read and the binaries are read
+// on first use. New programs are appended to the file (by a background thread if possible), and the number
+// of records in the header is updated after each one, so an interrupted write only loses the last program.
+// A state can be in the file more than once (the last one wins), the file is compacted when that waste
+// becomes too large.
 typedef struct psa_s {
     fpe_state_t state;
     GLenum      format;
     int         size;
-    void*       prog;
+    void*       prog;   // NULL until read from the file
+    long        offs;   // offset of the binary in the file, or -1 if not written yet
 } psa_t;
 
 KHASH_MAP_INIT_FPE(psalist, psa_t *);
 
-// Precompiled Shader Archive
+#define PSA_COUNT_OFFS  (sizeof(PSA_SIGN)+2*sizeof(int))
+
+typedef struct psa_record_s {
+    struct psa_record_s *next;
+    int         size;   // size of data
+    char        data[]; // the record as saved in the file
+} psa_record_t;
+
 typedef struct gl4es_psa_s {
     int             size;
-    int             dirty;
-    kh_psalist_t*   cache;    
+    int             records;    // number of records in the file (including overriden ones)
+    int             valid;      // file exists and is compatible, else it will be recreated on first write
+    long            end;        // end of the last record in the file, anything after it is from an interrupted write
+    FILE*           file;       // opened for reading the binaries
+    kh_psalist_t*   cache;
+#ifdef PSA_THREAD
+    pthread_t       writer;
+    int             writer_started;
+    int             writer_stop;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_cond_t  idle;
+    int             writing;
+#endif
+    psa_record_t*   queue;      // records waiting to be appended
+    psa_record_t*   queue_last;
+    FILE*           wfile;      // opened for appending records (only used by the writer)
 } gl4es_psa_t;
 
 static gl4es_psa_t *psa = NULL;
 static char *psa_name = NULL;
 
+static int psa_readheader(FILE* f, int* n)
+{
+    char tmp[sizeof(PSA_SIGN)];
+    int version = 0, sz_fpe = 0;
+    if(fread(tmp, sizeof(PSA_SIGN), 1, f)!=1 || strcmp(tmp, PSA_SIGN)!=0)
+        return 0;   // too short or bad signature
+    if(fread(&version, sizeof(version), 1, f)!=1 || version!=CACHE_VERSION)
+        return 0;   // unsupported version
+    if(fread(&sz_fpe, sizeof(sz_fpe), 1, f)!=1 || sz_fpe!=sizeof(fpe_state_t))
+        return 0;   // maybe try to adapt instead?
+    if(fread(n, sizeof(*n), 1, f)!=1 || *n<0)
+        return 0;
+    return 1;
+}
+
+static int psa_writeheader(FILE* f, int n)
+{
+    int version = CACHE_VERSION;
+    int sz_fpe = sizeof(fpe_state_t);
+    return fwrite(PSA_SIGN, sizeof(PSA_SIGN), 1, f)==1
+        && fwrite(&version, sizeof(version), 1, f)==1
+        && fwrite(&sz_fpe, sizeof(sz_fpe), 1, f)==1
+        && fwrite(&n, sizeof(n), 1, f)==1;
+}
+
+static void psa_put(psa_t* p)
+{
+    int ret;
+    khint_t k = kh_put(psalist, psa->cache, &p->state, &ret);
+    if(!ret) {
+        psa_t *p2 = kh_value(psa->cache, k);
+        kh_key(psa->cache, k) = &p->state;
+        free(p2->prog);
+        free(p2);
+    }
+    kh_value(psa->cache, k) = p;
+    psa->size = kh_size(psa->cache);
+}
 
 void fpe_readPSA()
 {
@@ -100,119 +183,207 @@ void fpe_readPSA()
     FILE *f = fopen(psa_name, "rb");
     if(!f)
         return;
-    char tmp[sizeof(PSA_SIGN)];
-    if(fread(tmp, sizeof(PSA_SIGN), 1, f)!=1) {
-        fclose(f);
-        return; //to short
-    }
-    if(strcmp(tmp, PSA_SIGN)!=0) {
-        fclose(f);
-        return; // bad signature
-    }
-    int version = 0;
-    if(fread(&version, sizeof(version), 1, f)!=1) {
-        fclose(f);
-        return;
-    }
-    if(version!=CACHE_VERSION) {
-        fclose(f);
-        return; // unsupported version
-    }
-    int sz_fpe = 0;
-    if(fread(&sz_fpe, sizeof(sz_fpe), 1, f)!=1) {
-        fclose(f);
-        return;
-    }
-    if(sz_fpe!=sizeof(fpe_state_t)) {
-        fclose(f);
-        return; // maybe try to adapt instead?
-    }
     int n = 0;
-    if(fread(&n, sizeof(n), 1, f)!=1) {
+    if(!psa_readheader(f, &n)) {
         fclose(f);
         return;
     }
-    for (int i=0; i<n; ++i) {
+    // only read the states, the binaries are skipped and read when needed
+    // unbuffered, because buffering would read most of the binaries anyway
+    setvbuf(f, NULL, _IONBF, 0);
+    char head[sizeof(fpe_state_t)+sizeof(GLenum)+sizeof(int)];
+    long offs = ftell(f);
+    int i;
+    for (i=0; i<n; ++i) {
+        if(fread(head, sizeof(head), 1, f)!=1)
+            break;
         psa_t *p = (psa_t*)calloc(1, sizeof(psa_t));
-        if(fread(&p->state, sizeof(p->state), 1, f)!=1) {
+        memcpy(&p->state, head, sizeof(p->state));
+        memcpy(&p->format, head+sizeof(p->state), sizeof(p->format));
+        memcpy(&p->size, head+sizeof(p->state)+sizeof(p->format), sizeof(p->size));
+        p->offs = offs+sizeof(head);
+        if(p->size<=0 || fseek(f, p->size, SEEK_CUR)) {
             free(p);
-            fclose(f);
-            return;
+            break;
         }
-        if(fread(&p->format, sizeof(p->format), 1, f)!=1) {
-            free(p);
-            fclose(f);
-            return;
+        offs = p->offs+p->size;
+        psa_put(p);
+    }
+    psa->records = i;
+    psa->end = offs;
+    psa->valid = (i==n);    // a truncated file will be recreated
+    if(psa->valid)
+        psa->file = f;
+    else
+        fclose(f);
+    SHUT_LOGD("Loaded a PSA with %d Precompiled Programs\n", psa->size);
+}
+
+// append a record at the end of the file, and update the number of records
+static void psa_append(psa_record_t* r)
+{
+    if(!psa->wfile) {
+        if(psa->valid)
+            psa->wfile = fopen(psa_name, "r+b");
+        if(!psa->wfile) {
+            // new (or incompatible) file
+            psa->wfile = fopen(psa_name, "w+b");
+            if(!psa->wfile)
+                return;
+            psa->records = 0;
+            if(!psa_writeheader(psa->wfile, 0) || fflush(psa->wfile) || (psa->end=ftell(psa->wfile))<0) {
+                fclose(psa->wfile);
+                psa->wfile = NULL;
+                return;
+            }
         }
-        if(fread(&p->size, sizeof(p->size), 1, f)!=1) {
-            free(p);
-            fclose(f);
-            return;
+    }
+    FILE* f = psa->wfile;
+    if(fseek(f, psa->end, SEEK_SET) || fwrite(r->data, r->size, 1, f)!=1 || fflush(f))
+        return;
+    int n = psa->records+1;
+    if(fseek(f, PSA_COUNT_OFFS, SEEK_SET) || fwrite(&n, sizeof(n), 1, f)!=1 || fflush(f))
+        return;
+    psa->records = n;
+    psa->end += r->size;
+}
+
+#ifdef PSA_THREAD
+static void* psa_writer(void* arg)
+{
+    pthread_mutex_lock(&psa->lock);
+    while(1) {
+        while(!psa->queue && !psa->writer_stop)
+            pthread_cond_wait(&psa->wake, &psa->lock);
+        if(!psa->queue)
+            break;  // stop, and nothing left to write
+        psa_record_t *r = psa->queue;
+        psa->queue = r->next;
+        if(!psa->queue)
+            psa->queue_last = NULL;
+        psa->writing = 1;
+        pthread_mutex_unlock(&psa->lock);
+        psa_append(r);
+        free(r);
+        pthread_mutex_lock(&psa->lock);
+        psa->writing = 0;
+        if(!psa->queue)
+            pthread_cond_broadcast(&psa->idle);
+    }
+    pthread_mutex_unlock(&psa->lock);
+    return NULL;
+}
+#endif
+
+static void psa_queue(psa_t* p)
+{
+    // the record is copied, so the psa_t can be freed while it's waiting
+    int size = sizeof(p->state)+sizeof(p->format)+sizeof(p->size)+p->size;
+    psa_record_t *r = (psa_record_t*)malloc(sizeof(psa_record_t)+size);
+    r->next = NULL;
+    r->size = size;
+    char* d = r->data;
+    memcpy(d, &p->state, sizeof(p->state)); d+=sizeof(p->state);
+    memcpy(d, &p->format, sizeof(p->format)); d+=sizeof(p->format);
+    memcpy(d, &p->size, sizeof(p->size)); d+=sizeof(p->size);
+    memcpy(d, p->prog, p->size);
+#ifdef PSA_THREAD
+    if(globals4es.threads) {
+        pthread_mutex_lock(&psa->lock);
+        if(!psa->writer_started) {
+            psa->writer_started = (pthread_create(&psa->writer, NULL, psa_writer, NULL)==0)?1:-1;
         }
-        p->prog = malloc(p->size);
-        if(fread(p->prog, p->size, 1, f)!=1) {
-            free(p->prog);
-            free(p);
-            fclose(f);
+        if(psa->writer_started==1) {
+            if(psa->queue_last)
+                psa->queue_last->next = r;
+            else
+                psa->queue = r;
+            psa->queue_last = r;
+            pthread_cond_signal(&psa->wake);
+            pthread_mutex_unlock(&psa->lock);
             return;
         }
-        int ret;
-        khint_t k = kh_put(psalist, psa->cache, &p->state, &ret);
-        kh_value(psa->cache, k) = p;
-        psa->size = kh_size(psa->cache);
+        pthread_mutex_unlock(&psa->lock);
     }
-    fclose(f);
-    SHUT_LOGD("Loaded a PSA with %d Precompiled Programs\n", psa->size);
+#endif
+    psa_append(r);
+    free(r);
+}
+
+// wait for the writer to have written everything
+static void psa_flush()
+{
+#ifdef PSA_THREAD
+    pthread_mutex_lock(&psa->lock);
+    while(psa->queue || psa->writing)
+        pthread_cond_wait(&psa->idle, &psa->lock);
+    pthread_mutex_unlock(&psa->lock);
+#endif
+}
+
+static int psa_loadprog(psa_t* p)
+{
+    if(p->prog)
+        return 1;
+    if(p->offs<0 || !psa->file)
+        return 0;
+    p->prog = malloc(p->size);
+    if(fseek(psa->file, p->offs, SEEK_SET) || fread(p->prog, p->size, 1, psa->file)!=1) {
+        free(p->prog);
+        p->prog = NULL;
+        return 0;
+    }
+    return 1;
 }
 
 void fpe_writePSA()
 {
+    // the programs are saved when they are added, just finish that, and compact the file if too much of it is wasted
     if(!psa || !psa_name)
         return;
-    if(!psa->dirty)
-        return; // no need
-    FILE *f = fopen(psa_name, "wb");
-    if(!f)
-        return;
-    if(fwrite(PSA_SIGN, sizeof(PSA_SIGN), 1, f)!=1) {
-        fclose(f);
-        return; //to short
-    }
-    int version = CACHE_VERSION;
-    if(fwrite(&version, sizeof(version), 1, f)!=1) {
-        fclose(f);
-        return;
-    }
-    int sz_fpe = sizeof(fpe_state_t);
-    if(fwrite(&sz_fpe, sizeof(sz_fpe), 1, f)!=1) {
-        fclose(f);
+    psa_flush();
+    if(psa->records<=psa->size*2 || psa->records<64)
         return;
-    }
-    if(fwrite(&psa->size, sizeof(psa->size), 1, f)!=1) {
-        fclose(f);
+    char *tmpname = (char*)malloc(strlen(psa_name)+5);
+    strcpy(tmpname, psa_name);
+    strcat(tmpname, ".tmp");
+    FILE *f = fopen(tmpname, "wb");
+    if(!f) {
+        free(tmpname);
         return;
     }
+    int ok = psa_writeheader(f, 0);
+    int n = 0;
     psa_t *p;
-    kh_foreach_value(psa->cache, p, 
-        if(fwrite(&p->state, sizeof(p->state), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(&p->format, sizeof(p->format), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(&p->size, sizeof(p->size), 1, f)!=1) {
-            fclose(f);
-            return;
-        }
-        if(fwrite(p->prog, p->size, 1, f)!=1) {
-            fclose(f);
-            return;
+    long end = 0;
+    ok = ok && (end=ftell(f))>0;
+    kh_foreach_value(psa->cache, p,
+        if(ok && psa_loadprog(p)) {
+            ok = fwrite(&p->state, sizeof(p->state), 1, f)==1
+              && fwrite(&p->format, sizeof(p->format), 1, f)==1
+              && fwrite(&p->size, sizeof(p->size), 1, f)==1
+              && fwrite(p->prog, p->size, 1, f)==1;
+            end += sizeof(p->state)+sizeof(p->format)+sizeof(p->size)+p->size;
+            ++n;
         }
     );
-    fclose(f);
-    SHUT_LOGD("Saved a PSA with %d Precompiled Programs\n", psa->size);
+    ok = ok && fseek(f, PSA_COUNT_OFFS, SEEK_SET)==0 && fwrite(&n, sizeof(n), 1, f)==1;
+    if(fclose(f) || !ok) {
+        remove(tmpname);
+        free(tmpname);
+        return;
+    }
+    if(psa->wfile) {
+        fclose(psa->wfile);
+        psa->wfile = NULL;
+    }
+    if(rename(tmpname, psa_name)==0) {
+        SHUT_LOGD("Compacted the PSA from %d to %d records\n", psa->records, n);
+        psa->records = n;
+        psa->end = end;
+        psa->valid = 1;
+    }
+    free(tmpname);
 }
 
 void fpe_InitPSA(const char* name)
@@ -221,6 +392,11 @@ void fpe_InitPSA(const char* name)
         return; // already inited
     psa = (gl4es_psa_t*)calloc(1, sizeof(gl4es_psa_t));
     psa->cache = kh_init(psalist);
+#ifdef PSA_THREAD
+    pthread_mutex_init(&psa->lock, NULL);
+    pthread_cond_init(&psa->wake, NULL);
+    pthread_cond_init(&psa->idle, NULL);
+#endif
     psa_name = strdup(name);
 }
 
@@ -228,6 +404,27 @@ void fpe_FreePSA()
 {
     if(!psa)
         return; // nothing to init
+#ifdef PSA_THREAD
+    if(psa->writer_started==1) {
+        pthread_mutex_lock(&psa->lock);
+        psa->writer_stop = 1;
+        pthread_cond_signal(&psa->wake);
+        pthread_mutex_unlock(&psa->lock);
+        pthread_join(psa->writer, NULL);
+    }
+    pthread_mutex_destroy(&psa->lock);
+    pthread_cond_destroy(&psa->wake);
+    pthread_cond_destroy(&psa->idle);
+#endif
+    while(psa->queue) {
+        psa_record_t *r = psa->queue;
+        psa->queue = r->next;
+        free(r);
+    }
+    if(psa->wfile)
+        fclose(psa->wfile);
+    if(psa->file)
+        fclose(psa->file);
     
     psa_t *m;
     kh_foreach_value(psa->cache, m, 
@@ -253,6 +450,8 @@ int fpe_GetProgramPSA(GLuint program, fpe_state_t* state)
     if(k==kh_end(psa->cache))
         return 0; // not here
     psa_t *p = kh_value(psa->cache, k);
+    if(!psa_loadprog(p))
+        return 0; // the file is not usable anymore
     // try to load...
     return gl4es_useProgramBinary(program, p->size, p->format, p->prog);
 }
@@ -264,9 +463,9 @@ void fpe_AddProgramPSA(GLuint program, fpe_state_t* state)
     // if state contains custom vertex of fragment shader, then ignore
     if(state->vertex_prg_enable || state->fragment_prg_enable)
         return;
-    psa->dirty = 1;
     psa_t *p = (psa_t*)calloc(1, sizeof(psa_t));
     memcpy(&p->state, state, sizeof(p->state));
+    p->offs = -1;
 
     int l = gl4es_getProgramBinary(program, &p->size, &p->format, &p->prog);
     if(l==0) { // there was an error...
@@ -274,16 +473,8 @@ void fpe_AddProgramPSA(GLuint program, fpe_state_t* state)
         free(p);
         return;
     }
-    // add program
-    int ret;
-    khint_t k = kh_put(psalist, psa->cache, &p->state, &ret);
-    if(!ret) {
-        psa_t *p2 = kh_value(psa->cache, k);
-        free(p2->prog);
-        p2->prog = NULL;
-        free(p2);
-    }
-    kh_value(psa->cache, k) = p;
-    // all done
-    psa->size = kh_size(psa->cache);
-}
\ No newline at end of file
+    // add program, and save it
+    psa_put(p);
+    if(psa_name)
+        psa_queue(p);
+}
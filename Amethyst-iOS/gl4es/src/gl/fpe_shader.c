@@ -348,6 +348,13 @@ const char* const* fpe_VertexShader(shaderconv_need_t* need, fpe_state_t *state)
         ShadAppend(buff);
         #endif
     }
+    if(state->stipple) {
+        sprintf(buff, "varying %s float StippleDist;\n", fogp);
+        ShadAppend(buff);
+        sprintf(buff, "varying %s vec2 StipplePattern;\n", fogp);
+        ShadAppend(buff);
+        headers+=2;
+    }
     // textures coordinates
     for (int i=0; i<hardext.maxtex; i++) {
         int t = state->texture[i].textype;
@@ -800,6 +807,13 @@ const char* const* fpe_VertexShader(shaderconv_need_t* need, fpe_state_t *state)
         ShadAppend(buff);
         #endif
     }
+    // line stipple: the distance along the line (in pattern length) and the pattern bytes are computed on the CPU
+    if(state->stipple) {
+        sprintf(buff, "StippleDist = gl_MultiTexCoord%d.x;\n", state->stipple_tmu);
+        ShadAppend(buff);
+        sprintf(buff, "StipplePattern = gl_MultiTexCoord%d.yz;\n", state->stipple_tmu);
+        ShadAppend(buff);
+    }
         
 
     ShadAppend("}\n");
@@ -826,6 +840,7 @@ const char* const* fpe_FragmentShader(shaderconv_need_t* need, fpe_state_t *stat
     int pointsprite = state->pointsprite;
     int pointsprite_coord = state->pointsprite_coord;
     int pointsprite_upper = state->pointsprite_upper;
+    int stipple = state->stipple;
     int texenv_combine = 0;
     int texturing = 0;
     char buff[1024];
@@ -928,6 +943,13 @@ const char* const* fpe_FragmentShader(shaderconv_need_t* need, fpe_state_t *stat
         ShadAppend(gl4es_alphaRefSource);
         headers++;
     } 
+    if(stipple) {
+        sprintf(buff, "varying %s float StippleDist;\n", fogp);
+        ShadAppend(buff);
+        sprintf(buff, "varying %s vec2 StipplePattern;\n", fogp);
+        ShadAppend(buff);
+        headers+=2;
+    }
 
     ShadAppend("void main() {\n");
 
@@ -946,6 +968,19 @@ const char* const* fpe_FragmentShader(shaderconv_need_t* need, fpe_state_t *stat
         ShadAppend(")<0.) discard;\n");
     }
 
+    //*** Line Stipple
+    if(stipple) {
+        if(comments)
+            ShadAppend("// Line Stipple\n");
+        // no integer ops in GLSL ES 1.0: the pattern byte (+0.5) is scaled so the wanted bit lands on the first fractional bit
+        sprintf(buff, "%s float stipple_bit = floor(fract(StippleDist)*16.);\n", fogp);
+        ShadAppend(buff);
+        sprintf(buff, "%s float stipple_pat = StipplePattern.x;\n", fogp);
+        ShadAppend(buff);
+        ShadAppend("if (stipple_bit>=8.) { stipple_pat = StipplePattern.y; stipple_bit -= 8.; }\n");
+        ShadAppend("if (fract(stipple_pat*exp2(-1.-stipple_bit))<0.5) discard;\n");
+    }
+
     //*** initial color
     sprintf(buff, "vec4 fColor = %s;\n", twosided?"(gl_FrontFacing)?Color:BackColor":"Color");
     ShadAppend(buff);
@@ -27,9 +27,61 @@ KHASH_MAP_IMPL_INT(framebufferlist_t, glframebuffer_t *);
 int npot(int n);
 int wrap_npot(GLenum wrap);
 
+// grow a fbotable_t array so it holds name id (id must be < MAX_FBOTABLE)
+static void** fbotable_grow(void** objs, int* cap, GLuint id) {
+    int n = (*cap)?(*cap):64;
+    while(n<=id) n<<=1;
+    if(n>MAX_FBOTABLE) n = MAX_FBOTABLE;
+    objs = (void**)realloc(objs, n*sizeof(void*));
+    memset(objs+*cap, 0, (n-*cap)*sizeof(void*));
+    *cap = n;
+    return objs;
+}
+
+static void fbotable_setfb(GLuint id, glframebuffer_t* fb) {
+    fbotable_t *table = glstate->fbo.table;
+    if(id>=MAX_FBOTABLE)
+        return;
+    if(id>=table->fb_cap)
+        table->fb = (glframebuffer_t**)fbotable_grow((void**)table->fb, &table->fb_cap, id);
+    table->fb[id] = fb;
+}
+
+static void fbotable_setrb(GLuint id, glrenderbuffer_t* rb) {
+    fbotable_t *table = glstate->fbo.table;
+    if(id>=MAX_FBOTABLE)
+        return;
+    if(id>=table->rb_cap)
+        table->rb = (glrenderbuffer_t**)fbotable_grow((void**)table->rb, &table->rb_cap, id);
+    table->rb[id] = rb;
+}
+
+void invalidateFBOStatus() {
+    ++glstate->fbo.table->gen;
+}
+
+// bind a framebuffer on GLES, unless it's already the one bound
+static void bindRealFBO(GLuint fbo) {
+    if(glstate->fbo.real_fb==fbo)
+        return;
+    LOAD_GLES2_OR_OES(glBindFramebuffer);
+    gles_glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glstate->fbo.real_fb = fbo;
+}
+
+// same, but always bind: around the swap and the context changes, it may have been changed outside of gl4es
+static void rebindRealFBO(GLuint fbo) {
+    glstate->fbo.real_fb = FBO_UNKNOWN;
+    bindRealFBO(fbo);
+}
+
 glframebuffer_t* find_framebuffer(GLuint framebuffer) {
     // Get a framebuffer based on ID
     if (framebuffer == 0) return glstate->fbo.fbo_0; // NULL or fbo_0 ?
+    if (framebuffer < glstate->fbo.table->fb_cap)
+        return glstate->fbo.table->fb[framebuffer];
+    if (framebuffer < MAX_FBOTABLE)
+        return NULL;    // it would be in the table
     int ret;
     khint_t k;
     khash_t(framebufferlist_t) *list = glstate->fbo.framebufferlist;
@@ -61,8 +113,7 @@ void readfboBegin() {
 	GLuint fbo = glstate->fbo.fbo_read->id;
 	if (!fbo)
 		fbo = glstate->fbo.mainfbo_fbo;
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
-	gles_glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	bindRealFBO(fbo);
 }
 
 void readfboEnd() {
@@ -75,13 +126,16 @@ void readfboEnd() {
 	GLuint fbo = glstate->fbo.fbo_draw->id;
 	if (!fbo)
 		fbo = glstate->fbo.mainfbo_fbo;
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
-	gles_glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	bindRealFBO(fbo);
 }
 
 glrenderbuffer_t* find_renderbuffer(GLuint renderbuffer) {
     // Get a renderbuffer based on ID
     if (renderbuffer == 0) return glstate->fbo.default_rb;
+    if (renderbuffer < glstate->fbo.table->rb_cap)
+        return glstate->fbo.table->rb[renderbuffer];
+    if (renderbuffer < MAX_FBOTABLE)
+        return NULL;    // it would be in the table
     int ret;
     khint_t k;
     khash_t(renderbufferlist_t) *list = glstate->fbo.renderbufferlist;
@@ -116,6 +170,7 @@ void gl4es_glGenFramebuffers(GLsizei n, GLuint *ids) {
         memset(fb, 0, sizeof(glframebuffer_t));
         fb->id = ids[i];
         fb->n_draw = 0; // correct?
+        fbotable_setfb(ids[i], fb);
     }
 }
 
@@ -123,6 +178,7 @@ void gl4es_glDeleteFramebuffers(GLsizei n, GLuint *framebuffers) {
     DBG(printf("glDeleteFramebuffers(%i, %p), framebuffers[0]=%u\n", n, framebuffers, framebuffers[0]);)
     // delete tracking
     khint_t k;
+    int unbound = 0;
     if (glstate->fbo.framebufferlist)
         for (int i=0; i<n; i++) {
             khint_t k;
@@ -159,8 +215,21 @@ void gl4es_glDeleteFramebuffers(GLsizei n, GLuint *framebuffers) {
                                 tex->renderstencil = 0;
                             }
                         }
+                        // the bindings to a deleted framebuffer go back to 0
+                        if(glstate->fbo.fbo_read==fb)
+                            glstate->fbo.fbo_read = glstate->fbo.fbo_0;
+                        if(glstate->fbo.fbo_draw==fb)
+                            glstate->fbo.fbo_draw = glstate->fbo.fbo_0;
+                        if(glstate->fbo.current_fb==fb) {
+                            glstate->fbo.current_fb = glstate->fbo.fbo_0;
+                            unbound = 1;
+                        }
                         free(fb);
-                        kh_del(framebufferlist_t, glstate->fbo.framebufferlist, k);                        
+                        kh_del(framebufferlist_t, glstate->fbo.framebufferlist, k);
+                        fbotable_setfb(t, NULL);
+                        // GLES falls back to 0 if it was bound, unless it's only recycled
+                        if(glstate->fbo.real_fb==t && !globals4es.recyclefbo)
+                            glstate->fbo.real_fb = 0;
                     }
                 }
             }
@@ -169,6 +238,9 @@ void gl4es_glDeleteFramebuffers(GLsizei n, GLuint *framebuffers) {
     if (globals4es.recyclefbo) {
         DBG(printf("Recycling %i FBOs\n", n);)
         noerrorShim();
+        // the default state is set up before LIBGL_RECYCLEFBO is read
+        if(!glstate->fbo.old)
+            glstate->fbo.old = (oldfbos_t*)calloc(1, sizeof(oldfbos_t));
         if(glstate->fbo.old->cap == 0) {
             glstate->fbo.old->cap = 16;
             glstate->fbo.old->fbos = (GLuint*)malloc(glstate->fbo.old->cap * sizeof(GLuint));
@@ -184,6 +256,9 @@ void gl4es_glDeleteFramebuffers(GLsizei n, GLuint *framebuffers) {
         errorGL();
         gles_glDeleteFramebuffers(n, framebuffers);
     }
+    // 0 is the main FBO, if any (and a recycled framebuffer is still bound on GLES)
+    if(unbound)
+        bindRealFBO(glstate->fbo.mainfbo_fbo);
 }
 
 GLboolean gl4es_glIsFramebuffer(GLuint framebuffer) {
@@ -208,7 +283,19 @@ GLenum gl4es_glCheckFramebufferStatus(GLenum target) {
             return GL_FRAMEBUFFER_COMPLETE; // cheating here
         if(target==GL_DRAW_FRAMEBUFFER)
             rtarget = GL_FRAMEBUFFER;
-        result = gles_glCheckFramebufferStatus(target);
+        glframebuffer_t *fb = glstate->fbo.current_fb;
+        // the status of the window framebuffer is not cached, it depends on the surface
+        int cache = (rtarget==GL_FRAMEBUFFER && (fb->id || glstate->fbo.mainfbo_fbo));
+        if(cache && fb->status_gen==glstate->fbo.table->gen) {
+            noerrorShim();
+            result = fb->status;
+        } else {
+            result = gles_glCheckFramebufferStatus(rtarget);
+            if(cache && result) {
+                fb->status = result;
+                fb->status_gen = glstate->fbo.table->gen;
+            }
+        }
      }
     DBG(printf("glCheckFramebufferStatus(0x%04X)=0x%04X\n", target, result);)
     return result;
@@ -254,10 +341,15 @@ void gl4es_glBindFramebuffer(GLenum target, GLuint framebuffer) {
         framebuffer = glstate->fbo.mainfbo_fbo;
 
     glstate->fbo.current_fb = fb;
-        
+
+    if(glstate->fbo.real_fb==framebuffer) {
+        noerrorShim();
+        return;
+    }
     gles_glBindFramebuffer(target, framebuffer);
     GLenum err=gles_glGetError();
     errorShim(err);
+    glstate->fbo.real_fb = (err==GL_NO_ERROR)?framebuffer:FBO_UNKNOWN;
     
 //    glstate->fbo.fb_status = (framebuffer==0)?GL_FRAMEBUFFER_COMPLETE:gles_glCheckFramebufferStatus(target);
 }
@@ -265,15 +357,14 @@ void gl4es_glBindFramebuffer(GLenum target, GLuint framebuffer) {
 GLenum ReadDraw_Push(GLenum target) {
     if(target==GL_FRAMEBUFFER)
         return GL_FRAMEBUFFER;
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
     if(target==GL_DRAW_FRAMEBUFFER) {
         if(glstate->fbo.current_fb!=glstate->fbo.fbo_draw)
-            gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.fbo_draw->id)?glstate->fbo.fbo_draw->id:glstate->fbo.mainfbo_fbo);
+            bindRealFBO((glstate->fbo.fbo_draw->id)?glstate->fbo.fbo_draw->id:glstate->fbo.mainfbo_fbo);
         return GL_FRAMEBUFFER;
     }
     if(target==GL_READ_FRAMEBUFFER) {
         if(glstate->fbo.current_fb!=glstate->fbo.fbo_read)
-            gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.fbo_read->id)?glstate->fbo.fbo_read->id:glstate->fbo.mainfbo_fbo);
+            bindRealFBO((glstate->fbo.fbo_read->id)?glstate->fbo.fbo_read->id:glstate->fbo.mainfbo_fbo);
         return GL_FRAMEBUFFER;
     }
     return target;
@@ -281,17 +372,19 @@ GLenum ReadDraw_Push(GLenum target) {
 void ReadDraw_Pop(GLenum target) {
     if(target==GL_FRAMEBUFFER)
         return;
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
     if(target==GL_DRAW_FRAMEBUFFER && glstate->fbo.current_fb!=glstate->fbo.fbo_draw) {
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
+        bindRealFBO((glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
     }
     if(target==GL_READ_FRAMEBUFFER && glstate->fbo.current_fb!=glstate->fbo.fbo_read) {
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
+        bindRealFBO((glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
     }
 }
 
 void SetAttachment(glframebuffer_t* fb, GLenum attachment, GLenum atttarget, GLuint att, int level)
 {
+    // the cached read format/type of the framebuffer may not be valid anymore
+    fb->read_format = 0;
+    fb->read_type = 0;
     switch (attachment) {
     case GL_COLOR_ATTACHMENT0:
     case GL_COLOR_ATTACHMENT1:
@@ -444,6 +537,8 @@ void gl4es_glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum texta
          errorShim(GL_INVALID_ENUM);
          return;
      }
+    // the texture may be re-specified and attached below
+    invalidateFBOStatus();
     
     int twidth = 0, theight = 0;
     // find texture and get it's real name
@@ -832,6 +927,7 @@ void gl4es_glGenRenderbuffers(GLsizei n, GLuint *renderbuffers) {
         glrenderbuffer_t *rend = kh_value(list, k) = malloc(sizeof(glrenderbuffer_t));
         memset(rend, 0, sizeof(glrenderbuffer_t));
         rend->renderbuffer = renderbuffers[i];
+        fbotable_setrb(renderbuffers[i], rend);
     }
 }
 
@@ -861,6 +957,7 @@ void gl4es_glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum re
         errorShim(GL_INVALID_OPERATION);
         return;
     }
+    invalidateFBOStatus();
 
     if (attachment >= GL_COLOR_ATTACHMENT0 && (attachment < (GL_COLOR_ATTACHMENT0+hardext.maxcolorattach)) && globals4es.fboforcetex) {
         if(rend->renderbuffer) {
@@ -940,6 +1037,7 @@ void gl4es_glDeleteRenderbuffers(GLsizei n, GLuint *renderbuffers) {
     DBG(printf("glDeleteRenderbuffer(%d, %p)\n", n, renderbuffers);)
     LOAD_GLES2_OR_OES(glDeleteRenderbuffers);
     
+    invalidateFBOStatus();
     // check if we delete a depthstencil
     khint_t k;
     if (glstate->fbo.renderbufferlist)
@@ -958,6 +1056,7 @@ void gl4es_glDeleteRenderbuffers(GLsizei n, GLuint *renderbuffers) {
                             gl4es_glDeleteTextures(1, &rend->secondarytexture);
                         free(rend);
                         kh_del(renderbufferlist_t, glstate->fbo.renderbufferlist, k);
+                        fbotable_setrb(t, NULL);
                     }
                 }
             }
@@ -978,6 +1077,7 @@ void gl4es_glRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei w
         errorShim(GL_INVALID_OPERATION);
         return;
     }
+    invalidateFBOStatus();
     
     errorGL();
     width = (hardext.npot>0 && !globals4es.potframebuffer)?width:npot(width);
@@ -1204,97 +1304,124 @@ void gl4es_glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint * par
     gles_glGetRenderbufferParameteriv(target, pname, params);
 }
 
-void createMainFBO(int width, int height) {
+// (re)specify the color buffer of the current FBO of the ring, keeping the GL names,
+// and attach it with the shared depth and stencil buffers. Texture unit 0 must be active
+static GLenum realizeMainFBO() {
     LOAD_GLES2_OR_OES(glGenFramebuffers);
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
     LOAD_GLES2_OR_OES(glFramebufferTexture2D);
     LOAD_GLES2_OR_OES(glCheckFramebufferStatus);
     LOAD_GLES2_OR_OES(glFramebufferRenderbuffer);
-    LOAD_GLES2_OR_OES(glRenderbufferStorage);
-    LOAD_GLES2_OR_OES(glGenRenderbuffers);
-    LOAD_GLES2_OR_OES(glBindRenderbuffer);
     LOAD_GLES(glTexImage2D);
     LOAD_GLES(glGenTextures);
     LOAD_GLES(glBindTexture);
-    LOAD_GLES(glActiveTexture);
     LOAD_GLES(glTexParameteri);
-    LOAD_GLES2(glClientActiveTexture);
-    LOAD_GLES(glClear);
-
-    // If there is already a Framebuffer created, let's delete it.... unless it's already the right size!
-    int createIt = 1;
-    if (glstate->fbo.mainfbo_fbo) {
-        if (width==glstate->fbo.mainfbo_width && height==glstate->fbo.mainfbo_height)
-            return;
-        //lets adjust the FBO instead of adjusting it
-        createIt = 0;
-    }
-    DBG(printf("LIBGL: Create FBO of %ix%i 32bits\n", width, height);)
-    // switch to texture unit 0 if needed
-    if (glstate->texture.active != 0)
-        gles_glActiveTexture(GL_TEXTURE0);
-    if (glstate->texture.client != 0 && gles_glClientActiveTexture)
-        gles_glClientActiveTexture(GL_TEXTURE0);
-        
-    glstate->fbo.mainfbo_width = width;
-    glstate->fbo.mainfbo_height = height;
-    glstate->fbo.mainfbo_nwidth = width = hardext.npot>0?width:npot(width);
-    glstate->fbo.mainfbo_nheight = height = hardext.npot>0?height:npot(height);
 
+    mainfbo_t *cur = &glstate->fbo.mainfbo[glstate->fbo.mainfbo_cur];
+    int createIt = (cur->fbo==0);
     // create the texture
     if(createIt)
-	    gles_glGenTextures(1, &glstate->fbo.mainfbo_tex);
-    gles_glBindTexture(GL_TEXTURE_2D, glstate->fbo.mainfbo_tex);
+	    gles_glGenTextures(1, &cur->tex);
+    gles_glBindTexture(GL_TEXTURE_2D, cur->tex);
     if(createIt) {
         gles_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         gles_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         gles_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         gles_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
-    gles_glTexImage2D(GL_TEXTURE_2D, 0, globals4es.fbo_noalpha?GL_RGB:GL_RGBA, width, height,
+    cur->nwidth = glstate->fbo.mainfbo_nwidth;
+    cur->nheight = glstate->fbo.mainfbo_nheight;
+    gles_glTexImage2D(GL_TEXTURE_2D, 0, globals4es.fbo_noalpha?GL_RGB:GL_RGBA, cur->nwidth, cur->nheight,
 					0, globals4es.fbo_noalpha?GL_RGB:GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	gles_glBindTexture(GL_TEXTURE_2D, 0);
-    // create the render buffers
-    if(createIt) {
-        gles_glGenRenderbuffers(1, &glstate->fbo.mainfbo_dep);
-        gles_glGenRenderbuffers(1, &glstate->fbo.mainfbo_ste);
-    }
-    gles_glBindRenderbuffer(GL_RENDERBUFFER, glstate->fbo.mainfbo_ste);
-    gles_glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
-    gles_glBindRenderbuffer(GL_RENDERBUFFER, glstate->fbo.mainfbo_dep);
-    gles_glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
-    gles_glBindRenderbuffer(GL_RENDERBUFFER, 0);
     // create a fbo
     if(createIt)
-        gles_glGenFramebuffers(1, &glstate->fbo.mainfbo_fbo);
-    gles_glBindFramebuffer(GL_FRAMEBUFFER, glstate->fbo.mainfbo_fbo);
+        gles_glGenFramebuffers(1, &cur->fbo);
+    bindRealFBO(cur->fbo);
     
     // re-attach, even if not creating the fbo...
     gles_glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, glstate->fbo.mainfbo_ste);
     gles_glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, glstate->fbo.mainfbo_dep);
     
-    gles_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, glstate->fbo.mainfbo_tex, 0);
+    gles_glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cur->tex, 0);
 
 	GLenum status = gles_glCheckFramebufferStatus(GL_FRAMEBUFFER);
 
-	gles_glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	bindRealFBO(0);
+
+    invalidateFBOStatus();
+    glstate->fbo.mainfbo_fbo = cur->fbo;
+    glstate->fbo.mainfbo_tex = cur->tex;
+    return status;
+}
+
+static void mainfbo_begin() {
+    LOAD_GLES(glActiveTexture);
+    LOAD_GLES2(glClientActiveTexture);
+    // switch to texture unit 0 if needed
+    if (glstate->texture.active != 0)
+        gles_glActiveTexture(GL_TEXTURE0);
+    if (glstate->texture.client != 0 && gles_glClientActiveTexture)
+        gles_glClientActiveTexture(GL_TEXTURE0);
+}
 
+static void mainfbo_end() {
+    LOAD_GLES(glBindTexture);
+    LOAD_GLES(glActiveTexture);
+    LOAD_GLES2(glClientActiveTexture);
     // Put everything back
     gles_glBindTexture(GL_TEXTURE_2D, glstate->texture.bound[0][ENABLED_TEX2D]->glname);
     if (glstate->texture.active != 0)
         gles_glActiveTexture(GL_TEXTURE0 + glstate->texture.active);
     if (glstate->texture.client != 0 && gles_glClientActiveTexture)
         gles_glClientActiveTexture(GL_TEXTURE0 + glstate->texture.client);
+}
+
+void createMainFBO(int width, int height) {
+    LOAD_GLES2_OR_OES(glRenderbufferStorage);
+    LOAD_GLES2_OR_OES(glGenRenderbuffers);
+    LOAD_GLES2_OR_OES(glBindRenderbuffer);
+    LOAD_GLES(glClear);
+
+    // If there is already a Framebuffer created, let's delete it.... unless it's already the right size!
+    int createIt = 1;
+    if (glstate->fbo.mainfbo_fbo) {
+        if (width==glstate->fbo.mainfbo_width && height==glstate->fbo.mainfbo_height)
+            return;
+        //lets adjust the FBO instead of adjusting it
+        createIt = 0;
+    }
+    DBG(printf("LIBGL: Create FBO of %ix%i 32bits\n", width, height);)
+    mainfbo_begin();
+        
+    glstate->fbo.mainfbo_width = width;
+    glstate->fbo.mainfbo_height = height;
+    glstate->fbo.mainfbo_nwidth = width = hardext.npot>0?width:npot(width);
+    glstate->fbo.mainfbo_nheight = height = hardext.npot>0?height:npot(height);
+
+    // create the render buffers, shared by all the FBOs of the ring (the resolve only reads the color)
+    if(createIt) {
+        gles_glGenRenderbuffers(1, &glstate->fbo.mainfbo_dep);
+        gles_glGenRenderbuffers(1, &glstate->fbo.mainfbo_ste);
+    }
+    gles_glBindRenderbuffer(GL_RENDERBUFFER, glstate->fbo.mainfbo_ste);
+    gles_glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
+    gles_glBindRenderbuffer(GL_RENDERBUFFER, glstate->fbo.mainfbo_dep);
+    gles_glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    gles_glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    // only the current color buffer is resized now, the others when they come back in the ring
+    GLenum status = realizeMainFBO();
+
+    mainfbo_end();
     GLuint current_rb = glstate->fbo.current_rb->renderbuffer;
     gles_glBindRenderbuffer(GL_RENDERBUFFER, current_rb);
     // Final check, and bind the fbo for future use
     if (status != GL_FRAMEBUFFER_COMPLETE) {
         printf("LIBGL: Error while creating main fbo (0x%04X)\n", status);
         deleteMainFBO(glstate);
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, glstate->fbo.current_fb->id);
+        bindRealFBO(glstate->fbo.current_fb->id);
         
     } else {
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
+        bindRealFBO((glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
         // clear color, depth and stencil...
         if (glstate->fbo.current_fb->id==0)
             gles_glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -1302,6 +1429,28 @@ void createMainFBO(int width, int height) {
     
 }
 
+// move to the next color buffer of the ring, so the next frame doesn't wait for the resolve of this one
+static void nextMainFBO() {
+    int ring = (globals4es.fbo_ring>1)?globals4es.fbo_ring:1;
+    if(ring==1)
+        return;
+    glstate->fbo.mainfbo_cur = (glstate->fbo.mainfbo_cur+1)%ring;
+    mainfbo_t *cur = &glstate->fbo.mainfbo[glstate->fbo.mainfbo_cur];
+    if(cur->fbo && cur->nwidth==glstate->fbo.mainfbo_nwidth && cur->nheight==glstate->fbo.mainfbo_nheight) {
+        glstate->fbo.mainfbo_fbo = cur->fbo;
+        glstate->fbo.mainfbo_tex = cur->tex;
+        return;
+    }
+    // first use, or the size changed since it was last used
+    mainfbo_begin();
+    GLenum status = realizeMainFBO();
+    mainfbo_end();
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        printf("LIBGL: Error while creating main fbo (0x%04X)\n", status);
+        deleteMainFBO(glstate);
+    }
+}
+
 void blitMainFBO(int x, int y, int width, int height) {
     if (glstate->fbo.mainfbo_fbo==0)
         return;
@@ -1332,25 +1481,24 @@ void blitMainFBO(int x, int y, int width, int height) {
         rx, ry,
         0, 0, x, y, BLIT_OPAQUE);
     gl4es_glViewport(vp[0], vp[1], vp[2], vp[3]);
+    nextMainFBO();
 }
 
 void bindMainFBO() {
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
     LOAD_GLES2_OR_OES(glCheckFramebufferStatus);
     if (!glstate->fbo.mainfbo_fbo)
         return;
     if (glstate->fbo.current_fb->id==0) {
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, glstate->fbo.mainfbo_fbo);
+        rebindRealFBO(glstate->fbo.mainfbo_fbo);
         //gles_glCheckFramebufferStatus(GL_FRAMEBUFFER);
     }
 }
 
 void unbindMainFBO() {
-    LOAD_GLES2_OR_OES(glBindFramebuffer);
     if (!glstate->fbo.mainfbo_fbo)
         return;
     if (glstate->fbo.current_fb->id==0) {
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        rebindRealFBO(0);
     }
 }
 
@@ -1369,14 +1517,18 @@ void deleteMainFBO(void *state) {
         gles_glDeleteRenderbuffers(1, &glstate->fbo.mainfbo_ste);
         glstate->fbo.mainfbo_ste = 0;
     }
-    if (glstate->fbo.mainfbo_tex) {
-        gles_glDeleteTextures(1, &glstate->fbo.mainfbo_tex);
-        glstate->fbo.mainfbo_tex = 0;
-    }
-    if (glstate->fbo.mainfbo_fbo) {
-        gles_glDeleteFramebuffers(1, &glstate->fbo.mainfbo_fbo);
-        glstate->fbo.mainfbo_fbo = 0;
-    }
+    for (int i=0; i<MAX_MAINFBO; i++) {
+        mainfbo_t *fbo = &glstate->fbo.mainfbo[i];
+        if (fbo->tex)
+            gles_glDeleteTextures(1, &fbo->tex);
+        if (fbo->fbo)
+            gles_glDeleteFramebuffers(1, &fbo->fbo);
+        memset(fbo, 0, sizeof(mainfbo_t));
+    }
+    glstate->fbo.mainfbo_cur = 0;
+    glstate->fbo.mainfbo_tex = 0;
+    glstate->fbo.mainfbo_fbo = 0;
+    glstate->fbo.real_fb = FBO_UNKNOWN;
     
     // all done...
 }
@@ -1473,8 +1625,7 @@ GLuint gl4es_getCurrentFBO() {
 }
 
 void gl4es_setCurrentFBO() {
-  LOAD_GLES2_OR_OES(glBindFramebuffer);
-  gles_glBindFramebuffer(GL_FRAMEBUFFER, (glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
+  rebindRealFBO((glstate->fbo.current_fb->id)?glstate->fbo.current_fb->id:glstate->fbo.mainfbo_fbo);
 }
 
 // DrawBuffers functions are faked unless GL_EXT_draw_buffers is supported
@@ -1688,10 +1839,9 @@ void gl4es_saveCurrentFBO()
     if(framebuffer==0)
         framebuffer = glstate->fbo.mainfbo_fbo;
     if(framebuffer) {
-        LOAD_GLES2_OR_OES(glBindFramebuffer);
         if(hardext.vendor&VEND_ARM)
             gl4es_glFinish(); //MALI seems to need a flush commandbefore unbinding the Framebuffer here
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        rebindRealFBO(0);
     }
 }
 
@@ -1702,8 +1852,7 @@ void gl4es_restoreCurrentFBO()
     if(framebuffer==0)
         framebuffer = glstate->fbo.mainfbo_fbo;
     if(framebuffer) {
-        LOAD_GLES2_OR_OES(glBindFramebuffer);
-        gles_glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        rebindRealFBO(framebuffer);
     }
 }
 
@@ -49,6 +49,9 @@ void unbindMainFBO();
 void readfboBegin();
 void readfboEnd();
 
+// the cached framebuffer status may have changed (attachment re-specified, deleted...)
+void invalidateFBOStatus();
+
 GLuint gl4es_getCurrentFBO();
 void gl4es_setCurrentFBO();
 
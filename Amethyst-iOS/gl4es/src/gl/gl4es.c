@@ -940,6 +940,9 @@ void glDeleteLists(GLuint list, GLsizei range) AliasExport("gl4es_glDeleteLists"
 
 void gl4es_glListBase(GLuint base) {
 	noerrorShimNoPurge();
+    if(glstate->list.base==base)
+        return;
+    attrib_changed(GL_LIST_BIT);
     glstate->list.base = base;
 }
 void glListBase(GLuint base) AliasExport("gl4es_glListBase");
@@ -1063,6 +1066,7 @@ void gl4es_glShadeModel(GLenum mode) {
     noerrorShim();
     if(mode==glstate->shademodel)
         return;
+    attrib_changed(GL_LIGHTING_BIT);
     glstate->shademodel = mode;
     LOAD_GLES2(glShadeModel);
     if(gles_glShadeModel) {
@@ -1085,6 +1089,7 @@ void gl4es_glAlphaFunc(GLenum func, GLclampf ref) {
             errorShim(GL_INVALID_ENUM);
             return;
     }
+    attrib_changed(GL_COLOR_BUFFER_BIT);
     glstate->alphafunc = func;
     glstate->alpharef = ref;
     LOAD_GLES_FPE(glAlphaFunc);
@@ -1101,6 +1106,7 @@ void gl4es_glLogicOp(GLenum opcode) {
     if(glstate->logicop==opcode)
         return;
     // TODO: test if opcode is valid
+    attrib_changed(GL_COLOR_BUFFER_BIT);
     glstate->logicop = opcode;
     LOAD_GLES2(glLogicOp);
     if(gles_glLogicOp) {
@@ -1116,6 +1122,7 @@ void gl4es_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean
         noerrorShim();
         return;
     }
+    attrib_changed(GL_COLOR_BUFFER_BIT);
     glstate->colormask[0]=red;
     glstate->colormask[1]=green;
     glstate->colormask[2]=blue;
@@ -1125,8 +1132,17 @@ void gl4es_glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean
 }
 void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) AliasExport("gl4es_glColorMask");
 
+void gl4es_glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) {
+    PUSH_IF_COMPILING(glClearColor);
+    attrib_changed(GL_COLOR_BUFFER_BIT);
+    LOAD_GLES(glClearColor);
+    gles_glClearColor(red, green, blue, alpha);
+}
+void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) AliasExport("gl4es_glClearColor");
+
 void gl4es_glClear(GLbitfield mask) {
     PUSH_IF_COMPILING(glClear);
+    if (glstate->raster.bm_drawing) bitmap_flush();
 
     mask &= GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
     LOAD_GLES(glClear);
@@ -21,6 +21,14 @@
 
 #define _EXT(func_name) MAP(#func_name "EXT", gl4es_ ## func_name)
 
+// conditions of the LOOKUP_IF blocks of gl_lookup.inc
+#define LOOKUP_FBO          1   // hardext.fbo
+#define LOOKUP_BLENDCOLOR   2   // globals4es.blendcolor || hardext.blendcolor
+#define LOOKUP_BLENDEQ      4   // hardext.blendeq
+#define LOOKUP_BLENDFUNC    8   // hardext.blendfunc
+#define LOOKUP_ES2          16  // hardext.esversion>1
+#define LOOKUP_QUERIES      32  // globals4es.queries
+
 #ifndef STUB_FCT
 #error STUB_FCT is not defined
 #endif
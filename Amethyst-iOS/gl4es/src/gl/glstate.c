@@ -1,6 +1,7 @@
 #include "glstate.h"
 
 #include "../glx/hardext.h"
+#include "blit.h"
 #include "fpe.h"
 #include "framebuffers.h"
 #include "gl4es.h"
@@ -8,6 +9,7 @@
 #include "init.h"
 #include "loader.h"
 #include "oldprogram.h"
+#include "render.h"
 
 glstate_t *glstate = NULL;
 
@@ -90,6 +92,7 @@ void* NewGLState(void* shared_glstate, int es2only) {
         glstate->fbo.default_rb = copy_state->fbo.default_rb;
         glstate->fbo.framebufferlist = copy_state->fbo.framebufferlist;
         glstate->fbo.fbo_0 = copy_state->fbo.fbo_0;
+        glstate->fbo.table = copy_state->fbo.table;
         glstate->fbo.old = copy_state->fbo.old;
 
         glstate->defaultvbo = copy_state->defaultvbo;
@@ -152,6 +155,11 @@ void* NewGLState(void* shared_glstate, int es2only) {
 		k = kh_put(gllisthead, list, 1, &ret);
 		kh_del(gllisthead, list, k);
     }
+    // query objects
+    if(!shared_glstate)
+    {
+        glstate->queries = (glquerylist_t*)calloc(1, sizeof(glquerylist_t));
+    }
     // actual_tex2d
     if(!shared_glstate)
     {
@@ -266,6 +274,7 @@ void* NewGLState(void* shared_glstate, int es2only) {
         glstate->light.lights[i].spotCutoff = 180;
         glstate->light.lights[i].constantAttenuation = 1;
     }
+    glstate->light.generation = light_NewGeneration();
     // Materials
     glstate->material.front.ambient[0] = 
     glstate->material.front.ambient[1] =
@@ -414,11 +423,14 @@ void* NewGLState(void* shared_glstate, int es2only) {
         fb->width = glstate->fbo.mainfbo_width;
         fb->height = glstate->fbo.mainfbo_height;
         glstate->fbo.fbo_0 = fb;
+        glstate->fbo.table = (fbotable_t*)calloc(1, sizeof(fbotable_t));
+        glstate->fbo.table->gen = 1;
         if(globals4es.recyclefbo) {
             glstate->fbo.old = (oldfbos_t*)calloc(1, sizeof(oldfbos_t));
         }
     }
     glstate->fbo.current_fb = glstate->fbo.fbo_0;
+    glstate->fbo.real_fb = 0;
     glstate->fbo.current_rb = glstate->fbo.default_rb;
     glstate->fbo.fbo_read = glstate->fbo.fbo_0;
     glstate->fbo.fbo_draw = glstate->fbo.fbo_0;
@@ -475,12 +487,21 @@ void DeleteGLState(void* oldstate) {
     }
     free_hashmap(glvao_t, vaos, glvao, free);
     if(!state->shared_cnt) {
-        free_hashmap(glquery_t, queries, queries, free);
+        if(state->queries) {
+            free(state->queries->list);
+            free_hashmap(glquery_t, queries->sparse, queries, free);
+            free(state->queries);
+        }
         free_hashmap(glbuffer_t, buffers, buff, free);
         free_hashmap(gltexture_t, texture.list, tex, free_texture);
         free_hashmap(renderlist_t, headlists, gllisthead, free_renderlist);
         free_hashmap(glrenderbuffer_t, fbo.renderbufferlist, renderbufferlist_t, free_renderbuffer);
         free_hashmap(glframebuffer_t, fbo.framebufferlist, framebufferlist_t, free_framebuffer);
+        if(state->fbo.table) {
+            free(state->fbo.table->fb);
+            free(state->fbo.table->rb);
+            free(state->fbo.table);
+        }
     }
     #undef free_hashmap
     // free texture zero as it's not in the list anymore
@@ -497,6 +518,7 @@ void DeleteGLState(void* oldstate) {
     freemap(2, vertex3); freemap(2, vertex4); freemap(2, index); freemap(2, color4); freemap(2, normal); 
     freemap(2, texture1); freemap(2, texture2); freemap(2, texture3); freemap(2, texture4);   
     #undef freemap
+    free_eval_cache(state->eval_cache);
     // free active list
     if(!state->shared_cnt && state->list.active) free_renderlist(state->list.active);
 
@@ -527,6 +549,10 @@ void DeleteGLState(void* oldstate) {
         free(state->raster.data);
     if(state->raster.bitmap)
         free(state->raster.bitmap);
+    free_bitmap_atlas(state->raster.bm_atlas);
+    free_drawpixels_cache(state->raster.dp_cache);
+    // select
+    free_select_cache(state->selectbuf.cache);
     // TODO: delete the "immediate" stuff and bitmap texture?
     // scratch buffer
     if(state->scratch)
@@ -552,10 +578,7 @@ void DeleteGLState(void* oldstate) {
         free(state->fbo.old);
     }
     // free blit GLES2 stuff
-    if(state->blit) {
-        //TODO: check if should delete GL object too
-        free(state->blit);
-    }
+    free_blit(state->blit);
     if(!state->shared_cnt) {
         FreeOldProgramMap(state);
         free(state->glsl);
@@ -602,6 +625,8 @@ void ActivateGLState(void* new_glstate) {
         gles_glGetIntegerv(GL_VIEWPORT, (GLint*)&newstate->raster.viewport);
         gles_glGetIntegerv(GL_SCISSOR_BOX, (GLint*)&newstate->raster.scissor);
     }
+    // the GLES context may not be the one this state was last used with
+    newstate->fbo.real_fb = FBO_UNKNOWN;
     glstate = newstate;
 }
 
@@ -15,6 +15,7 @@ typedef struct glstate_s {
     enable_state_t      enable;
     map_grid_t          map_grid[2];
     map_states_t        map1, map2;
+    struct em_cache_s   *eval_cache;        // glEvalMesh meshes
     khash_t(gllisthead) *headlists;         // shared
     texgen_state_t      texgen[MAX_TEX];
     texenv_state_t      texenv[MAX_TEX];
@@ -30,6 +31,10 @@ typedef struct glstate_s {
     int                 inv_mv_matrix_dirty;
     GLfloat             normal_matrix[9];
     int                 normal_matrix_dirty;
+    GLfloat             inv_mvp_matrix[16];
+    int                 inv_mvp_matrix_dirty;
+    GLfloat             inv_p_matrix[16];
+    int                 inv_p_matrix_dirty;
     matrixstack_t       *modelview_matrix;
     matrixstack_t       *projection_matrix;
     matrixstack_t       **texture_matrix;
@@ -51,8 +56,11 @@ typedef struct glstate_s {
     int                 shim_error;
     GLenum              last_error;
     GLint               vp[4];
-    khash_t(queries)    *queries;       // shared
+    glquerylist_t       *queries;       // shared
+    GLuint              query_active;   // query between glBeginQuery / glEndQuery, 0 if none
     glstack_t           *stack;
+    GLuint              attrib_serial;      // incremented each time an attribute group is modified
+    GLuint              attrib_changed[32]; // attrib_serial of the last modification, per GL_xxx_BIT group
     glclientstack_t     *clientStack;
     raster_state_t      raster;
     GLuint              *actual_tex2d; // store the texture actually bounded TEX2D unit, because it's shared... (TODO: all binding and not only TEX2D)
@@ -84,6 +92,11 @@ typedef struct glstate_s {
     fpe_fpe_t           *fpe;
     fpestatus_t         fpe_client;
     fpe_cache_t         *fpe_cache;
+    fpe_state_t         fpe_last;           // raw fpe_state when the current program was resolved
+    program_t           *fpe_last_glsl;     // GLSL program it was resolved for (NULL for fixed pipeline)
+    program_t           *fpe_last_custom;   // the resolved (maybe customized) GLSL program
+    unsigned int        fpe_last_generation;// glsl->generation when fpe_last_glsl was resolved
+    int                 fpe_last_fixed;     // fpe_last was resolved for the fixed pipeline, to glstate->fpe
     gleshard_t          *gleshard;          //shared
     glesblit_t          *blit;
     fbo_t               fbo;
@@ -122,6 +135,7 @@ typedef struct glstate_s {
     int                 helper_texlen[MAX_TEX];
     GLfloat*            texgened[MAX_TEX];
     int                 texgenedsz[MAX_TEX];
+    texgen_cache_t      texgen_cache[MAX_TEX];
 } glstate_t;
 
 
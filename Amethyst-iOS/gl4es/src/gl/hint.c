@@ -13,6 +13,7 @@ void pandora_set_gamma();
 void gl4es_glHint(GLenum pname, GLenum mode) {
     
     FLUSH_BEGINEND;
+    attrib_changed(GL_HINT_BIT);
 
     LOAD_GLES(glHint);
     noerrorShim();
@@ -5,6 +5,7 @@
 #include <unistd.h>
 #include "../../version.h"
 #include "../glx/glx_gbm.h"
+#include "../glx/hardext.h"
 #include "../glx/streaming.h"
 #include "build_info.h"
 #include "debug.h"
@@ -12,7 +13,9 @@
 #include "logs.h"
 #include "fpe_cache.h"
 #include "init.h"
+#include "shaderconv_cache.h"
 #include "envvars.h"
+#include "workers.h"
 #if defined(__EMSCRIPTEN__)
 #define NO_INIT_CONSTRUCTOR
 #endif
@@ -138,6 +141,10 @@ void initialize_gl4es() {
     env(LIBGL_NOTEXRECT, globals4es.notexrect, "Don't export Text Rectangle extension");
     if(globals4es.usefbo) {
       env(LIBGL_FBONOALPHA, globals4es.fbo_noalpha, "Main FBO have no alpha channel");
+      if(GetEnvVarInt("LIBGL_FBORING",&globals4es.fbo_ring,1) && globals4es.fbo_ring>1) {
+        if(globals4es.fbo_ring>MAX_MAINFBO) globals4es.fbo_ring = MAX_MAINFBO;
+        SHUT_LOGD("Main FBO is a ring of %d color buffers\n", globals4es.fbo_ring);
+      }
     }
 
 		globals4es.es=ReturnEnvVarInt("LIBGL_ES");
@@ -217,6 +224,40 @@ void initialize_gl4es() {
         break;
     }
 
+    char cwd[1024];
+    if (getcwd(cwd, sizeof(cwd))!= NULL)
+        SHUT_LOGD("Current folder is:%s\n", cwd);
+
+    // folder for the hardware probe cache, the PSA and the shader cache
+    cwd[0]='\0';
+    // TODO: What to do on ANDROID and EMSCRIPTEN?
+#ifdef __linux__
+    const char* home = GetEnvVar("HOME");
+    if(home)
+        strcpy(cwd, home);
+    if(cwd[strlen(cwd)]!='/')
+        strcat(cwd, "/");
+#elif defined AMIGAOS4
+    strcpy(cwd, "PROGDIR:");
+#endif
+    char cache_name[1024+20];
+    globals4es.nohwcache = ReturnEnvVarInt("LIBGL_NOHWCACHE");
+    switch(globals4es.nohwcache) {
+        case 1:
+            SHUT_LOGD("Don't cache the hardware probe\n");
+            break;
+        case 2:
+            SHUT_LOGD("Force a new hardware probe\n");
+            break;
+        default:
+            globals4es.nohwcache = 0;
+    }
+    if(strlen(cwd)) {
+        strcpy(cache_name, cwd);
+        strcat(cache_name, ".gl4es.hwc");
+        hardext_InitCache(cache_name);
+    }
+
     GetHardwareExtensions(gl4es_notest);
 
 #if !defined(NO_LOADER) && !defined(NO_GBM)
@@ -404,6 +445,10 @@ void initialize_gl4es() {
         globals4es.nointovlhack = 1;
         SHUT_LOGD("No hack in shader converter to define overloaded function with int\n");
     }
+    env(LIBGL_NOSIMD, globals4es.nosimd, "Don't use SIMD fast paths");
+    if(GetEnvVarInt("LIBGL_THREADS",&globals4es.threads,-1)) {
+        SHUT_LOGD("Use %d worker threads for CPU conversions\n", globals4es.threads);
+    }
     if(IsEnvVarTrue("LIBGL_NOSHADERLOD")) {
         globals4es.noshaderlod = 1;
         SHUT_LOGD("No GL_EXT_shader_texture_lod used even if present\n");
@@ -635,31 +680,28 @@ void initialize_gl4es() {
     }
     env(LIBGL_GLXNATIVE, globals4es.glxnative, "Don't filter GLXConfig with GLX_X_NATIVE_TYPE");
 #endif
-    char cwd[1024];
-    if (getcwd(cwd, sizeof(cwd))!= NULL)
-        SHUT_LOGD("Current folder is:%s\n", cwd);
-
     if(hardext.prgbin_n>0 && !globals4es.notexarray) {
         env(LIBGL_NOPSA, globals4es.nopsa, "Don't use PrecompiledShaderArchive");
         if(globals4es.nopsa==0) {
-            cwd[0]='\0';
-            // TODO: What to do on ANDROID and EMSCRIPTEN?
-#ifdef __linux__
-            const char* home = GetEnvVar("HOME");
-            if(home)
-                strcpy(cwd, home);
-            if(cwd[strlen(cwd)]!='/')
-                strcat(cwd, "/");
-#elif defined AMIGAOS4
-            strcpy(cwd, "PROGDIR:");
-#endif
             if(strlen(cwd)) {
-                strcat(cwd, ".gl4es.psa");
-                fpe_InitPSA(cwd);
+                strcpy(cache_name, cwd);
+                strcat(cache_name, ".gl4es.psa");
+                fpe_InitPSA(cache_name);
                 fpe_readPSA();
             }
         }
     }
+    env(LIBGL_NOSHADERCACHE, globals4es.noshadercache, "Don't cache converted shaders");
+    if(globals4es.noshadercache==0) {
+        env(LIBGL_SHADERCACHEMEM, globals4es.shadercachemem, "Cache converted shaders in memory only");
+        if(globals4es.shadercachemem==0 && strlen(cwd)) {
+            strcpy(cache_name, cwd);
+            strcat(cache_name, ".gl4es.shc");
+            shaderconv_InitCache(cache_name);
+            shaderconv_readCache();
+        } else
+            shaderconv_InitCache(NULL);
+    }
 }
 
 
@@ -677,8 +719,12 @@ void close_gl4es() {
     FreeFBVisual();
     #endif
     gl_close();
+    workers_quit();
     fpe_writePSA();
     fpe_FreePSA();
+    shaderconv_writeCache();
+    shaderconv_FreeCache();
+    hardext_InitCache(NULL);
 		#if defined(GL4ES_COMPILE_FOR_USE_IN_SHARED_LIB) && defined(AMIGAOS4)
 	    os4CloseLib();
 	  #endif
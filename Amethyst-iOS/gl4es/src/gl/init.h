@@ -73,7 +73,13 @@ typedef struct _globals4es {
  int nointovlhack;
  int noshaderlod;
  int fbo_noalpha;
+ int fbo_ring;
  int glxnative;
+ int nosimd;
+ int threads;
+ int noshadercache;
+ int shadercachemem;
+ int nohwcache;
  #ifndef NO_GBM
  char drmcard[50];
  #endif
@@ -6,6 +6,16 @@
 #include "matrix.h"
 #include "matvec.h"
 
+// the generations are unique among all the contexts, so a program can tell if its light uniforms are up to date
+// (atomic, contexts can be current in different threads)
+static unsigned light_generation = 0;
+
+unsigned light_NewGeneration() {
+    return __sync_add_and_fetch(&light_generation, 1);
+}
+
+#define LIGHT_CHANGED glstate->light.generation = light_NewGeneration()
+
 void gl4es_glLightModelf(GLenum pname, GLfloat param) {
 //printf("%sglLightModelf(%04X, %.2f)\n", (state.list.compiling)?"list":"", pname, param);
     ERROR_IN_BEGIN
@@ -16,6 +26,7 @@ void gl4es_glLightModelf(GLenum pname, GLfloat param) {
             gl4es_glLightModelfv(pname, dummy);
             return;
         } else gl4es_flush();
+    attrib_changed(GL_LIGHTING_BIT);
     switch (pname) {
         case GL_LIGHT_MODEL_TWO_SIDE:
             errorGL();
@@ -46,6 +57,7 @@ void gl4es_glLightModelf(GLenum pname, GLfloat param) {
                     return;
                 }
                 glstate->light.local_viewer=value;
+                LIGHT_CHANGED;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_localviewer=value;
             }
@@ -76,6 +88,7 @@ void gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
             noerrorShim();
             return;
         } else gl4es_flush();
+    attrib_changed(GL_LIGHTING_BIT);
     switch (pname) {
         case GL_LIGHT_MODEL_AMBIENT:
             if(memcmp(glstate->light.ambient, params, 4*sizeof(GLfloat))==0) {
@@ -84,6 +97,7 @@ void gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
             }
             errorGL();
             memcpy(glstate->light.ambient, params, 4*sizeof(GLfloat));
+            LIGHT_CHANGED;
             break;
         case GL_LIGHT_MODEL_TWO_SIDE:
             if(glstate->light.two_side == params[0]) {
@@ -118,6 +132,7 @@ void gl4es_glLightModelfv(GLenum pname, const GLfloat* params) {
                     return;
                 }
                 glstate->light.local_viewer=value;
+                LIGHT_CHANGED;
                 if(glstate->fpe_state)
                     glstate->fpe_state->light_localviewer=value;
             }
@@ -149,6 +164,7 @@ void gl4es_glLightfv(GLenum light, GLenum pname, const GLfloat* params) {
     GLfloat tmp[4];
     GLfloat mtmp[16];
     noerrorShim();
+    attrib_changed(GL_LIGHTING_BIT);
     switch(pname) {
         case GL_AMBIENT:
             if(memcmp(glstate->light.lights[nl].ambient, params, 4*sizeof(GLfloat))==0)
@@ -239,6 +255,7 @@ void gl4es_glLightfv(GLenum light, GLenum pname, const GLfloat* params) {
             glstate->light.lights[nl].quadraticAttenuation = params[0];
             break;
     }
+    LIGHT_CHANGED;
     LOAD_GLES_FPE(glLightfv);
     gles_glLightfv(light, pname, params);
     errorGL();
@@ -272,6 +289,9 @@ void gl4es_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) {
         errorShim(GL_INVALID_ENUM);
         return;
     }
+    attrib_changed(GL_LIGHTING_BIT);
+    material_state_t old;
+    memcpy(&old, &glstate->material, sizeof(material_state_t));
     switch(pname) {
         case GL_AMBIENT:
             if(face==GL_FRONT_AND_BACK || face==GL_FRONT)
@@ -336,6 +356,8 @@ void gl4es_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) {
             }
             break;
     }
+    if(memcmp(&old, &glstate->material, sizeof(material_state_t)))
+        LIGHT_CHANGED;
 
     if(face==GL_BACK && hardext.esversion==1) { // lets ignore GL_BACK in GLES 1.1
         noerrorShim();
@@ -371,6 +393,7 @@ void gl4es_glMaterialf(GLenum face, GLenum pname, GLfloat param) {
         errorShim(GL_INVALID_VALUE);
         return;
     }
+    attrib_changed(GL_LIGHTING_BIT);
     if(face==GL_FRONT_AND_BACK || face==GL_FRONT) {
         if(glstate->material.front.shininess == param)
             return;
@@ -381,6 +404,7 @@ void gl4es_glMaterialf(GLenum face, GLenum pname, GLfloat param) {
             return;
         glstate->material.back.shininess = param;
     }
+    LIGHT_CHANGED;
 
     if(face==GL_BACK && hardext.esversion==1) { // lets ignore GL_BACK in GLES 1.1
         noerrorShim();
@@ -433,6 +457,34 @@ void gl4es_glColorMaterial(GLenum face, GLenum mode) {
     noerrorShim();
 }
 
+const lightblock_t* light_GetBlock() {
+    lightblock_t *b = &glstate->light.block;
+    if(b->generation == glstate->light.generation)
+        return b;
+    const material_t* mat[2] = {&glstate->material.front, &glstate->material.back};
+    for (int i=0; i<hardext.maxlights; i++) {
+        light_t *l = &glstate->light.lights[i];
+        memcpy(b->halfVector[i], l->position, 4*sizeof(GLfloat));
+        vector4_normalize(b->halfVector[i]);
+        if(!glstate->light.local_viewer) {
+            b->halfVector[i][2]+=1.f;
+            vector4_normalize(b->halfVector[i]);
+        }
+        b->spotCosCutoff[i] = cosf(l->spotCutoff*3.1415926535f/180.0f);
+        for (int j=0; j<2; j++) {
+            vector4_mult(mat[j]->ambient, l->ambient, b->lightprod[j][i][0]);
+            vector4_mult(mat[j]->diffuse, l->diffuse, b->lightprod[j][i][1]);
+            vector4_mult(mat[j]->specular, l->specular, b->lightprod[j][i][2]);
+        }
+    }
+    for (int j=0; j<2; j++) {
+        vector4_mult(mat[j]->ambient, glstate->light.ambient, b->sceneColor[j]);
+        vector4_add(b->sceneColor[j], mat[j]->emission, b->sceneColor[j]);
+    }
+    b->generation = glstate->light.generation;
+    return b;
+}
+
 void glLightModelf(GLenum pname, GLfloat param) AliasExport("gl4es_glLightModelf");
 void glLightModelfv(GLenum pname, const GLfloat* params) AliasExport("gl4es_glLightModelfv");
 void glLightfv(GLenum light, GLenum pname, const GLfloat* params) AliasExport("gl4es_glLightfv");
@@ -15,12 +15,23 @@ typedef struct {
     GLfloat         spotCutoff;
 } light_t;
 
+// Values derived from the lights, light model and material, computed once per generation
+typedef struct {
+    GLfloat     halfVector[MAX_LIGHT][4];
+    GLfloat     spotCosCutoff[MAX_LIGHT];
+    GLfloat     lightprod[2][MAX_LIGHT][3][4];  // front/back, then ambient/diffuse/specular products
+    GLfloat     sceneColor[2][4];               // front/back
+    unsigned    generation;
+} lightblock_t;
+
 typedef struct {
     light_t     lights[MAX_LIGHT];
     GLfloat     ambient[4];
     GLboolean   two_side;
     GLboolean   separate_specular;
     GLboolean   local_viewer;
+    unsigned    generation;     // changed each time a light, the light model or the material is changed
+    lightblock_t block;
 } light_state_t;
 
 typedef struct {
@@ -50,4 +61,7 @@ void gl4es_glMaterialfv(GLenum face, GLenum pname, const GLfloat *params) ;
 void gl4es_glMaterialf(GLenum face, GLenum pname, const GLfloat param);
 void gl4es_glColorMaterial(GLenum face, GLenum mode);
 
+unsigned light_NewGeneration();
+const lightblock_t* light_GetBlock();
+
 #endif // _GL4ES_LIGHT_H_
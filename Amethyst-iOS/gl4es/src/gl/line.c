@@ -1,10 +1,12 @@
 #include "line.h"
 #include <stdio.h>
 
+#include "../glx/hardext.h"
 #include "debug.h"
 #include "gl4es.h"
 #include "glstate.h"
 #include "list.h"
+#include "loader.h"
 #include "matrix.h"
 #include "matvec.h"
 
@@ -15,6 +17,14 @@
 #define DBG(a)
 #endif
 
+void gl4es_glLineWidth(GLfloat width) {
+    PUSH_IF_COMPILING(glLineWidth);
+    attrib_changed(GL_LINE_BIT);
+    LOAD_GLES(glLineWidth);
+    gles_glLineWidth(width);
+}
+void glLineWidth(GLfloat width) AliasExport("gl4es_glLineWidth");
+
 void gl4es_glLineStipple(GLuint factor, GLushort pattern) {
     DBG(printf("glLineStipple(%d, 0x%04X)\n", factor, pattern);)
     if(glstate->list.active) {
@@ -28,6 +38,13 @@ void gl4es_glLineStipple(GLuint factor, GLushort pattern) {
     }
     if(factor<1) factor = 1;
     if(factor>256) factor = 256;
+    if(hardext.esversion>1) {
+        // the FPE fragment shader tests the pattern itself, no texture needed
+        glstate->linestipple.factor = factor;
+        glstate->linestipple.pattern = pattern;
+        noerrorShim();
+        return;
+    }
     if(pattern!=glstate->linestipple.pattern || factor!=glstate->linestipple.factor || !glstate->linestipple.texture) {
         glstate->linestipple.factor = factor;
         glstate->linestipple.pattern = pattern;
@@ -70,6 +87,14 @@ void bind_stipple_tex() {
     gl4es_glBindTexture(GL_TEXTURE_2D, glstate->linestipple.texture);
 }
 
+static inline void stipple_coord(GLfloat *texPos, GLfloat len, GLfloat pat_lo, GLfloat pat_hi) {
+    texPos[0] = len;
+    // the pattern bytes are only used by the FPE fragment shader, the 1 texel high ES1.1 texture ignores them
+    texPos[1] = pat_lo;
+    texPos[2] = pat_hi;
+    texPos[3] = 1.0f;
+}
+
 GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *modes, int stride, int length, GLfloat* noalloctex) {
     DBG(printf("Generate stripple tex (stride=%d, noalloctex=%p) length=%d:", stride, noalloctex, length);)
     // generate our texture coords
@@ -88,6 +113,9 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
     // projected coordinates here, and transform to screen pixel using viewport
     // because projected coordinates are from -1. to +1., w and h are to be divided by 2...
     w*=0.5f; h*=0.5f;
+    // +0.5 keeps the fragment shader bit test away from rounding edges
+    const GLfloat pat_lo = (glstate->linestipple.pattern&0xff)+0.5f;
+    const GLfloat pat_hi = (glstate->linestipple.pattern>>8)+0.5f;
     int i=0;
     for (int k=0; k<length; k++) {
         GLenum mode = modes[k].mode_init;
@@ -122,14 +150,12 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
                 DBG(printf("%f->%f (%f,%f -> %f,%f)\t", oldlen, len, x1, y1, x2, y2);)
                 if(sindices)
                     texPos = tex+texstride*sindices[i+0];   // it get writen 2*, but that should be ok, it's the same value
-                memset(texPos, 0, 4*sizeof(GLfloat));
-                texPos[0] = oldlen; texPos[3] = 1.0f;
+                stipple_coord(texPos, oldlen, pat_lo, pat_hi);
                 if(sindices)
                     texPos = tex+texstride*sindices[i+1];
                 else
                     texPos+=texstride;
-                memset(texPos, 0, 4*sizeof(GLfloat));
-                texPos[0] = len; texPos[3] = 1.0f;
+                stipple_coord(texPos, len, pat_lo, pat_hi);
                 texPos+=texstride;
             }
         else { // GL_LINE_STRIP and GL_LINE_LOOPS works the same here 
@@ -140,8 +166,9 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
             x2=(v[0]/v[3])*w; y2=(v[1]/v[3])*h;
             vertPos+=stride;
             DBG(printf("%f\t", len);)
-            memset(texPos, 0, 4*sizeof(GLfloat));
-            texPos[0] = len; texPos[3] = 1.0f;
+            if(sindices)
+                texPos = tex+texstride*sindices[i];
+            stipple_coord(texPos, len, pat_lo, pat_hi);
             texPos+=texstride;
             ++i;
             for (; i < modes[k].ilen; i++) {
@@ -155,8 +182,7 @@ GLfloat *gen_stipple_tex_coords(GLfloat *vert, GLushort *sindices, modeinit_t *m
                 DBG(printf("->%f\t", len);)
                 if(sindices)
                     texPos = tex+texstride*sindices[i];
-                memset(texPos, 0, 4*sizeof(GLfloat));
-                texPos[0] = len; texPos[3] = 1.0f;
+                stipple_coord(texPos, len, pat_lo, pat_hi);
                 texPos+=texstride;
             }
         }
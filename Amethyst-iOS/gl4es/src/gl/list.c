@@ -14,6 +14,8 @@ KHASH_MAP_IMPL_INT(texgen, rendertexgen_t *);
 KHASH_MAP_IMPL_INT(texenv, rendertexenv_t *);
 KHASH_MAP_IMPL_INT(gllisthead, renderlist_t*);
 
+static GLuint renderlist_serial = 0;
+
 renderlist_t *alloc_renderlist() {
     int a;
 
@@ -25,6 +27,8 @@ renderlist_t *alloc_renderlist() {
     list->lightmodelparam = GL_LIGHT_MODEL_AMBIENT;
     list->target_texture = GL_TEXTURE_2D;
     list->tmu = glstate->texture.active;
+    if(!++renderlist_serial) ++renderlist_serial;
+    list->serial = renderlist_serial;
 
     memcpy(list->lastNormal, glstate->normal, 3*sizeof(GLfloat));
     memcpy(list->lastSecondaryColors, glstate->secondary, 3*sizeof(GLfloat));
@@ -617,8 +621,10 @@ renderlist_t* append_calllist(renderlist_t *list, renderlist_t *a)
                 a->shared_calls = (int*)malloc(sizeof(int));
                 *a->shared_calls = 0;
             }
-            // batch copy first
+            // batch copy first (but keep the new serial)
+            GLuint serial = new->serial;
             memcpy(new, a, sizeof(renderlist_t));
+            new->serial = serial;
             list->next = new;
             new->prev = list;
             // ok, now on new list
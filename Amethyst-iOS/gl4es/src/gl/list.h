@@ -144,6 +144,7 @@ typedef struct _renderlist_t {
     GLenum mode;
     GLenum mode_init;		// initial requested mode
     GLuint name;
+    GLuint serial;          // unique for the life of the list, 0 is never used
     modeinit_t* mode_inits;   // array of requested/len, for the merger
     int     mode_init_cap;
     int     mode_init_len;
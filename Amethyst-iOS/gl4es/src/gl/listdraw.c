@@ -575,7 +575,7 @@ void draw_renderlist(renderlist_t *list) {
         #define TEXTURE(A) if (cur_tex!=A) {gl4es_glClientActiveTexture(A+GL_TEXTURE0); cur_tex=A;}
         stipple = false;
         if ((list->mode == GL_LINES || list->mode == GL_LINE_STRIP || list->mode == GL_LINE_LOOP)
-                && glstate->enable.line_stipple) {
+                && glstate->enable.line_stipple && (hardext.esversion==1 || !glstate->glsl->program)) {
             stipple = true;
             if(get_target(glstate->enable.texture[0])!=-1)
                 stipple_tmu = 1;
@@ -584,37 +584,43 @@ void draw_renderlist(renderlist_t *list) {
         }
         if (stipple) {
             if(!use_vbo_array) use_vbo_array = 1;
-            stipple_old = glstate->gleshard->active;
-            if(glstate->gleshard->active!=stipple_tmu) {
-                LOAD_GLES(glActiveTexture);
-                gl4es_glActiveTexture(GL_TEXTURE0+stipple_tmu);
-            }
-            TEXTURE(stipple_tmu);
-            GLenum matmode;
-            gl4es_glGetIntegerv(GL_MATRIX_MODE, &matmode);
-            gl4es_glMatrixMode(GL_TEXTURE);
-            gl4es_glPushMatrix();
-            gl4es_glLoadIdentity();
-            gl4es_glMatrixMode(matmode);
-            stipple_env = glstate->texenv[stipple_tmu].env.mode;
-            gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-            stipple_tex2d = gl4es_glIsEnabled(GL_TEXTURE_2D);
-            stipple_alpha = gl4es_glIsEnabled(GL_ALPHA_TEST);
-            gl4es_glEnable(GL_TEXTURE_2D);
-            gl4es_glEnable(GL_ALPHA_TEST);
-            for (int k=0; k<4; k++) {
-                stipple_texgen[k] = gl4es_glIsEnabled(GL_TEXTURE_GEN_S+k);
-                if(stipple_texgen[k])
-                    gl4es_glDisable(GL_TEXTURE_GEN_S+k);
+            if(hardext.esversion>1) {
+                // the FPE fragment shader tests the pattern, it only needs the distance along the lines
+                glstate->fpe_state->stipple = 1;
+                glstate->fpe_state->stipple_tmu = stipple_tmu;
+            } else {
+                stipple_old = glstate->gleshard->active;
+                if(glstate->gleshard->active!=stipple_tmu) {
+                    LOAD_GLES(glActiveTexture);
+                    gl4es_glActiveTexture(GL_TEXTURE0+stipple_tmu);
+                }
+                TEXTURE(stipple_tmu);
+                GLenum matmode;
+                gl4es_glGetIntegerv(GL_MATRIX_MODE, &matmode);
+                gl4es_glMatrixMode(GL_TEXTURE);
+                gl4es_glPushMatrix();
+                gl4es_glLoadIdentity();
+                gl4es_glMatrixMode(matmode);
+                stipple_env = glstate->texenv[stipple_tmu].env.mode;
+                gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+                stipple_tex2d = gl4es_glIsEnabled(GL_TEXTURE_2D);
+                stipple_alpha = gl4es_glIsEnabled(GL_ALPHA_TEST);
+                gl4es_glEnable(GL_TEXTURE_2D);
+                gl4es_glEnable(GL_ALPHA_TEST);
+                for (int k=0; k<4; k++) {
+                    stipple_texgen[k] = gl4es_glIsEnabled(GL_TEXTURE_GEN_S+k);
+                    if(stipple_texgen[k])
+                        gl4es_glDisable(GL_TEXTURE_GEN_S+k);
+                }
+                stipple_afunc = glstate->alphafunc;
+                stipple_aref = glstate->alpharef;
+                gl4es_glAlphaFunc(GL_GREATER, 0.0f);
+                bind_stipple_tex();
             }
-            stipple_afunc = glstate->alphafunc;
-            stipple_aref = glstate->alpharef;
-            gl4es_glAlphaFunc(GL_GREATER, 0.0f);
-            bind_stipple_tex();
             modeinit_t tmp; tmp.mode_init = list->mode_init; tmp.ilen=list->ilen?list->ilen:list->len;
             list->tex[stipple_tmu] = gen_stipple_tex_coords(list->vert, list->indices, list->mode_inits?list->mode_inits:&tmp, list->vert_stride, list->mode_inits?list->mode_init_len:1, (list->use_glstate)?(list->vert+8+stipple_tmu*4):NULL);
         }
-        #define RS(A, len) if(glstate->texgenedsz[A]<len) {free(glstate->texgened[A]); glstate->texgened[A]=malloc(4*sizeof(GLfloat)*len); glstate->texgenedsz[A]=len; } use_texgen[A]=1
+        #define RS(A, len) if(glstate->texgenedsz[A]<len) {free(glstate->texgened[A]); glstate->texgened[A]=malloc(4*sizeof(GLfloat)*len); glstate->texgenedsz[A]=len; glstate->texgen_cache[A].serial=0; } use_texgen[A]=1
         // cannot use list->maxtex because some TMU can be using TexGen or point sprites...
         if(hardext.esversion==1) {
             for (int a=0; a<hardext.maxtex; a++) {
@@ -625,14 +631,16 @@ void draw_renderlist(renderlist_t *list) {
                     if ((glstate->enable.texgen_s[a] || glstate->enable.texgen_t[a] || glstate->enable.texgen_r[a]  || glstate->enable.texgen_q[a])) {
                         TEXTURE(a);
                         RS(a, list->len);
-                        gen_tex_coords(list->vert, list->normal, &glstate->texgened[a], list->len, &needclean[a], a, (list->ilen<list->len)?indices:NULL, (list->ilen<list->len)?list->ilen:0);
+                        gen_tex_coords(list->vert, list->normal, &glstate->texgened[a], list->len, &needclean[a], a, (list->ilen<list->len)?indices:NULL, (list->ilen<list->len)?list->ilen:0, list->serial);
                     } else if ((list->tex[a]==NULL) && !(list->mode==GL_POINT && glstate->texture.pscoordreplace[a])) {
                         RS(a, list->len);
-                        gen_tex_coords(list->vert, list->normal, &glstate->texgened[a], list->len, &needclean[a], a, (list->ilen<list->len)?indices:NULL, (list->ilen<list->len)?list->ilen:0);
+                        gen_tex_coords(list->vert, list->normal, &glstate->texgened[a], list->len, &needclean[a], a, (list->ilen<list->len)?indices:NULL, (list->ilen<list->len)?list->ilen:0, list->serial);
                     }
                     // adjust the tex_coord now if needed, even on texgened ones
                     gltexture_t *bound = glstate->texture.bound[a][itarget];
                     if((list->tex[a] || (use_texgen[a] && !needclean[a])) && ((!(globals4es.texmat || glstate->texture_matrix[a]->identity)) || (bound->adjust))) {
+                        // texgened is modified in place, it cannot be reused as-is on next draw
+                        glstate->texgen_cache[a].serial = 0;
                         if(!use_texgen[a]) {
                             RS(a, list->len);
                             if(list->tex_stride[a]) {
@@ -814,30 +822,35 @@ void draw_renderlist(renderlist_t *list) {
             if(!list->use_glstate)   //TODO: avoid that malloc/free...
                 free(list->tex[stipple_tmu]);
             list->tex[stipple_tmu]=NULL;
-            LOAD_GLES(glActiveTexture);
-            if(glstate->gleshard->active!=stipple_tmu)
-                gl4es_glActiveTexture(GL_TEXTURE0+stipple_tmu);
-            GLenum matmode;
-            gl4es_glGetIntegerv(GL_MATRIX_MODE, &matmode);
-            gl4es_glMatrixMode(GL_TEXTURE);
-            gl4es_glPopMatrix();
-            gl4es_glMatrixMode(matmode);
-            gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, stipple_env);
-            gl4es_glAlphaFunc(stipple_afunc, stipple_aref);
-            if(stipple_tex2d)
-                gl4es_glEnable(GL_TEXTURE_2D);
-            else
-                gl4es_glDisable(GL_TEXTURE_2D);
-            if(stipple_alpha)
-                gl4es_glEnable(GL_ALPHA_TEST);
-            else
-                gl4es_glDisable(GL_ALPHA_TEST);
-            for (int k=0; k<4; k++) {
-                if(stipple_texgen[k])
-                    gl4es_glEnable(GL_TEXTURE_GEN_S+k);
+            if(hardext.esversion>1) {
+                glstate->fpe_state->stipple = 0;
+                glstate->fpe_state->stipple_tmu = 0;
+            } else {
+                LOAD_GLES(glActiveTexture);
+                if(glstate->gleshard->active!=stipple_tmu)
+                    gl4es_glActiveTexture(GL_TEXTURE0+stipple_tmu);
+                GLenum matmode;
+                gl4es_glGetIntegerv(GL_MATRIX_MODE, &matmode);
+                gl4es_glMatrixMode(GL_TEXTURE);
+                gl4es_glPopMatrix();
+                gl4es_glMatrixMode(matmode);
+                gl4es_glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, stipple_env);
+                gl4es_glAlphaFunc(stipple_afunc, stipple_aref);
+                if(stipple_tex2d)
+                    gl4es_glEnable(GL_TEXTURE_2D);
+                else
+                    gl4es_glDisable(GL_TEXTURE_2D);
+                if(stipple_alpha)
+                    gl4es_glEnable(GL_ALPHA_TEST);
+                else
+                    gl4es_glDisable(GL_ALPHA_TEST);
+                for (int k=0; k<4; k++) {
+                    if(stipple_texgen[k])
+                        gl4es_glEnable(GL_TEXTURE_GEN_S+k);
+                }
+                if(glstate->gleshard->active!=stipple_old)
+                    gl4es_glActiveTexture(GL_TEXTURE0+stipple_old);
             }
-            if(glstate->gleshard->active!=stipple_old)
-                gl4es_glActiveTexture(GL_TEXTURE0+stipple_old);
         }
         if(list->post_color) gl4es_glColor4fv(list->post_colors);
         if(list->post_normal) gl4es_glNormal3fv(list->post_normals);
@@ -54,6 +54,21 @@ static int update_current_identity(int I) {
 	}
 }
 
+static int get_current_identity() {
+	switch(glstate->matrix_mode) {
+		case GL_MODELVIEW:
+			return glstate->modelview_matrix->identity;
+		case GL_PROJECTION:
+			return glstate->projection_matrix->identity;
+		case GL_TEXTURE:
+			return glstate->texture_matrix[glstate->texture.active]->identity;
+		default:
+			if(glstate->matrix_mode>=GL_MATRIX0_ARB && glstate->matrix_mode<GL_MATRIX0_ARB+MAX_ARB_MATRIX)
+				return glstate->arb_matrix[glstate->matrix_mode-GL_MATRIX0_ARB]->identity;
+		return 0;
+	}
+}
+
 static int send_to_hardware() {
 	if(hardext.esversion>1)
 		return 0;
@@ -89,6 +104,10 @@ DBG(printf("init_matrix(%p)\n", glstate);)
 	memset(glstate->normal_matrix, 0, 9*sizeof(GLfloat));
 	glstate->normal_matrix[0] = glstate->normal_matrix[4] = glstate->normal_matrix[8] = 1.0f;
 	glstate->normal_matrix_dirty = 1;
+	set_identity(glstate->inv_mvp_matrix);
+	glstate->inv_mvp_matrix_dirty = 0;
+	set_identity(glstate->inv_p_matrix);
+	glstate->inv_p_matrix_dirty = 0;
     for (int i=0; i<MAX_TEX; i++) {
         alloc_matrix(&glstate->texture_matrix[i], MAX_STACK_TEXTURE);
         set_identity(TOP(texture_matrix[i]));
@@ -108,6 +127,24 @@ void set_fpe_textureidentity() {
 		glstate->fpe_state->texture[glstate->texture.active].texmat = 1;
 }
 
+// flag the derived matrices (computed lazily in matrix.h) that depends on current matrix
+static void matrix_changed() {
+	switch(glstate->matrix_mode) {
+		case GL_MODELVIEW:
+			glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
+			glstate->mvp_matrix_dirty = glstate->inv_mvp_matrix_dirty = 1;
+			break;
+		case GL_PROJECTION:
+			glstate->inv_p_matrix_dirty = 1;
+			glstate->mvp_matrix_dirty = glstate->inv_mvp_matrix_dirty = 1;
+			break;
+		case GL_TEXTURE:
+			if(glstate->fpe_state)
+				set_fpe_textureidentity();
+			break;
+	}
+}
+
 void gl4es_glMatrixMode(GLenum mode) {
 DBG(printf("glMatrixMode(%s), list=%p\n", PrintEnum(mode), glstate->list.active);)
 	noerrorShim();
@@ -121,6 +158,7 @@ DBG(printf("glMatrixMode(%s), list=%p\n", PrintEnum(mode), glstate->list.active)
 		return;
 	}
     if(glstate->matrix_mode != mode) {
+			attrib_changed(GL_TRANSFORM_BIT);
 			glstate->matrix_mode = mode;
 			LOAD_GLES_FPE(glMatrixMode);
 			gles_glMatrixMode(mode);
@@ -183,25 +221,23 @@ DBG(printf("glPopMatrix(), list=%p\n", glstate->list.active);)
 	// go...
 	noerrorShim();
 	switch(matrix_mode) {
+		// derived matrices only need an update if the pop'd matrix is different
 		#define P(A) if(glstate->A->top) { \
+			int changed = memcmp(TOP(A)-16, TOP(A), 16*sizeof(GLfloat)); \
 			--glstate->A->top; \
 			glstate->A->identity = is_identity(update_current_mat()); \
+			if(changed) \
+				matrix_changed(); \
 			if (send_to_hardware()) {LOAD_GLES(glLoadMatrixf); gles_glLoadMatrixf(update_current_mat()); } \
 		} else errorShim(GL_STACK_UNDERFLOW)
 		case GL_PROJECTION:
 			P(projection_matrix);
-			glstate->mvp_matrix_dirty = 1;
 			break;
 		case GL_MODELVIEW:
 			P(modelview_matrix);
-			glstate->mvp_matrix_dirty = 1;
-			glstate->inv_mv_matrix_dirty = 1;
-			glstate->normal_matrix_dirty = 1;
 			break;
 		case GL_TEXTURE:
 			P(texture_matrix[glstate->texture.active]);
-			if(glstate->fpe_state)
-				set_fpe_textureidentity();
 			break;
 		default:
 			if(glstate->matrix_mode>=GL_MATRIX0_ARB && glstate->matrix_mode<GL_MATRIX0_ARB+MAX_ARB_MATRIX) {
@@ -227,14 +263,13 @@ DBG(printf("glLoadMatrix(%f, %f, %f, %f, %f, %f, %f...), list=%p\n", m[0], m[1],
 			return;
 		}
 	}
-	memcpy(update_current_mat(), m, 16*sizeof(GLfloat));
-	const int id = update_current_identity(0);
-	if(glstate->matrix_mode==GL_MODELVIEW)
-		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
-	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
-		glstate->mvp_matrix_dirty = 1;
-	else if((glstate->matrix_mode==GL_TEXTURE) && glstate->fpe_state)
-		set_fpe_textureidentity();
+	GLfloat *current_mat = update_current_mat();
+	if(memcmp(current_mat, m, 16*sizeof(GLfloat))) {
+		memcpy(current_mat, m, 16*sizeof(GLfloat));
+		update_current_identity(0);
+		matrix_changed();
+	}
+	const int id = get_current_identity();
     if(send_to_hardware()) {
 		LOAD_GLES(glLoadMatrixf);
 		LOAD_GLES(glLoadIdentity);
@@ -262,12 +297,7 @@ DBG(printf("glMultMatrix(%f, %f, %f, %f, %f, %f, %f...), list=%p\n", m[0], m[1],
 	GLfloat *current_mat = update_current_mat();
 	matrix_mul(current_mat, m, current_mat);
 	const int id = update_current_identity(0);
-	if(glstate->matrix_mode==GL_MODELVIEW)
-		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
-	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
-		glstate->mvp_matrix_dirty = 1;
-	else if((glstate->matrix_mode==GL_TEXTURE) && glstate->fpe_state)
-		set_fpe_textureidentity();
+	matrix_changed();
 	DBG(printf(" => (%f, %f, %f, %f, %f, %f, %f...)\n", current_mat[0], current_mat[1], current_mat[2], current_mat[3], current_mat[4], current_mat[5], current_mat[6]);)
 	if(send_to_hardware()) {
 		LOAD_GLES(glLoadMatrixf);
@@ -288,14 +318,11 @@ DBG(printf("glLoadIdentity(), list=%p\n", glstate->list.active);)
 			return;
 		}
 	}
-	set_identity(update_current_mat());
-	update_current_identity(1);
-	if(glstate->matrix_mode==GL_MODELVIEW)
-		glstate->normal_matrix_dirty = glstate->inv_mv_matrix_dirty = 1;
-	if(glstate->matrix_mode==GL_MODELVIEW || glstate->matrix_mode==GL_PROJECTION)
-		glstate->mvp_matrix_dirty = 1;
-	else if((glstate->matrix_mode==GL_TEXTURE) && glstate->fpe_state)
-		set_fpe_textureidentity();
+	if(!get_current_identity()) {
+		set_identity(update_current_mat());
+		update_current_identity(1);
+		matrix_changed();
+	}
 	if(send_to_hardware()) {
 		LOAD_GLES(glLoadIdentity);
 		gles_glLoadIdentity();
@@ -2,12 +2,19 @@
 
 #include <string.h>
 
+#include "simd.h"
+
+// armv7 inline asm below, AArch64 and x86 use the intrinsics from simd.h
+#if defined(__ARM_NEON__) && !defined(__APPLE__) && !defined(__aarch64__)
+#define MATVEC_NEON32
+#endif
+
 float FASTMATH dot(const float *a, const float *b) {
     return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
 }
 
 float FASTMATH dot4(const float *a, const float *b) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
     register float ret;
     asm volatile (
     "vld1.f32 {d0-d1}, [%1]        \n" //q0 = a(0..3)
@@ -33,7 +40,7 @@ void cross3(const float *a, const float *b, float* c) {
 }
 
 void matrix_vector(const float *a, const float *b, float *c) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
     const float* a1 = a+8;
     asm volatile (
     "vld4.f32 {d0,d2,d4,d6}, [%1]        \n" 
@@ -47,6 +54,15 @@ void matrix_vector(const float *a, const float *b, float *c) {
     ::"r"(c), "r"(a), "r"(a1), "r"(b)
     : "q0", "q1", "q2", "q3", "q4", "memory"
         );
+#elif defined(GL4ES_SIMD_NEON64)
+    // only on NEON, where the transposed load is a single vld4 (on SSE2, the shuffles cost more than the scalar code)
+    simd_f4 t[4];
+    simd_load_t(a, t);  // t[k] = a(k,4+k,8+k,12+k)
+    simd_f4 r = simd_mul_f(t[0], simd_set1_f(b[0]));
+    r = simd_add_f(r, simd_mul_f(t[1], simd_set1_f(b[1])));
+    r = simd_add_f(r, simd_mul_f(t[2], simd_set1_f(b[2])));
+    r = simd_add_f(r, simd_mul_f(t[3], simd_set1_f(b[3])));
+    simd_store_f(c, r);
 #else
     c[0] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
     c[1] = a[4] * b[0] + a[5] * b[1] + a[6] * b[2] + a[7] * b[3];
@@ -56,7 +72,7 @@ void matrix_vector(const float *a, const float *b, float *c) {
 }
 
 void vector_matrix(const float *a, const float *b, float *c) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
     const float* b2=b+4;
     const float* b3=b+8;
     const float* b4=b+12;
@@ -74,6 +90,12 @@ void vector_matrix(const float *a, const float *b, float *c) {
     ::"r"(c), "r"(a), "r"(b), "r"(b2), "r"(b3), "r"(b4)
     : "%2", "q0", "q1", "q2", "memory"
         );
+#elif defined(GL4ES_SIMD)
+    simd_f4 r = simd_mul_f(simd_load_f(b), simd_set1_f(a[0]));
+    r = simd_add_f(r, simd_mul_f(simd_load_f(b+4), simd_set1_f(a[1])));
+    r = simd_add_f(r, simd_mul_f(simd_load_f(b+8), simd_set1_f(a[2])));
+    r = simd_add_f(r, simd_mul_f(simd_load_f(b+12), simd_set1_f(a[3])));
+    simd_store_f(c, r);
 #else
     const float a0=a[0], a1=a[1], a2=a[2], a3=a[3];
     c[0] = a0 * b[0] + a1 * b[4] + a2 * b[8] + a3 * b[12];
@@ -84,7 +106,7 @@ void vector_matrix(const float *a, const float *b, float *c) {
 }
 
 void vector3_matrix(const float *a, const float *b, float *c) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
     const float* b2=b+4;
     const float* b3=b+8;
     const float* b4=b+12;
@@ -105,6 +127,12 @@ void vector3_matrix(const float *a, const float *b, float *c) {
     ::"r"(c), "r"(a), "r"(b), "r"(b2), "r"(b3), "r"(b4)
     : "q0", "q1", "q2", "memory"
         );
+#elif defined(GL4ES_SIMD)
+    simd_f4 r = simd_mul_f(simd_load_f(b), simd_set1_f(a[0]));
+    r = simd_add_f(r, simd_mul_f(simd_load_f(b+4), simd_set1_f(a[1])));
+    r = simd_add_f(r, simd_mul_f(simd_load_f(b+8), simd_set1_f(a[2])));
+    r = simd_add_f(r, simd_load_f(b+12));
+    simd_store_f(c, r);
 #else
     c[0] = a[0] * b[0] + a[1] * b[4] + a[2] * b[8] + b[12];
     c[1] = a[0] * b[1] + a[1] * b[5] + a[2] * b[9] + b[13];
@@ -126,7 +154,7 @@ void vector3_matrix3(const float *a, const float *b, float *c) {
 }
 
 void vector_normalize(float *a) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
         asm volatile (
         "vld1.32                {d4}, [%0]                      \n\t"   //d4={x0,y0}
         "flds                   s10, [%0, #8]                   \n\t"   //d5[0]={z0}
@@ -161,7 +189,7 @@ void vector_normalize(float *a) {
 }
 
 void vector4_normalize(float *a) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
         asm volatile (
         "vld1.32                {q2}, [%0]                      \n\t"   //q2={x0,y0,z0,00}
 
@@ -196,7 +224,7 @@ void vector4_normalize(float *a) {
 void FASTMATH matrix_transpose(const float *a, float *b) {
     // column major -> row major
     // a(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15) -> b(0,4,8,12,1,5,9,13,2,6,10,14,3,7,11,15)
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
    const float* a1 = a+8;
 	float* b1=b+8;
     asm volatile (
@@ -207,6 +235,13 @@ void FASTMATH matrix_transpose(const float *a, float *b) {
     ::"r"(b), "r"(a), "r"(a1), "r"(b1)
     : "q0", "q1", "q2", "q3", "memory"
         );
+#elif defined(GL4ES_SIMD)
+    simd_f4 t[4];
+    simd_load_t(a, t);
+    simd_store_f(b, t[0]);
+    simd_store_f(b+4, t[1]);
+    simd_store_f(b+8, t[2]);
+    simd_store_f(b+12, t[3]);
 #else
     for (int i=0; i<4; i++)
         for (int j=0; j<4; j++)
@@ -259,7 +294,7 @@ void matrix_inverse3_transpose(const float *m, float *r) {
 }
     
 void matrix_mul(const float *a, const float *b, float *c) {
-#if defined(__ARM_NEON__) && !defined(__APPLE__)
+#ifdef MATVEC_NEON32
     const float* a1 = a+8;
 	const float* b1=b+8;
     float* c1=c+8;
@@ -290,6 +325,19 @@ void matrix_mul(const float *a, const float *b, float *c) {
     : "q0", "q1", "q2", "q3", 
       "q8", "q9", "q10", "q11", "q12", "q13", "q14", "q15", "memory"
         );
+#elif defined(GL4ES_SIMD)
+    // c can alias a or b, so load everything first
+    const simd_f4 a0 = simd_load_f(a), a1 = simd_load_f(a+4), a2 = simd_load_f(a+8), a3 = simd_load_f(a+12);
+    simd_f4 r[4];
+    for (int i=0; i<4; i++) {
+        const float* bi = b+i*4;
+        r[i] = simd_mul_f(a0, simd_set1_f(bi[0]));
+        r[i] = simd_add_f(r[i], simd_mul_f(a1, simd_set1_f(bi[1])));
+        r[i] = simd_add_f(r[i], simd_mul_f(a2, simd_set1_f(bi[2])));
+        r[i] = simd_add_f(r[i], simd_mul_f(a3, simd_set1_f(bi[3])));
+    }
+    for (int i=0; i<4; i++)
+        simd_store_f(c+i*4, r[i]);
 #else
    float a00 = a[0], a01 = a[1], a02 = a[2], a03 = a[3],
         a10 = a[4], a11 = a[5], a12 = a[6], a13 = a[7],
@@ -323,15 +371,21 @@ void matrix_mul(const float *a, const float *b, float *c) {
 }
 
 void vector4_mult(const float *a, const float *b, float *c) {
-//TODO: NEON version of this
+#ifdef GL4ES_SIMD
+    simd_store_f(c, simd_mul_f(simd_load_f(a), simd_load_f(b)));
+#else
     for (int i=0; i<4; i++)
         c[i] = a[i]*b[i];
+#endif
 }
 
 void vector4_add(const float *a, const float *b, float *c) {
-//TODO: NEON version of this
+#ifdef GL4ES_SIMD
+    simd_store_f(c, simd_add_f(simd_load_f(a), simd_load_f(b)));
+#else
     for (int i=0; i<4; i++)
         c[i] = a[i]+b[i];
+#endif
 }
 
 void vector4_sub(const float *a, const float *b, float *c) {
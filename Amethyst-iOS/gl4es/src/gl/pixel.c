@@ -6,6 +6,9 @@
 #include "gl4es.h"
 #include "glstate.h"
 #include "debug.h"
+#include "init.h"
+#include "simd.h"
+#include "workers.h"
 
 #ifdef __BIG_ENDIAN__
 #define GL_INT8_REV     GL_UNSIGNED_INT_8_8_8_8
@@ -15,23 +18,14 @@
 #define GL_INT8         GL_UNSIGNED_INT_8_8_8_8
 #endif
 
+// bitfields would follow the ABI allocation order (LSB first on little endian), so use plain masks
 typedef union {
     uint16_t bin;
-    struct {
-        uint16_t sign:1;
-        uint16_t exp:5;
-        uint16_t mant:10;
-    } x;
 } halffloat_t;
 
 typedef union {
     float f;
     uint32_t bin;
-    struct {
-        uint32_t sign:1;
-        uint32_t exp:8;
-        uint32_t mant:23;
-    } x;
 } fullfloat_t;
 
 static const colorlayout_t *get_color_map(GLenum format) {
@@ -64,18 +58,17 @@ static const colorlayout_t *get_color_map(GLenum format) {
 static inline float float_h2f(halffloat_t t)
 {
     fullfloat_t tmp;
-    tmp.x.sign = t.x.sign;  // copy sign
-    if(t.x.exp==0 /*&& t.mant==0*/) {
-    // 0 and denormal?
-        tmp.x.exp=0;
-        tmp.x.mant=0;
-    } else if (t.x.exp==31) {
+    const uint32_t sign = (uint32_t)(t.bin&0x8000)<<16;
+    const uint32_t bits = t.bin&0x7fff;
+    if(bits<0x0400) {
+    // 0 and denormal: mant * 2^-24
+        tmp.f = (float)bits * (1.0f/16777216.0f);
+        tmp.bin |= sign;
+    } else if (bits>=0x7c00) {
     // Inf / NaN
-        tmp.x.exp=255;
-        tmp.x.mant=(t.x.mant<<13);
+        tmp.bin = sign | 0x7f800000 | ((bits&0x3ff)<<13);
     } else {
-        tmp.x.mant=(t.x.mant<<13);
-        tmp.x.exp = t.x.exp+0x38;
+        tmp.bin = sign | ((bits<<13) + (112<<23));
     }
 
     return tmp.f;
@@ -86,25 +79,20 @@ static inline halffloat_t float_f2h(float f)
     fullfloat_t tmp;
     halffloat_t ret;
     tmp.f = f;
-    ret.x.sign = tmp.x.sign;
-    if (tmp.x.exp == 0) {
-        // O and denormal
-        ret.bin = 0;
-    } else if (tmp.x.exp==255) {
+    const uint16_t sign = (tmp.bin>>16)&0x8000;
+    const uint32_t exp = (tmp.bin>>23)&0xff;
+    if (exp==255) {
         // Inf / NaN
-        ret.x.exp = 31;
-        ret.x.mant = tmp.x.mant>>13;
-    } else if(tmp.x.exp>0x71) {
-        // flush to 0
-        ret.x.exp = 0;
-        ret.x.mant = 0;
-    } else if(tmp.x.exp<0x8e) {
+        ret.bin = sign | 0x7c00 | ((tmp.bin&0x7fffff)?0x200:0);
+    } else if(exp<113) {
+        // flush to 0 (including denormals)
+        ret.bin = sign;
+    } else if(exp>142) {
         // clamp to max
-        ret.x.exp = 30;
-        ret.x.mant = 1023;
+        ret.bin = sign | 0x7bff;
     } else {
-        ret.x.exp = tmp.x.exp - 38;
-        ret.x.mant = tmp.x.mant>>13;
+        // mantissa is truncated
+        ret.bin = sign | ((exp-112)<<10) | ((tmp.bin>>13)&0x3ff);
     }
 
     return ret;
@@ -752,6 +740,268 @@ bool quarter_pixel(const GLvoid *src[16],
     #undef write_each
 }
 
+#ifdef GL4ES_SIMD
+// Row converters for the most common upload conversions, 4 pixels at a time.
+// Each one gives the exact same result as the scalar path it replaces (the fast loops
+// of pixel_convert, or remap_pixel), which is still used for the tail of the rows,
+// for the other cases, and with LIBGL_NOSIMD=1.
+// Formats with 1 to 3 bytes per pixel would need byte shuffles (not in SSE2), so
+// those are done on 32bits words instead.
+typedef void (*convert_row_t)(const GLubyte *s, GLubyte *d, int n);
+
+static inline simd_u4 simd_swap_rb(simd_u4 v) {
+    return simd_or_u(simd_and_u(v, simd_set1_u(0xff00ff00)),
+        simd_or_u(simd_and_u(simd_shr_u(v, 16), simd_set1_u(0xff)), simd_shl_u(simd_and_u(v, simd_set1_u(0xff)), 16)));
+}
+static inline uint32_t swap_rb(uint32_t v) {
+    return (v&0xff00ff00) | ((v&0x00ff0000)>>16) | ((v&0x000000ff)<<16);
+}
+
+static void row_swap_rb(const GLubyte *s, GLubyte *d, int n) {
+    int i = 0;
+    for (; i+4<=n; i+=4, s+=16, d+=16)
+        simd_store_u(d, simd_swap_rb(simd_load_u(s)));
+    for (; i<n; i++, s+=4, d+=4) {
+        uint32_t v;
+        memcpy(&v, s, 4);
+        v = swap_rb(v);
+        memcpy(d, &v, 4);
+    }
+}
+
+static void row_rgb_rgba(const GLubyte *s, GLubyte *d, int n) {
+    int i = 0;
+    uint32_t w[4];
+    for (; i+4<=n; i+=4, s+=12, d+=16) {
+        memcpy(w, s, 12);
+        w[3] = (w[2]>>8) | 0xff000000;
+        w[2] = (w[1]>>16) | (w[2]<<16) | 0xff000000;
+        w[1] = (w[0]>>24) | (w[1]<<8) | 0xff000000;
+        w[0] |= 0xff000000;
+        memcpy(d, w, 16);
+    }
+    for (; i<n; i++, s+=3, d+=4) {
+        d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 255;
+    }
+}
+
+static void row_l_rgba(const GLubyte *s, GLubyte *d, int n) {
+    for (int i=0; i<n; i++, d+=4) {
+        uint32_t v = s[i]*0x010101u | 0xff000000;
+        memcpy(d, &v, 4);
+    }
+}
+static void row_la_rgba(const GLubyte *s, GLubyte *d, int n) {
+    for (int i=0; i<n; i++, s+=2, d+=4) {
+        uint32_t v = s[0]*0x010101u | ((uint32_t)s[1]<<24);
+        memcpy(d, &v, 4);
+    }
+}
+
+// 565/4444/5551 -> 8888. The float expansion of remap_pixel, (c/max)*255.0, is exactly
+// (c*17) for 4 bits, (c*259+1)>>5 for 565 red/blue (read as c*2/63) and (c*259+3)>>6 for 6 bits
+static void row_565_rgba(const GLubyte *s, GLubyte *d, int n) {
+    int i = 0;
+    const simd_u4 m5 = simd_set1_u(0x1f), m6 = simd_set1_u(0x3f), k = simd_set1_u(259);
+    const simd_u4 one = simd_set1_u(1), three = simd_set1_u(3), alpha = simd_set1_u(0xff000000);
+    for (; i+4<=n; i+=4, s+=8, d+=16) {
+        simd_u4 v = simd_load_us4(s);
+        simd_u4 r = simd_shr_u(simd_add_u(simd_mul15_u(simd_shr_u(v, 11), k), one), 5);
+        simd_u4 g = simd_shr_u(simd_add_u(simd_mul15_u(simd_and_u(simd_shr_u(v, 5), m6), k), three), 6);
+        simd_u4 b = simd_shr_u(simd_add_u(simd_mul15_u(simd_and_u(v, m5), k), one), 5);
+        simd_store_u(d, simd_or_u(simd_or_u(r, simd_shl_u(g, 8)), simd_or_u(simd_shl_u(b, 16), alpha)));
+    }
+    for (; i<n; i++, s+=2, d+=4) {
+        GLushort v;
+        memcpy(&v, s, 2);
+        d[0] = (((v>>11)&0x1f)*259+1)>>5;
+        d[1] = (((v>>5)&0x3f)*259+3)>>6;
+        d[2] = ((v&0x1f)*259+1)>>5;
+        d[3] = 255;
+    }
+}
+static void row_4444_rgba(const GLubyte *s, GLubyte *d, int n) {
+    int i = 0;
+    const simd_u4 m = simd_set1_u(0x0f), k = simd_set1_u(17);
+    for (; i+4<=n; i+=4, s+=8, d+=16) {
+        simd_u4 v = simd_load_us4(s);
+        simd_u4 r = simd_mul15_u(simd_shr_u(v, 12), k);
+        simd_u4 g = simd_mul15_u(simd_and_u(simd_shr_u(v, 8), m), k);
+        simd_u4 b = simd_mul15_u(simd_and_u(simd_shr_u(v, 4), m), k);
+        simd_u4 a = simd_mul15_u(simd_and_u(v, m), k);
+        simd_store_u(d, simd_or_u(simd_or_u(r, simd_shl_u(g, 8)), simd_or_u(simd_shl_u(b, 16), simd_shl_u(a, 24))));
+    }
+    for (; i<n; i++, s+=2, d+=4) {
+        GLushort v;
+        memcpy(&v, s, 2);
+        d[0] = ((v>>12)&0x0f)*17;
+        d[1] = ((v>>8)&0x0f)*17;
+        d[2] = ((v>>4)&0x0f)*17;
+        d[3] = (v&0x0f)*17;
+    }
+}
+static void row_5551_rgba(const GLubyte *s, GLubyte *d, int n) {
+    int i = 0;
+    const simd_u4 m = simd_set1_u(0x1f<<3), one = simd_set1_u(1), alpha = simd_set1_u(0xff000000);
+    for (; i+4<=n; i+=4, s+=8, d+=16) {
+        simd_u4 v = simd_load_us4(s);
+        simd_u4 r = simd_and_u(simd_shr_u(v, 8), m);
+        simd_u4 g = simd_and_u(simd_shr_u(v, 3), m);
+        simd_u4 b = simd_and_u(simd_shl_u(v, 2), m);
+        simd_u4 a = simd_and_u(simd_cmpeq_u(simd_and_u(v, one), one), alpha);
+        simd_store_u(d, simd_or_u(simd_or_u(r, simd_shl_u(g, 8)), simd_or_u(simd_shl_u(b, 16), a)));
+    }
+    for (; i<n; i++, s+=2, d+=4) {
+        GLushort v;
+        memcpy(&v, s, 2);
+        d[0] = ((v>>11)&0x1f)<<3;
+        d[1] = ((v>>6)&0x1f)<<3;
+        d[2] = ((v>>1)&0x1f)<<3;
+        d[3] = (v&0x01)?255:0;
+    }
+}
+
+// 8888 -> 565/4444/5551, with the truncation of the fast loops of pixel_convert
+static inline simd_u4 simd_to_565(simd_u4 v) {
+    return simd_or_u(simd_or_u(simd_shl_u(simd_and_u(v, simd_set1_u(0xf8)), 8), simd_and_u(simd_shr_u(v, 5), simd_set1_u(0x7e0))),
+        simd_and_u(simd_shr_u(v, 19), simd_set1_u(0x1f)));
+}
+static inline simd_u4 simd_to_4444(simd_u4 v) {
+    return simd_or_u(simd_or_u(simd_shl_u(simd_and_u(v, simd_set1_u(0xf0)), 8), simd_and_u(simd_shr_u(v, 4), simd_set1_u(0xf00))),
+        simd_or_u(simd_and_u(simd_shr_u(v, 16), simd_set1_u(0xf0)), simd_shr_u(v, 28)));
+}
+static inline simd_u4 simd_to_5551(simd_u4 v) {
+    return simd_or_u(simd_or_u(simd_shl_u(simd_and_u(v, simd_set1_u(0xf8)), 8), simd_and_u(simd_shr_u(v, 5), simd_set1_u(0x7c0))),
+        simd_or_u(simd_and_u(simd_shr_u(v, 18), simd_set1_u(0x3e)), simd_shr_u(v, 31)));
+}
+static inline GLushort to_565(uint32_t v) {
+    return ((v&0xf8)<<8) | ((v>>5)&0x7e0) | ((v>>19)&0x1f);
+}
+static inline GLushort to_4444(uint32_t v) {
+    return ((v&0xf0)<<8) | ((v>>4)&0xf00) | ((v>>16)&0xf0) | (v>>28);
+}
+static inline GLushort to_5551(uint32_t v) {
+    return ((v&0xf8)<<8) | ((v>>5)&0x7c0) | ((v>>18)&0x3e) | (v>>31);
+}
+#define ROW_TO_16(name, conv, swap)                                 \
+static void name(const GLubyte *s, GLubyte *d, int n) {            \
+    int i = 0;                                                      \
+    for (; i+4<=n; i+=4, s+=16, d+=8) {                             \
+        simd_u4 v = simd_load_u(s);                                 \
+        if(swap) v = simd_swap_rb(v);                               \
+        simd_store_us4(d, simd_##conv(v));                          \
+    }                                                               \
+    for (; i<n; i++, s+=4, d+=2) {                                  \
+        uint32_t v;                                                 \
+        memcpy(&v, s, 4);                                           \
+        if(swap) v = swap_rb(v);                                    \
+        GLushort r = conv(v);                                       \
+        memcpy(d, &r, 2);                                           \
+    }                                                               \
+}
+ROW_TO_16(row_rgba_565, to_565, 0)
+ROW_TO_16(row_bgra_565, to_565, 1)
+ROW_TO_16(row_rgba_4444, to_4444, 0)
+ROW_TO_16(row_bgra_4444, to_4444, 1)
+ROW_TO_16(row_rgba_5551, to_5551, 0)
+ROW_TO_16(row_bgra_5551, to_5551, 1)
+#undef ROW_TO_16
+
+// half float <-> float, same rules as float_h2f / float_f2h
+static inline simd_f4 simd_h2f(simd_u4 h) {
+    const simd_u4 sign = simd_shl_u(simd_and_u(h, simd_set1_u(0x8000)), 16);
+    const simd_u4 bits = simd_and_u(h, simd_set1_u(0x7fff));
+    simd_u4 norm = simd_add_u(simd_shl_u(bits, 13), simd_set1_u(112<<23));
+    // Inf / NaN: exponent goes to 255
+    norm = simd_select_u(simd_cmpgt_u(bits, simd_set1_u(0x7bff)), simd_add_u(norm, simd_set1_u(112<<23)), norm);
+    // 0 and denormal: mant * 2^-24
+    simd_u4 denorm = simd_as_u(simd_mul_f(simd_cvt_u(bits), simd_set1_f(1.0f/16777216.0f)));
+    return simd_as_f(simd_or_u(sign, simd_select_u(simd_cmpgt_u(simd_set1_u(0x0400), bits), denorm, norm)));
+}
+static inline simd_u4 simd_f2h(simd_f4 f) {
+    const simd_u4 v = simd_as_u(f);
+    const simd_u4 sign = simd_and_u(simd_shr_u(v, 16), simd_set1_u(0x8000));
+    const simd_u4 exp = simd_and_u(simd_shr_u(v, 23), simd_set1_u(0xff));
+    simd_u4 h = simd_or_u(simd_shl_u(simd_add_u(exp, simd_set1_u(-112)), 10), simd_and_u(simd_shr_u(v, 13), simd_set1_u(0x3ff)));
+    h = simd_select_u(simd_cmpgt_u(exp, simd_set1_u(142)), simd_set1_u(0x7bff), h);
+    h = simd_select_u(simd_cmpgt_u(simd_set1_u(113), exp), simd_set1_u(0), h);
+    const simd_u4 nan = simd_select_u(simd_cmpeq_u(simd_and_u(v, simd_set1_u(0x7fffff)), simd_set1_u(0)), simd_set1_u(0x7c00), simd_set1_u(0x7e00));
+    h = simd_select_u(simd_cmpeq_u(exp, simd_set1_u(255)), nan, h);
+    return simd_or_u(sign, h);
+}
+
+// float conversions work on components, n is the number of pixels of 4 components
+static void row_f32_ub(const GLubyte *s, GLubyte *d, int n) {
+    const float *f = (const float*)s;
+    for (int i=0; i<n; i++, f+=4, d+=4) {
+        uint32_t v = simd_cvt_ub4_dbl(simd_load_f(f), 255.0);
+        memcpy(d, &v, 4);
+    }
+}
+static void row_h16_ub(const GLubyte *s, GLubyte *d, int n) {
+    for (int i=0; i<n; i++, s+=8, d+=4) {
+        uint32_t v = simd_cvt_ub4_dbl(simd_h2f(simd_load_us4(s)), 255.0);
+        memcpy(d, &v, 4);
+    }
+}
+static void row_h16_f32(const GLubyte *s, GLubyte *d, int n) {
+    for (int i=0; i<n; i++, s+=8, d+=16)
+        simd_store_f(d, simd_h2f(simd_load_us4(s)));
+}
+static void row_f32_h16(const GLubyte *s, GLubyte *d, int n) {
+    for (int i=0; i<n; i++, s+=16, d+=8)
+        simd_store_us4(d, simd_f2h(simd_load_f(s)));
+}
+static void row_ub_h16(const GLubyte *s, GLubyte *d, int n) {
+    const simd_f4 k = simd_set1_f(255.0f);
+    for (int i=0; i<n; i++, s+=4, d+=8) {
+        uint32_t v;
+        memcpy(&v, s, 4);
+        simd_store_us4(d, simd_f2h(simd_div_f(simd_cvt_ub4(v), k)));
+    }
+}
+static void row_ub_f32(const GLubyte *s, GLubyte *d, int n) {
+    const simd_f4 k = simd_set1_f(255.0f);
+    for (int i=0; i<n; i++, s+=4, d+=16) {
+        uint32_t v;
+        memcpy(&v, s, 4);
+        simd_store_f(d, simd_div_f(simd_cvt_ub4(v), k));
+    }
+}
+
+static convert_row_t get_convert_row(GLenum src_format, GLenum src_type, GLenum dst_format, GLenum dst_type) {
+    static const struct {
+        GLenum src_format, src_type, dst_format, dst_type;
+        convert_row_t row;
+    } rows[] = {
+        {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_swap_rb},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_BGRA, GL_UNSIGNED_BYTE, row_swap_rb},
+        {GL_RGB, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_rgb_rgba},
+        {GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_l_rgba},
+        {GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE, row_la_rgba},
+        {GL_RGB, GL_UNSIGNED_SHORT_5_6_5, GL_RGBA, GL_UNSIGNED_BYTE, row_565_rgba},
+        {GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, GL_RGBA, GL_UNSIGNED_BYTE, row_4444_rgba},
+        {GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, GL_RGBA, GL_UNSIGNED_BYTE, row_5551_rgba},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_rgba_565},
+        {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, row_bgra_565},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, row_rgba_4444},
+        {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, row_bgra_4444},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, row_rgba_5551},
+        {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, row_bgra_5551},
+        {GL_RGBA, GL_FLOAT, GL_RGBA, GL_UNSIGNED_BYTE, row_f32_ub},
+        {GL_RGBA, GL_HALF_FLOAT_OES, GL_RGBA, GL_UNSIGNED_BYTE, row_h16_ub},
+        {GL_RGBA, GL_HALF_FLOAT_OES, GL_RGBA, GL_FLOAT, row_h16_f32},
+        {GL_RGBA, GL_FLOAT, GL_RGBA, GL_HALF_FLOAT_OES, row_f32_h16},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_HALF_FLOAT_OES, row_ub_h16},
+        {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_FLOAT, row_ub_f32},
+    };
+    for (int i=0; i<sizeof(rows)/sizeof(rows[0]); i++)
+        if(rows[i].src_format==src_format && rows[i].src_type==src_type && rows[i].dst_format==dst_format && rows[i].dst_type==dst_type)
+            return rows[i].row;
+    return NULL;
+}
+#endif // GL4ES_SIMD
+
 bool pixel_convert(const GLvoid *src, GLvoid **dst,
                    GLuint width, GLuint height,
                    GLenum src_format, GLenum src_type,
@@ -795,6 +1045,19 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
         *dst = malloc(dst_size);
     uintptr_t src_pos = widthalign((uintptr_t)src, align);
     uintptr_t dst_pos = widthalign((uintptr_t)*dst, align);
+#ifdef GL4ES_SIMD
+    if(!globals4es.nosimd) {
+        convert_row_t row = get_convert_row(src_format, src_type, dst_format, dst_type);
+        if(row) {
+            for (int i = 0; i < height; i++) {
+                row((const GLubyte*)src_pos, (GLubyte*)dst_pos, width);
+                src_pos += width*src_stride + src_widthadj;
+                dst_pos += width*dst_stride + dst_width;
+            }
+            return true;
+        }
+    }
+#endif
     // fast optimized loop for common conversion cases first...
     // TODO: Rewrite that with some Macro, it's obviously doable to simplify the reading (and writting) of all this
     // simple BGRA <-> RGBA / UNSIGNED_BYTE 
@@ -1005,7 +1268,7 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
     if ((src_format == GL_RGBA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_5_5_5_1) && ((src_type == GL_UNSIGNED_BYTE))) {
         for (int i = 0; i < height; i++) {
 			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[2]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[0]&0xf8)<<(10-2)) | ((GLushort)(((char*)src_pos)[3])>>15);
+				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[2]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[0]&0xf8)<<(10-2)) | ((GLushort)(((GLubyte*)src_pos)[3])>>7);
 				src_pos += src_stride;
 				dst_pos += dst_stride;
 			}
@@ -1018,7 +1281,7 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
     if ((src_format == GL_BGRA) && (dst_format == GL_RGBA) && (dst_type == GL_UNSIGNED_SHORT_5_5_5_1) && ((src_type == GL_UNSIGNED_BYTE))) {
         for (int i = 0; i < height; i++) {
 			for (int j = 0; j < width; j++) {
-				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[0]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[2]&0xf8)<<(10-2)) | ((GLushort)(((char*)src_pos)[3])>>15);
+				*(GLushort*)dst_pos = ((GLushort)(((char*)src_pos)[0]&0xf8)>>(3-1)) | ((GLushort)(((char*)src_pos)[1]&0xf8)<<(5-2)) | ((GLushort)(((char*)src_pos)[2]&0xf8)<<(10-2)) | ((GLushort)(((GLubyte*)src_pos)[3])>>7);
 				src_pos += src_stride;
 				dst_pos += dst_stride;
 			}
@@ -1108,7 +1371,7 @@ bool pixel_convert(const GLvoid *src, GLvoid **dst,
                 tmp[2] = glstate->raster.map_i2b[idx&(glstate->raster.map_i2b_size-1)];
                 tmp[3] = glstate->raster.map_i2a[idx&(glstate->raster.map_i2a_size-1)];
                 remap_pixel((const GLvoid *)tmp, (GLvoid *)dst_pos,
-                                src_color, GL_FLOAT, dst_color, dst_type);
+                                src_color, GL_UNSIGNED_BYTE, dst_color, dst_type);
                 src_pos += src_stride;
                 dst_pos += dst_stride;
             }
@@ -1191,6 +1454,120 @@ bool pixel_scale(const GLvoid *old, GLvoid **new,
     return true;
 }
 
+// Fast path of pixel_halfscale / pixel_quarterscale for GL_UNSIGNED_BYTE formats where each byte is a component.
+// It does the exact same float math as half_pixel / quarter_pixel, so the result is bit identical,
+// and it's split in slices of rows for the worker threads.
+typedef struct {
+    const GLubyte *src;
+    GLubyte *dst;
+    GLuint width, new_width, bpp;
+    int dx, dy;             // halfscale: offset of the 2nd pixel
+    int dxs[4], dys[4];     // quarterscale: offsets of the 4 pixels
+} scale_job_t;
+
+static float ub_to_float[256];  // i/255.0f, same value as the division done in half_pixel
+
+static void init_ub_to_float() {
+    if(ub_to_float[255]==0.0f)
+        for (int i=0; i<256; i++)
+            ub_to_float[i] = i / 255.0f;
+}
+
+static void halfscale_ub_rows(void* arg, int start, int end) {
+    const scale_job_t *job = (const scale_job_t*)arg;
+    const int bpp = job->bpp;
+    const int line = job->width*bpp;
+    const int nx = job->dx*bpp;     // offset to the next pixel of the row
+    const int ny = job->dy*line;    // offset to the same pixel, next row
+    const int step = (job->dx+1)*bpp;
+    const float *f = ub_to_float;
+    for (int y=start; y<end; y++) {
+        const GLubyte *s = job->src + y*(job->dy+1)*line;
+        GLubyte *d = job->dst + y*job->new_width*bpp;
+        GLuint x = 0;
+#ifdef GL4ES_SIMD
+        if(bpp==4 && !globals4es.nosimd) {
+            const simd_f4 k = simd_set1_f(255.0f);
+            const simd_f4 q = simd_set1_f(0.25f);
+            for (; x<job->new_width; x++, s+=step, d+=4) {
+                uint32_t w0, w1, w2, w3;
+                memcpy(&w0, s, 4);
+                memcpy(&w1, s+nx, 4);
+                memcpy(&w2, s+ny, 4);
+                memcpy(&w3, s+ny+nx, 4);
+                simd_f4 v = simd_add_f(simd_div_f(simd_cvt_ub4(w0), k), simd_div_f(simd_cvt_ub4(w1), k));
+                v = simd_add_f(v, simd_div_f(simd_cvt_ub4(w2), k));
+                v = simd_add_f(v, simd_div_f(simd_cvt_ub4(w3), k));
+                w0 = simd_cvt_ub4_dbl(simd_mul_f(v, q), 255.0);
+                memcpy(d, &w0, 4);
+            }
+        }
+#endif
+        for (; x<job->new_width; x++, s+=step)
+            for (int c=0; c<bpp; c++)
+                *(d++) = (f[s[c]] + f[s[c+nx]] + f[s[c+ny]] + f[s[c+ny+nx]]) * 0.25f * 255.0;
+    }
+}
+
+static void quarterscale_ub_rows(void* arg, int start, int end) {
+    const scale_job_t *job = (const scale_job_t*)arg;
+    const int bpp = job->bpp;
+    const int line = job->width*bpp;
+    int offs[16];   // same order as the pixels of quarter_pixel
+    for (int dy=0; dy<4; dy++)
+        for (int dx=0; dx<4; dx++)
+            offs[dx+dy*4] = job->dxs[dx]*bpp + job->dys[dy]*line;
+    const float *f = ub_to_float;
+    for (int y=start; y<end; y++) {
+        const GLubyte *s = job->src + y*4*line;
+        GLubyte *d = job->dst + y*job->new_width*bpp;
+        GLuint x = 0;
+#ifdef GL4ES_SIMD
+        if(bpp==4 && !globals4es.nosimd) {
+            const simd_f4 k = simd_set1_f(255.0f);
+            const simd_f4 q = simd_set1_f(0.0625f);
+            for (; x<job->new_width; x++, s+=16, d+=4) {
+                uint32_t w;
+                memcpy(&w, s, 4);
+                simd_f4 v = simd_div_f(simd_cvt_ub4(w), k);
+                for (int i=1; i<16; i++) {
+                    memcpy(&w, s+offs[i], 4);
+                    v = simd_add_f(v, simd_div_f(simd_cvt_ub4(w), k));
+                }
+                w = simd_cvt_ub4_dbl(simd_mul_f(v, q), 255.0);
+                memcpy(d, &w, 4);
+            }
+        }
+#endif
+        for (; x<job->new_width; x++, s+=4*bpp)
+            for (int c=0; c<bpp; c++) {
+                float v = f[s[c]];
+                for (int i=1; i<16; i++)
+                    v += f[s[c+offs[i]]];
+                *(d++) = v * 0.0625f * 255.0;
+            }
+    }
+}
+
+static int scale_ub_format(GLenum format, GLenum type) {
+    if(type!=GL_UNSIGNED_BYTE && type!=GL_INT8_REV)
+        return 0;
+    switch(format) {
+        case GL_RED:
+        case GL_R:
+        case GL_RG:
+        case GL_RGB:
+        case GL_BGR:
+        case GL_RGBA:
+        case GL_BGRA:
+        case GL_LUMINANCE:
+        case GL_LUMINANCE_ALPHA:
+        case GL_ALPHA:
+            return 1;
+    }
+    return 0;
+}
+
 bool pixel_halfscale(const GLvoid *old, GLvoid **new,
                  GLuint width, GLuint height,
                  GLenum format, GLenum type) {
@@ -1198,6 +1575,22 @@ bool pixel_halfscale(const GLvoid *old, GLvoid **new,
         *new = NULL;
         return true;
     }
+    if(scale_ub_format(format, type)) {
+        init_ub_to_float();
+        scale_job_t job;
+        job.src = (const GLubyte*)old;
+        job.width = width;
+        job.new_width = width / 2; if(!job.new_width) ++job.new_width;
+        GLuint new_height = height / 2; if(!new_height) ++new_height;
+        job.bpp = pixel_sizeof(format, type);
+        job.dx = (width>1)?1:0;
+        job.dy = (height>1)?1:0;
+        job.dst = (GLubyte*)malloc(job.bpp * job.new_width * new_height);
+        const int rowsize = job.new_width*job.bpp;
+        workers_run(halfscale_ub_rows, &job, new_height, (65536+rowsize-1)/rowsize);  // at least 64k bytes per slice
+        *new = job.dst;
+        return true;
+    }
     GLuint pixel_size, new_width, new_height;
     new_width = width / 2; if(!new_width) ++new_width;
     new_height = height / 2; if(!new_height) ++new_height;
@@ -1288,6 +1681,23 @@ bool pixel_quarterscale(const GLvoid *old, GLvoid **new,
     GLuint pixel_size, new_width, new_height;
     new_width = width / 4; if(!new_width) ++new_width;
     new_height = height / 4; if(!new_height) ++new_height;
+    if(scale_ub_format(format, type)) {
+        init_ub_to_float();
+        scale_job_t job;
+        job.src = (const GLubyte*)old;
+        job.width = width;
+        job.new_width = new_width;
+        job.bpp = pixel_sizeof(format, type);
+        const int dxs[4] = {0, width>1?1:0, width>2?2:0, width>3?3:width>1?1:0};
+        const int dys[4] = {0, height>1?1:0, height>2?2:0, height>3?3:height>1?1:0};
+        memcpy(job.dxs, dxs, sizeof(dxs));
+        memcpy(job.dys, dys, sizeof(dys));
+        job.dst = (GLubyte*)malloc(job.bpp * new_width * new_height);
+        const int rowsize = new_width*job.bpp;
+        workers_run(quarterscale_ub_rows, &job, new_height, (65536+rowsize-1)/rowsize);
+        *new = job.dst;
+        return true;
+    }
 /*    if (new_width*4!=width || new_height*4!=height) {
         printf("LIBGL: quarterscaling %ux%u failed\n", width, height);
         return false;
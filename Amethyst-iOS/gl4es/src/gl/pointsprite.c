@@ -121,6 +121,7 @@ void gl4es_glPointSize(GLfloat size) {
         errorShim(GL_INVALID_VALUE);
         return;
     }
+    attrib_changed(GL_POINT_BIT);
     glstate->pointsprite.size = size;
     errorGL();
     LOAD_GLES_FPE(glPointSize);
@@ -802,10 +802,10 @@ char* preproc(const char* code, int keepcomments, int gl_es, extensions_t* exts,
                     }
                     int l = strlen(tok.str);
                     if(sz+l>=cap) {
-                        cap+=2000;
+                        cap+=(cap>2000)?cap:2000;   // grow geometricaly on big shaders
                         ncode = (char*)realloc(ncode, cap);
                     }
-                    strcat(ncode, tok.str);
+                    memcpy(ncode+sz-1, tok.str, l+1);   // append at the end, don't rescan the whole string
                     sz+=l;
                 }
         }
@@ -20,9 +20,20 @@
 
 //KH Map implementations
 KHASH_MAP_IMPL_INT(attribloclist, attribloc_t *);
-KHASH_MAP_IMPL_INT(uniformlist, uniform_t *);
 KHASH_MAP_IMPL_INT(programlist, program_t *);
 
+static void free_uniforms(program_t *glprogram)
+{
+    for (int i=0; i<glprogram->num_location; i++)
+        free(glprogram->uniform[i].name);
+    free(glprogram->uniform);
+    glprogram->uniform = NULL;
+    glprogram->num_location = 0;
+    glprogram->num_uniform = 0;
+    free(glprogram->dirty);
+    glprogram->dirty = NULL;
+    glprogram->num_dirty = 0;
+}
 
 void gl4es_glAttachShader(GLuint program, GLuint shader) {
     DBG(printf("glAttachShader(%d, %d)\n", program, shader);)
@@ -123,13 +134,12 @@ GLuint gl4es_glCreateProgram(void) {
             kh_destroy(attribloclist, glprogram->attribloc);
             glprogram->attribloc = NULL;
         }
+        free_uniforms(glprogram);
         memset(glprogram, 0, sizeof(program_t));
     }
     glprogram->id = program;
     // initialize attribloc hashmap
     khash_t(attribloclist) *attribloc = glprogram->attribloc = kh_init(attribloclist);
-    // initialize uniform hashmap
-    khash_t(uniformlist) *uniform = glprogram->uniform = kh_init(uniformlist);
     // all done
     return program;
 }
@@ -137,6 +147,18 @@ GLuint gl4es_glCreateProgram(void) {
 void actualy_deleteshader(GLuint shader);
 void actualy_detachshader(GLuint shader);
 
+static void forget_fpe_last(program_t *glprogram) {
+    // the program (or a customization of it) may be the last one resolved by realize_glenv, in this
+    // context or in any context sharing the programs: they all check the generation before reusing it
+    if(glstate) {
+        ++glstate->glsl->generation;
+        if(glstate->fpe_last_glsl==glprogram || glstate->fpe_last_custom==glprogram) {
+            glstate->fpe_last_glsl = NULL;
+            glstate->fpe_last_custom = NULL;
+        }
+    }
+}
+
 void deleteProgram(program_t *glprogram, khint_t k_program) {
     free(glprogram->attach);
     // clean attribloc
@@ -149,20 +171,14 @@ void deleteProgram(program_t *glprogram, khint_t k_program) {
         glprogram->attribloc = NULL;
     }
     // clean uniform list
-    if(glprogram->uniform) {
-        uniform_t *m;
-        kh_foreach_value(glprogram->uniform, m,
-            free(m->name); free(m);
-        )
-        kh_destroy(uniformlist, glprogram->uniform);
-        glprogram->uniform = NULL;
-    }
+    free_uniforms(glprogram);
     // clean cache
     if(glprogram->cache.cache)
         free(glprogram->cache.cache);
     // clean fpe cache if it exist
     if(glprogram->fpe_cache)
         fpe_disposeCache((fpe_cache_t*)glprogram->fpe_cache, 1);
+    forget_fpe_last(glprogram);
     // delete program
     kh_del(programlist, glstate->glsl->programs, k_program);
     free(glprogram);
@@ -311,22 +327,19 @@ void gl4es_glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLs
     }
 
     // look in uniform cache, that is filled when program is linked
-    if(glprogram->uniform) {
-        uniform_t *m;
-        khint_t k;
-        kh_foreach_value(glprogram->uniform, m,
-            if(m->internal_id == index) {
-                if(type) *type = m->type;
-                if(size) *size = m->size;
-                if(length) *length = strlen(m->name);
-                if(bufSize && name) {
-                    strncpy(name, m->name, bufSize-1);
-                    name[bufSize-1] = '\0';
-                }
-                DBG(printf(" found %s (%d), type=%s, size=%d\n", m->name, strlen(m->name), PrintEnum(m->type), m->size);)
-                return;
+    for (int i=0; i<glprogram->num_location; i++) {
+        uniform_t *m = &glprogram->uniform[i];
+        if(m->internal_id == index) {
+            if(type) *type = m->type;
+            if(size) *size = m->size;
+            if(length) *length = strlen(m->name);
+            if(bufSize && name) {
+                strncpy(name, m->name, bufSize-1);
+                name[bufSize-1] = '\0';
             }
-        );
+            DBG(printf(" found %s (%d), type=%s, size=%d\n", m->name, strlen(m->name), PrintEnum(m->type), m->size);)
+            return;
+        }
     }
     // end
     DBG(printf(" not found\n");)
@@ -408,16 +421,14 @@ void gl4es_glGetProgramiv(GLuint program, GLenum pname, GLint *params) {
                 *params = 0;
             break;
         case GL_ACTIVE_UNIFORMS:
-            *params = (glprogram->uniform)?glprogram->num_uniform:0;
+            *params = glprogram->num_uniform;
             break;
         case GL_ACTIVE_UNIFORM_MAX_LENGTH:
             {
                 int l = 0;
-                uniform_t *m;
-                kh_foreach_value(glprogram->uniform, m,
-                    if(l<strlen(m->name)+1)
-                        l = strlen(m->name)+1;
-                )
+                for (int i=0; i<glprogram->num_location; i++)
+                    if(l<strlen(glprogram->uniform[i].name)+1)
+                        l = strlen(glprogram->uniform[i].name)+1;
                 *params = l;
             }
             break;
@@ -463,19 +474,16 @@ GLint gl4es_glGetUniformLocation(GLuint program, const GLchar *name) {
             index = index*10 + *(p++)-'0';
         }
     }
-    if(glprogram->uniform) {
-        uniform_t *m;
-        khint_t k;
-        kh_foreach_value(glprogram->uniform, m,
-            if(strlen(m->name)==l && strncmp(m->name, name, l)==0) {
-                res = m->id;
-                if(index>m->size) {
-                    res = -1;   // too big !
-                } else
-                    res += index;
-                break;
-            }
-        )
+    for (int i=0; i<glprogram->num_location; i++) {
+        uniform_t *m = &glprogram->uniform[i];
+        if(strlen(m->name)==l && strncmp(m->name, name, l)==0) {
+            res = i;
+            if(index>m->size) {
+                res = -1;   // too big !
+            } else
+                res += index;
+            break;
+        }
     }
     DBG(printf(" location: %d\n", res);)
     return res;
@@ -516,19 +524,21 @@ static void clear_program(program_t *glprogram)
         kh_del(attribloclist, attribloc, 1);
     }
     // clear all Uniform cache
-    glprogram->num_uniform = 0;
-    if(glprogram->uniform) {
-        uniform_t *m;
-        khint_t k;
-        kh_foreach(glprogram->uniform, k, m,
-            free(m->name); free(m);
-            kh_del(uniformlist, glprogram->uniform, k);
-        )
-    }
+    free_uniforms(glprogram);
     glprogram->cache.size = 0;  // reset cache buffer
 }
 
-static void fill_program(program_t *glprogram)
+// not enough memory: leave no uniform, and no builtin or sampler pointing to one
+static int fill_failed(program_t *glprogram)
+{
+    clear_program(glprogram);
+    builtin_Init(glprogram);
+    memset(glprogram->texunits, 0, sizeof(glprogram->texunits));
+    return 0;
+}
+
+// return 0 if there is not enough memory for the uniforms
+static int fill_program(program_t *glprogram)
 {
     LOAD_GLES(glGetError);
     LOAD_GLES2(glGetProgramiv);
@@ -547,7 +557,6 @@ static void fill_program(program_t *glprogram)
     // Grab all Uniform
     gles_glGetProgramiv(glprogram->id, GL_ACTIVE_UNIFORMS, &n);
     gles_glGetProgramiv(glprogram->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxsize);
-    khash_t(uniformlist) *uniforms = glprogram->uniform;
     uniform_t *gluniform = NULL;
     int uniform_cache = 0;
     GLint size = 0;
@@ -563,9 +572,16 @@ static void fill_program(program_t *glprogram)
             if(name[strlen(name)-1]==']' && strrchr(name, '[')) (*strrchr(name, '['))='\0';
             GLint id = gles_glGetUniformLocation(glprogram->id, name);
             if(id!=-1) {
+                // each element get its own location, the next ones in the array
+                uniform_t *uniforms = (uniform_t*)realloc(glprogram->uniform, (glprogram->num_location+size)*sizeof(uniform_t));
+                if(!uniforms) {
+                    free(name);
+                    return fill_failed(glprogram);
+                }
+                glprogram->uniform = uniforms;
                 for (int j = 0; j<size; j++) {
-                    k = kh_put(uniformlist, uniforms, id, &ret);
-                    gluniform = kh_value(uniforms, k) = malloc(sizeof(uniform_t));
+                    GLint location = glprogram->num_location++;
+                    gluniform = &glprogram->uniform[location];
                     memset(gluniform, 0, sizeof(uniform_t));
                     if(j) {
                         gluniform->name = malloc(strlen(name)+1+5);
@@ -578,20 +594,20 @@ static void fill_program(program_t *glprogram)
                     gluniform->type = type;
                     gluniform->cache_offs = uniform_cache+j*uniformsize(type);
                     gluniform->cache_size = uniformsize(type)*(size-j);
-                    gluniform->builtin = builtin_CheckUniform(glprogram, name, id, size-j);
+                    gluniform->builtin = builtin_CheckUniform(glprogram, name, location, size-j);
                     // TextureUnit grabbing...
                     if(type==GL_SAMPLER_CUBE) {
-                        glprogram->texunits[tu_idx].id = id;
+                        glprogram->texunits[tu_idx].id = location;
                         glprogram->texunits[tu_idx].type=TU_CUBE;
                         glprogram->texunits[tu_idx].req_tu = glprogram->texunits[tu_idx].act_tu = 0;
                         ++tu_idx;
                     } else if (type==GL_SAMPLER_2D) {
-                        glprogram->texunits[tu_idx].id = id;
+                        glprogram->texunits[tu_idx].id = location;
                         glprogram->texunits[tu_idx].type=TU_TEX2D;
                         glprogram->texunits[tu_idx].req_tu = glprogram->texunits[tu_idx].act_tu = 0;
                         ++tu_idx;
                     }
-                    DBG(printf(" uniform #%d : \"%s\"%s type=%s size=%d\n", id, gluniform->name, gluniform->builtin?" (builtin) ":"", PrintEnum(gluniform->type), gluniform->size);)
+                    DBG(printf(" uniform #%d (%d) : \"%s\"%s type=%s size=%d\n", location, id, gluniform->name, gluniform->builtin?" (builtin) ":"", PrintEnum(gluniform->type), gluniform->size);)
                     if(gluniform->size==1) ++glprogram->num_uniform;
                     id++;
                 }
@@ -603,19 +619,23 @@ static void fill_program(program_t *glprogram)
     free(name);
     // reset uniform cache
     if(glprogram->cache.cap < uniform_cache) {
+        void *cache = realloc(glprogram->cache.cache, uniform_cache);
+        if(!cache)
+            return fill_failed(glprogram);
         glprogram->cache.cap=uniform_cache;
-        glprogram->cache.cache = malloc(glprogram->cache.cap);
+        glprogram->cache.cache = cache;
     }
     memset(glprogram->cache.cache, 0, glprogram->cache.cap);
     //Maybe Sampler uniform should not be initialized to 0, but to -1, to be sure the value is initialized?
-    if(glprogram->uniform) {
-        uniform_t *m;
-        khint_t k;
-        kh_foreach(glprogram->uniform, k, m,
-            if(m->type == GL_SAMPLER_2D || m->type == GL_SAMPLER_CUBE)
-                memset(glprogram->cache.cache+m->cache_offs, 0xff, m->cache_size);
-        )
+    for (int i=0; i<glprogram->num_location; i++) {
+        uniform_t *m = &glprogram->uniform[i];
+        if(m->type == GL_SAMPLER_2D || m->type == GL_SAMPLER_CUBE)
+            memset(glprogram->cache.cache+m->cache_offs, 0xff, m->cache_size);
     }
+    // at most one entry per location in the dirty list
+    glprogram->dirty = (GLint*)malloc((glprogram->num_location+1)*sizeof(GLint));
+    if(!glprogram->dirty)
+        return fill_failed(glprogram);
 
     // Grab all Attrib
     gles_glGetProgramiv(glprogram->id, GL_ACTIVE_ATTRIBUTES, &n);
@@ -653,6 +673,7 @@ static void fill_program(program_t *glprogram)
         DBG(else printf("LIBGL: Warning, getting Attrib #%d info failed with %s\n", i, PrintEnum(e2));)
     }
     free(name);
+    return 1;
 }
 
 int gl4es_useProgramBinary(GLuint program, int length, GLenum format, const void* binary)
@@ -672,9 +693,12 @@ int gl4es_useProgramBinary(GLuint program, int length, GLenum format, const void
 
     gles_glGetProgramiv(glprogram->id, GL_LINK_STATUS, &glprogram->linked);
     DBG(printf(" link status = %d\n", glprogram->linked);)
-    if(glprogram->linked) {
-        fill_program(glprogram);
-    } else {
+    if(glprogram->linked && !fill_program(glprogram)) {
+        glprogram->linked = 0;
+        errorShim(GL_OUT_OF_MEMORY);
+        return 0;
+    }
+    if(!glprogram->linked) {
         // should DBG the linker error?
         DBG(printf(" Load failed!\n");)
         glprogram->linked = 0;
@@ -738,6 +762,7 @@ void gl4es_glLinkProgram(GLuint program) {
     noerrorShim();
 
     clear_program(glprogram);
+    forget_fpe_last(glprogram);
 
     // check if attached shaders are compatible in term of varying...
     shaderconv_need_t needs = {0};
@@ -787,9 +812,13 @@ void gl4es_glLinkProgram(GLuint program) {
         // Get Link Status
         gles_glGetProgramiv(glprogram->id, GL_LINK_STATUS, &glprogram->linked);
         DBG(printf(" link status = %d\n", glprogram->linked);)
-        if(glprogram->linked) {
-            fill_program(glprogram);
-        } else {
+        if(glprogram->linked && !fill_program(glprogram)) {
+            // not enough memory for the uniforms, the program can't be used
+            glprogram->linked = 0;
+            errorShim(GL_OUT_OF_MEMORY);
+            return;
+        }
+        if(!glprogram->linked) {
             GLsizei log_length;
             gles_glGetProgramiv(glprogram->id, GL_INFO_LOG_LENGTH, &log_length);
             DBG(printf("Linker error length: %i\n", log_length));
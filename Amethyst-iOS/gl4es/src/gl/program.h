@@ -111,10 +111,9 @@ typedef struct {
     int             cache_size; // this is GLsizeof(type)*size
     uintptr_t       parent_offs;    // in case the uniform is from a fpe custom program
     int             parent_size;    // 0 means not found in parent... like for builtin
+    int             dirty;  // number of elements to send to GLES before next draw (0 if up to date)
 } uniform_t;
 
-KHASH_MAP_DECLARE_INT(uniformlist, uniform_t *);
-
 typedef struct {
     void*           cache;  // buffer of the uniform size
     int             cap;    // capacity of the cache
@@ -132,8 +131,6 @@ typedef struct {
     GLint       spotExponent; //float
     GLint       spotCutoff; //float
     GLint       spotCosCutoff; //float
-    GLfloat     oldspotCutoff;  // cache to avoid recalc of spotCutoff
-    GLfloat     oldspotCosCutoff; //float
     GLint       constantAttenuation; //float
     GLint       linearAttenuation; //float
     GLint       quadraticAttenuation; //float
@@ -217,9 +214,12 @@ typedef struct {
     shaderconv_need_t *default_need;    // filled only if default_vertex or default_fragment is used
     int             va_size[MAX_VATTRIB];
     khash_t(attribloclist)     *attribloc;
-    khash_t(uniformlist) *uniform;
+    uniform_t       *uniform;   // uniforms by location, locations are remapped to 0..num_location-1 at link time
+    int             num_location;
     int             num_uniform;
     uniformcache_t  cache;
+    GLint           *dirty;     // locations of the dirty uniforms
+    int             num_dirty;
     // builtin attrib
     int                             has_builtin_attrib;
     GLint                           builtin_attrib[ATT_MAX];
@@ -227,6 +227,7 @@ typedef struct {
     int                             has_builtin_matrix;
     GLint                           builtin_matrix[MAT_MAX];
     int                             has_builtin_light;
+    unsigned                        light_generation;   // glstate->light.generation the light uniforms were last set from
     builtin_lightsource_t           builtin_lights[MAX_LIGHT];
     builtin_lightmodel_t            builtin_lightmodel;
     builtin_material_t              builtin_material[2];
@@ -317,15 +318,6 @@ int gl4es_getProgramBinary(GLuint program, int *length, GLenum *format, void** b
         return (type)0; \
     }
 
-#define APPLY_PROGRAM(prg, glprg) \
-    if(glstate->gleshard->program != prg) {  \
-        glstate->gleshard->program = prg;    \
-        glstate->gleshard->glprogram = glprg;\
-        LOAD_GLES2(glUseProgram);           \
-        if(gles_glUseProgram)               \
-            gles_glUseProgram(prg);         \
-    }
-
 void GoUniformfv(program_t *glprogram, GLint location, int size, int count, const GLfloat *value);
 void GoUniformiv(program_t *glprogram, GLint location, int size, int count, const GLint *value);
 void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
@@ -333,6 +325,7 @@ void GoUniformMatrix3fv(program_t *glprogram, GLint location, GLsizei count, GLb
 void GoUniformMatrix4fv(program_t *glprogram, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
 int GetUniformi(program_t *glprogram, GLint location);
 const char* GetUniformName(program_t *glprogram, GLint location);
+void FlushUniforms(program_t *glprogram);    // send the uniforms changed since last call to GLES
 
 GLvoid glBindAttribLocationARB(GLhandleARB programObj, GLuint index, const GLcharARB *name);
 GLvoid glGetActiveAttribARB(GLhandleARB programObj, GLuint index, GLsizei maxLength, GLsizei *length, GLint *size, GLenum *type, GLcharARB *name);
@@ -1,14 +1,86 @@
 #include "queries.h"
 
-#include "khash.h"
 #include "gl4es.h"
 #include "glstate.h"
 #include "loader.h"
 
 KHASH_MAP_IMPL_INT(queries, glquery_t *);
 
-static GLuint lastquery = 0;
-static glquery_t *active_samples_passed = 0;
+// GL_EXT_occlusion_query_boolean entry points
+typedef void (*glGenQueries_PTR)(GLsizei n, GLuint* ids);
+typedef void (*glDeleteQueries_PTR)(GLsizei n, const GLuint* ids);
+typedef void (*glBeginQuery_PTR)(GLenum target, GLuint id);
+typedef void (*glEndQuery_PTR)(GLenum target);
+typedef void (*glGetQueryObjectuiv_PTR)(GLuint id, GLenum pname, GLuint* params);
+
+static int is_query_target(GLenum target) {
+    return (target==GL_SAMPLES_PASSED || target==GL_ANY_SAMPLES_PASSED || target==GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+}
+
+// GLES only knows boolean occlusion queries, so GL_SAMPLES_PASSED will answer 0 or 1
+static GLenum hardware_target(GLenum target) {
+    return (target==GL_SAMPLES_PASSED)?GL_ANY_SAMPLES_PASSED:target;
+}
+
+static glquery_t* find_query(GLuint id) {
+    glquerylist_t *queries = glstate->queries;
+    if(id>=QUERY_DENSE_MAX) {
+        if(!queries->sparse)
+            return NULL;
+        khint_t k = kh_get(queries, queries->sparse, id);
+        return (k!=kh_end(queries->sparse))?kh_value(queries->sparse, k):NULL;
+    }
+    if(!id || id>queries->last || !queries->list[id].used)
+        return NULL;
+    return &queries->list[id];
+}
+
+// return NULL if out of memory
+static glquery_t* reserve_query(GLuint id) {
+    glquerylist_t *queries = glstate->queries;
+    if(id>=QUERY_DENSE_MAX) {
+        if(!queries->sparse)
+            queries->sparse = kh_init(queries);
+        int ret;
+        khint_t k = kh_put(queries, queries->sparse, id, &ret);
+        if(ret) {
+            glquery_t *query = (glquery_t*)calloc(1, sizeof(glquery_t));
+            if(!query) {
+                kh_del(queries, queries->sparse, k);
+                return NULL;
+            }
+            query->used = 1;
+            kh_value(queries->sparse, k) = query;
+        }
+        return kh_value(queries->sparse, k);
+    }
+    if(id>=queries->size) {
+        GLuint size = queries->size?(queries->size*2):64;
+        while(size<=id) size*=2;    // no overflow, size stays <= QUERY_DENSE_MAX
+        glquery_t *list = (glquery_t*)realloc(queries->list, size*sizeof(glquery_t));
+        if(!list)
+            return NULL;
+        memset(list+queries->size, 0, (size-queries->size)*sizeof(glquery_t));
+        queries->list = list;
+        queries->size = size;
+    }
+    if(id>queries->last)
+        queries->last = id;
+    queries->list[id].used = 1;
+    return &queries->list[id];
+}
+
+static void free_query(GLuint id, glquery_t *query) {
+    glquerylist_t *queries = glstate->queries;
+    if(id>=QUERY_DENSE_MAX) {
+        kh_del(queries, queries->sparse, kh_get(queries, queries->sparse, id));
+        free(query);
+        return;
+    }
+    memset(query, 0, sizeof(glquery_t));
+    if(id<queries->first)
+        queries->first = id;
+}
 
 void gl4es_glGenQueries(GLsizei n, GLuint * ids) {
     FLUSH_BEGINEND;
@@ -17,96 +89,107 @@ void gl4es_glGenQueries(GLsizei n, GLuint * ids) {
 		errorShim(GL_INVALID_VALUE);
         return;
     }
+    glquerylist_t *queries = glstate->queries;
+    GLuint id = queries->first?queries->first:1;
     for (int i=0; i<n; i++) {
-        ids[i] = ++lastquery;
+        while(id<=queries->last && queries->list[id].used)
+            ++id;
+        if(id>=QUERY_DENSE_MAX || !reserve_query(id)) {
+            errorShim(GL_OUT_OF_MEMORY);
+            break;
+        }
+        ids[i] = id++;
     }
+    queries->first = id;
 }
 
 GLboolean gl4es_glIsQuery(GLuint id) {
 	if(glstate->list.compiling) {errorShim(GL_INVALID_OPERATION); return GL_FALSE;}
 	FLUSH_BEGINEND;
-	khash_t(queries) *list = glstate->queries;
-	khint_t k;
 	noerrorShim();
-    if (list) {
-		k = kh_get(queries, list, id);
-		if (k != kh_end(list)) {
-			return GL_TRUE;
-		}
-	}
-	return GL_FALSE;
+	glquery_t *query = find_query(id);
+	// a name only become a query object once it has been used with glBeginQuery
+	return (query && query->target)?GL_TRUE:GL_FALSE;
 }
 
 void gl4es_glDeleteQueries(GLsizei n, const GLuint* ids) {
     FLUSH_BEGINEND;
-	khash_t(queries) *list = glstate->queries;
-    if (list) {
-        khint_t k;
-        glquery_t *query;
-        for (int i = 0; i < n; i++) {
-            GLuint t = ids[i];
-            if (t) {    // don't allow to remove default one
-                k = kh_get(queries, list, t);
-                if (k != kh_end(list)) {
-                    query = kh_value(list, k);
-                    kh_del(queries, list, k);
-                    free(query);
-                    if(active_samples_passed==query)
-                    	active_samples_passed = NULL;
-                }
+    for (int i = 0; i < n; i++) {
+        GLuint id = ids[i];
+        glquery_t *query = find_query(id);
+        if(!query)
+            continue;
+        if(query->glname) {
+            if(glstate->query_active==id) {
+                LOAD_GLES_EXT(glEndQuery);
+                gles_glEndQuery(hardware_target(query->target));
             }
+            LOAD_GLES_EXT(glDeleteQueries);
+            gles_glDeleteQueries(1, &query->glname);
         }
+        if(glstate->query_active==id)
+            glstate->query_active = 0;
+        free_query(id, query);
     }
     noerrorShim();
 }
 
 void gl4es_glBeginQuery(GLenum target, GLuint id) {
-	if(target!=GL_SAMPLES_PASSED) {
+	if(!is_query_target(target)) {
 		errorShim(GL_INVALID_ENUM);
 		return;
 	}
     FLUSH_BEGINEND;
 
-   	khint_t k;
-   	int ret;
-    glquery_t *query;
-	khash_t(queries) *list = glstate->queries;
-	if (! list) {
-		list = glstate->queries = kh_init(queries);
-		// segfaults if we don't do a single put
-		kh_put(queries, list, 1, &ret);
-		kh_del(queries, list, 1);
-	}
-    k = kh_get(queries, list, id);
-    if (k != kh_end(list)) {
-        query = kh_value(list, k);
-    } else {
-        k = kh_put(queries, list, id, &ret);
-        query = kh_value(list, k) = malloc(sizeof(glquery_t));
+    glquery_t *query = find_query(id);
+    if(!query && id) {
+        query = reserve_query(id);  // old GL allows unreserved names here
+        if(!query) {
+            errorShim(GL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+    if(!query || glstate->query_active || (query->target && query->target!=target)) {
+        errorShim(GL_INVALID_OPERATION);
+        return;
     }
     query->target = target;
     query->num = 0;
-    active_samples_passed = query;
+    query->available = 0;
+    if(hardext.occlusionquery) {
+        if(!query->glname) {
+            LOAD_GLES_EXT(glGenQueries);
+            gles_glGenQueries(1, &query->glname);
+        }
+        LOAD_GLES_EXT(glBeginQuery);
+        gles_glBeginQuery(hardware_target(target), query->glname);
+    }
+    glstate->query_active = id;
     noerrorShim();
 }
 
 void gl4es_glEndQuery(GLenum target) {
-	if(target!=GL_SAMPLES_PASSED) {
+	if(!is_query_target(target)) {
 		errorShim(GL_INVALID_ENUM);
 		return;
 	}
-	if(!active_samples_passed) {
+    glquery_t *query = find_query(glstate->query_active);
+	if(!query || query->target!=target) {
 		errorShim(GL_INVALID_OPERATION);
 		return;
 	}
     FLUSH_BEGINEND;
 
-    active_samples_passed = NULL;
+    if(query->glname) {
+        LOAD_GLES_EXT(glEndQuery);
+        gles_glEndQuery(hardware_target(target));
+    }
+    glstate->query_active = 0;
 	noerrorShim();
 }
 
 void gl4es_glGetQueryiv(GLenum target, GLenum pname, GLint* params) {
-	if(target!=GL_SAMPLES_PASSED) {
+	if(!is_query_target(target)) {
 		errorShim(GL_INVALID_ENUM);
 		return;
 	}
@@ -115,84 +198,70 @@ void gl4es_glGetQueryiv(GLenum target, GLenum pname, GLint* params) {
 	noerrorShim();
 	switch (pname) {
 		case GL_CURRENT_QUERY:
-			*params = (active_samples_passed)?active_samples_passed->id:0;
+		{
+			glquery_t *query = find_query(glstate->query_active);
+			*params = (query && query->target==target)?glstate->query_active:0;
 			break;
+		}
 		case GL_QUERY_COUNTER_BITS:
-			*params = 0;	//no counter...
+			*params = hardext.occlusionquery?1:0;	// boolean hardware counter, or no counter at all
 			break;
 		default:
 			errorShim(GL_INVALID_ENUM);
 	}
 }
 
-void gl4es_glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params) {
-   	khint_t k;
-   	int ret;
+// return 0 and set the error if the query cannot be read
+static int get_query_object(GLuint id, GLenum pname, GLuint* params) {
     FLUSH_BEGINEND;
 
-    glquery_t *query = NULL;
-	khash_t(queries) *list = glstate->queries;
-	if (! list) {
-		list = glstate->queries = kh_init(queries);
-		// segfaults if we don't do a single put
-		k = kh_put(queries, list, 1, &ret);
-		kh_del(queries, list, k);
-	}
-    k = kh_get(queries, list, id);
-    if (k != kh_end(list)) {
-        query = kh_value(list, k);
-    }
-    if(!query) {
+    glquery_t *query = find_query(id);
+    if(!query || !query->target || id==glstate->query_active) {
     	errorShim(GL_INVALID_OPERATION);
-    	return;
+    	return 0;
     }
     noerrorShim();
     switch (pname) {
     	case GL_QUERY_RESULT_AVAILABLE:
-    		*params = GL_FALSE;
+    		if(query->glname && !query->available) {
+    			// just poll the driver, the result is kept once it's there
+    			LOAD_GLES_EXT(glGetQueryObjectuiv);
+    			GLuint available = GL_FALSE;
+    			gles_glGetQueryObjectuiv(query->glname, GL_QUERY_RESULT_AVAILABLE, &available);
+    			if(available) {
+    				gles_glGetQueryObjectuiv(query->glname, GL_QUERY_RESULT, &query->result);
+    				query->available = 1;
+    			}
+    		}
+    		*params = query->available?GL_TRUE:GL_FALSE;
     		break;
     	case GL_QUERY_RESULT:
-    		*params = query->num;
+    		if(query->glname) {
+    			if(!query->available) {
+    				// this one waits for the GPU
+    				LOAD_GLES_EXT(glGetQueryObjectuiv);
+    				gles_glGetQueryObjectuiv(query->glname, GL_QUERY_RESULT, &query->result);
+    				query->available = 1;
+    			}
+    			*params = query->result;
+    		} else
+    			*params = query->num;
     		break;
     	default:
     		errorShim(GL_INVALID_ENUM);
-    		break;
+    		return 0;
     }
+    return 1;
+}
+
+void gl4es_glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params) {
+    GLuint value;
+    if(get_query_object(id, pname, &value))
+        *params = (GLint)value;
 }
 
 void gl4es_glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params) {
-   	khint_t k;
-   	int ret;
-    FLUSH_BEGINEND;
-		
-    glquery_t *query = NULL;
-	khash_t(queries) *list = glstate->queries;
-	if (! list) {
-		list = glstate->queries = kh_init(queries);
-		// segfaults if we don't do a single put
-		kh_put(queries, list, 1, &ret);
-		kh_del(queries, list, 1);
-	}
-    k = kh_get(queries, list, id);
-    if (k != kh_end(list)) {
-        query = kh_value(list, k);
-    }
-    if(!query) {
-    	errorShim(GL_INVALID_OPERATION);
-    	return;
-    }
-    noerrorShim();
-    switch (pname) {
-    	case GL_QUERY_RESULT_AVAILABLE:
-    		*params = GL_FALSE;
-    		break;
-    	case GL_QUERY_RESULT:
-    		*params = query->num;
-    		break;
-    	default:
-    		errorShim(GL_INVALID_ENUM);
-    		break;
-    }
+    get_query_object(id, pname, params);
 }
 
 
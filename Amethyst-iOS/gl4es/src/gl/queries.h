@@ -14,11 +14,26 @@ void gl4es_glGetQueryObjectiv(GLuint id, GLenum pname, GLint* params);
 void gl4es_glGetQueryObjectuiv(GLuint id, GLenum pname, GLuint* params);
 
 typedef struct {
-    GLuint id;
-    GLenum target;
-    int num;
+    GLenum target;      // 0 until the first glBeginQuery on that name
+    GLuint glname;      // hardware query (GL_EXT_occlusion_query_boolean), 0 if emulated
+    GLuint result;      // hardware result, valid once available is set
+    int num;            // emulated counter
+    GLubyte used;       // name has been reserved
+    GLubyte available;  // hardware result has been read back
 } glquery_t;
 
 KHASH_MAP_DECLARE_INT(queries, glquery_t *)
 
+// names below QUERY_DENSE_MAX are in a dense array, the others (only seen when an application
+// uses its own names with glBeginQuery) are in a hashmap
+#define QUERY_DENSE_MAX 65536
+
+typedef struct {
+    glquery_t *list;    // dense array, indexed by query name (0 is never a valid name)
+    GLuint size;        // allocated entries in list
+    GLuint last;        // highest name in use in list
+    GLuint first;       // lowest name that may be free in list
+    khash_t(queries) *sparse;   // names >= QUERY_DENSE_MAX, NULL until one is used
+} glquerylist_t;
+
 #endif // _GL4ES_QUERIES_H_
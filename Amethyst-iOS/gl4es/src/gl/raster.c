@@ -10,6 +10,7 @@
 #include "loader.h"
 #include "matvec.h"
 #include "pixel.h"
+#include "enum_info.h"
 
 #define min(a, b)	((a)<b)?(a):(b)
 #define max(a, b)	((a)>(b))?(a):(b)
@@ -66,6 +67,7 @@ void gl4es_glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
 		if (glstate->raster.bm_drawing)	bitmap_flush();
     	LOAD_GLES(glViewport);
 		gles_glViewport(x, y, width, height);
+		attrib_changed(GL_VIEWPORT_BIT);
 		glstate->raster.viewport.x = x;
 		glstate->raster.viewport.y = y;
 		glstate->raster.viewport.width = width;
@@ -91,6 +93,7 @@ void gl4es_glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
 		if (glstate->raster.bm_drawing) bitmap_flush();
     	LOAD_GLES(glScissor);
 		gles_glScissor(x, y, width, height);
+		attrib_changed(GL_SCISSOR_BIT);
 		glstate->raster.scissor.x = x;
 		glstate->raster.scissor.y = y;
 		glstate->raster.scissor.width = width;
@@ -118,6 +121,7 @@ void gl4es_glPixelZoom(GLfloat xfactor, GLfloat yfactor) {
 			return;
 		} else gl4es_flush();
 
+	attrib_changed(GL_PIXEL_MODE_BIT);
 	glstate->raster.raster_zoomx = xfactor;
 	glstate->raster.raster_zoomy = yfactor;
 //printf("LIBGL: glPixelZoom(%f, %f)\n", xfactor, yfactor);
@@ -133,6 +137,7 @@ void gl4es_glPixelTransferf(GLenum pname, GLfloat param) {
 		} else gl4es_flush();
 
 //printf("LIBGL: glPixelTransferf(%04x, %f)\n", pname, param);
+	attrib_changed(GL_PIXEL_MODE_BIT);
 	switch(pname) {
 		case GL_RED_SCALE:
 			glstate->raster.raster_scale[0]=param;
@@ -152,12 +157,15 @@ void gl4es_glPixelTransferf(GLenum pname, GLfloat param) {
 			break;
 		case GL_INDEX_SHIFT:
 			glstate->raster.index_shift=param;
+			++glstate->raster.map_gen;
 			break;
 		case GL_INDEX_OFFSET:
 			glstate->raster.index_offset=param;
+			++glstate->raster.map_gen;
 			break;
 		case GL_MAP_COLOR:
 			glstate->raster.map_color=param?1:0;
+			++glstate->raster.map_gen;
 			break;
 		/*default:
 			printf("LIBGL: stubbed glPixelTransferf(%04x, %f)\n", pname, param);*/
@@ -212,6 +220,7 @@ void raster_to_texture(rasterlist_t *r)
 	GLboolean compiling = glstate->list.compiling;
 	glstate->list.compiling = false;
     gl4es_glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT );
+	gl4es_glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);	// the pixel store is the one of the application
 	GLuint old_tex_unit, old_tex;
 	old_tex_unit = glstate->texture.active;
 	if (old_tex_unit!=0) gl4es_glActiveTexture(GL_TEXTURE0);
@@ -250,11 +259,192 @@ void raster_to_texture(rasterlist_t *r)
 	gl4es_glBindTexture(GL_TEXTURE_2D, old_tex);
 	if (old_tex_unit!=0) 
 		gl4es_glActiveTexture(old_tex_unit+GL_TEXTURE0);
+	gl4es_glPopClientAttrib();
 	gl4es_glPopAttrib();
 	if (old_list) glstate->list.active = old_list;
 	glstate->list.compiling = compiling;
 }
 
+// Glyph atlas: small bitmaps (so mostly font glyphs) are expanded once in a shared texture, keyed on their
+// content and color, and each glBitmap only adds a quad. The quads are drawn in one go by bitmap_flush.
+// The other bitmaps (zoomed, with pixel transfer or too big) still go through the viewport sized buffer.
+#define BM_ATLAS_SIZE   512
+#define BM_GLYPH_MAX    128
+
+typedef struct bm_glyph_s {
+	khint32_t	hash;
+	GLsizei		width, height;
+	GLuint		color;
+	int			x, y;		// position in the atlas
+	GLubyte		*bits;
+} bm_glyph_t;
+
+static kh_inline khint32_t bm_glyph_hash(bm_glyph_t* g) { return g->hash; }
+static kh_inline int bm_glyph_equal(bm_glyph_t* a, bm_glyph_t* b)
+{
+	return a->hash==b->hash && a->width==b->width && a->height==b->height && a->color==b->color
+		&& memcmp(a->bits, b->bits, ((a->width+7)/8)*a->height)==0;
+}
+KHASH_INIT(bmglyph, bm_glyph_t*, char, 0, bm_glyph_hash, bm_glyph_equal);
+
+typedef struct bm_atlas_s {
+	GLuint		texture;
+	GLubyte		*pixels;			// copy of the texture
+	int			shelf_x, shelf_y, shelf_h;
+	int			dirty_y1, dirty_y2;	// rows to upload
+	khash_t(bmglyph) *glyphs;
+	GLfloat		*vert, *tex;		// quads to draw, as 2 triangles
+	int			count, cap;
+} bm_atlas_t;
+
+void free_bitmap_atlas(bm_atlas_t *atlas)
+{
+	if(!atlas)
+		return;
+	for (khint_t k=kh_begin(atlas->glyphs); k!=kh_end(atlas->glyphs); ++k)
+		if(kh_exist(atlas->glyphs, k))
+			free(kh_key(atlas->glyphs, k));
+	kh_destroy(bmglyph, atlas->glyphs);
+	free(atlas->pixels);
+	free(atlas->vert);
+	free(atlas->tex);
+	free(atlas);
+}
+
+static void bm_atlas_reset(bm_atlas_t *atlas)
+{
+	for (khint_t k=kh_begin(atlas->glyphs); k!=kh_end(atlas->glyphs); ++k)
+		if(kh_exist(atlas->glyphs, k))
+			free(kh_key(atlas->glyphs, k));
+	kh_clear(bmglyph, atlas->glyphs);
+	atlas->shelf_x = atlas->shelf_y = atlas->shelf_h = 0;
+	// the pixels don't need to be cleared, only the glyphs are sampled
+}
+
+static bm_glyph_t* bm_atlas_glyph(GLsizei width, GLsizei height, const GLubyte *bitmap)
+{
+	bm_atlas_t *atlas = glstate->raster.bm_atlas;
+	if(!atlas) {
+		atlas = glstate->raster.bm_atlas = (bm_atlas_t*)calloc(1, sizeof(bm_atlas_t));
+		atlas->pixels = (GLubyte*)malloc(BM_ATLAS_SIZE*BM_ATLAS_SIZE*4);
+		atlas->glyphs = kh_init(bmglyph);
+		atlas->dirty_y1 = BM_ATLAS_SIZE;
+	}
+	GLubyte col[4];
+	for (int i=0; i<4; i++)
+		col[i] = glstate->color[i]*255.f;
+	int rowsize = (width+7)/8;
+	int sz = rowsize*height;
+	bm_glyph_t tmp;
+	tmp.width = width;
+	tmp.height = height;
+	memcpy(&tmp.color, col, 4);
+	tmp.bits = (GLubyte*)bitmap;
+	khint32_t h = 2166136261u^tmp.color;
+	h = (h^width)*16777619u;
+	h = (h^height)*16777619u;
+	for (int i=0; i<sz; ++i)
+		h = (h^bitmap[i])*16777619u;
+	tmp.hash = h;
+	khint_t k = kh_get(bmglyph, atlas->glyphs, &tmp);
+	if(k!=kh_end(atlas->glyphs))
+		return kh_key(atlas->glyphs, k);
+	// new glyph, find a place for it (with a 1 pixel gap)
+	if(atlas->shelf_x+width>BM_ATLAS_SIZE) {
+		atlas->shelf_x = 0;
+		atlas->shelf_y += atlas->shelf_h;
+		atlas->shelf_h = 0;
+	}
+	if(atlas->shelf_y+height>BM_ATLAS_SIZE) {
+		// atlas is full, draw what is pending and start again
+		if(glstate->raster.bm_drawing)
+			bitmap_flush();
+		bm_atlas_reset(atlas);
+	}
+	bm_glyph_t *g = (bm_glyph_t*)malloc(sizeof(bm_glyph_t)+sz);
+	memcpy(g, &tmp, sizeof(bm_glyph_t));
+	g->bits = (GLubyte*)(g+1);
+	memcpy(g->bits, bitmap, sz);
+	g->x = atlas->shelf_x;
+	g->y = atlas->shelf_y;
+	atlas->shelf_x += width+1;
+	atlas->shelf_h = max(atlas->shelf_h, height+1);
+	int ret;
+	kh_put(bmglyph, atlas->glyphs, g, &ret);
+	// expand it
+	for (int y=0; y<height; ++y) {
+		const GLubyte *from = bitmap+y*rowsize;
+		GLubyte *to = atlas->pixels+4*(g->x+(g->y+y)*BM_ATLAS_SIZE);
+		for (int x=0; x<width; ++x, to+=4) {
+			if(from[x/8] & (1<<(7-(x%8))))
+				memcpy(to, col, 4);
+			else
+				memset(to, 0, 4);
+		}
+	}
+	atlas->dirty_y1 = min(atlas->dirty_y1, g->y);
+	atlas->dirty_y2 = max(atlas->dirty_y2, g->y+height);
+	return g;
+}
+
+static void bm_atlas_quad(bm_glyph_t *g, int rx, int ry)
+{
+	bm_atlas_t *atlas = glstate->raster.bm_atlas;
+	if(atlas->count==atlas->cap) {
+		atlas->cap += 64;
+		atlas->vert = (GLfloat*)realloc(atlas->vert, atlas->cap*12*sizeof(GLfloat));
+		atlas->tex = (GLfloat*)realloc(atlas->tex, atlas->cap*12*sizeof(GLfloat));
+	}
+	GLfloat w2 = 2.0f / glstate->raster.viewport.width;
+	GLfloat h2 = 2.0f / glstate->raster.viewport.height;
+	GLfloat x1 = rx*w2-1.0f, x2 = (rx+g->width)*w2-1.0f;
+	GLfloat y1 = ry*h2-1.0f, y2 = (ry+g->height)*h2-1.0f;
+	GLfloat s1 = g->x*(1.0f/BM_ATLAS_SIZE), s2 = (g->x+g->width)*(1.0f/BM_ATLAS_SIZE);
+	GLfloat t1 = g->y*(1.0f/BM_ATLAS_SIZE), t2 = (g->y+g->height)*(1.0f/BM_ATLAS_SIZE);
+	GLfloat *v = atlas->vert+atlas->count*12;
+	GLfloat *t = atlas->tex+atlas->count*12;
+	v[0] = x1; v[1] = y1;  v[2] = x2; v[3] = y1;  v[4] = x2; v[5] = y2;
+	v[6] = x1; v[7] = y1;  v[8] = x2; v[9] = y2;  v[10]= x1; v[11]= y2;
+	t[0] = s1; t[1] = t1;  t[2] = s2; t[3] = t1;  t[4] = s2; t[5] = t2;
+	t[6] = s1; t[7] = t1;  t[8] = s2; t[9] = t2;  t[10]= s1; t[11]= t2;
+	++atlas->count;
+}
+
+static GLuint bm_atlas_draw()
+{
+	bm_atlas_t *atlas = glstate->raster.bm_atlas;
+	if(!atlas->texture) {
+		gl4es_glGenTextures(1, &atlas->texture);
+		gl4es_glBindTexture(GL_TEXTURE_2D, atlas->texture);
+
+		gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		gl4es_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BM_ATLAS_SIZE, BM_ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	} else {
+		gl4es_glBindTexture(GL_TEXTURE_2D, atlas->texture);
+	}
+	// upload the new glyphs
+	if(atlas->dirty_y2>atlas->dirty_y1) {
+		gl4es_glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+		gl4es_glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		gl4es_glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		gl4es_glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		gl4es_glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+		gl4es_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, atlas->dirty_y1, BM_ATLAS_SIZE, atlas->dirty_y2-atlas->dirty_y1,
+			GL_RGBA, GL_UNSIGNED_BYTE, atlas->pixels+4*atlas->dirty_y1*BM_ATLAS_SIZE);
+		gl4es_glPopClientAttrib();
+		atlas->dirty_y1 = BM_ATLAS_SIZE;
+		atlas->dirty_y2 = 0;
+	}
+	gl4es_blitTextureArrays(atlas->texture, atlas->vert, atlas->tex, GL_TRIANGLES, atlas->count*6, BLIT_ALPHA);
+	atlas->count = 0;
+	return atlas->texture;
+}
+
 void bitmap_flush() {
 	if(!glstate->raster.bm_drawing)
 		return;
@@ -272,48 +462,54 @@ void bitmap_flush() {
 	if(IS_TEXTURE_RECTANGLE(old_active)) gl4es_glDisable(GL_TEXTURE_RECTANGLE_ARB);
 	if(IS_CUBE_MAP(old_active)) gl4es_glDisable(GL_TEXTURE_CUBE_MAP);
 
-	if(!glstate->raster.bm_texture) {
-		gl4es_glGenTextures(1, &glstate->raster.bm_texture);
-		gl4es_glBindTexture(GL_TEXTURE_2D, glstate->raster.bm_texture);
-
-		gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0); // this is to be sure texture is not npot'ed ...
-		gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);	// ... if not needed
-	} else {
-		gl4es_glBindTexture(GL_TEXTURE_2D, glstate->raster.bm_texture);
-	}
-	if (glstate->raster.bm_tnwidth < glstate->raster.bm_width || glstate->raster.bm_tnheight < glstate->raster.bm_height) {
-		glstate->raster.bm_tnwidth = (hardext.npot)?glstate->raster.bm_width:npot(glstate->raster.bm_width);
-		glstate->raster.bm_tnheight = (hardext.npot)?glstate->raster.bm_height:npot(glstate->raster.bm_height);
-		gl4es_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, glstate->raster.bm_tnwidth, glstate->raster.bm_tnheight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-	}
-	int sx = glstate->raster.bm_x1;
-	int ex = glstate->raster.bm_x2-glstate->raster.bm_x1;
-	int sy = glstate->raster.bm_y1;
-	int ey = glstate->raster.bm_y2-glstate->raster.bm_y1;
-	if(sx==0 && sy==0 && ex==glstate->raster.bm_width && ey==glstate->raster.bm_height) {
-		gl4es_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, glstate->raster.bm_width, glstate->raster.bm_height, GL_RGBA, GL_UNSIGNED_BYTE, glstate->raster.bitmap);
+	GLuint bm_tex;
+	if(glstate->raster.bm_drawing==2) {
+		bm_tex = bm_atlas_draw();
 	} else {
-		int alloc = 4*ex*ey;
-		gl4es_scratch(alloc);
-		for (int i=0; i<ey; i++)
-			memcpy(glstate->scratch+4*i*ex, glstate->raster.bitmap+4*(sx+(sy+i)*glstate->raster.bm_width), ex*4);
-		gl4es_glTexSubImage2D(GL_TEXTURE_2D, 0, sx, sy, ex, ey, GL_RGBA, GL_UNSIGNED_BYTE, glstate->scratch);
-	}
-
-	gl4es_blitTexture(
-		glstate->raster.bm_texture, 
-		sx, sy,
-		ex, ey,
-		glstate->raster.bm_tnwidth , glstate->raster.bm_tnheight,
-		1.f, 1.f, 
-		0, 0,	//vp is default here
-		sx, sy,
-		BLIT_ALPHA
-	);
+		if(!glstate->raster.bm_texture) {
+			gl4es_glGenTextures(1, &glstate->raster.bm_texture);
+			gl4es_glBindTexture(GL_TEXTURE_2D, glstate->raster.bm_texture);
+
+			gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			gl4es_glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0); // this is to be sure texture is not npot'ed ...
+			gl4es_glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);	// ... if not needed
+		} else {
+			gl4es_glBindTexture(GL_TEXTURE_2D, glstate->raster.bm_texture);
+		}
+		if (glstate->raster.bm_tnwidth < glstate->raster.bm_width || glstate->raster.bm_tnheight < glstate->raster.bm_height) {
+			glstate->raster.bm_tnwidth = (hardext.npot)?glstate->raster.bm_width:npot(glstate->raster.bm_width);
+			glstate->raster.bm_tnheight = (hardext.npot)?glstate->raster.bm_height:npot(glstate->raster.bm_height);
+			gl4es_glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, glstate->raster.bm_tnwidth, glstate->raster.bm_tnheight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		}
+		int sx = glstate->raster.bm_x1;
+		int ex = glstate->raster.bm_x2-glstate->raster.bm_x1;
+		int sy = glstate->raster.bm_y1;
+		int ey = glstate->raster.bm_y2-glstate->raster.bm_y1;
+		if(sx==0 && sy==0 && ex==glstate->raster.bm_width && ey==glstate->raster.bm_height) {
+			gl4es_glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, glstate->raster.bm_width, glstate->raster.bm_height, GL_RGBA, GL_UNSIGNED_BYTE, glstate->raster.bitmap);
+		} else {
+			int alloc = 4*ex*ey;
+			gl4es_scratch(alloc);
+			for (int i=0; i<ey; i++)
+				memcpy(glstate->scratch+4*i*ex, glstate->raster.bitmap+4*(sx+(sy+i)*glstate->raster.bm_width), ex*4);
+			gl4es_glTexSubImage2D(GL_TEXTURE_2D, 0, sx, sy, ex, ey, GL_RGBA, GL_UNSIGNED_BYTE, glstate->scratch);
+		}
+
+		gl4es_blitTexture(
+			glstate->raster.bm_texture, 
+			sx, sy,
+			ex, ey,
+			glstate->raster.bm_tnwidth , glstate->raster.bm_tnheight,
+			1.f, 1.f, 
+			0, 0,	//vp is default here
+			sx, sy,
+			BLIT_ALPHA
+		);
+		bm_tex = glstate->raster.bm_texture;
+	}
 
 	glstate->raster.bm_drawing = 0;
 
@@ -323,7 +519,7 @@ void bitmap_flush() {
 	if(IS_TEXTURE_RECTANGLE(old_active)) gl4es_glEnable(GL_TEXTURE_RECTANGLE_ARB);
 	if(IS_CUBE_MAP(old_active)) gl4es_glEnable(GL_TEXTURE_CUBE_MAP);
 
-	if (old_tex!=glstate->raster.bm_texture)
+	if (old_tex!=bm_tex)
 		gl4es_glBindTexture(GL_TEXTURE_2D, old_tex);
 
 	if(old_tex_unit)
@@ -369,6 +565,22 @@ void gl4es_glBitmap(GLsizei width, GLsizei height, GLfloat xorig, GLfloat yorig,
         return;
     }
 
+	if(width<=BM_GLYPH_MAX && height<=BM_GLYPH_MAX && width>0 && height>0
+	 && glstate->raster.raster_zoomx==1.0f && glstate->raster.raster_zoomy==1.0f && !raster_need_transform()) {
+		int rx = glstate->raster.rPos.x-xorig;
+		int ry = glstate->raster.rPos.y-yorig;
+		if(rx<glstate->raster.viewport.width && ry<glstate->raster.viewport.height && rx+width>0 && ry+height>0) {
+			if(glstate->raster.bm_drawing==1)
+				bitmap_flush();	// keep the drawing order
+			bm_glyph_t *g = bm_atlas_glyph(width, height, bitmap);
+			bm_atlas_quad(g, rx, ry);
+			glstate->raster.bm_drawing = 2;
+		}
+		glstate->raster.rPos.x += xmove;
+		glstate->raster.rPos.y += ymove;
+		return;
+	}
+
 	// get start/end of drawed pixel
 	float zoomx = glstate->raster.raster_zoomx;
 	float zoomy = glstate->raster.raster_zoomy;
@@ -397,6 +609,8 @@ void gl4es_glBitmap(GLsizei width, GLsizei height, GLfloat xorig, GLfloat yorig,
 	}
 	if (ex<0 || ey<0 || sx<0 || sy<0 || sx==ex || sy==ey)	// nothing to draw, no changes
 		return;
+	if(glstate->raster.bm_drawing==2)
+		bitmap_flush();	// keep the drawing order
 	// create/realloc buffer if needed
 	if(glstate->raster.bm_alloc < glstate->raster.viewport.width*glstate->raster.viewport.height*4) {
 		if(glstate->raster.bitmap)
@@ -466,6 +680,160 @@ void gl4es_glBitmap(GLsizei width, GLsizei height, GLfloat xorig, GLfloat yorig,
 	glstate->raster.bm_drawing = 1;
 }
 
+// Cache of glDrawPixels textures: an image drawn again (same pixels, same format and same pixel
+// transfer state) reuses the texture it was uploaded to the previous time. Images are only cached
+// the second time they are seen, so streamed images still use the single "immediate" texture.
+#define DP_CACHE_SIZE	(16*1024*1024)	// max size of the cached textures, in bytes
+#define DP_CACHE_SEEN	16				// number of recent uncached images remembered
+
+typedef struct dp_key_s {
+	uint64_t	hash;		// of the pixels
+	GLsizei		width, height, rowlength;
+	GLint		skip_pixels, skip_rows;
+	GLenum		format, type;
+	GLfloat		scale[4], bias[4];
+	GLuint		map_gen;
+} dp_key_t;
+
+typedef struct dp_entry_s {
+	dp_key_t	key;
+	rasterlist_t raster;
+	int			size;
+	struct dp_entry_s *prev, *next;	// LRU list, most recent first
+} dp_entry_t;
+
+static kh_inline khint32_t dp_key_hash(dp_key_t* k) { return (khint32_t)(k->hash^(k->hash>>32)); }
+#define dp_key_equal(a, b) (memcmp(a, b, sizeof(dp_key_t))==0)
+KHASH_INIT(dpcache, dp_key_t*, dp_entry_t*, 1, dp_key_hash, dp_key_equal);
+
+typedef struct dp_cache_s {
+	khash_t(dpcache) *entries;
+	dp_entry_t	*first, *last;
+	int			size;
+	uint64_t	seen[DP_CACHE_SEEN];
+	int			seen_idx;
+} dp_cache_t;
+
+void free_drawpixels_cache(dp_cache_t *cache)
+{
+	if(!cache)
+		return;
+	dp_entry_t *e = cache->first;
+	while(e) {
+		dp_entry_t *next = e->next;
+		free(e);
+		e = next;
+	}
+	kh_destroy(dpcache, cache->entries);
+	free(cache);
+}
+
+static int dp_makekey(dp_key_t *key, GLsizei width, GLsizei height, GLsizei rowlength, GLenum format, GLenum type, const GLvoid *data)
+{
+	// all the rows read, the skipped ones included
+	int size = pixel_sizeof(format, type)*rowlength*(height+glstate->texture.unpack_skip_rows);
+	if(!data || !size)
+		return 0;
+	memset(key, 0, sizeof(dp_key_t));	// no garbage in the padding, it's hashed and compared
+	// 64bits FNV-1a like, on 4 interleaved lanes of 8 bytes so the multiplications don't wait for each other
+	const uint8_t *p = (const uint8_t*)data;
+	uint64_t l[4] = {0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL, 0x9ce484222325cbf2ULL, 0x2325cbf29ce48422ULL};
+	while(size>=32) {
+		uint64_t v[4];
+		memcpy(v, p, 32);
+		for (int i=0; i<4; ++i) {
+			l[i] = (l[i]^v[i])*0x100000001b3ULL;
+			l[i] ^= l[i]>>29;
+		}
+		p+=32; size-=32;
+	}
+	uint64_t h = l[0];
+	for (int i=1; i<4; ++i)
+		h = ((h^l[i])*0x100000001b3ULL)^(h>>29);
+	while(size--)
+		h = (h^*(p++))*0x100000001b3ULL;
+	key->hash = h;
+	key->width = width;
+	key->height = height;
+	key->rowlength = rowlength;
+	key->skip_pixels = glstate->texture.unpack_skip_pixels;
+	key->skip_rows = glstate->texture.unpack_skip_rows;
+	key->format = format;
+	key->type = type;
+	memcpy(key->scale, glstate->raster.raster_scale, sizeof(key->scale));
+	memcpy(key->bias, glstate->raster.raster_bias, sizeof(key->bias));
+	key->map_gen = glstate->raster.map_gen;
+	return 1;
+}
+
+static void dp_unlink(dp_cache_t *cache, dp_entry_t *e)
+{
+	if(e->prev) e->prev->next = e->next; else cache->first = e->next;
+	if(e->next) e->next->prev = e->prev; else cache->last = e->prev;
+	e->prev = e->next = NULL;
+}
+
+static void dp_pushfront(dp_cache_t *cache, dp_entry_t *e)
+{
+	e->prev = NULL;
+	e->next = cache->first;
+	if(cache->first) cache->first->prev = e; else cache->last = e;
+	cache->first = e;
+}
+
+static dp_entry_t* dp_find(dp_key_t *key)
+{
+	dp_cache_t *cache = glstate->raster.dp_cache;
+	if(!cache)
+		return NULL;
+	khint_t k = kh_get(dpcache, cache->entries, key);
+	if(k==kh_end(cache->entries))
+		return NULL;
+	dp_entry_t *e = kh_value(cache->entries, k);
+	if(cache->first!=e) {
+		dp_unlink(cache, e);
+		dp_pushfront(cache, e);
+	}
+	return e;
+}
+
+// return 1 if the image has been seen recently, and remember it else
+static int dp_seen(dp_key_t *key)
+{
+	dp_cache_t *cache = glstate->raster.dp_cache;
+	if(!cache) {
+		cache = glstate->raster.dp_cache = (dp_cache_t*)calloc(1, sizeof(dp_cache_t));
+		cache->entries = kh_init(dpcache);
+	}
+	uint64_t h = key->hash^((uint64_t)key->width<<32)^key->height^((uint64_t)key->format<<16)^key->type;
+	for (int i=0; i<DP_CACHE_SEEN; ++i)
+		if(cache->seen[i]==h)
+			return 1;
+	cache->seen[cache->seen_idx] = h;
+	cache->seen_idx = (cache->seen_idx+1)%DP_CACHE_SEEN;
+	return 0;
+}
+
+static void dp_add(dp_entry_t *e)
+{
+	dp_cache_t *cache = glstate->raster.dp_cache;
+	e->size = e->raster.nwidth*e->raster.nheight*4;
+	cache->size += e->size;
+	int ret;
+	khint_t k = kh_put(dpcache, cache->entries, &e->key, &ret);
+	kh_value(cache->entries, k) = e;
+	dp_pushfront(cache, e);
+	// evict the least recently used ones
+	while(cache->size>DP_CACHE_SIZE && cache->last!=e) {
+		dp_entry_t *old = cache->last;
+		dp_unlink(cache, old);
+		kh_del(dpcache, cache->entries, kh_get(dpcache, cache->entries, &old->key));
+		cache->size -= old->size;
+		gl4es_glDeleteTextures(1, &old->raster.texture);
+		free(old);
+	}
+}
+
 void gl4es_glDrawPixels(GLsizei width, GLsizei height, GLenum format,
                   GLenum type, const GLvoid *data) {
     GLubyte *pixels, *from, *to;
@@ -489,12 +857,31 @@ void gl4es_glDrawPixels(GLsizei width, GLsizei height, GLenum format,
 		return;
     }
 
-    init_raster(width, height);
-
 	GLsizei bmp_width = (glstate->texture.unpack_row_length)?glstate->texture.unpack_row_length:width;
 
-    if (! pixel_convert(data, &dst, bmp_width, height,
+	dp_key_t key;
+	dp_entry_t *cached = NULL;
+	if (!glstate->list.active && width*height*4<=DP_CACHE_SIZE/4
+	 && dp_makekey(&key, width, height, bmp_width, format, type, data)) {
+		cached = dp_find(&key);
+		if (cached) {
+			cached->raster.zoomx = glstate->raster.raster_zoomx;
+			cached->raster.zoomy = glstate->raster.raster_zoomy;
+			render_raster_list(&cached->raster);
+			return;
+		}
+		if (dp_seen(&key)) {
+			// drawn again, so it will be cached this time
+			cached = (dp_entry_t*)calloc(1, sizeof(dp_entry_t));
+			memcpy(&cached->key, &key, sizeof(dp_key_t));
+		}
+	}
+
+    init_raster(width, height);
+
+    if (! pixel_convert(data, &dst, bmp_width, height+glstate->texture.unpack_skip_rows,
                         format, type, GL_RGBA, GL_UNSIGNED_BYTE, 0, 1)) {	// pack_align is forced to 1 when drawing
+        free(cached);
         return;
     }
 					  
@@ -535,6 +922,8 @@ void gl4es_glDrawPixels(GLsizei width, GLsizei height, GLenum format,
 		memset(r, 0, sizeof(rasterlist_t));
         r->shared = (int*)malloc(sizeof(int));
         *r->shared = 0;
+	} else if (cached) {
+		r = &cached->raster;
 	} else {
 		r = &glstate->raster.immediate;
 		if(r->texture && (width>r->nwidth || height>r->nheight)) {
@@ -550,6 +939,8 @@ void gl4es_glDrawPixels(GLsizei width, GLsizei height, GLenum format,
 	r->bitmap = false;
 	r->zoomx = glstate->raster.raster_zoomx;
 	r->zoomy = glstate->raster.raster_zoomy;
+	if (cached)
+		dp_add(cached);
 	if (!(glstate->list.active)) {
 		render_raster_list(r);
 /*		gles_glDeleteTextures(1, &r->texture);
@@ -634,15 +1025,16 @@ void gl4es_glPixelMapfv(GLenum map, GLsizei mapsize, const GLfloat *values) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<mapsize; i++)
-			p[i] = values[i]*255.0f;
+			p[i] = (values[i]<0.0f)?0:((values[i]>1.0f)?255:(GLubyte)(values[i]*255.0f));
 	} else {
 		GLuint *p = (GLuint*)array;
 		for (int i=0; i<mapsize; i++)
 			p[i] = values[i];
 	}
 	*size = mapsize;
+	++glstate->raster.map_gen;
 }
 void gl4es_glPixelMapuiv(GLenum map,GLsizei mapsize, const GLuint *values) {
 	if(mapsize>MAX_MAP_SIZE) {
@@ -665,7 +1057,7 @@ void gl4es_glPixelMapuiv(GLenum map,GLsizei mapsize, const GLuint *values) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<mapsize; i++)
 			p[i] = values[i]>>24;
 	} else {
@@ -674,6 +1066,7 @@ void gl4es_glPixelMapuiv(GLenum map,GLsizei mapsize, const GLuint *values) {
 			p[i] = values[i];
 	}
 	*size = mapsize;
+	++glstate->raster.map_gen;
 }
 
 void gl4es_glPixelMapusv(GLenum map,GLsizei mapsize, const GLushort *values) {
@@ -697,7 +1090,7 @@ void gl4es_glPixelMapusv(GLenum map,GLsizei mapsize, const GLushort *values) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<mapsize; i++)
 			p[i] = values[i]>>8;
 	} else {
@@ -706,6 +1099,7 @@ void gl4es_glPixelMapusv(GLenum map,GLsizei mapsize, const GLushort *values) {
 			p[i] = values[i];
 	}
 	*size = mapsize;
+	++glstate->raster.map_gen;
 }
 void gl4es_glGetPixelMapfv(GLenum map, GLfloat *data) {
 	int wf = 1;
@@ -715,7 +1109,7 @@ void gl4es_glGetPixelMapfv(GLenum map, GLfloat *data) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<*size; i++)
 			data[i] = p[i]/255.0f;
 	} else {
@@ -732,7 +1126,7 @@ void gl4es_glGetPixelMapuiv(GLenum map, GLuint *data) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<*size; i++)
 			data[i] = ((GLuint)(p[i]))<<24;
 	} else {
@@ -749,7 +1143,7 @@ void gl4es_glGetPixelMapusv(GLenum map, GLushort *data) {
 		return;
 	noerrorShim();
 	if(wf) {
-		GLfloat *p = (GLfloat*)array;
+		GLubyte *p = (GLubyte*)array;
 		for (int i=0; i<*size; i++)
 			data[i] = ((GLuint)(p[i]))<<8;
 	} else {
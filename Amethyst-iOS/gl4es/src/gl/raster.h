@@ -49,5 +49,9 @@ void gl4es_glGetPixelMapusv(GLenum map, GLushort *data);
 void render_raster_list(rasterlist_t* raster);
 
 void bitmap_flush();
+struct bm_atlas_s;
+void free_bitmap_atlas(struct bm_atlas_s *atlas);
+struct dp_cache_s;
+void free_drawpixels_cache(struct dp_cache_s *cache);
 	
 #endif // _GL4ES_RASTER_H_
@@ -1,8 +1,11 @@
 #include "render.h"
 
 #include "array.h"
+#include "enum_info.h"
 #include "init.h"
 #include "matrix.h"
+#include "matvec.h"
+#include "simd.h"
 
 void push_hit() {
     // push current hit to hit list, and re-init current hit
@@ -53,6 +56,8 @@ GLint gl4es_glRenderMode(GLenum mode) {
 	if (glstate->render_mode == GL_SELECT) {
         push_hit();
 		ret = glstate->selectbuf.count;
+		free_select_cache(glstate->selectbuf.cache);
+		glstate->selectbuf.cache = NULL;
     }
 	if (mode == GL_SELECT) {
 		if (glstate->selectbuf.buffer == NULL)	{// error, cannot use Select Mode without select buffer
@@ -212,16 +217,8 @@ GLboolean select_segment_in_viewscreen(const GLfloat *a, const GLfloat *b) {
 	return true;
 }
 
-GLboolean select_triangle_in_viewscreen(const GLfloat *a, const GLfloat *b, const GLfloat *c) {
-	/*
-	 Return True is the triangle is in the viewscreen, or completly include, or include the viewscreen
-	*/
-	 // Check if any segment intersect the viewscreen (include test if any point is inside the viewscreen)
-	 if (select_segment_in_viewscreen(a, b)) return true;
-	 if (select_segment_in_viewscreen(b, c)) return true;
-	 if (select_segment_in_viewscreen(c, a)) return true;
-
-	 // Now check if the viewscreen is completly inside the triangle
+static GLboolean select_viewscreen_in_triangle(const GLfloat *a, const GLfloat *b, const GLfloat *c) {
+	// Check if the viewscreen is completly inside the triangle
 	 #define sign(p1, p2, p3) (p1[0]-p3[0])*(p2[1]-p3[1])-(p2[0]-p3[0])*(p1[1]-p3[1])
 	 for (int i=0; i<4; i++) {
 	 	GLboolean b1,b2,b3;
@@ -240,101 +237,264 @@ GLboolean select_triangle_in_viewscreen(const GLfloat *a, const GLfloat *b, cons
 	 return false;
 }
 
+GLboolean select_triangle_in_viewscreen(const GLfloat *a, const GLfloat *b, const GLfloat *c) {
+	/*
+	 Return True is the triangle is in the viewscreen, or completly include, or include the viewscreen
+	*/
+	 // Check if any segment intersect the viewscreen (include test if any point is inside the viewscreen)
+	 if (select_segment_in_viewscreen(a, b)) return true;
+	 if (select_segment_in_viewscreen(b, c)) return true;
+	 if (select_segment_in_viewscreen(c, a)) return true;
+
+	 return select_viewscreen_in_triangle(a, b, c);
+}
+
 static void FASTMATH ZMinMax(GLfloat *zmin, GLfloat *zmax, GLfloat *vtx) {
 	if (vtx[2]<*zmin) *zmin=vtx[2];
 	if (vtx[2]>*zmax) *zmax=vtx[2];
 }
 
+/*
+ Outcodes of the transformed vertices: a bit is only set when the vertex is far enough on one side
+ of the viewscreen that select_segment_in_viewscreen always rejects a segment with both ends on
+ that side, even with the rounding of its float computations (the margin keeps the Liang-Barsky
+ ratios above 1+2^-21 as long as the coordinates are under the far limit).
+ Other vertices get no bit and go through the full tests, so the hits are the same.
+*/
+#define SELECT_OUT_LEFT		1
+#define SELECT_OUT_RIGHT	2
+#define SELECT_OUT_BOTTOM	4
+#define SELECT_OUT_TOP		8
+#define SELECT_OUT_MARGIN	1.0625f
+#define SELECT_OUT_FAR		65536.0f
 
-void select_glDrawArrays(const vertexattrib_t* vtx, GLenum mode, GLuint first, GLuint count) {
-	if (count == 0) return;
-	if (vtx->pointer == NULL) return;
-	if (glstate->selectbuf.buffer == NULL) return;
-	GLfloat *vert = copy_gl_array(vtx->pointer, vtx->type, 
-			vtx->size, vtx->stride,
-			GL_FLOAT, 4, 0, count+first, NULL);
-	GLfloat zmin=1e10f, zmax=-1e10f;
-	int found = 0;
+static inline GLubyte select_outcode(const GLfloat *a) {
+	GLubyte c = 0;
+	if (a[0]<-SELECT_OUT_MARGIN && a[0]>-SELECT_OUT_FAR) c|=SELECT_OUT_LEFT;
+	else if (a[0]>SELECT_OUT_MARGIN && a[0]<SELECT_OUT_FAR) c|=SELECT_OUT_RIGHT;
+	if (a[1]<-SELECT_OUT_MARGIN && a[1]>-SELECT_OUT_FAR) c|=SELECT_OUT_BOTTOM;
+	else if (a[1]>SELECT_OUT_MARGIN && a[1]<SELECT_OUT_FAR) c|=SELECT_OUT_TOP;
+	return c;
+}
 
-	#define FOUND()	{ 				\
-		found = 1;					\
-		glstate->selectbuf.hit = 1; \
+static void FASTMATH select_transform_vertices(GLfloat *vert, GLubyte *code, int count, const GLfloat *mvp) {
+	int i = 0;
+#ifdef GL4ES_SIMD
+	if (!globals4es.nosimd) {
+		// same operations as vector_matrix and select_transform, with the matrix kept in registers
+		const simd_f4 m0 = simd_load_f(mvp), m1 = simd_load_f(mvp+4), m2 = simd_load_f(mvp+8), m3 = simd_load_f(mvp+12);
+		const simd_m4 xyz = simd_lanemask(3);
+		for (; i<count; i++) {
+			GLfloat *a = vert+i*4;
+			simd_f4 r = simd_mul_f(m0, simd_set1_f(a[0]));
+			r = simd_add_f(r, simd_mul_f(m1, simd_set1_f(a[1])));
+			r = simd_add_f(r, simd_mul_f(m2, simd_set1_f(a[2])));
+			r = simd_add_f(r, simd_mul_f(m3, simd_set1_f(a[3])));
+			simd_store_f(a, r);
+			simd_store_f(a, simd_select(xyz, simd_div_f(r, simd_set1_f(a[3])), r));
+			code[i] = select_outcode(a);
+		}
+	}
+#endif
+	for (; i<count; i++) {
+		GLfloat *a = vert+i*4;
+		vector_matrix(a, mvp, a);
+		a[0]/=a[3];
+		a[1]/=a[3];
+		a[2]/=a[3];
+		code[i] = select_outcode(a);
 	}
+}
 
-    // transform the points
-	for (int i=first; i<count+first; i++) {
-		select_transform(vert+i*4);
-		ZMinMax(&glstate->selectbuf.zminoverall, &glstate->selectbuf.zmaxoverall, vert+i*4);
-    }
-    // intersect with screen now
-    GLfloat *vert2 = vert + first*4;
-	for (int i=0; i<count; i++) {
-		switch (mode) {
-			case GL_POINTS:
-				if (select_point_in_viewscreen(vert2+i*4)) {
-					ZMinMax(&zmin, &zmax, vert+i*4);
-					FOUND();
-				}
-				break;
-			case GL_LINES:
-				if (i%2==1) {
-					if (select_segment_in_viewscreen(vert2+(i-1)*4, vert2+i*4)) {
-						ZMinMax(&zmin, &zmax, vert+(i-1)*4);
-						ZMinMax(&zmin, &zmax, vert+i*4);
-						FOUND();
-					}
-				}
-				break;
-			case GL_LINE_STRIP:
-			case GL_LINE_LOOP:		//FIXME: the last "loop" segment is missing here
-				if (i>0) {
-					if (select_segment_in_viewscreen(vert2+(i-1)*4, vert2+i*4)) {
-						ZMinMax(&zmin, &zmax, vert+(i-1)*4);
-						ZMinMax(&zmin, &zmax, vert+i*4);
-						FOUND();
-					}
-				}
-				break;
-			case GL_TRIANGLES:
-				if (i%3==2) {
-					if (select_triangle_in_viewscreen(vert2+(i-2)*4, vert2+(i-1)*4, vert2+i*4)) {
-						ZMinMax(&zmin, &zmax, vert+(i-2)*4);
-						ZMinMax(&zmin, &zmax, vert+(i-1)*4);
-						ZMinMax(&zmin, &zmax, vert+i*4);
-						FOUND();
-					}
+/*
+ Transformed vertices of the last select draws. They are reused while the vertex array, its content
+ and the MVP matrix don't change, like when an editor draws each object of a big array with its own
+ glLoadName and glDrawElements.
+*/
+typedef struct select_cache_s {
+	const GLvoid*	pointer;	// source array
+	GLenum		type;
+	GLint		size;
+	GLsizei		stride;
+	GLfloat		mvp[16];
+	int			first;		// cached vertices are [first, last)
+	int			last;
+	int			cap;
+	GLfloat*	vert;		// transformed vertices, divided by w
+	GLubyte*	code;		// outcodes of the transformed vertices
+	char*		src;		// copy of the source, to detect changes in the array
+	int			srccap;
+} select_cache_t;
+
+void free_select_cache(struct select_cache_s *cache) {
+	if (!cache)
+		return;
+	free(cache->vert);
+	free(cache->code);
+	free(cache->src);
+	free(cache);
+}
+
+static int select_srclen(const select_cache_t *sc, int first, int last) {
+	return (last-first-1)*sc->stride + sc->size*gl_sizeof(sc->type);
+}
+
+static int select_cache_valid(const select_cache_t *sc, int first, int last) {
+	return memcmp(sc->src+(first-sc->first)*sc->stride, (const char*)sc->pointer+first*sc->stride, select_srclen(sc, first, last))==0;
+}
+
+static void select_cache_reserve(select_cache_t *sc, int count) {
+	// the range grows a draw at a time, so grow the buffers by more than that
+	if (count>sc->cap) {
+		sc->cap = (count>sc->cap*2)?count:sc->cap*2;
+		sc->vert = (GLfloat*)realloc(sc->vert, sc->cap*4*sizeof(GLfloat));
+		sc->code = (GLubyte*)realloc(sc->code, sc->cap);
+	}
+	int srclen = select_srclen(sc, 0, count);
+	if (srclen>sc->srccap) {
+		sc->srccap = (srclen>sc->srccap*2)?srclen:sc->srccap*2;
+		sc->src = (char*)realloc(sc->src, sc->srccap);
+	}
+}
+
+// convert and transform [first, last) into the cache (inside the cached range)
+static void select_cache_fill(select_cache_t *sc, int first, int last) {
+	if (first>=last)
+		return;
+	int offs = first-sc->first;
+	// not normalized, missing z is 0 and missing w is 1
+	copy_gl_array_texcoord(sc->pointer, sc->type, sc->size, sc->stride, 4, first, last, sc->vert+offs*4);
+	memcpy(sc->src+offs*sc->stride, (const char*)sc->pointer+first*sc->stride, select_srclen(sc, first, last));
+	select_transform_vertices(sc->vert+offs*4, sc->code+offs, last-first, sc->mvp);
+}
+
+static select_cache_t *select_vertices(const vertexattrib_t* vtx, int first, int last) {
+	select_cache_t *sc = glstate->selectbuf.cache;
+	if (!sc)
+		sc = glstate->selectbuf.cache = (select_cache_t*)calloc(1, sizeof(select_cache_t));
+	const GLfloat *mvp = getMVPMat();
+	GLsizei stride = vtx->stride?vtx->stride:vtx->size*gl_sizeof(vtx->type);
+	int same = (sc->last>sc->first) && sc->pointer==vtx->pointer && sc->type==vtx->type
+		&& sc->size==vtx->size && sc->stride==stride && memcmp(sc->mvp, mvp, sizeof(sc->mvp))==0;
+	if (same && first>=sc->first && last<=sc->last && select_cache_valid(sc, first, last))
+		return sc;
+	// extend the cached range when the draw is next to it (the vertices in between are also transformed,
+	// at most as many as in the draw), else start again with this draw. Only the part of the cache used
+	// by the draw is checked, the rest is checked by the draws that use it.
+	int newfirst = (same && first>sc->first)?sc->first:first;
+	int newlast = (same && last<sc->last)?sc->last:last;
+	int overfirst = (first>sc->first)?first:sc->first;
+	int overlast = (last<sc->last)?last:sc->last;
+	if (same && (newlast-newfirst)<=(sc->last-sc->first)+2*(last-first)
+	 && (overfirst>=overlast || select_cache_valid(sc, overfirst, overlast))) {
+		int shift = sc->first-newfirst;
+		select_cache_reserve(sc, newlast-newfirst);
+		if (shift) {
+			memmove(sc->vert+shift*4, sc->vert, (sc->last-sc->first)*4*sizeof(GLfloat));
+			memmove(sc->code+shift, sc->code, sc->last-sc->first);
+			memmove(sc->src+shift*stride, sc->src, select_srclen(sc, sc->first, sc->last));
+		}
+		int oldfirst = sc->first, oldlast = sc->last;
+		sc->first = newfirst;
+		sc->last = newlast;
+		select_cache_fill(sc, newfirst, oldfirst);
+		select_cache_fill(sc, oldlast, newlast);
+		return sc;
+	}
+	sc->pointer = vtx->pointer;
+	sc->type = vtx->type;
+	sc->size = vtx->size;
+	sc->stride = stride;
+	memcpy(sc->mvp, mvp, sizeof(sc->mvp));
+	sc->first = first;
+	sc->last = last;
+	select_cache_reserve(sc, last-first);
+	select_cache_fill(sc, first, last);
+	return sc;
+}
+
+/*
+ Test the primitives against the viewscreen. Vertex i of the draw is first+i without indices.
+ Return True if any primitive was hit, with zmin/zmax updated with its vertices.
+*/
+static int select_primitives(const select_cache_t *sc, GLenum mode, GLuint count, GLuint first, const GLushort *sind, const GLuint *iind, GLfloat *zmin, GLfloat *zmax) {
+	int found = 0;
+	#define IDX(i)	((sind?sind[i]:(iind?iind[i]:first+(i)))-sc->first)
+	#define V(i)	(sc->vert+IDX(i)*4)
+	#define C(i)	(sc->code[IDX(i)])
+	switch (mode) {
+		case GL_POINTS:
+			for (int i=0; i<count; i++)
+				if (!C(i) && select_point_in_viewscreen(V(i))) {
+					ZMinMax(zmin, zmax, V(i));
+					found = 1;
 				}
-				break;
-			case GL_TRIANGLE_STRIP:
-				if (i>1) {
-					if (select_triangle_in_viewscreen(vert2+(i-2)*4, vert2+(i-1)*4, vert2+i*4)) {
-						ZMinMax(&zmin, &zmax, vert+(i-2)*4);
-						ZMinMax(&zmin, &zmax, vert+(i-1)*4);
-						ZMinMax(&zmin, &zmax, vert+i*4);
-						FOUND();
-					}
+			break;
+		case GL_LINES:
+		case GL_LINE_STRIP:
+		case GL_LINE_LOOP:		//FIXME: the last "loop" segment is missing here
+			for (int i=1; i<count; i+=(mode==GL_LINES)?2:1)
+				if (!(C(i-1)&C(i)) && select_segment_in_viewscreen(V(i-1), V(i))) {
+					ZMinMax(zmin, zmax, V(i-1));
+					ZMinMax(zmin, zmax, V(i));
+					found = 1;
 				}
-				break;
-			case GL_TRIANGLE_FAN:
-				if (i>1) {
-					if (select_triangle_in_viewscreen(vert2, vert2+(i-1)*4, vert2+i*4)) {
-						ZMinMax(&zmin, &zmax, vert);
-						ZMinMax(&zmin, &zmax, vert+(i-1)*4);
-						ZMinMax(&zmin, &zmax, vert+i*4);
-						FOUND();
-					}
+			break;
+		case GL_TRIANGLES:
+		case GL_TRIANGLE_STRIP:
+		case GL_TRIANGLE_FAN:
+			for (int i=2; i<count; i+=(mode==GL_TRIANGLES)?3:1) {
+				const int i0 = (mode==GL_TRIANGLE_FAN)?0:i-2;
+				const GLfloat *a = V(i0), *b = V(i-1), *c = V(i);
+				const GLubyte ca = C(i0), cb = C(i-1), cc = C(i);
+				// edges with both ends on the same side are skipped, they can't hit
+				if ((!(ca&cb) && select_segment_in_viewscreen(a, b))
+				 || (!(cb&cc) && select_segment_in_viewscreen(b, c))
+				 || (!(cc&ca) && select_segment_in_viewscreen(c, a))
+				 || select_viewscreen_in_triangle(a, b, c)) {
+					ZMinMax(zmin, zmax, V(i0));
+					ZMinMax(zmin, zmax, V(i-1));
+					ZMinMax(zmin, zmax, V(i));
+					found = 1;
 				}
-				break;
-			default:
-				return;		// Should never go there!
-		}
+			}
+			break;
 	}
-	free(vert);
-	if(found) {
+	#undef C
+	#undef V
+	#undef IDX
+	return found;
+}
+
+// update the overall z range with the vertices [first, last), and return True if they are all on the same side
+static int select_zrange(const select_cache_t *sc, int first, int last) {
+	GLubyte all = 0xff;
+	for (int i=first-sc->first; i<last-sc->first; i++) {
+		ZMinMax(&glstate->selectbuf.zminoverall, &glstate->selectbuf.zmaxoverall, sc->vert+i*4);
+		all &= sc->code[i];
+	}
+	return all!=0;
+}
+
+static void select_draw(const vertexattrib_t* vtx, GLenum mode, GLuint count, GLuint first, GLuint last,
+	const GLushort *sind, const GLuint *iind, GLfloat zmin, GLfloat zmax) {
+	select_cache_t *sc = select_vertices(vtx, first, last);
+	// whole draw rejected when all its vertices are on the same side (triangles still need the
+	// "viewscreen inside" test, for degenerated ones)
+	if (select_zrange(sc, first, last) && mode<GL_TRIANGLES)
+		return;
+	if (select_primitives(sc, mode, count, first, sind, iind, &zmin, &zmax)) {
+		glstate->selectbuf.hit = 1;
 		if (zmin<glstate->selectbuf.zmin) 	glstate->selectbuf.zmin=zmin;
 		if (zmax>glstate->selectbuf.zmax) 	glstate->selectbuf.zmax=zmax;
 	}
-	#undef FOUND
+}
+
+void select_glDrawArrays(const vertexattrib_t* vtx, GLenum mode, GLuint first, GLuint count) {
+	if (count == 0) return;
+	if (vtx->pointer == NULL) return;
+	if (glstate->selectbuf.buffer == NULL) return;
+	select_draw(vtx, mode, count, first, first+count, NULL, NULL, 1e10f, -1e10f);
 }
 
 void select_glDrawElements(const vertexattrib_t* vtx, GLenum mode, GLuint count, GLenum type, GLvoid * indices) {
@@ -349,152 +509,7 @@ void select_glDrawElements(const vertexattrib_t* vtx, GLenum mode, GLuint count,
 		getminmax_indices_us(sind, &max, &min, count);
 	else
 		getminmax_indices_ui(iind, &max, &min, count);
-    max++;
-	GLfloat *vert = copy_gl_array(vtx->pointer, vtx->type, 
-			vtx->size, vtx->stride,
-			GL_FLOAT, 4, 0, max, NULL);
-	GLfloat zmin=1e10f, zmax=-10e6f;
-	int found = 0;
-	for (int i=min; i<max; i++) {
-		select_transform(vert+i*4);
-		ZMinMax(&glstate->selectbuf.zminoverall, &glstate->selectbuf.zmaxoverall, vert+i*4);
-	}
-
-	#define FOUND()	{ 				\
-		found = 1;					\
-		glstate->selectbuf.hit = 1; \
-		}
-
-	if(sind) {
-		for (int i=0; i<count; i++) {
-			switch (mode) {
-				case GL_POINTS:
-					if (select_point_in_viewscreen(vert+sind[i]*4)) {
-						ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-						FOUND();
-					}
-					break;
-				case GL_LINES:
-					if (i%2==1) {
-						if (select_segment_in_viewscreen(vert+sind[(i-1)]*4, vert+sind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+sind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_LINE_STRIP:
-				case GL_LINE_LOOP:		//FIXME: the last "loop" segment is missing here
-					if (i>0) {
-						if (select_segment_in_viewscreen(vert+sind[(i-1)]*4, vert+sind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+sind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLES:
-					if (i%3==2) {
-						if (select_triangle_in_viewscreen(vert+sind[(i-2)]*4, vert+sind[(i-1)]*4, vert+sind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+sind[i-2]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLE_STRIP:
-					if (i>1) {
-						if (select_triangle_in_viewscreen(vert+sind[(i-2)]*4, vert+sind[(i-1)]*4, vert+sind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+sind[i-2]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLE_FAN:
-					if (i>1) {
-						if (select_triangle_in_viewscreen(vert+sind[0]*4, vert+sind[(i-1)]*4, vert+sind[i]*4))
-							ZMinMax(&zmin, &zmax, vert+sind[0]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+sind[i]*4);
-							FOUND();
-					}
-					break;
-				default:
-					return;		// Should never go there!
-			}
-		} 
-	} else {
-		for (int i=0; i<count; i++) {
-			switch (mode) {
-				case GL_POINTS:
-					if (select_point_in_viewscreen(vert+iind[i]*4)) {
-						ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-						FOUND();
-					}
-					break;
-				case GL_LINES:
-					if (i%2==1) {
-						if (select_segment_in_viewscreen(vert+iind[(i-1)]*4, vert+iind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+iind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_LINE_STRIP:
-				case GL_LINE_LOOP:		//FIXME: the last "loop" segment is missing here
-					if (i>0) {
-						if (select_segment_in_viewscreen(vert+iind[(i-1)]*4, vert+iind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+iind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLES:
-					if (i%3==2) {
-						if (select_triangle_in_viewscreen(vert+iind[(i-2)]*4, vert+iind[(i-1)]*4, vert+iind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+iind[i-2]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLE_STRIP:
-					if (i>1) {
-						if (select_triangle_in_viewscreen(vert+iind[(i-2)]*4, vert+iind[(i-1)]*4, vert+iind[i]*4)) {
-							ZMinMax(&zmin, &zmax, vert+iind[i-2]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-							FOUND();
-						}
-					}
-					break;
-				case GL_TRIANGLE_FAN:
-					if (i>1) {
-						if (select_triangle_in_viewscreen(vert+iind[0]*4, vert+iind[(i-1)]*4, vert+iind[i]*4))
-							ZMinMax(&zmin, &zmax, vert+iind[0]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i-1]*4);
-							ZMinMax(&zmin, &zmax, vert+iind[i]*4);
-							FOUND();
-					}
-					break;
-				default:
-					return;		// Should never go there!
-			}
-		}
-	}
-	free(vert);
-	if(found) {
-		if (zmin<glstate->selectbuf.zmin) 	glstate->selectbuf.zmin=zmin;
-		if (zmax>glstate->selectbuf.zmax) 	glstate->selectbuf.zmax=zmax;
-	}
-
-	#undef FOUND
+	select_draw(vtx, mode, count, min, max+1, sind, iind, 1e10f, -10e6f);
 }
 
 //Direct wrapper
@@ -13,5 +13,7 @@ void gl4es_glSelectBuffer(GLsizei size, GLuint *buffer);
 
 void select_glDrawElements(const vertexattrib_t* vtx, GLenum mode, GLuint count, GLenum type, GLvoid * indices);
 void select_glDrawArrays(const vertexattrib_t* vtx, GLenum mode, GLuint first, GLuint count);
+struct select_cache_s;
+void free_select_cache(struct select_cache_s *cache);
 
 #endif // _GL4ES_RENDER_H_
@@ -6,6 +6,7 @@
 #include "fpe_shader.h"
 #include "init.h"
 #include "preproc.h"
+#include "shaderconv_cache.h"
 #include "string_utils.h"
 #include "shader_hacks.h"
 #include "logs.h"
@@ -439,6 +440,14 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
       sprintf(gl4es_VA[i], "%s%d", gl4es_VertexAttrib, i);
     }
   }
+  shaderconv_need_t need_in;
+  if(need) {
+    char* cached = shaderconv_GetCache(pEntry, isVertex, need, forwardPort);
+    if(cached)
+      return cached;
+    memcpy(&need_in, need, sizeof(need_in));
+  }
+  int cacheable = need?1:0;
   int fpeShader = (strstr(pEntry, fpeshader_signature)!=NULL)?1:0;
   int maskbefore = 4|(isVertex?1:2);
   int maskafter = 8|(isVertex?1:2);
@@ -629,6 +638,7 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
   }
     // now check to remove trailling "f" after float, as it's not supported too
   newptr = Tmp;
+  char* outptr = Tmp; // the removed 'f' are skipped in a single pass
   // simple state machine...
   int state = 0;
   while (*newptr!=0x00) {
@@ -651,9 +661,9 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
         else if ((*newptr==' ') || (*newptr==0x0d) || (*newptr==0x0a) || (*newptr=='-') || (*newptr=='+') || (*newptr=='*') || (*newptr=='/') || (*newptr=='(') || (*newptr==')' || (*newptr=='>') || (*newptr=='<')))
           state = 0; // separator
         else  if (*newptr == 'f' ) {
-          // remove that f
-          memmove(newptr, newptr+1, strlen(newptr+1)+1);
-          newptr--;
+          // remove that f (just don't copy it)
+          newptr++;
+          continue;
         } else
           state = 3;
           break;
@@ -663,9 +673,9 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
         else if ((*newptr==' ') || (*newptr==0x0d) || (*newptr==0x0a) || (*newptr=='-') || (*newptr=='+') || (*newptr=='*') || (*newptr=='/') || (*newptr=='(') || (*newptr==')' || (*newptr=='>') || (*newptr=='<')))
           state = 0; // separator
         else  if (*newptr == 'f' ) {
-          // remove that f
-          memmove(newptr, newptr+1, strlen(newptr+1)+1);
-          newptr--;
+          // remove that f (just don't copy it)
+          newptr++;
+          continue;
         } else
           state = 3;
           break;
@@ -676,8 +686,9 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
           state = 3;
           break;
     }
-    newptr++;
+    *(outptr++) = *(newptr++);
   }
+  *outptr = 0x00;
   Tmp = InplaceReplace(Tmp, &tmpsize, "gl_FragDepth", (hardext.fragdepth)?"gl_FragDepthEXT":"fakeFragDepth");
   // builtin attribs
   if(isVertex) {
@@ -822,7 +833,7 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
   {
     if(strstr(Tmp, "transpose(") || strstr(Tmp, "transpose ") || strstr(Tmp, "transpose\t")) {
       Tmp = InplaceInsert(GetLine(Tmp, headline), gl4es_transpose, Tmp, &tmpsize);
-      InplaceReplace(Tmp, &tmpsize, "transpose", "gl4es_transpose");
+      Tmp = InplaceReplace(Tmp, &tmpsize, "transpose", "gl4es_transpose");
       // don't increment headline count, as all variying and attributes should be created before
     }
     // check for builtin matrix uniform...
@@ -1231,6 +1242,8 @@ char* ConvertShader(const char* pEntry, int isVertex, shaderconv_need_t *need, i
   // clean preproc'd source
   if(pEntry!=pBuffer)
     free(pBuffer);
+  if(cacheable)
+    shaderconv_AddCache(pEntry, isVertex, &need_in, need, forwardPort, Tmp);
   return Tmp;
 }
 
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../glx/hardext.h"
+#include "init.h"
+#include "logs.h"
+#include "shaderconv_cache.h"
+
+//#define DEBUG
+#ifdef DEBUG
+#define DBG(a) a
+#else
+#define DBG(a)
+#endif
+
+static const char SHC_SIGN[] = "GL4ES ShaderConversionCache";
+#define SHC_VERSION 1
+#define SHC_CACHE_SIZE  (4*1024*1024)   // max size of the cached shaders (sources and converted), in bytes
+
+// Everything ConvertShader output depends on, beside the source itself
+typedef struct shc_key_s {
+    uint64_t            hash;       // hash of the source
+    uint64_t            conf;       // hash of the hardware capabilities and settings
+    int                 length;     // length of the source
+    int                 isVertex;
+    int                 forwardPort;
+    shaderconv_need_t   need;       // need on input
+} shc_key_t;
+
+typedef struct shc_s {
+    shc_key_t           key;
+    shaderconv_need_t   need;       // need on output
+    char*               source;
+    char*               converted;
+    int                 size;
+    struct shc_s        *prev, *next;   // LRU list, most recent first
+} shc_t;
+
+typedef shc_key_t *kh_shc_t;
+
+static uint64_t shc_hash(const void* data, int size, uint64_t h)
+{
+    // 64bits FNV-1a, 8 bytes at a time
+    const uint8_t* p = (const uint8_t*)data;
+    while(size>=8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h = (h^v)*0x100000001b3ULL;
+        h ^= h>>29;
+        p+=8; size-=8;
+    }
+    while(size--)
+        h = (h^*(p++))*0x100000001b3ULL;
+    return h;
+}
+
+#define kh_shc_hash_func(key) (khint32_t)((key)->hash^((key)->hash>>32))
+#define kh_shc_hash_equal(a, b) (memcmp(a, b, sizeof(shc_key_t)) == 0 && \
+    strcmp(((shc_t*)(a))->source, ((shc_t*)(b))->source) == 0)
+
+KHASH_INIT(shclist, kh_shc_t, shc_t*, 1, kh_shc_hash_func, kh_shc_hash_equal);
+
+typedef struct gl4es_shc_s {
+    int             dirty;
+    khash_t(shclist)* cache;
+    shc_t           *first, *last;
+    int             size;
+} gl4es_shc_t;
+
+static gl4es_shc_t *shc = NULL;
+static char *shc_name = NULL;
+
+static uint64_t shc_conf()
+{
+    // ConvertShader depends on those settings and on many hardext fields, so just take them all
+    int settings[4] = {globals4es.comments, globals4es.shadernogles, globals4es.notexarray, globals4es.nointovlhack};
+    return shc_hash(settings, sizeof(settings), shc_hash(&hardext, sizeof(hardext), 0xcbf29ce484222325ULL));
+}
+
+static void shc_init()
+{
+    if(shc)
+        return;
+    shc = (gl4es_shc_t*)calloc(1, sizeof(gl4es_shc_t));
+    shc->cache = kh_init(shclist);
+}
+
+static void shc_free(shc_t *p)
+{
+    free(p->source);
+    free(p->converted);
+    free(p);
+}
+
+static void shc_unlink(shc_t *p)
+{
+    if(p->prev) p->prev->next = p->next; else shc->first = p->next;
+    if(p->next) p->next->prev = p->prev; else shc->last = p->prev;
+    p->prev = p->next = NULL;
+}
+
+static void shc_pushfront(shc_t *p)
+{
+    p->prev = NULL;
+    p->next = shc->first;
+    if(shc->first) shc->first->prev = p; else shc->last = p;
+    shc->first = p;
+}
+
+static void shc_add(shc_t *p)
+{
+    int ret;
+    p->size = sizeof(shc_t) + p->key.length + strlen(p->converted);
+    // the key is the first member of shc_t, so the equal function can reach the source
+    khint_t k = kh_put(shclist, shc->cache, &p->key, &ret);
+    if(!ret) {
+        shc_t *old = kh_value(shc->cache, k);
+        kh_key(shc->cache, k) = &p->key;
+        shc_unlink(old);
+        shc->size -= old->size;
+        shc_free(old);
+    }
+    kh_value(shc->cache, k) = p;
+    shc->size += p->size;
+    shc_pushfront(p);
+    // evict the least recently used ones
+    while(shc->size>SHC_CACHE_SIZE && shc->last!=p) {
+        shc_t *old = shc->last;
+        shc_unlink(old);
+        kh_del(shclist, shc->cache, kh_get(shclist, shc->cache, &old->key));
+        shc->size -= old->size;
+        shc_free(old);
+    }
+}
+
+void shaderconv_InitCache(const char* name)
+{
+    shc_init();
+    if(name && !shc_name)
+        shc_name = strdup(name);    // without a name, the cache is only in memory
+}
+
+void shaderconv_FreeCache()
+{
+    if(!shc)
+        return;
+    shc_t *p = shc->first;
+    while(p) {
+        shc_t *next = p->next;
+        shc_free(p);
+        p = next;
+    }
+    kh_destroy(shclist, shc->cache);
+    free(shc);
+    shc = NULL;
+    free(shc_name);
+    shc_name = NULL;
+}
+
+void shaderconv_readCache()
+{
+    if(!shc || !shc_name)
+        return;
+    FILE *f = fopen(shc_name, "rb");
+    if(!f)
+        return;
+    char tmp[sizeof(SHC_SIGN)];
+    int version = 0, sz_key = 0, n = 0;
+    if(fread(tmp, sizeof(SHC_SIGN), 1, f)!=1 || strcmp(tmp, SHC_SIGN)!=0
+     || fread(&version, sizeof(version), 1, f)!=1 || version!=SHC_VERSION
+     || fread(&sz_key, sizeof(sz_key), 1, f)!=1 || sz_key!=sizeof(shc_key_t)
+     || fread(&n, sizeof(n), 1, f)!=1) {
+        fclose(f);
+        return; // not a cache file, or an unsupported version
+    }
+    int loaded = 0;
+    for (int i=0; i<n; ++i) {
+        shc_t *p = (shc_t*)calloc(1, sizeof(shc_t));
+        int len = 0;
+        if(fread(&p->key, sizeof(p->key), 1, f)!=1
+         || fread(&p->need, sizeof(p->need), 1, f)!=1
+         || fread(&len, sizeof(len), 1, f)!=1 || len<=0
+         || p->key.length<0) {
+            free(p);
+            break;
+        }
+        p->source = (char*)malloc(p->key.length+1);
+        p->converted = (char*)malloc(len+1);
+        if((p->key.length && fread(p->source, p->key.length, 1, f)!=1)
+         || fread(p->converted, len, 1, f)!=1) {
+            shc_free(p);
+            break;
+        }
+        p->source[p->key.length] = '\0';
+        p->converted[len] = '\0';
+        shc_add(p);
+        ++loaded;
+    }
+    fclose(f);
+    SHUT_LOGD("Loaded a Shader Cache with %d converted Shaders\n", loaded);
+}
+
+void shaderconv_writeCache()
+{
+    if(!shc || !shc_name)
+        return;
+    if(!shc->dirty)
+        return; // no need
+    FILE *f = fopen(shc_name, "wb");
+    if(!f)
+        return;
+    int version = SHC_VERSION;
+    int sz_key = sizeof(shc_key_t);
+    int n = kh_size(shc->cache);
+    if(fwrite(SHC_SIGN, sizeof(SHC_SIGN), 1, f)!=1
+     || fwrite(&version, sizeof(version), 1, f)!=1
+     || fwrite(&sz_key, sizeof(sz_key), 1, f)!=1
+     || fwrite(&n, sizeof(n), 1, f)!=1) {
+        fclose(f);
+        return;
+    }
+    // least recently used first, so the order is the same once read back
+    for (shc_t *p=shc->last; p; p=p->prev) {
+        int len = strlen(p->converted);
+        if(fwrite(&p->key, sizeof(p->key), 1, f)!=1
+         || fwrite(&p->need, sizeof(p->need), 1, f)!=1
+         || fwrite(&len, sizeof(len), 1, f)!=1
+         || (p->key.length && fwrite(p->source, p->key.length, 1, f)!=1)
+         || fwrite(p->converted, len, 1, f)!=1) {
+            fclose(f);
+            return;
+        }
+    }
+    fclose(f);
+    shc->dirty = 0;
+    SHUT_LOGD("Saved a Shader Cache with %d converted Shaders\n", n);
+}
+
+static void shc_makekey(shc_key_t *key, const char* source, int isVertex, const shaderconv_need_t *need, int forwardPort)
+{
+    memset(key, 0, sizeof(shc_key_t));    // no garbage in the padding, it's hashed and compared
+    key->length = strlen(source);
+    key->hash = shc_hash(source, key->length, 0xcbf29ce484222325ULL);
+    key->conf = shc_conf();
+    key->isVertex = isVertex;
+    key->forwardPort = forwardPort;
+    memcpy(&key->need, need, sizeof(shaderconv_need_t));
+}
+
+char* shaderconv_GetCache(const char* source, int isVertex, shaderconv_need_t *need, int forwardPort)
+{
+    if(!shc || globals4es.dbgshaderconv)
+        return NULL;
+    shc_t tmp;
+    shc_makekey(&tmp.key, source, isVertex, need, forwardPort);
+    tmp.source = (char*)source;
+    khint_t k = kh_get(shclist, shc->cache, &tmp.key);
+    if(k==kh_end(shc->cache))
+        return NULL;
+    shc_t *p = kh_value(shc->cache, k);
+    if(shc->first!=p) {
+        shc_unlink(p);
+        shc_pushfront(p);
+    }
+    DBG(printf("Shader conversion found in cache (%d bytes)\n", p->key.length);)
+    memcpy(need, &p->need, sizeof(shaderconv_need_t));
+    return strdup(p->converted);
+}
+
+void shaderconv_AddCache(const char* source, int isVertex, const shaderconv_need_t *need_in, const shaderconv_need_t *need_out, int forwardPort, const char* converted)
+{
+    if(!shc || globals4es.dbgshaderconv)
+        return;
+    shc_t *p = (shc_t*)calloc(1, sizeof(shc_t));
+    shc_makekey(&p->key, source, isVertex, need_in, forwardPort);
+    memcpy(&p->need, need_out, sizeof(shaderconv_need_t));
+    p->source = strdup(source);
+    p->converted = strdup(converted);
+    shc_add(p);
+    shc->dirty = 1;
+}
@@ -0,0 +1,15 @@
+#ifndef _GL4ES_SHADERCONV_CACHE_H_
+#define _GL4ES_SHADERCONV_CACHE_H_
+
+#include "shader.h"
+
+// Cache of ConvertShader results, in memory and saved next to the PSA
+void shaderconv_InitCache(const char* name);
+void shaderconv_FreeCache();
+void shaderconv_readCache();
+void shaderconv_writeCache();
+// return a malloc'd copy of the converted shader and update need, or NULL if not in the cache
+char* shaderconv_GetCache(const char* source, int isVertex, shaderconv_need_t *need, int forwardPort);
+void shaderconv_AddCache(const char* source, int isVertex, const shaderconv_need_t *need_in, const shaderconv_need_t *need_out, int forwardPort, const char* converted);
+
+#endif // _GL4ES_SHADERCONV_CACHE_H_
@@ -0,0 +1,201 @@
+#ifndef _GL4ES_SIMD_H_
+#define _GL4ES_SIMD_H_
+
+#include <stdint.h>
+#include <string.h>
+
+// Compile time selection of the SIMD intrinsics used by the fast paths.
+// NEON is mandatory on AArch64 (so also on Apple Silicon / iOS), and SSE2 is
+// part of the x86-64 baseline, so no cpuid probing is needed.
+// The armv7 inline asm in matvec.c / array.c is not affected by this header.
+// Fast paths can still be disabled at runtime with LIBGL_NOSIMD=1 (globals4es.nosimd),
+// in which case the scalar reference code is used.
+// The matvec.c routines are selected at compile time only: they use the same
+// operation order as the scalar code, so they give the same results.
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && !defined(__BIG_ENDIAN__)
+ #define GL4ES_SIMD_NEON64
+ #include <arm_neon.h>
+#elif defined(__SSE2__) || defined(__x86_64__)
+ #define GL4ES_SIMD_SSE2
+ #include <emmintrin.h>
+#endif
+
+#if defined(GL4ES_SIMD_NEON64) || defined(GL4ES_SIMD_SSE2)
+ #define GL4ES_SIMD
+#endif
+
+#ifdef GL4ES_SIMD
+// Small set of portable wrappers, so each fast path is written only once.
+// All loads are unaligned, and only touch the bytes they convert.
+#ifdef GL4ES_SIMD_NEON64
+typedef float32x4_t simd_f4;
+typedef uint32x4_t  simd_m4;
+
+static inline simd_f4 simd_load_f(const void* p) { return vld1q_f32((const float*)p); }
+static inline void simd_store_f(void* p, simd_f4 v) { vst1q_f32((float*)p, v); }
+static inline simd_f4 simd_set1_f(float f) { return vdupq_n_f32(f); }
+static inline simd_f4 simd_mul_f(simd_f4 a, simd_f4 b) { return vmulq_f32(a, b); }
+static inline simd_f4 simd_add_f(simd_f4 a, simd_f4 b) { return vaddq_f32(a, b); }
+static inline simd_f4 simd_div_f(simd_f4 a, simd_f4 b) { return vdivq_f32(a, b); }
+static inline simd_f4 simd_sub_f(simd_f4 a, simd_f4 b) { return vsubq_f32(a, b); }
+static inline simd_f4 simd_sqrt_f(simd_f4 a) { return vsqrtq_f32(a); }
+static inline simd_f4 simd_select(simd_m4 m, simd_f4 a, simd_f4 b) { return vbslq_f32(m, a, b); }
+static inline simd_m4 simd_load_m(const uint32_t* p) { return vld1q_u32(p); }
+// load a 4x4 matrix transposed (t[i] = m[i], m[i+4], m[i+8], m[i+12])
+static inline void simd_load_t(const float* m, simd_f4 t[4]) {
+    float32x4x4_t v = vld4q_f32(m);
+    t[0] = v.val[0]; t[1] = v.val[1]; t[2] = v.val[2]; t[3] = v.val[3];
+}
+// in place 4x4 transpose (rows <-> columns)
+static inline void simd_transpose(simd_f4 t[4]) {
+    float32x4x2_t p01 = vtrnq_f32(t[0], t[1]);
+    float32x4x2_t p23 = vtrnq_f32(t[2], t[3]);
+    t[0] = vcombine_f32(vget_low_f32(p01.val[0]), vget_low_f32(p23.val[0]));
+    t[1] = vcombine_f32(vget_low_f32(p01.val[1]), vget_low_f32(p23.val[1]));
+    t[2] = vcombine_f32(vget_high_f32(p01.val[0]), vget_high_f32(p23.val[0]));
+    t[3] = vcombine_f32(vget_high_f32(p01.val[1]), vget_high_f32(p23.val[1]));
+}
+
+static inline simd_f4 simd_cvt_ub4(uint32_t w) {
+    uint16x8_t h = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(w)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(h)));
+}
+static inline simd_f4 simd_cvt_b4(uint32_t w) {
+    int16x8_t h = vmovl_s8(vreinterpret_s8_u32(vdup_n_u32(w)));
+    return vcvtq_f32_s32(vmovl_s16(vget_low_s16(h)));
+}
+static inline simd_f4 simd_cvt_us4(uint64_t q) {
+    return vcvtq_f32_u32(vmovl_u16(vcreate_u16(q)));
+}
+static inline simd_f4 simd_cvt_s4(uint64_t q) {
+    return vcvtq_f32_s32(vmovl_s16(vcreate_s16(q)));
+}
+// 4 x (GLubyte)(v*scale), with the product done in double like the scalar "f * 255.0"
+// (out of range values wrap, as the scalar conversion through a 32 bits int)
+static inline uint32_t simd_cvt_ub4_dbl(simd_f4 v, double scale) {
+    const float64x2_t mn = vdupq_n_f64(-2147483648.0), mx = vdupq_n_f64(2147483647.0);
+    int64x2_t lo = vcvtq_s64_f64(vminq_f64(vmaxq_f64(vmulq_n_f64(vcvt_f64_f32(vget_low_f32(v)), scale), mn), mx));
+    int64x2_t hi = vcvtq_s64_f64(vminq_f64(vmaxq_f64(vmulq_n_f64(vcvt_high_f64_f32(v), scale), mn), mx));
+    uint16x4_t h = vmovn_u32(vreinterpretq_u32_s32(vcombine_s32(vmovn_s64(lo), vmovn_s64(hi))));
+    return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(h, h))), 0);
+}
+
+// integer lanes
+typedef uint32x4_t simd_u4;
+static inline simd_u4 simd_load_u(const void* p) { return vreinterpretq_u32_u8(vld1q_u8((const uint8_t*)p)); }
+static inline void simd_store_u(void* p, simd_u4 v) { vst1q_u8((uint8_t*)p, vreinterpretq_u8_u32(v)); }
+// 4 x 16 bits <-> 4 lanes (only the low 16 bits of the lanes are stored)
+static inline simd_u4 simd_load_us4(const void* p) { return vmovl_u16(vreinterpret_u16_u8(vld1_u8((const uint8_t*)p))); }
+static inline void simd_store_us4(void* p, simd_u4 v) { vst1_u8((uint8_t*)p, vreinterpret_u8_u16(vmovn_u32(v))); }
+static inline simd_u4 simd_set1_u(uint32_t u) { return vdupq_n_u32(u); }
+static inline simd_u4 simd_and_u(simd_u4 a, simd_u4 b) { return vandq_u32(a, b); }
+static inline simd_u4 simd_or_u(simd_u4 a, simd_u4 b) { return vorrq_u32(a, b); }
+static inline simd_u4 simd_add_u(simd_u4 a, simd_u4 b) { return vaddq_u32(a, b); }
+// a*b, for lanes < 2^15
+static inline simd_u4 simd_mul15_u(simd_u4 a, simd_u4 b) { return vmulq_u32(a, b); }
+// comparisons, for lanes < 2^31
+static inline simd_u4 simd_cmpeq_u(simd_u4 a, simd_u4 b) { return vceqq_u32(a, b); }
+static inline simd_u4 simd_cmpgt_u(simd_u4 a, simd_u4 b) { return vcgtq_u32(a, b); }
+static inline simd_u4 simd_select_u(simd_u4 m, simd_u4 a, simd_u4 b) { return vbslq_u32(m, a, b); }
+static inline simd_f4 simd_cvt_u(simd_u4 v) { return vcvtq_f32_u32(v); }
+static inline simd_f4 simd_as_f(simd_u4 v) { return vreinterpretq_f32_u32(v); }
+static inline simd_u4 simd_as_u(simd_f4 v) { return vreinterpretq_u32_f32(v); }
+#define simd_shl_u(v, n) vshlq_n_u32(v, n)
+#define simd_shr_u(v, n) vshrq_n_u32(v, n)
+#else // GL4ES_SIMD_SSE2
+typedef __m128 simd_f4;
+typedef __m128 simd_m4;
+
+static inline simd_f4 simd_load_f(const void* p) { return _mm_loadu_ps((const float*)p); }
+static inline void simd_store_f(void* p, simd_f4 v) { _mm_storeu_ps((float*)p, v); }
+static inline simd_f4 simd_set1_f(float f) { return _mm_set1_ps(f); }
+static inline simd_f4 simd_mul_f(simd_f4 a, simd_f4 b) { return _mm_mul_ps(a, b); }
+static inline simd_f4 simd_add_f(simd_f4 a, simd_f4 b) { return _mm_add_ps(a, b); }
+static inline simd_f4 simd_div_f(simd_f4 a, simd_f4 b) { return _mm_div_ps(a, b); }
+static inline simd_f4 simd_sub_f(simd_f4 a, simd_f4 b) { return _mm_sub_ps(a, b); }
+static inline simd_f4 simd_sqrt_f(simd_f4 a) { return _mm_sqrt_ps(a); }
+static inline simd_f4 simd_select(simd_m4 m, simd_f4 a, simd_f4 b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+static inline simd_m4 simd_load_m(const uint32_t* p) { return _mm_loadu_ps((const float*)p); }
+// load a 4x4 matrix transposed (t[i] = m[i], m[i+4], m[i+8], m[i+12])
+static inline void simd_load_t(const float* m, simd_f4 t[4]) {
+    __m128 r0 = _mm_loadu_ps(m), r1 = _mm_loadu_ps(m+4), r2 = _mm_loadu_ps(m+8), r3 = _mm_loadu_ps(m+12);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    t[0] = r0; t[1] = r1; t[2] = r2; t[3] = r3;
+}
+// in place 4x4 transpose (rows <-> columns)
+static inline void simd_transpose(simd_f4 t[4]) {
+    _MM_TRANSPOSE4_PS(t[0], t[1], t[2], t[3]);
+}
+
+static inline simd_f4 simd_cvt_ub4(uint32_t w) {
+    __m128i z = _mm_setzero_si128();
+    __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)w), z);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, z));
+}
+static inline simd_f4 simd_cvt_b4(uint32_t w) {
+    __m128i v = _mm_cvtsi32_si128((int)w);
+    v = _mm_unpacklo_epi8(v, v);
+    v = _mm_unpacklo_epi16(v, v);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(v, 24));
+}
+static inline simd_f4 simd_cvt_us4(uint64_t q) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)&q);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+}
+static inline simd_f4 simd_cvt_s4(uint64_t q) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)&q);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+}
+// 4 x (GLubyte)(v*scale), with the product done in double like the scalar "f * 255.0"
+// (out of range values wrap, as the scalar conversion through a 32 bits int)
+static inline uint32_t simd_cvt_ub4_dbl(simd_f4 v, double scale) {
+    __m128d s = _mm_set1_pd(scale);
+    __m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(v), s));
+    __m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), s));
+    __m128i i = _mm_and_si128(_mm_unpacklo_epi64(lo, hi), _mm_set1_epi32(0xff));
+    i = _mm_packs_epi32(i, i);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+}
+
+// integer lanes
+typedef __m128i simd_u4;
+static inline simd_u4 simd_load_u(const void* p) { return _mm_loadu_si128((const __m128i*)p); }
+static inline void simd_store_u(void* p, simd_u4 v) { _mm_storeu_si128((__m128i*)p, v); }
+// 4 x 16 bits <-> 4 lanes (only the low 16 bits of the lanes are stored)
+static inline simd_u4 simd_load_us4(const void* p) { return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128()); }
+static inline void simd_store_us4(void* p, simd_u4 v) {
+    v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);  // sign extend, so the saturation of packs is a no-op
+    _mm_storel_epi64((__m128i*)p, _mm_packs_epi32(v, v));
+}
+static inline simd_u4 simd_set1_u(uint32_t u) { return _mm_set1_epi32((int)u); }
+static inline simd_u4 simd_and_u(simd_u4 a, simd_u4 b) { return _mm_and_si128(a, b); }
+static inline simd_u4 simd_or_u(simd_u4 a, simd_u4 b) { return _mm_or_si128(a, b); }
+static inline simd_u4 simd_add_u(simd_u4 a, simd_u4 b) { return _mm_add_epi32(a, b); }
+// a*b, for lanes < 2^15 (no 32 bits mullo in SSE2, but the high halves are 0 here)
+static inline simd_u4 simd_mul15_u(simd_u4 a, simd_u4 b) { return _mm_madd_epi16(a, b); }
+// comparisons, for lanes < 2^31
+static inline simd_u4 simd_cmpeq_u(simd_u4 a, simd_u4 b) { return _mm_cmpeq_epi32(a, b); }
+static inline simd_u4 simd_cmpgt_u(simd_u4 a, simd_u4 b) { return _mm_cmpgt_epi32(a, b); }
+static inline simd_u4 simd_select_u(simd_u4 m, simd_u4 a, simd_u4 b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+static inline simd_f4 simd_cvt_u(simd_u4 v) { return _mm_cvtepi32_ps(v); }
+static inline simd_f4 simd_as_f(simd_u4 v) { return _mm_castsi128_ps(v); }
+static inline simd_u4 simd_as_u(simd_f4 v) { return _mm_castps_si128(v); }
+#define simd_shl_u(v, n) _mm_slli_epi32(v, n)
+#define simd_shr_u(v, n) _mm_srli_epi32(v, n)
+#endif
+
+// mask with the first n lanes (0..4) set
+static inline simd_m4 simd_lanemask(int n) {
+    static const uint32_t masks[5][4] = {
+        {0, 0, 0, 0},
+        {0xffffffffu, 0, 0, 0},
+        {0xffffffffu, 0xffffffffu, 0, 0},
+        {0xffffffffu, 0xffffffffu, 0xffffffffu, 0},
+        {0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu}
+    };
+    return simd_load_m(masks[n]);
+}
+#endif // GL4ES_SIMD
+
+#endif // _GL4ES_SIMD_H_
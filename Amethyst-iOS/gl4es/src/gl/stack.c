@@ -14,6 +14,23 @@
 #define DBG(a)
 #endif
 
+void attrib_changed(GLbitfield groups) {
+    const GLuint serial = ++glstate->attrib_serial;
+    while (groups) {
+        glstate->attrib_changed[__builtin_ctz(groups)] = serial;
+        groups &= groups-1;
+    }
+}
+
+// groups modified after serial. Current color / normal / texcoord are changed by every glColor/glNormal... so are not tracked
+static GLbitfield attrib_modified(GLuint serial) {
+    GLbitfield ret = GL_CURRENT_BIT;
+    for (int i=0; i<32; i++)
+        if ((int)(glstate->attrib_changed[i]-serial) > 0)
+            ret |= 1u<<i;
+    return ret;
+}
+
 void gl4es_glPushAttrib(GLbitfield mask) {
     DBG(printf("glPushAttrib(0x%04X)\n", mask);)
     realize_textures(0);
@@ -36,6 +53,8 @@ void gl4es_glPushAttrib(GLbitfield mask) {
 
     glstack_t *cur = glstate->stack + glstate->stack->len;
     cur->mask = mask;
+    cur->serial = glstate->attrib_serial;
+    memcpy(cur->changed, glstate->attrib_changed, sizeof(cur->changed));
     cur->clip_planes_enabled = NULL;
     cur->clip_planes = NULL;
     cur->lights_enabled = NULL;
@@ -350,8 +369,10 @@ DBG(printf("glPopAttrib()\n");)
     }
 
     glstack_t *cur = glstate->stack + glstate->stack->len-1;
+    // only restore the groups that have been modified since the push
+    const GLbitfield mask = cur->mask & attrib_modified(cur->serial);
 
-    if (cur->mask & GL_COLOR_BUFFER_BIT) {
+    if (mask & GL_COLOR_BUFFER_BIT) {
         enable_disable(GL_ALPHA_TEST, cur->alpha_test);
         gl4es_glAlphaFunc(cur->alpha_test_func, cur->alpha_test_ref);
 
@@ -367,20 +388,20 @@ DBG(printf("glPopAttrib()\n");)
         gl4es_glColorMask(v4(cur->color_mask));
     }
 
-    if (cur->mask & GL_CURRENT_BIT) {
+    if (mask & GL_CURRENT_BIT) {
         gl4es_glColor4f(v4(cur->color));
         gl4es_glNormal3f(v3(cur->normal));
         gl4es_glTexCoord4f(v4(cur->tex));
     }
 
-    if (cur->mask & GL_DEPTH_BUFFER_BIT) {
+    if (mask & GL_DEPTH_BUFFER_BIT) {
         enable_disable(GL_DEPTH_TEST, cur->depth_test);
         gl4es_glDepthFunc(cur->depth_func);
         gl4es_glClearDepth(cur->clear_depth);
         gl4es_glDepthMask(cur->depth_mask);
     }
 
-    if (cur->mask & GL_ENABLE_BIT) {
+    if (mask & GL_ENABLE_BIT) {
         int i;
 
         enable_disable(GL_ALPHA_TEST, cur->alpha_test);
@@ -443,7 +464,7 @@ DBG(printf("glPopAttrib()\n");)
         if (glstate->texture.active != old_tex) gl4es_glActiveTexture(GL_TEXTURE0+old_tex);
     }
 
-    if (cur->mask & GL_FOG_BIT) {
+    if (mask & GL_FOG_BIT) {
         enable_disable(GL_FOG, cur->fog);
         gl4es_glFogfv(GL_FOG_COLOR, cur->fog_color);
         gl4es_glFogf(GL_FOG_DENSITY, cur->fog_density);
@@ -452,7 +473,7 @@ DBG(printf("glPopAttrib()\n");)
         gl4es_glFogf(GL_FOG_MODE, cur->fog_mode);
     }
 
-    if (cur->mask & GL_HINT_BIT) {
+    if (mask & GL_HINT_BIT) {
         gl4es_glHint(GL_PERSPECTIVE_CORRECTION_HINT, cur->perspective_hint);
         gl4es_glHint(GL_POINT_SMOOTH_HINT, cur->point_smooth_hint);
         gl4es_glHint(GL_LINE_SMOOTH_HINT, cur->line_smooth_hint);
@@ -462,7 +483,7 @@ DBG(printf("glPopAttrib()\n");)
             gl4es_glHint(i, cur->gles4_hint[i-GL4ES_HINT_FIRST]);
     }
 
-    if (cur->mask & GL_LIGHTING_BIT) {
+    if (mask & GL_LIGHTING_BIT) {
         enable_disable(GL_LIGHTING, cur->lighting);
         gl4es_glLightModelfv(GL_LIGHT_MODEL_AMBIENT, cur->light_model_ambient);
         gl4es_glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, cur->light_model_two_side);
@@ -508,24 +529,24 @@ DBG(printf("glPopAttrib()\n");)
     }
 
 	// GL_LIST_BIT
-    if (cur->mask & GL_LIST_BIT) {
+    if (mask & GL_LIST_BIT) {
         gl4es_glListBase(cur->list_base);
     }
 
-    if (cur->mask & GL_LINE_BIT) {
+    if (mask & GL_LINE_BIT) {
         enable_disable(GL_LINE_SMOOTH, cur->line_smooth);
         // TODO: stipple stuff here
         gl4es_glLineWidth(cur->line_width);
     }
 
-    if (cur->mask & GL_MULTISAMPLE_BIT) {
+    if (mask & GL_MULTISAMPLE_BIT) {
         enable_disable(GL_MULTISAMPLE, cur->multisample);
         enable_disable(GL_SAMPLE_ALPHA_TO_COVERAGE, cur->sample_alpha_to_coverage);
         enable_disable(GL_SAMPLE_ALPHA_TO_ONE, cur->sample_alpha_to_one);
         enable_disable(GL_SAMPLE_COVERAGE, cur->sample_coverage);
     }
 
-    if (cur->mask & GL_POINT_BIT) {
+    if (mask & GL_POINT_BIT) {
         enable_disable(GL_POINT_SMOOTH, cur->point_smooth);
         gl4es_glPointSize(cur->point_size);
         if(hardext.pointsprite) {
@@ -543,12 +564,12 @@ DBG(printf("glPopAttrib()\n");)
         }
     }
 
-    if (cur->mask & GL_SCISSOR_BIT) {
+    if (mask & GL_SCISSOR_BIT) {
         enable_disable(GL_SCISSOR_TEST, cur->scissor_test);
         gl4es_glScissor(v4(cur->scissor_box));
     }
 
-    if (cur->mask & GL_STENCIL_BUFFER_BIT) {
+    if (mask & GL_STENCIL_BUFFER_BIT) {
         enable_disable(GL_STENCIL_TEST, cur->stencil_test);
         gl4es_glStencilFunc(cur->stencil_func, cur->stencil_ref, cur->stencil_mask);
         //TODO: Stencil value mask
@@ -557,7 +578,7 @@ DBG(printf("glPopAttrib()\n");)
         //TODO: Stencil buffer writemask
     }
 
-    if (cur->mask & GL_TEXTURE_BIT) {
+    if (mask & GL_TEXTURE_BIT) {
         int old_tex = glstate->texture.active;
         int a;
         //TODO: Enable bit for the 4 texture coordinates
@@ -577,7 +598,7 @@ DBG(printf("glPopAttrib()\n");)
         if (glstate->texture.active!= old_tex) gl4es_glActiveTexture(GL_TEXTURE0+old_tex);
     }
     
-	if (cur->mask & GL_PIXEL_MODE_BIT) {
+	if (mask & GL_PIXEL_MODE_BIT) {
 		GLenum pixel_name[] = {GL_RED_BIAS, GL_RED_SCALE, GL_GREEN_BIAS, GL_GREEN_SCALE, GL_BLUE_BIAS, GL_BLUE_SCALE, GL_ALPHA_BIAS, GL_ALPHA_SCALE};
 		int i;
 		for (i=0; i<8; i++) 
@@ -588,7 +609,7 @@ DBG(printf("glPopAttrib()\n");)
 		gl4es_glPixelZoom(cur->pixel_zoomx, cur->pixel_zoomy);
 	}
 
-	if (cur->mask & GL_TRANSFORM_BIT) {
+	if (mask & GL_TRANSFORM_BIT) {
 		if (!(cur->mask & GL_ENABLE_BIT)) {
 			int i;
 			for (i = 0; i < hardext.maxplanes; i++) {
@@ -600,11 +621,16 @@ DBG(printf("glPopAttrib()\n");)
 		enable_disable(GL_RESCALE_NORMAL, cur->rescale_normal_flag);		
 	}
 
-    if (cur->mask & GL_VIEWPORT_BIT) {
+    if (mask & GL_VIEWPORT_BIT) {
 		gl4es_glViewport(cur->viewport_size[0], cur->viewport_size[1], cur->viewport_size[2], cur->viewport_size[3]);
 		gl4es_glDepthRangef(cur->depth_range[0], cur->depth_range[1]);
 	}
 	
+    // pushed groups are now back to their state at push time, so don't count the restore as a modification
+    for (int i=0; i<32; i++)
+        if (cur->mask & (1u<<i))
+            glstate->attrib_changed[i] = cur->changed[i];
+
     maybe_free(cur->clip_planes_enabled);
     maybe_free(cur->clip_planes);
     maybe_free(cur->lights_enabled);
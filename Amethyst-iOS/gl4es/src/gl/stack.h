@@ -14,6 +14,8 @@
 
 typedef struct _glstack_t {
     GLbitfield mask;
+    GLuint serial;          // glstate->attrib_serial at push time
+    GLuint changed[32];     // glstate->attrib_changed at push time
 
     // GL_COLOR_BUFFER_BIT
     GLboolean alpha_test;
@@ -175,4 +177,8 @@ void gl4es_glPopClientAttrib();
 void gl4es_glPushAttrib(GLbitfield mask);
 void gl4es_glPopAttrib();
 
+// Note that the GL_xxx_BIT attribute group(s) have been modified, so glPopAttrib will restore them
+// (groups not modified between the push and the pop are skipped)
+void attrib_changed(GLbitfield groups);
+
 #endif // _GL4ES_STACK_H_
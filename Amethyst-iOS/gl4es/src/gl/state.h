@@ -82,6 +82,18 @@ typedef struct {
     GLfloat Q_O[4];
 } texgen_state_t;
 
+// what the coordinates generated by gen_tex_coords were computed from
+typedef struct {
+    GLuint          serial;     // renderlist serial, 0 means empty
+    GLint           count;
+    GLuint          ilen;
+    GLuint          enabled;    // texture target and texgen enables
+    texgen_state_t  texgen;
+    GLfloat         modelview[16];
+    GLfloat         normal[3];
+    GLfloat         texcoord[4];
+} texgen_cache_t;
+
 typedef struct {
     texenv_t        env;
     texfilter_t     filter;
@@ -133,6 +145,7 @@ typedef struct {
     GLint index_shift;
     GLint index_offset;
     int     map_color;
+    GLuint  map_gen;    // changed with the pixel maps and the index transfer
     int     map_i2i_size;
     int     map_i2r_size;
     int     map_i2g_size;
@@ -165,7 +178,7 @@ typedef struct {
     GLsizei raster_nheight;
     GLint	raster_x1, raster_x2, raster_y1, raster_y2;
     // bitmap specific datas
-    int     bm_drawing; // flag if some bitmap are there
+    int     bm_drawing; // flag if some bitmap are there (1: in the bitmap buffer, 2: in the glyph atlas)
     int     bm_x1, bm_y1;
     int     bm_x2, bm_y2;
     GLubyte *bitmap;
@@ -173,6 +186,8 @@ typedef struct {
     GLsizei bm_width, bm_height;
     GLuint  bm_texture;
     int     bm_tnwidth, bm_tnheight;
+    struct bm_atlas_s *bm_atlas;
+    struct dp_cache_s *dp_cache;    // glDrawPixels textures
 
 } raster_state_t;
 
@@ -205,6 +220,7 @@ typedef struct {
     GLuint  overflow;
     GLuint  pos;
     GLboolean  hit;
+    struct select_cache_s *cache;   // transformed vertices
 } selectbuf_t;
 
 typedef struct {
@@ -221,6 +237,7 @@ typedef struct glsl_s {
     GLuint                 program;
     program_t              *glprogram;
     int                    es2; // context is es2
+    unsigned int           generation;  // bumped when a program is linked or deleted, for fpe_last in every context
     // old ARB_vertex_program & ARB_fragment_program states
     khash_t(oldprograms)   *oldprograms;
     int                    error_ptr;   // error position from last "Old" program compile
@@ -238,13 +255,16 @@ typedef struct {
 } gleshard_t;
 
 typedef struct {
-    GLuint          vertexshader;
     GLuint          pixelshader;
-    GLuint          vertexshader_alpha;
-    GLuint          pixelshader_alpha;
     GLuint          program;
-    GLuint          program_alpha;
-    GLfloat         vert[8], tex[8];
+    GLint           pos, tex;       // uniforms locations
+    GLfloat         posrect[4], texrect[4]; // last values sent to the uniforms
+} blitprogram_t;
+
+typedef struct glesblit_s {
+    GLuint          vertexshader;
+    blitprogram_t   prog[2];        // plain and alpha (discard transparent texels), created on first use
+    GLuint          quad;           // VBO with the unit quad
 } glesblit_t;
 
 typedef struct {
@@ -291,6 +311,8 @@ typedef struct {
     GLenum read_type;
     int    n_draw;
     GLenum drawbuff[MAX_DRAW_BUFFERS];    //TODO: define a MAX_DRAWBUFF?
+    GLenum status;          // cached glCheckFramebufferStatus result...
+    unsigned int status_gen;// ...valid while it's the fbotable_t gen
 } glframebuffer_t;
 
 typedef struct {
@@ -301,6 +323,25 @@ typedef struct {
 
 KHASH_MAP_DECLARE_INT(framebufferlist_t, glframebuffer_t *);
 
+// direct access to the framebuffers and renderbuffers by name, in front of the hashmaps (for names < MAX_FBOTABLE)
+#define MAX_FBOTABLE 4096
+#define FBO_UNKNOWN  0xffffffffu
+typedef struct {
+    glframebuffer_t  **fb;
+    int                fb_cap;
+    glrenderbuffer_t **rb;
+    int                rb_cap;
+    unsigned int       gen;     // changed each time an attachment, or the storage of one, changes
+} fbotable_t;
+
+#define MAX_MAINFBO 3
+typedef struct {
+    GLuint fbo;
+    GLuint tex;
+    int    nwidth;  // size of the texture, may lag behind the main FBO size until it's used again
+    int    nheight;
+} mainfbo_t;
+
 typedef struct {
     khash_t(renderbufferlist_t) *renderbufferlist;
     glrenderbuffer_t *default_rb;
@@ -314,12 +355,16 @@ typedef struct {
     int mainfbo_height;
     int mainfbo_nwidth;
     int mainfbo_nheight;
+    mainfbo_t mainfbo[MAX_MAINFBO]; // ring of color buffers (LIBGL_FBORING), mainfbo_fbo/tex are the current one
+    int mainfbo_cur;
     
     khash_t(framebufferlist_t) *framebufferlist;
     glframebuffer_t *fbo_0;
     glframebuffer_t *fbo_read;
     glframebuffer_t *fbo_draw;
     glframebuffer_t *current_fb;
+    fbotable_t      *table;
+    GLuint           real_fb;   // framebuffer really bound on GLES, FBO_UNKNOWN if not known
 
     GLenum fb_status;
     int    internal;
@@ -15,6 +15,7 @@ void gl4es_glStencilMask(GLuint mask) {
         return;
     }
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.mask[0] = glstate->stencil.mask[1] = mask;
     errorGL();
     gles_glStencilMask(mask);
@@ -38,6 +39,7 @@ void gl4es_glStencilMaskSeparate(GLenum face, GLuint mask) {
     }
     LOAD_GLES2_OR_OES(glStencilMaskSeparate);
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.mask[(face==GL_FRONT)?0:1] = mask;
 
     errorGL();
@@ -65,6 +67,7 @@ void gl4es_glStencilFunc(GLenum func, GLint ref, GLuint mask) {
     LOAD_GLES(glStencilFunc);
     errorGL();
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.func[0] = glstate->stencil.func[1] = func;
     glstate->stencil.f_ref[0] = glstate->stencil.f_ref[1] = ref;
     glstate->stencil.f_mask[0] = glstate->stencil.f_mask[1] = mask;
@@ -92,6 +95,7 @@ void gl4es_glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mas
     LOAD_GLES2_OR_OES(glStencilFuncSeparate);
     errorGL();
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.func[idx]=func;
     glstate->stencil.f_ref[idx]=ref;
     glstate->stencil.f_mask[idx]=mask;
@@ -118,6 +122,7 @@ void gl4es_glStencilOp(GLenum fail, GLenum zfail, GLenum zpass) {
       }
     LOAD_GLES(glStencilOp);
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.sfail[0] = glstate->stencil.sfail[1] = fail;
     glstate->stencil.dpfail[0] = glstate->stencil.dpfail[1] = zfail;
     glstate->stencil.dppass[0] = glstate->stencil.dppass[1] = zpass;
@@ -145,6 +150,7 @@ void gl4es_glStencilOpSeparate(GLenum face, GLenum sfail, GLenum zfail, GLenum z
     }
     LOAD_GLES2_OR_OES(glStencilOpSeparate);
     errorGL();
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.sfail[idx] = sfail;
     glstate->stencil.dpfail[idx] = zfail;
     glstate->stencil.dppass[idx] = zpass;
@@ -169,6 +175,7 @@ void gl4es_glClearStencil(GLint s) {
       }
     LOAD_GLES(glClearStencil);
     FLUSH_BEGINEND;
+    attrib_changed(GL_STENCIL_BUFFER_BIT);
     glstate->stencil.clear = s;
     errorGL();
     gles_glClearStencil(s);
@@ -8,25 +8,84 @@ const char* AllSeparators = " \t\n\r.,;()[]{}-<>+*/%&\\\"'^$=!:?";
 
 char* ResizeIfNeeded(char* pBuffer, int *size, int addsize);
 
+// Replace the n occurences of S found at offs[] (increasing) by D, with one move of the string
+static char* ReplaceAt(char* pBuffer, int* size, const int* offs, int n, int lS, const char* D, int lD)
+{
+    if(!n)
+        return pBuffer;
+    int len = strlen(pBuffer);
+    if(lD<=lS) {
+        // shrinking (or same size): forward
+        char* w = pBuffer+offs[0];
+        for (int i=0; i<n; ++i) {
+            int end = (i+1<n)?offs[i+1]:len+1;  // the '\0' is moved too
+            memcpy(w, D, lD);
+            w += lD;
+            memmove(w, pBuffer+offs[i]+lS, end-offs[i]-lS);
+            w += end-offs[i]-lS;
+        }
+    } else {
+        // growing: backward, after the resize
+        pBuffer = ResizeIfNeeded(pBuffer, size, (lD-lS)*n);
+        char* w = pBuffer+len+1+(lD-lS)*n;
+        for (int i=n-1; i>=0; --i) {
+            int end = (i+1<n)?offs[i+1]:len+1;
+            int l = end-offs[i]-lS;
+            w -= l;
+            memmove(w, pBuffer+offs[i]+lS, l);
+            w -= lD;
+            memcpy(w, D, lD);
+        }
+    }
+    return pBuffer;
+}
+
+#define MAX_STACK_OFFS 256
 char* InplaceReplace(char* pBuffer, int* size, const char* S, const char* D)
 {
     int lS = strlen(S), lD = strlen(D);
-    pBuffer = ResizeIfNeeded(pBuffer, size, (lD-lS)*CountString(pBuffer, S));
-    char* p = pBuffer;
+    // first collect the occurences, then move the string only once.
+    // An occurence is checked against what is before it once replaced (like a replace done in place)
+    int stack_offs[MAX_STACK_OFFS];
+    int *offs = stack_offs, cap = MAX_STACK_OFFS, n = 0;
+    int outlen = 0; // length of the new string before p
+    int prev = -1;  // end of the last replaced occurence
+    char prevc = 0; // last char of the new string before p (valid if outlen)
+    const char* p = pBuffer;
+    const char* last = pBuffer;
     while((p = strstr(p, S)))
     {
         // found an occurence of S
         // check if good to replace, strchr also found '\0' :)
-        if(strchr(AllSeparators, p[lS])!=NULL && (p==pBuffer || strchr(AllSeparators, p[-1])!=NULL)) {
-            // move out rest of string
-            memmove(p+lD, p+lS, strlen(p)-lS+1);
-            // replace
-            memcpy(p, D, strlen(D));
-            // next
-            p+=lD;
-        } else p+=lS;
+        outlen += p-last;
+        if(p>pBuffer && (p!=last || (p-pBuffer)!=prev))
+            prevc = p[-1];
+        last = p;
+        if(strchr(AllSeparators, p[lS])!=NULL && (outlen==0 || strchr(AllSeparators, prevc)!=NULL)) {
+            if(n==cap) {
+                cap*=2;
+                if(offs==stack_offs) {
+                    offs = (int*)malloc(cap*sizeof(int));
+                    memcpy(offs, stack_offs, sizeof(stack_offs));
+                } else
+                    offs = (int*)realloc(offs, cap*sizeof(int));
+            }
+            offs[n++] = p-pBuffer;
+            outlen += lD;
+            if(lD)
+                prevc = D[lD-1];
+            prev = p-pBuffer+lS;
+        } else {
+            outlen += lS;
+            prevc = p[lS-1];
+            prev = -1;
+        }
+        p += lS;
+        last = p;
     }
-    
+    pBuffer = ReplaceAt(pBuffer, size, offs, n, lS, D, lD);
+    if(offs!=stack_offs)
+        free(offs);
     return pBuffer;
 }
 
@@ -270,18 +329,25 @@ int CountStringSimple(char* pBuffer, const char* S)
 char* InplaceReplaceSimple(char* pBuffer, int* size, const char* S, const char* D)
 {
     int lS = strlen(S), lD = strlen(D);
-    pBuffer = ResizeIfNeeded(pBuffer, size, (lD-lS)*CountStringSimple(pBuffer, S));
+    int stack_offs[MAX_STACK_OFFS];
+    int *offs = stack_offs, cap = MAX_STACK_OFFS, n = 0;
     char* p = pBuffer;
     while((p = strstr(p, S)))
     {
         // found an occurence of S
-        // move out rest of string
-        memmove(p+lD, p+lS, strlen(p)-lS+1);
-        // replace
-        memcpy(p, D, strlen(D));
-        // next
-        p+=lD;
+        if(n==cap) {
+            cap*=2;
+            if(offs==stack_offs) {
+                offs = (int*)malloc(cap*sizeof(int));
+                memcpy(offs, stack_offs, sizeof(stack_offs));
+            } else
+                offs = (int*)realloc(offs, cap*sizeof(int));
+        }
+        offs[n++] = p-pBuffer;
+        p+=lS;
     }
-    
+    pBuffer = ReplaceAt(pBuffer, size, offs, n, lS, D, lD);
+    if(offs!=stack_offs)
+        free(offs);
     return pBuffer;
 }
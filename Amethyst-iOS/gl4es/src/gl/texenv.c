@@ -31,6 +31,7 @@ void gl4es_glTexEnvf(GLenum target, GLenum pname, GLfloat param) {
                 if (glstate->texture.pscoordreplace[tmu] == p)
                     return;
                 FLUSH_BEGINEND;
+                attrib_changed(GL_POINT_BIT);
                 glstate->texture.pscoordreplace[tmu] = p;
                 if (glstate->fpe_state)
                     glstate->fpe_state->pointsprite_coord = p;
@@ -7,6 +7,7 @@
 #include "loader.h"
 #include "matrix.h"
 #include "matvec.h"
+#include "simd.h"
 
 //extern void* eglGetProcAddress(const char*);
 
@@ -39,6 +40,7 @@ void gl4es_glTexGenfv(GLenum coord, GLenum pname, const GLfloat *param) {
 
     // pname is in: GL_TEXTURE_GEN_MODE, GL_OBJECT_PLANE, GL_EYE_PLANE
     noerrorShim();
+    attrib_changed(GL_TEXTURE_BIT);
     switch(pname) {
         case GL_TEXTURE_GEN_MODE: {
             int mode = -1;
@@ -172,8 +174,94 @@ void gl4es_glGetTexGenfv(GLenum coord,GLenum pname,GLfloat *params) {
 }
 
 
+#ifdef GL4ES_SIMD
+// The SIMD versions work on 4 vertices at a time, as x,y,z,w vectors, and
+// follow the operation order of the scalar loops, so results are the same.
+static inline void simd_fetch4(const GLfloat *verts, GLint i, GLushort *indices, simd_f4 v[4]) {
+    for (int j=0; j<4; j++)
+        v[j] = simd_load_f(verts+(indices?indices[i+j]:(i+j))*4);
+    simd_transpose(v);
+}
+
+static inline void simd_fetch4_normal(const GLfloat *norm, GLint i, GLushort *indices, simd_f4 n[3]) {
+    if(!norm) {
+        for (int j=0; j<3; j++)
+            n[j] = simd_set1_f(glstate->normal[j]);
+        return;
+    }
+    GLfloat tmp[3][4];
+    for (int j=0; j<4; j++) {
+        const GLfloat *p = norm+(indices?indices[i+j]:(i+j))*3;
+        tmp[0][j] = p[0]; tmp[1][j] = p[1]; tmp[2][j] = p[2];
+    }
+    for (int j=0; j<3; j++)
+        n[j] = simd_load_f(tmp[j]);
+}
+
+static inline void simd_set4(const GLfloat *c, simd_f4 r[4]) {
+    for (int j=0; j<4; j++)
+        r[j] = simd_set1_f(c[j]);
+}
+
+// v[0]*c[0] + v[1]*c[1] + v[2]*c[2] + v[3]*c[3]
+static inline simd_f4 simd_lin4(const simd_f4 v[4], const simd_f4 c[4]) {
+    simd_f4 r = simd_mul_f(v[0], c[0]);
+    r = simd_add_f(r, simd_mul_f(v[1], c[1]));
+    r = simd_add_f(r, simd_mul_f(v[2], c[2]));
+    return simd_add_f(r, simd_mul_f(v[3], c[3]));
+}
+
+// n[0]*c[0] + n[1]*c[1] + n[2]*c[2] + c[3]
+static inline simd_f4 simd_lin3(const simd_f4 n[3], const simd_f4 c[4]) {
+    simd_f4 r = simd_mul_f(n[0], c[0]);
+    r = simd_add_f(r, simd_mul_f(n[1], c[1]));
+    r = simd_add_f(r, simd_mul_f(n[2], c[2]));
+    return simd_add_f(r, c[3]);
+}
+
+// x,y,z scaled by 1/length(x,y,z), like vector_normalize
+static inline void simd_normalize3(simd_f4 v[3]) {
+    simd_f4 l = simd_mul_f(v[0], v[0]);
+    l = simd_add_f(l, simd_mul_f(v[1], v[1]));
+    l = simd_add_f(l, simd_mul_f(v[2], v[2]));
+    l = simd_div_f(simd_set1_f(1.0f), simd_sqrt_f(l));
+    for (int j=0; j<3; j++)
+        v[j] = simd_mul_f(v[j], l);
+}
+
+// write one component of 4 vertices
+static inline void simd_scatter1(GLfloat *out, GLint i, GLushort *indices, simd_f4 r) {
+    GLfloat tmp[4];
+    simd_store_f(tmp, r);
+    for (int j=0; j<4; j++)
+        out[(indices?indices[i+j]:(i+j))*4] = tmp[j];
+}
+
+// write the 4 components of 4 vertices
+static inline void simd_scatter4(GLfloat *out, GLint i, GLushort *indices, simd_f4 r[4]) {
+    simd_transpose(r);
+    for (int j=0; j<4; j++)
+        simd_store_f(out+(indices?indices[i+j]:(i+j))*4, r[j]);
+}
+#endif
+
 void dot_loop(const GLfloat *verts, const GLfloat *params, GLfloat *out, GLint count, GLushort *indices) {
-    for (int i = 0; i < count; i++) {
+    int i = 0;
+#ifdef GL4ES_SIMD_NEON64
+    // a single dot product is too cheap for the transposes on SSE2, only use NEON (vld4 does it for free)
+    if(!globals4es.nosimd) {
+        simd_f4 p[4], v[4];
+        simd_set4(params, p);
+        for (; i+4<=count; i+=4) {
+            if(indices)
+                simd_fetch4(verts, i, indices, v);
+            else
+                simd_load_t(verts+i*4, v);
+            simd_scatter1(out, i, indices, simd_lin4(v, p));
+        }
+    }
+#endif
+    for (; i < count; i++) {
 	GLushort k = indices?indices[i]:i;
         out[k*4] = dot4(verts+k*4, params);// + params[3];
     }
@@ -191,7 +279,47 @@ void sphere_loop(const GLfloat *verts, const GLfloat *norm, GLfloat *out, GLint
     const GLfloat *ModelviewMatrix = getMVMat();
     GLfloat eye[4], eye_norm[4], reflect[4];
     GLfloat a;
-    for (int i=0; i<count; i++) {
+    int i = 0;
+#ifdef GL4ES_SIMD
+    if(!globals4es.nosimd) {
+        // mv[j] / inv[j] are the columns of the vector_matrix / vector3_matrix products
+        simd_f4 mv[3][4], inv[3][4];
+        for (int j=0; j<3; j++)
+            for (int l=0; l<4; l++) {
+                mv[j][l] = simd_set1_f(ModelviewMatrix[l*4+j]);
+                inv[j][l] = simd_set1_f(InvModelview[l*4+j]);
+            }
+        const simd_f4 half = simd_set1_f(0.5f);
+        simd_f4 v[4], n[3], e[3], en[3], r[4];
+        for (; i+4<=count; i+=4) {
+            simd_fetch4(verts, i, indices, v);
+            simd_fetch4_normal(norm, i, indices, n);
+            for (int j=0; j<3; j++) {
+                e[j] = simd_lin4(v, mv[j]);
+                en[j] = simd_lin3(n, inv[j]);
+            }
+            simd_normalize3(e);
+            simd_normalize3(en);
+            simd_f4 d = simd_mul_f(e[0], en[0]);
+            d = simd_add_f(d, simd_mul_f(e[1], en[1]));
+            d = simd_add_f(d, simd_mul_f(e[2], en[2]));
+            d = simd_mul_f(d, simd_set1_f(2.0f));
+            for (int j=0; j<3; j++)
+                r[j] = simd_sub_f(e[j], simd_mul_f(en[j], d));
+            r[2] = simd_add_f(r[2], simd_set1_f(1.0f));
+            d = simd_mul_f(r[0], r[0]);
+            d = simd_add_f(d, simd_mul_f(r[1], r[1]));
+            d = simd_add_f(d, simd_mul_f(r[2], r[2]));
+            d = simd_div_f(half, simd_sqrt_f(d));
+            r[0] = simd_add_f(simd_mul_f(r[0], d), half);
+            r[1] = simd_add_f(simd_mul_f(r[1], d), half);
+            r[2] = simd_set1_f(0.0f);
+            r[3] = simd_set1_f(1.0f);
+            simd_scatter4(out, i, indices, r);
+        }
+    }
+#endif
+    for (; i<count; i++) {
 	GLushort k = indices?indices[i]:i;
         vector_matrix(verts+k*4, ModelviewMatrix, eye);
         vector4_normalize(eye);
@@ -217,11 +345,42 @@ void reflection_loop(const GLfloat *verts, const GLfloat *norm, GLfloat *out, GL
         return;
     }*/
     GLfloat InvModelview[16];
-    matrix_transpose(InvModelview, getInvMVMat());
+    matrix_transpose(getInvMVMat(), InvModelview);
     const GLfloat * ModelviewMatrix = getMVMat();
     GLfloat eye[4], eye_norm[4];
     GLfloat a;
-    for (int i=0; i<count; i++) {
+    int i = 0;
+#ifdef GL4ES_SIMD
+    if(!globals4es.nosimd) {
+        simd_f4 mv[4][4], inv[4][4];
+        for (int j=0; j<4; j++)
+            for (int l=0; l<4; l++) {
+                mv[j][l] = simd_set1_f(ModelviewMatrix[l*4+j]);
+                inv[j][l] = simd_set1_f(InvModelview[l*4+j]);
+            }
+        simd_f4 v[4], n[3], e[4], en[4], r[4];
+        for (; i+4<=count; i+=4) {
+            simd_fetch4(verts, i, indices, v);
+            simd_fetch4_normal(norm, i, indices, n);
+            for (int j=0; j<4; j++) {
+                e[j] = simd_lin4(v, mv[j]);
+                en[j] = simd_lin3(n, inv[j]);
+            }
+            simd_normalize3(e);
+            simd_normalize3(en);
+            simd_f4 d = simd_mul_f(e[0], en[0]);
+            d = simd_add_f(d, simd_mul_f(e[1], en[1]));
+            d = simd_add_f(d, simd_mul_f(e[2], en[2]));
+            d = simd_add_f(d, simd_mul_f(e[3], en[3]));
+            d = simd_mul_f(d, simd_set1_f(2.0f));
+            for (int j=0; j<3; j++)
+                r[j] = simd_sub_f(e[j], simd_mul_f(en[j], d));
+            r[3] = simd_set1_f(1.0f);
+            simd_scatter4(out, i, indices, r);
+        }
+    }
+#endif
+    for (; i<count; i++) {
 	GLushort k = indices?indices[i]:i;
         vector_matrix(verts+k*4, ModelviewMatrix, eye);
         vector4_normalize(eye);
@@ -241,7 +400,22 @@ void eye_loop(const GLfloat *verts, const GLfloat *param, GLfloat *out, GLint co
     // First get the ModelviewMatrix
     const GLfloat *ModelviewMatrix = getMVMat();
     GLfloat tmp[4];
-    for (int i=0; i<count; i++) {
+    int i = 0;
+#ifdef GL4ES_SIMD
+    if(!globals4es.nosimd) {
+        simd_f4 m[4][4], p[4], v[4], t[4];
+        for (int j=0; j<4; j++)
+            simd_set4(ModelviewMatrix+j*4, m[j]);
+        simd_set4(param, p);
+        for (; i+4<=count; i+=4) {
+            simd_fetch4(verts, i, indices, v);
+            for (int j=0; j<4; j++)
+                t[j] = simd_lin4(v, m[j]);
+            simd_scatter1(out, i, indices, simd_lin4(t, p));
+        }
+    }
+#endif
+    for (; i<count; i++) {
 	GLushort k = indices?indices[i]:i;
         matrix_vector(ModelviewMatrix, verts+k*4, tmp);
         out[k*4]=dot4(param, tmp);
@@ -251,14 +425,28 @@ void eye_loop(const GLfloat *verts, const GLfloat *param, GLfloat *out, GLint co
 void eye_loop_dual(const GLfloat *verts, const GLfloat *param1, const GLfloat* param2, GLfloat *out, GLint count, GLushort *indices) {
     // based on https://www.opengl.org/wiki/Mathematics_of_glTexGen
     // First get the ModelviewMatrix
-    GLfloat ModelviewMatrix[16], InvModelview[16];
-    gl4es_glGetFloatv(GL_MODELVIEW_MATRIX, InvModelview);
+    GLfloat ModelviewMatrix[16];
     // column major -> row major
-    matrix_transpose(InvModelview, ModelviewMatrix);
-    // And get the inverse
-    matrix_inverse(ModelviewMatrix, InvModelview);
+    matrix_transpose(getMVMat(), ModelviewMatrix);
     GLfloat tmp[4];
-    for (int i=0; i<count; i++) {
+    int i = 0;
+#ifdef GL4ES_SIMD
+    if(!globals4es.nosimd) {
+        simd_f4 m[4][4], p1[4], p2[4], v[4], t[4];
+        for (int j=0; j<4; j++)
+            simd_set4(ModelviewMatrix+j*4, m[j]);
+        simd_set4(param1, p1);
+        simd_set4(param2, p2);
+        for (; i+4<=count; i+=4) {
+            simd_fetch4(verts, i, indices, v);
+            for (int j=0; j<4; j++)
+                t[j] = simd_lin4(v, m[j]);
+            simd_scatter1(out, i, indices, simd_lin4(t, p1));
+            simd_scatter1(out+1, i, indices, simd_lin4(t, p2));
+        }
+    }
+#endif
+    for (; i<count; i++) {
 	GLushort k = indices?indices[i]:i;
         matrix_vector(ModelviewMatrix, verts+k*4, tmp);
         out[k*4+0]=dot4(param1, tmp);
@@ -280,14 +468,46 @@ static inline void tex_coord_loop(GLfloat *verts, GLfloat *norm, GLfloat *out, G
     }
 }
 
-void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count, GLint *needclean, int texture, GLushort *indices, GLuint ilen) {
+// Check if the coordinates already in the texgened buffer were generated from the same
+// renderlist and the same state. If not, the cache now describes the coordinates about to be generated.
+// valid is 0 if the buffer as just been allocated, serial is 0 if the renderlist can't be cached
+static int texgen_cached(int texture, GLuint serial, GLint count, GLuint ilen, int valid) {
+    texgen_cache_t *cache = &glstate->texgen_cache[texture];
+    if(!serial) {
+        cache->serial = 0;
+        return 0;
+    }
+    const GLuint enabled = glstate->enable.texture[texture]
+        | (glstate->enable.texgen_s[texture]?(1u<<28):0) | (glstate->enable.texgen_t[texture]?(1u<<29):0)
+        | (glstate->enable.texgen_r[texture]?(1u<<30):0) | (glstate->enable.texgen_q[texture]?(1u<<31):0);
+    if(valid && cache->serial==serial && cache->count==count && cache->ilen==ilen && cache->enabled==enabled
+        && !memcmp(&cache->texgen, &glstate->texgen[texture], sizeof(texgen_state_t))
+        && !memcmp(cache->modelview, getMVMat(), 16*sizeof(GLfloat))
+        && !memcmp(cache->normal, glstate->normal, 3*sizeof(GLfloat))
+        && !memcmp(cache->texcoord, glstate->texcoord[texture], 4*sizeof(GLfloat)))
+        return 1;
+    cache->serial = serial;
+    cache->count = count;
+    cache->ilen = ilen;
+    cache->enabled = enabled;
+    memcpy(&cache->texgen, &glstate->texgen[texture], sizeof(texgen_state_t));
+    memcpy(cache->modelview, getMVMat(), 16*sizeof(GLfloat));
+    memcpy(cache->normal, glstate->normal, 3*sizeof(GLfloat));
+    memcpy(cache->texcoord, glstate->texcoord[texture], 4*sizeof(GLfloat));
+    return 0;
+}
+
+void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count, GLint *needclean, int texture, GLushort *indices, GLuint ilen, GLuint serial) {
 //printf("gen_tex_coords(%p, %p, %p, %d, %p, %d, %p, %d) texgen = S:%s T:%s R:%s Q:%s, enabled:%c%c%c%c, tex=%02X\n", verts, norm, *coords, count, needclean, texture, indices, ilen, (glstate->enable.texgen_s[texture])?PrintEnum(glstate->texgen[texture].S):"-", (glstate->enable.texgen_t[texture])?PrintEnum(glstate->texgen[texture].T):"-", (glstate->enable.texgen_r[texture])?PrintEnum(glstate->texgen[texture].R):"-", (glstate->enable.texgen_q[texture])?PrintEnum(glstate->texgen[texture].Q):"-", (glstate->enable.texgen_s[texture])?'S':'-', (glstate->enable.texgen_t[texture])?'T':'-', (glstate->enable.texgen_r[texture])?'R':'-', (glstate->enable.texgen_q[texture])?'Q':'-', glstate->enable.texture[texture]);
     // TODO: do less work when called from glDrawElements?
     (*needclean) = 0;
     // special case : no texgen but texture activated, create a simple 1 repeated element
     if (!glstate->enable.texgen_s[texture] && !glstate->enable.texgen_t[texture] && !glstate->enable.texgen_r[texture] && !glstate->enable.texgen_q[texture]) {
+        const int valid = (*coords)!=NULL;
         if ((*coords)==NULL) 
             *coords = (GLfloat *)malloc(count * 4 * sizeof(GLfloat));
+        if (texgen_cached(texture, serial, count, ilen, valid))
+            return;
         if (indices)
             for (int i=0; i<ilen; i++) {
                 memcpy((*coords)+indices[i]*4, glstate->texcoord[texture], sizeof(GLfloat)*4);
@@ -303,8 +523,11 @@ void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count
     {
         if (!IS_TEX2D(glstate->enable.texture[texture]))
             return;
+        const int valid = (*coords)!=NULL;
         if ((*coords)==NULL) 
             *coords = (GLfloat *)malloc(count * 4 * sizeof(GLfloat));
+        if (texgen_cached(texture, serial, count, ilen, valid))
+            return;
         sphere_loop(verts, norm, *coords, (indices)?ilen:count, indices);
         return;
     }
@@ -339,8 +562,11 @@ void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count
         } else {
             if (!IS_TEX2D(glstate->enable.texture[texture]))
                 return;
+            const int valid = (*coords)!=NULL;
             if ((*coords)==NULL) 
                 *coords = (GLfloat *)malloc(count * 4 * sizeof(GLfloat));
+            if (texgen_cached(texture, serial, count, ilen, valid))
+                return;
             reflection_loop(verts, norm, *coords, (indices)?ilen:count, indices);
         }
         return;
@@ -377,8 +603,11 @@ void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count
     }
     if (!IS_ANYTEX(glstate->enable.texture[texture]))
 	return;
+    const int valid = (*coords)!=NULL;
     if ((*coords)==NULL) 
         *coords = (GLfloat *)malloc(count * 4 * sizeof(GLfloat));
+    if (texgen_cached(texture, serial, count, ilen, valid))
+        return;
     if (    (glstate->enable.texgen_s[texture] && glstate->texgen[texture].S==GL_EYE_LINEAR) 
         &&  (glstate->enable.texgen_t[texture] && glstate->texgen[texture].T==GL_EYE_LINEAR) )
     {
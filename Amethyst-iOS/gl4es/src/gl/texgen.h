@@ -5,7 +5,7 @@
 
 void gl4es_glTexGenfv(GLenum coord, GLenum pname, const GLfloat *params);
 void gl4es_glTexGeni(GLenum coord, GLenum pname, GLint param);
-void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count, GLint *needclean, int texture, GLushort* indices, GLuint ilen);
+void gen_tex_coords(GLfloat *verts, GLfloat *norm, GLfloat **coords, GLint count, GLint *needclean, int texture, GLushort* indices, GLuint ilen, GLuint serial);
 void gen_tex_clean(GLint cleancode, int texture);
 void gl4es_glGetTexGenfv(GLenum coord,GLenum pname,GLfloat *params);
 
@@ -61,6 +61,22 @@ static int inline maxlevel(int w, int h) {
     return mlevel;
 }
 
+// can GLES build the mipmap chain of a texture of that format (it needs to be color renderable and filterable)
+static int hardware_mipmap(GLenum format, GLenum type) {
+    if(hardext.esversion<2)
+        return 0;
+    switch(type) {
+        case GL_UNSIGNED_BYTE:
+            return hardext.rgba8 && (format==GL_RGBA || format==GL_RGB);
+        case GL_UNSIGNED_SHORT_5_6_5:
+            return format==GL_RGB;
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            return format==GL_RGBA;
+    }
+    return 0;
+}
+
 static int is_fake_compressed_rgb(GLenum internalformat)
 {
     if(internalformat==GL_COMPRESSED_RGB) return 1;
@@ -926,6 +942,8 @@ void gl4es_glTexImage2D(GLenum target, GLint level, GLint internalformat,
     noerrorShim();
 
     gltexture_t *bound = glstate->texture.bound[glstate->texture.active][itarget];
+    // the texture may be attached to a framebuffer
+    invalidateFBOStatus();
 
     //Special case when resizing an attached to FBO texture, taht is attached to depth and/or stencil => resizing is specific then
     if(bound->binded_fbo && (bound->binded_attachment==GL_DEPTH_ATTACHMENT || bound->binded_attachment==GL_STENCIL_ATTACHMENT || bound->binded_attachment==GL_DEPTH_STENCIL_ATTACHMENT))
@@ -1451,29 +1469,36 @@ void gl4es_glTexImage2D(GLenum target, GLint level, GLint internalformat,
             if(((bound->max_level == level && (level || bound->mipmap_need)) || (callgeneratemipmap && level==0) || (globals4es.automipmap==5 && level && !bound->mipmap_done)) && !(bound->max_level==bound->base_level && bound->max_level==0)) {
                 if(globals4es.automipmap==5 && level==1)
                     bound->mipmap_done = 1;
-                int leveln = level, nw = nwidth, nh = nheight, nww=width, nhh=height;
-                int pot = (nh==nhh && nw==nww);
-                void *ndata = pixels;
-                while(nw!=1 || nh!=1) {
-                    if(pixels) {
-                        GLvoid *out = ndata;
-                        pixel_halfscale(ndata, &out, nww, nhh, format, type);
-                        if (out != ndata && ndata!=pixels)
-                            free(ndata);
-                        ndata = out;
+                if(callgeneratemipmap && level==0 && pixels && rtarget==GL_TEXTURE_2D
+                  && nwidth==width && nheight==height && hardware_mipmap(format, type)) {
+                    // no padding, so the GPU can build the whole chain, and faster than the CPU
+                    LOAD_GLES2_OR_OES(glGenerateMipmap);
+                    gles_glGenerateMipmap(rtarget);
+                } else {
+                    int leveln = level, nw = nwidth, nh = nheight, nww=width, nhh=height;
+                    int pot = (nh==nhh && nw==nww);
+                    void *ndata = pixels;
+                    while(nw!=1 || nh!=1) {
+                        if(pixels) {
+                            GLvoid *out = ndata;
+                            pixel_halfscale(ndata, &out, nww, nhh, format, type);
+                            if (out != ndata && ndata!=pixels)
+                                free(ndata);
+                            ndata = out;
+                        }
+                        nw = nlevel(nw, 1);
+                        nh = nlevel(nh, 1);
+                        nww = nlevel(nww, 1);
+                        nhh = nlevel(nhh, 1);
+                        ++leveln;
+                        gles_glTexImage2D(rtarget, leveln, format, nw, nh, border,
+                                        format, type, (pot)?ndata:NULL);
+                        if(!pot && pixels) gles_glTexSubImage2D(rtarget, leveln, 0, 0, nww, nhh,
+                                            format, type, ndata);
                     }
-                    nw = nlevel(nw, 1);
-                    nh = nlevel(nh, 1);
-                    nww = nlevel(nww, 1);
-                    nhh = nlevel(nhh, 1);
-                    ++leveln;
-                    gles_glTexImage2D(rtarget, leveln, format, nw, nh, border,
-                                    format, type, (pot)?ndata:NULL);
-                    if(!pot && pixels) gles_glTexSubImage2D(rtarget, leveln, 0, 0, nww, nhh,
-                                        format, type, ndata);
+                    if (ndata!=pixels)
+                        free(ndata);
                 }
-                if (ndata!=pixels)
-                    free(ndata);
             }
         /*if (bound && bound->mipmap_need && !bound->mipmap_auto && (globals4es.automipmap!=3))
             gles_glTexParameteri( rtarget, GL_GENERATE_MIPMAP, GL_FALSE );*/
@@ -16,6 +16,7 @@
 #include "pixel.h"
 #include "raster.h"
 #include "stb_dxt_104.h"
+#include "workers.h"
 
 //#define DEBUG
 #ifdef DEBUG
@@ -110,6 +111,24 @@ GLenum compressedMinMipmap(GLenum param)
     }
 }
 
+typedef struct {
+    int dxt;
+    uint32_t width;
+    const uint8_t* data;
+    int transparent0;
+    int simpleAlpha, complexAlpha;
+    uint32_t* pixels;
+} dxt_job_t;
+
+// decompress the rows of blocks [start, end[, can run on a worker thread
+static void dxt_job(void* arg, int start, int end) {
+    dxt_job_t* job = (dxt_job_t*)arg;
+    int simpleAlpha = 0, complexAlpha = 0;
+    DecompressBlocksDXT(job->dxt, job->width, job->data, start, end, job->transparent0, &simpleAlpha, &complexAlpha, job->pixels);
+    if(simpleAlpha) __atomic_store_n(&job->simpleAlpha, 1, __ATOMIC_RELAXED);
+    if(complexAlpha) __atomic_store_n(&job->complexAlpha, 1, __ATOMIC_RELAXED);
+}
+
 GLvoid *uncompressDXTc(GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, int transparent0, int* simpleAlpha, int* complexAlpha, const GLvoid *data) {
     // uncompress a DXTc image
     // get pixel size of uncompressed image => fixed RGBA
@@ -139,28 +158,20 @@ GLvoid *uncompressDXTc(GLsizei width, GLsizei height, GLenum format, GLsizei ima
             blocksize = 16;
             break;
     }
-    uintptr_t src = (uintptr_t) data;
-    for (int y=0; y<height; y+=4) {
-        for (int x=0; x<width; x+=4) {
-            switch(format) {
-                case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-                case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-                case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
-                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
-                    DecompressBlockDXT1(x, y, width, (uint8_t*)src, transparent0, simpleAlpha, complexAlpha, pixels);
-                    break;
-                case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
-                    DecompressBlockDXT3(x, y, width, (uint8_t*)src, transparent0, simpleAlpha, complexAlpha, pixels);
-                    break;
-                case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-                case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
-                    DecompressBlockDXT5(x, y, width, (uint8_t*)src, transparent0, simpleAlpha, complexAlpha, pixels);
-                    break;
-            }
-            src+=blocksize;
-        }
-    }
+    dxt_job_t job;
+    job.dxt = (blocksize==8)?1:((format==GL_COMPRESSED_RGBA_S3TC_DXT3_EXT || format==GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT)?3:5);
+    job.width = width;
+    job.data = (const uint8_t*)data;
+    job.transparent0 = transparent0;
+    job.simpleAlpha = job.complexAlpha = 0;
+    job.pixels = (uint32_t*)pixels;
+    const int rows = (height+3)/4;
+    if(width&3)
+        dxt_job(&job, 0, rows);  // blocks overlap if width is not a multiple of 4, keep the serial order
+    else
+        workers_run(dxt_job, &job, rows, (16384+width-1)/width);  // at least 64k pixels per slice
+    if(job.simpleAlpha) *simpleAlpha = 1;
+    if(job.complexAlpha) *complexAlpha = 1;
     return pixels;
 }
 
@@ -195,6 +206,7 @@ void gl4es_glCompressedTexImage2D(GLenum target, GLint level, GLenum internalfor
         noerrorShim();
         return; //nothing, mipmap ignored...
     }
+    invalidateFBOStatus();
     
     glbuffer_t *unpack = glstate->vao->unpack;
     glstate->vao->unpack = NULL;
@@ -195,6 +195,7 @@ void gl4es_glBindTexture(GLenum target, GLuint texture) {
         
         FLUSH_BEGINEND;
         tex_changed = glstate->texture.active+1;
+        attrib_changed(GL_TEXTURE_BIT);
         glstate->texture.bound[glstate->texture.active][itarget] = tex;
 
         LOAD_GLES(glBindTexture);
@@ -421,6 +422,7 @@ void gl4es_glDeleteTextures(GLsizei n, const GLuint *textures) {
     
     noerrorShim();
     LOAD_GLES(glDeleteTextures);
+    invalidateFBOStatus();
     khash_t(tex) *list = glstate->texture.list;
     if (list) {
         khint_t k;
@@ -437,6 +439,7 @@ void gl4es_glDeleteTextures(GLsizei n, const GLuint *textures) {
                     for (int j=0; j<ENABLED_TEXTURE_LAST; j++)
                         if (tex == glstate->texture.bound[a][j]) {
                             glstate->texture.bound[a][j] = glstate->texture.zero;
+                            attrib_changed(GL_TEXTURE_BIT);
                             found = 1;
                         }
                     if(glstate->actual_tex2d[a]==tex->glname) {
@@ -40,6 +40,7 @@ void gl4es_glCopyTexImage2D(GLenum target,  GLint level,  GLenum internalformat,
 
     // actualy bound if targetting shared TEX2D
     realize_bound(glstate->texture.active, target);
+    invalidateFBOStatus();
 
     errorGL();
 
@@ -169,6 +170,7 @@ void gl4es_glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum
         errorShim(GL_INVALID_OPERATION);
         return;	// never in list
     }
+    if (glstate->raster.bm_drawing) bitmap_flush();
     LOAD_GLES(glReadPixels);
     errorGL();
     GLvoid* dst = data;
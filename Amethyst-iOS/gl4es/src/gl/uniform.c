@@ -110,11 +110,8 @@ void gl4es_glGetUniformfv(GLuint program, GLint location, GLfloat *params) {
     FLUSH_BEGINEND;
     CHECK_PROGRAM(void, program);
 
-    khint_t k;
-    uniform_t *gluniform = NULL;
-    k = kh_get(uniformlist, glprogram->uniform, k);
-    if(k!=kh_end(glprogram->uniform)) {
-        gluniform = kh_value(glprogram->uniform, k);
+    if(location>=0 && location<glprogram->num_location) {
+        uniform_t *gluniform = &glprogram->uniform[location];
         uintptr_t offs = gluniform->cache_offs;
         int size = gluniform->cache_size;
         if(is_uniform_float(gluniform->type)) {
@@ -137,11 +134,8 @@ void gl4es_glGetUniformiv(GLuint program, GLint location, GLint *params) {
     FLUSH_BEGINEND;
     CHECK_PROGRAM(void, program);
 
-    khint_t k;
-    uniform_t *gluniform = NULL;
-    k = kh_get(uniformlist, glprogram->uniform, k);
-    if(k!=kh_end(glprogram->uniform)) {
-        gluniform = kh_value(glprogram->uniform, k);
+    if(location>=0 && location<glprogram->num_location) {
+        uniform_t *gluniform = &glprogram->uniform[location];
         uintptr_t offs = gluniform->cache_offs;
         int size = gluniform->cache_size;
         if(is_uniform_int(gluniform->type)) {
@@ -160,6 +154,59 @@ void gl4es_glGetUniformiv(GLuint program, GLint location, GLint *params) {
     errorShim(GL_INVALID_VALUE);
 }
 
+static void MarkUniformDirty(program_t *glprogram, GLint location, int count)
+{
+    // the value is in the cache, it will be sent to GLES just before the next draw
+    uniform_t *m = &glprogram->uniform[location];
+    if(!m->dirty)
+        glprogram->dirty[glprogram->num_dirty++] = location;
+    if(m->dirty<count)
+        m->dirty = count;
+}
+
+void FlushUniforms(program_t *glprogram)
+{
+    if(!glprogram || !glprogram->num_dirty)
+        return;
+    LOAD_GLES2(glUniform1fv);
+    LOAD_GLES2(glUniform2fv);
+    LOAD_GLES2(glUniform3fv);
+    LOAD_GLES2(glUniform4fv);
+    LOAD_GLES2(glUniform1iv);
+    LOAD_GLES2(glUniform2iv);
+    LOAD_GLES2(glUniform3iv);
+    LOAD_GLES2(glUniform4iv);
+    LOAD_GLES2(glUniformMatrix2fv);
+    LOAD_GLES2(glUniformMatrix3fv);
+    LOAD_GLES2(glUniformMatrix4fv);
+    for (int i=0; i<glprogram->num_dirty; i++) {
+        uniform_t *m = &glprogram->uniform[glprogram->dirty[i]];
+        const void *v = glprogram->cache.cache + m->cache_offs;
+        DBG(printf("FlushUniforms(%p[%d]) uniform %s count=%d\n", glprogram, glprogram->id, m->name, m->dirty);)
+        switch(m->type) {
+            case GL_FLOAT: gles_glUniform1fv(m->id, m->dirty, v); break;
+            case GL_FLOAT_VEC2: gles_glUniform2fv(m->id, m->dirty, v); break;
+            case GL_FLOAT_VEC3: gles_glUniform3fv(m->id, m->dirty, v); break;
+            case GL_FLOAT_VEC4: gles_glUniform4fv(m->id, m->dirty, v); break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_CUBE: gles_glUniform1iv(m->id, m->dirty, v); break;
+            case GL_INT_VEC2:
+            case GL_BOOL_VEC2: gles_glUniform2iv(m->id, m->dirty, v); break;
+            case GL_INT_VEC3:
+            case GL_BOOL_VEC3: gles_glUniform3iv(m->id, m->dirty, v); break;
+            case GL_INT_VEC4:
+            case GL_BOOL_VEC4: gles_glUniform4iv(m->id, m->dirty, v); break;
+            case GL_FLOAT_MAT2: gles_glUniformMatrix2fv(m->id, m->dirty, GL_FALSE, v); break;
+            case GL_FLOAT_MAT3: gles_glUniformMatrix3fv(m->id, m->dirty, GL_FALSE, v); break;
+            case GL_FLOAT_MAT4: gles_glUniformMatrix4fv(m->id, m->dirty, GL_FALSE, v); break;
+        }
+        m->dirty = 0;
+    }
+    glprogram->num_dirty = 0;
+}
+
 void GoUniformfv(program_t *glprogram, GLint location, int size, int count, const GLfloat *value)
 {
     DBG(printf("GoUniformfv(%p[%d], %d, %d, %d, %p) =>(%f...)\n", glprogram, glprogram->id, location, size, count, value, value[0]);)
@@ -172,14 +219,11 @@ void GoUniformfv(program_t *glprogram, GLint location, int size, int count, cons
         return;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
     if(size != n_uniform(m->type) || !is_uniform_float(m->type) || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -193,17 +237,9 @@ void GoUniformfv(program_t *glprogram, GLint location, int size, int count, cons
     // update uniform
     memcpy(glprogram->cache.cache + m->cache_offs, value, rsize);
     LOAD_GLES2(glUniform1fv);
-    LOAD_GLES2(glUniform2fv);
-    LOAD_GLES2(glUniform3fv);
-    LOAD_GLES2(glUniform4fv);
     if(gles_glUniform1fv) {
-        switch (size) {
-            case 1: gles_glUniform1fv(m->id, count, value); break;
-            case 2: gles_glUniform2fv(m->id, count, value); break;
-            case 3: gles_glUniform3fv(m->id, count, value); break;
-            case 4: gles_glUniform4fv(m->id, count, value); break;
-        }
-        errorGL();
+        MarkUniformDirty(glprogram, location, count);
+        noerrorShim();
     } else
         errorShim(GL_INVALID_OPERATION);    // no GLLS hardware
 }
@@ -219,14 +255,11 @@ void GoUniformiv(program_t *glprogram, GLint location, int size, int count, cons
         return;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
     if(size != n_uniform(m->type) || !is_uniform_int(m->type)  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -241,17 +274,9 @@ void GoUniformiv(program_t *glprogram, GLint location, int size, int count, cons
     // update uniform
     memcpy(glprogram->cache.cache + m->cache_offs, value, rsize);
     LOAD_GLES2(glUniform1iv);
-    LOAD_GLES2(glUniform2iv);
-    LOAD_GLES2(glUniform3iv);
-    LOAD_GLES2(glUniform4iv);
     if(gles_glUniform1iv) {
-        switch (size) {
-            case 1: gles_glUniform1iv(m->id, count, value); break;
-            case 2: gles_glUniform2iv(m->id, count, value); break;
-            case 3: gles_glUniform3iv(m->id, count, value); break;
-            case 4: gles_glUniform4iv(m->id, count, value); break;
-        }
-        errorGL();
+        MarkUniformDirty(glprogram, location, count);
+        noerrorShim();
     } else
         errorShim(GL_INVALID_OPERATION);    // no GLLS hardware
 }
@@ -261,7 +286,6 @@ void gl4es_glUniform1f(GLint location, GLfloat v0) {
     PUSH_IF_COMPILING(glUniform1f);
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 1, 1, &v0);
 }
 void gl4es_glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
@@ -270,7 +294,6 @@ void gl4es_glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
     GLfloat fl[2] = {v0, v1};
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 2, 1, fl);
 }
 void gl4es_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
@@ -279,7 +302,6 @@ void gl4es_glUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
     GLfloat fl[3] = {v0, v1, v2};
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 3, 1, fl);
 }
 void gl4es_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
@@ -288,7 +310,6 @@ void gl4es_glUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLflo
     GLfloat fl[4] = {v0, v1, v2, v3};
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 4, 1, fl);
 }
 void gl4es_glUniform1i(GLint location, GLint v0) {
@@ -296,7 +317,6 @@ void gl4es_glUniform1i(GLint location, GLint v0) {
     PUSH_IF_COMPILING(glUniform1i);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 1, 1, &v0);
 }
 void gl4es_glUniform2i(GLint location, GLint v0, GLint v1) {
@@ -305,7 +325,6 @@ void gl4es_glUniform2i(GLint location, GLint v0, GLint v1) {
     GLint fl[2] = {v0, v1};
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 2, 1, fl);
 }
 void gl4es_glUniform3i(GLint location, GLint v0, GLint v1, GLint v2) {
@@ -314,7 +333,6 @@ void gl4es_glUniform3i(GLint location, GLint v0, GLint v1, GLint v2) {
     GLint fl[3] = {v0, v1, v2};
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 3, 1, fl);
 }
 void gl4es_glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
@@ -323,7 +341,6 @@ void gl4es_glUniform4i(GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
     GLint fl[4] = {v0, v1, v2, v3};
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 4, 1, fl);
 }
 //TODO: the "v" variant and matrix variant cannot be pushed simply...
@@ -332,7 +349,6 @@ void gl4es_glUniform1fv(GLint location, GLsizei count, const GLfloat *value) {
     PUSH_IF_COMPILING(glUniform1fv);
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 1, count, value);
 }
 void gl4es_glUniform2fv(GLint location, GLsizei count, const GLfloat *value) {
@@ -340,7 +356,6 @@ void gl4es_glUniform2fv(GLint location, GLsizei count, const GLfloat *value) {
     PUSH_IF_COMPILING(glUniform2fv);
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 2, count, value);
 }
 void gl4es_glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
@@ -348,7 +363,6 @@ void gl4es_glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
     PUSH_IF_COMPILING(glUniform3fv);
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 3, count, value);
 }
 void gl4es_glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {
@@ -356,35 +370,30 @@ void gl4es_glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {
     PUSH_IF_COMPILING(glUniform4fv);
     GLuint program = glstate->glsl->program; 
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 4, count, value);
 }
 void gl4es_glUniform1iv(GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform1iv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 1, count, value);
 }
 void gl4es_glUniform2iv(GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform2iv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 2, count, value);
 }
 void gl4es_glUniform3iv(GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform3iv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 3, count, value);
 }
 void gl4es_glUniform4iv(GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform4iv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 4, count, value);
 }
 
@@ -393,7 +402,6 @@ void gl4es_glUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose
     PUSH_IF_COMPILING(glUniformMatrix2fv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix2fv(glprogram, location, count, transpose, value);
 }
 
@@ -401,7 +409,6 @@ void gl4es_glProgramUniform1f(GLuint program, GLint location, GLfloat v0) {
     DBG(printf("glUniform1f(%d, %f)\n", location, v0);)
     PUSH_IF_COMPILING(glUniform1f);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 1, 1, &v0);
 }
 void gl4es_glProgramUniform2f(GLuint program, GLint location, GLfloat v0, GLfloat v1) {
@@ -409,7 +416,6 @@ void gl4es_glProgramUniform2f(GLuint program, GLint location, GLfloat v0, GLfloa
     PUSH_IF_COMPILING(glUniform2f);
     GLfloat fl[2] = {v0, v1};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 2, 1, fl);
 }
 void gl4es_glProgramUniform3f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
@@ -417,7 +423,6 @@ void gl4es_glProgramUniform3f(GLuint program, GLint location, GLfloat v0, GLfloa
     PUSH_IF_COMPILING(glUniform3f);
     GLfloat fl[3] = {v0, v1, v2};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 3, 1, fl);
 }
 void gl4es_glProgramUniform4f(GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
@@ -425,14 +430,12 @@ void gl4es_glProgramUniform4f(GLuint program, GLint location, GLfloat v0, GLfloa
     PUSH_IF_COMPILING(glUniform4f);
     GLfloat fl[4] = {v0, v1, v2, v3};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 4, 1, fl);
 }
 void gl4es_glProgramUniform1i(GLuint program, GLint location, GLint v0) {
     DBG(printf("glUniform1i(%d, %d)\n", location, v0);)
     PUSH_IF_COMPILING(glUniform1i);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 1, 1, &v0);
 }
 void gl4es_glProgramUniform2i(GLuint program, GLint location, GLint v0, GLint v1) {
@@ -440,7 +443,6 @@ void gl4es_glProgramUniform2i(GLuint program, GLint location, GLint v0, GLint v1
     PUSH_IF_COMPILING(glUniform2i);
     GLint fl[2] = {v0, v1};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 2, 1, fl);
 }
 void gl4es_glProgramUniform3i(GLuint program, GLint location, GLint v0, GLint v1, GLint v2) {
@@ -448,7 +450,6 @@ void gl4es_glProgramUniform3i(GLuint program, GLint location, GLint v0, GLint v1
     PUSH_IF_COMPILING(glUniform3i);
     GLint fl[3] = {v0, v1, v2};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 3, 1, fl);
 }
 void gl4es_glProgramUniform4i(GLuint program, GLint location, GLint v0, GLint v1, GLint v2, GLint v3) {
@@ -456,7 +457,6 @@ void gl4es_glProgramUniform4i(GLuint program, GLint location, GLint v0, GLint v1
     PUSH_IF_COMPILING(glUniform4i);
     GLint fl[4] = {v0, v1, v2, v3};
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 4, 1, fl);
 }
 //TODO: the "v" variant and matrix variant cannot be pushed simply...
@@ -464,52 +464,44 @@ void gl4es_glProgramUniform1fv(GLuint program, GLint location, GLsizei count, co
     DBG(printf("glUniform1fv(%d, %d, %p) =>(%f)\n", location, count, value, value[0]);)
     PUSH_IF_COMPILING(glUniform1fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 1, count, value);
 }
 void gl4es_glProgramUniform2fv(GLuint program, GLint location, GLsizei count, const GLfloat *value) {
     DBG(printf("glUniform2fv(%d, %d, %p) =>(%f %f)\n", location, count, value, value[0], value[1]);)
     PUSH_IF_COMPILING(glUniform2fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 2, count, value);
 }
 void gl4es_glProgramUniform3fv(GLuint program, GLint location, GLsizei count, const GLfloat *value) {
     DBG(printf("glUniform3fv(%d, %d, %p) =>(%f %f, %f)\n", location, count, value, value[0], value[1], value[2]);)
     PUSH_IF_COMPILING(glUniform3fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 3, count, value);
 }
 void gl4es_glProgramUniform4fv(GLuint program, GLint location, GLsizei count, const GLfloat *value) {
     DBG(printf("glUniform4fv(%d, %d, %p) =>(%f %f, %f, %f)\n", location, count, value, value[0], value[1], value[2], value[3]);)
     PUSH_IF_COMPILING(glUniform4fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformfv(glprogram, location, 4, count, value);
 }
 void gl4es_glProgramUniform1iv(GLuint program, GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform1iv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 1, count, value);
 }
 void gl4es_glProgramUniform2iv(GLuint program, GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform2iv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 2, count, value);
 }
 void gl4es_glProgramUniform3iv(GLuint program, GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform3iv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 3, count, value);
 }
 void gl4es_glProgramUniform4iv(GLuint program, GLint location, GLsizei count, const GLint *value) {
     PUSH_IF_COMPILING(glUniform4iv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformiv(glprogram, location, 4, count, value);
 }
 
@@ -517,7 +509,6 @@ void gl4es_glProgramUniformMatrix2fv(GLuint program, GLint location, GLsizei cou
     DBG(printf("glUniformMatrix2fv(%d, %d, %d, %p)\n", location, count, transpose, value);)
     PUSH_IF_COMPILING(glUniformMatrix2fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix2fv(glprogram, location, count, transpose, value);
 }
 
@@ -531,14 +522,11 @@ void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
     if(m->type!=GL_FLOAT_MAT2  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -564,8 +552,8 @@ void GoUniformMatrix2fv(program_t *glprogram, GLint location, GLsizei count, GLb
     memcpy(glprogram->cache.cache + m->cache_offs, v, rsize);
     LOAD_GLES2(glUniformMatrix2fv);
     if (gles_glUniformMatrix2fv) {
-        gles_glUniformMatrix2fv(m->id, count, GL_FALSE, v);
-        errorGL();
+        MarkUniformDirty(glprogram, location, count);
+        noerrorShim();
     } else
         errorShim(GL_INVALID_OPERATION);    // no GLSL hardware
 }
@@ -575,7 +563,6 @@ void gl4es_glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose
     PUSH_IF_COMPILING(glUniformMatrix3fv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix3fv(glprogram, location, count, transpose, value);
 }
 
@@ -583,7 +570,6 @@ void gl4es_glProgramUniformMatrix3fv(GLuint program, GLint location, GLsizei cou
     DBG(printf("glUniformMatrix3fv(%d, %d, %d, %p)\n", location, count, transpose, value);)
     PUSH_IF_COMPILING(glUniformMatrix3fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix3fv(glprogram, location, count, transpose, value);
 }
 
@@ -597,14 +583,11 @@ void GoUniformMatrix3fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
     if(m->type!=GL_FLOAT_MAT3  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -630,8 +613,8 @@ void GoUniformMatrix3fv(program_t *glprogram, GLint location, GLsizei count, GLb
     memcpy(glprogram->cache.cache + m->cache_offs, v, rsize);
     LOAD_GLES2(glUniformMatrix3fv);
     if (gles_glUniformMatrix3fv) {
-        gles_glUniformMatrix3fv(m->id, count, GL_FALSE, v);
-        errorGL();
+        MarkUniformDirty(glprogram, location, count);
+        noerrorShim();
     } else
         errorShim(GL_INVALID_OPERATION);    // no GLSL hardware
 }
@@ -640,14 +623,12 @@ void gl4es_glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose
     PUSH_IF_COMPILING(glUniformMatrix4fv);
     GLuint program = glstate->glsl->program;
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix4fv(glprogram, location, count, transpose, value);
 }
 void gl4es_glProgramUniformMatrix4fv(GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
     DBG(printf("glUniformMatrix4fv(%d, %d, %d, %p) p=>(%f, %f, %f, %f, %f...)\n", location, count, transpose, value, value[0], value[1], value[2], value[3], value[4]);)
     PUSH_IF_COMPILING(glUniformMatrix4fv);
     CHECK_PROGRAM(void, program);
-    APPLY_PROGRAM(program, glprogram);
     GoUniformMatrix4fv(glprogram, location, count, transpose, value);
 }
 
@@ -661,14 +642,11 @@ void GoUniformMatrix4fv(program_t *glprogram, GLint location, GLsizei count, GLb
         errorShim(GL_INVALID_VALUE);
         return;
     }
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         errorShim(GL_INVALID_OPERATION);
         return;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
     if(m->type!=GL_FLOAT_MAT4  || count>m->size) {
         errorShim(GL_INVALID_OPERATION);
         return;
@@ -692,8 +670,8 @@ void GoUniformMatrix4fv(program_t *glprogram, GLint location, GLsizei count, GLb
     memcpy(glprogram->cache.cache + m->cache_offs, v, rsize);
     LOAD_GLES2(glUniformMatrix4fv);
     if (gles_glUniformMatrix4fv) {
-        gles_glUniformMatrix4fv(m->id, count, GL_FALSE, v);
-        errorGL();
+        MarkUniformDirty(glprogram, location, count);
+        noerrorShim();
     } else {
         //printf("No GLES2 function\n");
         errorShim(GL_INVALID_OPERATION);    // no GLSL hardware
@@ -707,13 +685,10 @@ int GetUniformi(program_t *glprogram, GLint location)
         return 0;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         return 0;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
 
     // ok, grab the value in the cache
     GLint ret;
@@ -728,13 +703,10 @@ const char* GetUniformName(program_t *glprogram, GLint location)
         return 0;
     }
 
-    khint_t k;
-    uniform_t *m;
-    k = kh_get(uniformlist, glprogram->uniform, location);
-    if (k==kh_end(glprogram->uniform)) {
+    if (location<0 || location>=glprogram->num_location) {
         return 0;
     }
-    m = kh_value(glprogram->uniform, k);
+    uniform_t *m = &glprogram->uniform[location];
 
     // ok, grab the value in the cache
     return m->name;
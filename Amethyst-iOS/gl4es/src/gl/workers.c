@@ -0,0 +1,131 @@
+#include "workers.h"
+
+#include <stdlib.h>
+#if !defined(AMIGAOS4) && !defined(__EMSCRIPTEN__)
+#define USE_WORKERS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "init.h"
+#include "logs.h"
+
+#define MAX_WORKERS 8
+
+#ifdef USE_WORKERS
+static pthread_mutex_t workers_submit = PTHREAD_MUTEX_INITIALIZER;  // one job at a time
+static pthread_mutex_t workers_lock = PTHREAD_MUTEX_INITIALIZER;    // protect everything below
+static pthread_cond_t workers_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t workers_done = PTHREAD_COND_INITIALIZER;
+static pthread_t workers_threads[MAX_WORKERS];
+static int workers_count = -1;  // -1 means not started
+static int workers_stop = 0;
+// current job
+static workers_func_t job_func = NULL;
+static void* job_arg = NULL;
+static int job_count = 0, job_slice = 0, job_next = 0, job_pending = 0;
+
+// take and process slices of the current job until there is none left. Called with workers_lock held
+static void workers_process() {
+    while(job_next<job_count) {
+        workers_func_t func = job_func;
+        void* arg = job_arg;
+        int start = job_next;
+        int end = start + job_slice;
+        if(end>job_count) end = job_count;
+        job_next = end;
+        pthread_mutex_unlock(&workers_lock);
+        func(arg, start, end);
+        pthread_mutex_lock(&workers_lock);
+        if(!--job_pending)
+            pthread_cond_signal(&workers_done);
+    }
+}
+
+static void* workers_loop(void* arg) {
+    pthread_mutex_lock(&workers_lock);
+    while(1) {
+        while(!workers_stop && job_next>=job_count)
+            pthread_cond_wait(&workers_wake, &workers_lock);
+        if(workers_stop)
+            break;
+        workers_process();
+    }
+    pthread_mutex_unlock(&workers_lock);
+    return NULL;
+}
+
+// called with workers_submit held
+static void workers_start() {
+    int n = globals4es.threads;
+    if(n<0) {
+        // auto: leave one core for the main thread, and don't go too wide
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        n = (ncpu>1)?(ncpu-1):0;
+        if(n>3) n = 3;
+    }
+    if(n>MAX_WORKERS) n = MAX_WORKERS;
+    workers_count = 0;
+    for (int i=0; i<n; i++) {
+        if(pthread_create(&workers_threads[i], NULL, workers_loop, NULL))
+            break;
+        ++workers_count;
+    }
+    if(n)
+        SHUT_LOGD("Started %d worker threads\n", workers_count);
+}
+#endif
+
+void workers_run(workers_func_t func, void* arg, int count, int minslice) {
+    if(count<=0)
+        return;
+    if(minslice<1)
+        minslice = 1;
+#ifdef USE_WORKERS
+    if(globals4es.threads && count>=2*minslice) {
+        pthread_mutex_lock(&workers_submit);
+        if(workers_count<0)
+            workers_start();
+        if(workers_count>0) {
+            // a few slices per thread, so slices of uneven cost still balance
+            const int nslices = (workers_count+1)*4;
+            int slice = (count+nslices-1)/nslices;
+            if(slice<minslice) slice = minslice;
+            pthread_mutex_lock(&workers_lock);
+            job_func = func;
+            job_arg = arg;
+            job_slice = slice;
+            job_next = 0;
+            job_count = count;
+            job_pending = (count+slice-1)/slice;
+            pthread_cond_broadcast(&workers_wake);
+            workers_process();
+            while(job_pending)
+                pthread_cond_wait(&workers_done, &workers_lock);
+            job_count = job_next = 0;
+            pthread_mutex_unlock(&workers_lock);
+            pthread_mutex_unlock(&workers_submit);
+            return;
+        }
+        pthread_mutex_unlock(&workers_submit);
+    }
+#endif
+    func(arg, 0, count);
+}
+
+void workers_quit() {
+#ifdef USE_WORKERS
+    pthread_mutex_lock(&workers_submit);
+    if(workers_count>0) {
+        pthread_mutex_lock(&workers_lock);
+        workers_stop = 1;
+        pthread_cond_broadcast(&workers_wake);
+        pthread_mutex_unlock(&workers_lock);
+        for (int i=0; i<workers_count; i++)
+            pthread_join(workers_threads[i], NULL);
+        workers_stop = 0;
+    }
+    workers_count = -1;
+    pthread_mutex_unlock(&workers_submit);
+#endif
+}
@@ -0,0 +1,17 @@
+#ifndef _GL4ES_WORKERS_H_
+#define _GL4ES_WORKERS_H_
+
+// Small pool of worker threads, used to split CPU heavy conversions
+// (texture decompression, mipmap generation...) in independent slices.
+// Number of threads is LIBGL_THREADS (globals4es.threads), the pool is created on first use.
+
+// process items [start, end[
+typedef void (*workers_func_t)(void* arg, int start, int end);
+
+// Run func on [0, count[, split in slices of at least minslice items, on the pool and on the calling thread.
+// Returns when everything is done. Falls back to a single func(arg, 0, count) call for small jobs.
+void workers_run(workers_func_t func, void* arg, int count, int minslice);
+// Stop and join the threads of the pool
+void workers_quit();
+
+#endif // _GL4ES_WORKERS_H_
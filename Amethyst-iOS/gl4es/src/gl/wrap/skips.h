@@ -36,6 +36,7 @@
 #define skip_glLogicOp
 
 #define skip_glColorMask
+#define skip_glClearColor
 #define skip_glClear
 
 // depth.c
@@ -76,6 +77,9 @@
 #define skip_glMaterialfv
 #define skip_glMaterialf
 
+// line.c
+#define skip_glLineWidth
+
 // raster.c
 #define skip_glViewport
 #define skip_glScissor
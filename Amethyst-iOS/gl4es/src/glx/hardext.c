@@ -1,5 +1,13 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // for dladdr
+#endif
+#include <dlfcn.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
 #include "hardext.h"
 
+#include "../../version.h"
 #include "../gl/debug.h"
 #include "../gl/gl4es.h"
 #include "../gl/init.h"
@@ -18,6 +26,114 @@ static int tested = 0;
 
 hardext_t hardext = {0};
 
+// ********* Cache of the hardware probe *********
+static const char HWC_SIGN[] = "GL4ES HardwareProbeCache";
+#define HWC_VERSION 2
+
+static char *hwc_name = NULL;
+
+void hardext_InitCache(const char* name)
+{
+    free(hwc_name);
+    hwc_name = name?strdup(name):NULL;
+}
+
+static void hwc_addlib(char* key, int size, const void* sym)
+{
+    // identify a driver library by its file, so a driver update invalidate the cache
+    Dl_info info;
+    struct stat st;
+    if(!sym || !dladdr(sym, &info) || !info.dli_fname)
+        return;
+    int l = strlen(key);
+    if(stat(info.dli_fname, &st)==0)
+        snprintf(key+l, size-l, "|%s:%lld:%lld", info.dli_fname, (long long)st.st_size, (long long)st.st_mtime);
+    else
+        snprintf(key+l, size-l, "|%s", info.dli_fname);
+}
+
+static void hwc_makekey(char* key, int size, const char* vendor, const char* renderer, const char* version, const void* sym1, const void* sym2)
+{
+    // everything the probe depends on: the driver and the settings that change what is tested
+    snprintf(key, size, "%d.%d.%d|%d|%s|%s|%s|es%d|%d%d%d%d%d%d",
+        MAJOR, MINOR, REVISION, (int)sizeof(hardext_t),
+        vendor?vendor:"", renderer?renderer:"", version?version:"",
+        globals4es.es, globals4es.nobgra, globals4es.nodepthtex, globals4es.floattex,
+        globals4es.nohighp, globals4es.noshaderlod, globals4es.usegbm);
+    hwc_addlib(key, size, sym1);
+    hwc_addlib(key, size, sym2);
+}
+
+static unsigned int hwc_checksum(const hardext_t* h)
+{
+    // so a damaged file is not taken for capabilities
+    const unsigned char* p = (const unsigned char*)h;
+    unsigned int sum = 2166136261u;
+    for (int i=0; i<(int)sizeof(hardext_t); ++i)
+        sum = (sum^p[i])*16777619u;
+    return sum;
+}
+
+static int hwc_read(const char* key)
+{
+    if(!hwc_name || globals4es.nohwcache)
+        return 0;
+    FILE *f = fopen(hwc_name, "rb");
+    if(!f)
+        return 0;
+    char tmp[sizeof(HWC_SIGN)];
+    int version = 0, len = 0;
+    unsigned int sum = 0;
+    hardext_t h;
+    int ok = 0;
+    if(fread(tmp, sizeof(HWC_SIGN), 1, f)==1 && strcmp(tmp, HWC_SIGN)==0
+     && fread(&version, sizeof(version), 1, f)==1 && version==HWC_VERSION
+     && fread(&len, sizeof(len), 1, f)==1 && len==(int)strlen(key)) {
+        char *k = (char*)malloc(len+1);
+        if(fread(k, len, 1, f)==1 && memcmp(k, key, len)==0
+         && fread(&h, sizeof(h), 1, f)==1
+         && fread(&sum, sizeof(sum), 1, f)==1 && sum==hwc_checksum(&h))
+            ok = 1;
+        free(k);
+    }
+    fclose(f);
+    if(!ok)
+        return 0;   // not the same hardware, driver or settings (or not a cache file)
+    memcpy(&hardext, &h, sizeof(hardext_t));
+    return 1;
+}
+
+static void hwc_write(const char* key)
+{
+    if(!hwc_name || globals4es.nohwcache==1)
+        return;
+    FILE *f = fopen(hwc_name, "wb");
+    if(!f)
+        return;
+    int version = HWC_VERSION;
+    int len = strlen(key);
+    unsigned int sum = hwc_checksum(&hardext);
+    if(fwrite(HWC_SIGN, sizeof(HWC_SIGN), 1, f)!=1
+     || fwrite(&version, sizeof(version), 1, f)!=1
+     || fwrite(&len, sizeof(len), 1, f)!=1
+     || fwrite(key, len, 1, f)!=1
+     || fwrite(&hardext, sizeof(hardext_t), 1, f)!=1
+     || fwrite(&sum, sizeof(sum), 1, f)!=1) {
+        fclose(f);
+        remove(hwc_name);   // don't leave a partial file
+        return;
+    }
+    fclose(f);
+}
+
+static void hwc_loaded()
+{
+    // settings that the probe also changes
+    if(!hardext.glsl300es)
+        globals4es.vgpu_backport = 1;
+    SHUT_LOGD("Hardware capabilities loaded from cache (GLES %s, %d texture units, max texture size %d)\n", (hardext.esversion==1)?"1.1":"2.0", hardext.maxtex, hardext.maxsize);
+}
+
 int testGenericShader(struct shader_s* shader_source) {
     // check the current shader is valid for compilation
     LOAD_GLES2(glCreateShader);
@@ -150,8 +266,18 @@ void GetHardwareExtensions(int notest)
 #if defined(BCMHOST) && !defined(ANDROID)
     rpi_init();
 #endif
+    char hwc_key[1024];
 #ifdef NOEGL
     SHUT_LOGD("Hardware test on current Context...\n");
+    {
+        LOAD_GLES(glGetString);
+        hwc_makekey(hwc_key, sizeof(hwc_key), (const char*)gles_glGetString(GL_VENDOR), (const char*)gles_glGetString(GL_RENDERER), (const char*)gles_glGetString(GL_VERSION), gles_glGetString, NULL);
+        if(hwc_read(hwc_key)) {
+            tested = 1;
+            hwc_loaded();
+            return;
+        }
+    }
 #else
     // used EGL & GLES functions
     LOAD_EGL(eglBindAPI);
@@ -227,6 +353,17 @@ void GetHardwareExtensions(int notest)
         egl_eglTerminate(eglDisplay);
         return;
     }
+    {
+        // no need to create a context if that driver has already been probed
+        LOAD_GLES(glGetString);
+        hwc_makekey(hwc_key, sizeof(hwc_key), egl_eglQueryString(eglDisplay, EGL_VENDOR), egl_eglQueryString(eglDisplay, EGL_CLIENT_APIS), egl_eglQueryString(eglDisplay, EGL_VERSION), egl_eglInitialize, gles_glGetString);
+        if(hwc_read(hwc_key)) {
+            egl_eglTerminate(eglDisplay);
+            tested = 1;
+            hwc_loaded();
+            return;
+        }
+    }
 
     egl_eglChooseConfig(eglDisplay, configAttribs, pbufConfigs, 1, &configsFound);
 #ifndef NO_GBM
@@ -325,6 +462,7 @@ void GetHardwareExtensions(int notest)
     S("GL_OES_depth24 ", depth24, 1);
     S("GL_OES_rgb8_rgba8 ", rgba8, 1);
     S("GL_EXT_multi_draw_arrays ", multidraw, 0);
+    S("GL_EXT_occlusion_query_boolean ", occlusionquery, 1);
     if(!globals4es.nobgra) {
         S("GL_EXT_texture_format_BGRA8888 ", bgra8888, 1);
     }
@@ -488,4 +626,5 @@ void GetHardwareExtensions(int notest)
 
     egl_eglTerminate(eglDisplay);
 #endif
+    hwc_write(hwc_key);
 }
@@ -44,6 +44,7 @@ typedef struct _hardext {
     int srgb;           // EGL_KHR_gl_colorspace
     int mapbuffer;      // GL_OES_mapbuffer
     int drawbuffers;    // GL_EXT_draw_buffers
+    int occlusionquery; // GL_EXT_occlusion_query_boolean
     // es2 stuffs
     int esversion;      // 1 is ES1.1 backend, 2 is ES2
     int maxvattrib;     // GL_MAX_VERTEX_ATTRIBS (or 0 if not using es2)
@@ -73,6 +74,8 @@ typedef struct _hardext {
 extern hardext_t hardext;
 
 void GetHardwareExtensions(int test);
+// where to save the result of the probe (NULL for no cache), must be called before GetHardwareExtensions
+void hardext_InitCache(const char* name);
 int testGenericShader(struct shader_s * shader_source);
 
 #endif
@@ -0,0 +1,186 @@
+// glBitmap check, on a software GLES driver (swgles.c).
+//
+// The pbuffer must be exactly what GL draws: the set bits of each bitmap in the current color, at the
+// raster position minus the origin, the 0 bits leaving the framebuffer untouched. Checked for text
+// drawn again from the glyph atlas, text clipped by the viewport, overlapping glyphs, big bitmaps
+// (not in the atlas) mixed with glyphs, display lists and more glyphs than the atlas can hold.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "swgles.h"
+
+#define W 256
+#define H 256
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static GLubyte ref[W*H*4];
+static GLubyte ref_color[4];
+static float ref_x, ref_y;
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static GLubyte* random_bits(int width, int height) {
+    int sz = ((width+7)/8)*height;
+    GLubyte *bits = malloc(sz);
+    for (int i=0; i<sz; ++i)
+        bits[i] = rnd();
+    return bits;
+}
+
+static void clear() {
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (int i=0; i<W*H; ++i) {
+        ref[i*4+0] = ref[i*4+1] = ref[i*4+2] = 51;
+        ref[i*4+3] = 255;
+    }
+}
+
+// only full intensity colors, so the expected values don't depend on the rounding
+static void color(int c) {
+    const GLubyte col[4] = {(c&1)?255:0, (c&2)?255:0, (c&4)?255:0, 255};
+    glColor4ub(col[0], col[1], col[2], col[3]);
+    memcpy(ref_color, col, 4);
+}
+
+static void pos(float x, float y) {
+    glWindowPos2f(x, y);
+    ref_x = x;
+    ref_y = y;
+}
+
+static void ref_bitmap(int width, int height, float xorig, float yorig, float xmove, float ymove, const GLubyte *bits) {
+    int rx = (int)(ref_x-xorig), ry = (int)(ref_y-yorig);
+    for (int y=0; y<height; ++y)
+        for (int x=0; x<width; ++x)
+            if(bits[y*((width+7)/8)+x/8] & (0x80>>(x%8)))
+                if(rx+x>=0 && rx+x<W && ry+y>=0 && ry+y<H)
+                    memcpy(ref+4*(rx+x+(ry+y)*W), ref_color, 4);
+    ref_x += xmove;
+    ref_y += ymove;
+}
+
+static void bitmap(int width, int height, float xorig, float yorig, float xmove, float ymove, const GLubyte *bits) {
+    glBitmap(width, height, xorig, yorig, xmove, ymove, bits);
+    ref_bitmap(width, height, xorig, yorig, xmove, ymove, bits);
+}
+
+#define NGLYPHS 32
+static GLubyte *font[NGLYPHS];
+
+static void text(float x, float y, int c, const char *s) {
+    color(c);
+    pos(x, y);
+    for (; *s; ++s)
+        bitmap(8, 13, 0, 2, 9, 0, font[*s%NGLYPHS]);
+}
+
+static void check_text() {
+    static const char *lines[] = {"The quick brown fox", "jumps over the lazy", "dog, 0123456789!?"};
+    for (int frame=0; frame<3; ++frame) {
+        clear();
+        for (int i=0; i<3; ++i)
+            text(4, 200-20*i, i+1, lines[i]);
+        text(10.5f, 100.75f, 7, lines[0]);
+        char what[32];
+        sprintf(what, "text, frame %d", frame);
+        CHECK(!sw_compare(ref, what), "wrong text");
+    }
+}
+
+static void check_clipped() {
+    clear();
+    text(-20, 120, 3, "left clipped");
+    text(200, 130, 5, "right clipped");
+    text(60, -6, 6, "bottom clipped");
+    text(60, 250, 1, "top clipped");
+    text(-100, 150, 2, "outside");
+    CHECK(!sw_compare(ref, "clipped text"), "wrong clipped text");
+}
+
+static void check_overlap() {
+    clear();
+    for (int i=0; i<NGLYPHS; ++i) {
+        color(1+i%7);
+        pos(100+(i%4), 100+(i/4)%3);
+        bitmap(8, 13, 0, 0, 0, 0, font[i]);
+    }
+    CHECK(!sw_compare(ref, "overlapping glyphs"), "wrong overlapping glyphs");
+}
+
+static void check_big() {
+    GLubyte *big = random_bits(200, 150);
+    clear();
+    for (int i=0; i<6; ++i) {
+        text(5+i*3, 20+i*30, 1+i%7, "glyphs");
+        color(7-i%7);
+        pos(10+i*5, 8+i*4);
+        bitmap(200, 150, 0, 0, 0, 0, big);
+    }
+    text(30, 60, 2, "on top");
+    CHECK(!sw_compare(ref, "big bitmaps and glyphs"), "wrong big bitmaps and glyphs");
+    free(big);
+}
+
+static void check_list() {
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    for (int i=0; i<10; ++i)
+        glBitmap(8, 13, 0, 2, 9, 0, font[i]);
+    glEndList();
+    clear();
+    for (int l=0; l<3; ++l) {
+        color(l+4);
+        pos(20, 40+l*50);
+        glCallList(list);
+        for (int i=0; i<10; ++i)
+            ref_bitmap(8, 13, 0, 2, 9, 0, font[i]);
+        // and continue after it
+        bitmap(8, 13, 0, 2, 9, 0, font[20]);
+    }
+    CHECK(!sw_compare(ref, "display list"), "wrong display list");
+    glDeleteLists(list, 1);
+}
+
+static void check_overflow() {
+    // far more 16x16 glyphs than the 512x512 atlas can hold, drawn over each other
+    clear();
+    for (int i=0; i<1200; ++i) {
+        GLubyte *bits = random_bits(16, 16);
+        color(1+i%7);
+        pos((i*16)%W, ((i*16)/W)*12%H);
+        bitmap(16, 16, 0, 0, 16, 0, bits);
+        free(bits);
+    }
+    CHECK(!sw_compare(ref, "atlas overflow"), "wrong atlas overflow");
+}
+
+int main(int argc, char **argv) {
+    if(!sw_init(W, H))
+        return SW_SKIP;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i=0; i<NGLYPHS; ++i)
+        font[i] = random_bits(8, 13);
+    check_text();
+    check_clipped();
+    check_overlap();
+    check_big();
+    check_list();
+    check_overflow();
+    check_text();   // after the atlas was reset
+    for (int i=0; i<NGLYPHS; ++i)
+        free(font[i]);
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,239 @@
+// Blit check, on a software GLES driver (swgles.c).
+//
+// glBlitFramebuffer goes through gl4es_blitTexture, which keeps its programs, quad and uniforms from
+// one blit to the next, and only turns off (and back on) the states that are on:
+// - many blits per frame, of random rectangles (also zoomed x2), must copy what a CPU model copies,
+//   whatever the depth test, blending, culling, bound textures, active texture unit or GLSL program
+// - after each blit, a quad drawn with these states must give what they give: the blit must
+//   leave the GLES states as gl4es thinks they are
+// - on GLES2, deleting a gl4es state deletes its blit programs, shaders and quad buffer
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "swgles.h"
+#include "gl/gl4es.h"
+#include "gl/loader.h"
+
+// from gl4es (see glx.c)
+void* NewGLState(void* shared_glstate, int es2only);
+void ActivateGLState(void* new_glstate);
+void DeleteGLState(void* oldstate);
+
+#define W 128
+#define H 128
+#define SRC 40
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static GLubyte ref[W*H*4];
+static GLubyte src[SRC*SRC*4];
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static const GLubyte white[4] = {255, 255, 255, 255};
+static const GLubyte green[4] = {0, 255, 0, 255};
+
+// a W x H color texture and a depth buffer, or the SRC x SRC image
+static GLuint make_fbo(int dst) {
+    GLuint fbo, tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    if(dst)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, W, H, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SRC, SRC, 0, GL_RGBA, GL_UNSIGNED_BYTE, src);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+    if(dst) {
+        GLuint depth;
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, W, H);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    }
+    CHECK(glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE, "incomplete %s framebuffer", dst?"destination":"source");
+    return fbo;
+}
+
+static void ref_rect(int x, int y, int w, int h, const GLubyte *color) {
+    for (int j=y; j<y+h; ++j)
+        for (int i=x; i<x+w; ++i)
+            memcpy(ref+4*(i+j*W), color, 4);
+}
+
+static void blit(GLuint from, GLuint to, int zoom) {
+    const int w = 1+rnd()%(SRC/2), h = 1+rnd()%(SRC/2);
+    const int sx = rnd()%(SRC-w), sy = rnd()%(SRC-h);
+    const int dx = rnd()%(W-w*zoom), dy = rnd()%(H-h*zoom);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, from);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to);
+    glBlitFramebuffer(sx, sy, sx+w, sy+h, dx, dy, dx+w*zoom, dy+h*zoom, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, to);
+    for (int j=0; j<h*zoom; ++j)
+        for (int i=0; i<w*zoom; ++i)
+            memcpy(ref+4*(dx+i+(dy+j)*W), src+4*(sx+i/zoom+(sy+j/zoom)*SRC), 4);
+}
+
+static GLuint compile(GLenum type, const char *src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, NULL);
+    glCompileShader(s);
+    return s;
+}
+
+static GLuint make_program() {
+    const char *vs =
+        "attribute vec2 pos;\n"
+        "void main() {\n"
+        "    gl_Position = vec4(pos, 0.0, 1.0);\n"
+        "}\n";
+    const char *fs =
+        "void main() {\n"
+        "    gl_FragColor = vec4(0.0, 0.0, 1.0, 1.0);\n"
+        "}\n";
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, compile(GL_VERTEX_SHADER, vs));
+    glAttachShader(prog, compile(GL_FRAGMENT_SHADER, fs));
+    glLinkProgram(prog);
+    GLint linked = 0;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    CHECK(linked, "program not linked");
+    return prog;
+}
+
+static void check_blits() {
+    GLuint from = make_fbo(0), to = make_fbo(1);
+    GLuint prog = (hardext.esversion>1)?make_program():0;
+    // a green texture, to draw the quads with when GL_TEXTURE_2D is on
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, green);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glColor4ub(255, 255, 255, 255);
+    glDepthFunc(GL_NEVER);
+    glBlendFunc(GL_ZERO, GL_ONE);
+    glCullFace(GL_FRONT_AND_BACK);
+    glMatrixMode(GL_PROJECTION);
+    glOrtho(0, W, 0, H, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glBindFramebuffer(GL_FRAMEBUFFER, to);
+    glViewport(0, 0, W, H);
+    for (int frame=0; frame<40; ++frame) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+        memset(ref, 0, sizeof(ref));
+        for (int b=0; b<8; ++b) {
+            const int depth = !(rnd()%4), blend = !(rnd()%4), cull = !(rnd()%4);
+            const int texture = rnd()%2, unit = rnd()%2, useprog = prog && !(rnd()%3);
+            if(depth) glEnable(GL_DEPTH_TEST);
+            if(blend) glEnable(GL_BLEND);
+            if(cull) glEnable(GL_CULL_FACE);
+            if(texture) {
+                glBindTexture(GL_TEXTURE_2D, tex);
+                glEnable(GL_TEXTURE_2D);
+            }
+            if(unit) glActiveTexture(GL_TEXTURE1);
+            if(useprog) glUseProgram(prog);
+            blit(from, to, 1+rnd()%2);
+            if(useprog) glUseProgram(0);
+            if(unit) glActiveTexture(GL_TEXTURE0);
+            // a quad, drawn only if nothing discards it (white: with GL_OES_draw_texture, the blits of
+            // Mesa are modulated by the color of the last draw, not by the one the blit sets)
+            const int x = rnd()%(W-8), y = rnd()%(H-8);
+            glBegin(GL_QUADS);
+            glTexCoord2f(0.5f, 0.5f);
+            glVertex2i(x, y); glVertex2i(x+8, y); glVertex2i(x+8, y+8); glVertex2i(x, y+8);
+            glEnd();
+            if(!depth && !blend && !cull)
+                ref_rect(x, y, 8, 8, texture?green:white);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_BLEND);
+            glDisable(GL_CULL_FACE);
+            glDisable(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        char what[32];
+        sprintf(what, "frame %d", frame);
+        CHECK(!sw_compare(ref, what), "wrong blits, frame %d", frame);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &from);
+    glDeleteFramebuffers(1, &to);
+    glDeleteTextures(1, &tex);
+    if(prog)
+        glDeleteProgram(prog);
+}
+
+// gone, or flagged for deletion when still in use
+static int deleted_program(GLuint id) {
+    LOAD_GLES2(glIsProgram);
+    LOAD_GLES2(glGetProgramiv);
+    GLint flag = 0;
+    if(gles_glIsProgram(id))
+        gles_glGetProgramiv(id, GL_DELETE_STATUS, &flag);
+    else
+        flag = 1;
+    return flag;
+}
+
+static int deleted_shader(GLuint id) {
+    LOAD_GLES2(glIsShader);
+    LOAD_GLES2(glGetShaderiv);
+    GLint flag = 0;
+    if(gles_glIsShader(id))
+        gles_glGetShaderiv(id, GL_DELETE_STATUS, &flag);
+    else
+        flag = 1;
+    return flag;
+}
+
+static void check_delete() {
+    LOAD_GLES(glIsBuffer);
+    void *main_state = glstate;
+    void *state = NewGLState(NULL, 0);
+    ActivateGLState(state);
+    GLuint from = make_fbo(0), to = make_fbo(1);
+    glViewport(0, 0, W, H);
+    blit(from, to, 1);
+    CHECK(glstate->blit && glstate->blit->prog[0].program && glstate->blit->quad, "no blit program");
+    if(!glstate->blit)
+        return;
+    glesblit_t blit = *glstate->blit;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ActivateGLState(main_state);
+    DeleteGLState(state);
+    CHECK(deleted_program(blit.prog[0].program), "blit program not deleted");
+    CHECK(deleted_shader(blit.prog[0].pixelshader), "blit fragment shader not deleted");
+    CHECK(deleted_shader(blit.vertexshader), "blit vertex shader not deleted");
+    CHECK(!gles_glIsBuffer(blit.quad), "blit quad buffer not deleted");
+}
+
+int main(int argc, char **argv) {
+    if(!sw_init(W, H))
+        return SW_SKIP;
+    for (int i=0; i<SRC*SRC*4; ++i)
+        src[i] = rnd();
+    check_blits();
+    if(hardext.esversion>1)
+        check_delete();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
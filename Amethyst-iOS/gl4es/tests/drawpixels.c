@@ -0,0 +1,283 @@
+// glDrawPixels check, on a software GLES driver (swgles.c).
+//
+// An image drawn again comes from the cache of glDrawPixels textures (from its second draw), so the
+// pbuffer must stay what GL draws, and what an uncached draw gives:
+// - against a CPU model: RGBA, BGRA, RGB, LUMINANCE and LUMINANCE_ALPHA images, the same bytes in
+//   another format, pixels changed in place (also in the skipped rows), row length and skip, zoom
+// - against the same image in a display list (never cached): pixel transfer scale and bias, and
+//   pixel maps of color index images (also against the CPU model), changed between the draws
+// - many images, more than the cache holds, drawn again in another order
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "swgles.h"
+
+#define W 256
+#define H 256
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static GLubyte ref[W*H*4];
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static GLubyte* random_image(int size) {
+    GLubyte *p = malloc(size);
+    for (int i=0; i<size; ++i)
+        p[i] = rnd();
+    return p;
+}
+
+static void clear() {
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (int i=0; i<W*H; ++i) {
+        ref[i*4+0] = ref[i*4+1] = ref[i*4+2] = 51;
+        ref[i*4+3] = 255;
+    }
+}
+
+static int components(GLenum format) {
+    switch (format) {
+        case GL_RGBA: case GL_BGRA: return 4;
+        case GL_RGB: return 3;
+        case GL_LUMINANCE_ALPHA: return 2;
+    }
+    return 1;
+}
+
+// GL_UNSIGNED_BYTE image at an integer raster position, rows of rowlength pixels (0 is width),
+// packed (alignment 1)
+static void ref_drawpixels(int x, int y, int width, int height, GLenum format, const GLubyte *data,
+                           int rowlength, int skip_pixels, int skip_rows, int zoom) {
+    const int n = components(format);
+    if(!rowlength) rowlength = width;
+    for (int j=0; j<height; ++j)
+        for (int i=0; i<width; ++i) {
+            const GLubyte *s = data+n*(skip_pixels+i+(skip_rows+j)*rowlength);
+            GLubyte c[4];
+            switch (format) {
+                case GL_RGBA: memcpy(c, s, 4); break;
+                case GL_BGRA: c[0] = s[2]; c[1] = s[1]; c[2] = s[0]; c[3] = s[3]; break;
+                case GL_RGB: memcpy(c, s, 3); c[3] = 255; break;
+                case GL_LUMINANCE_ALPHA: c[0] = c[1] = c[2] = s[0]; c[3] = s[1]; break;
+                default: c[0] = c[1] = c[2] = s[0]; c[3] = 255;
+            }
+            for (int zy=0; zy<zoom; ++zy)
+                for (int zx=0; zx<zoom; ++zx) {
+                    int px = x+i*zoom+zx, py = y+j*zoom+zy;
+                    if(px>=0 && px<W && py>=0 && py<H)
+                        memcpy(ref+4*(px+py*W), c, 4);
+                }
+        }
+}
+
+static void drawpixels(int x, int y, int width, int height, GLenum format, const GLubyte *data) {
+    glWindowPos2i(x, y);
+    glDrawPixels(width, height, format, GL_UNSIGNED_BYTE, data);
+    ref_drawpixels(x, y, width, height, format, data, 0, 0, 0, 1);
+}
+
+static void check_formats() {
+    static const GLenum formats[] = {GL_RGBA, GL_BGRA, GL_RGB, GL_LUMINANCE, GL_LUMINANCE_ALPHA};
+    GLubyte *img = random_image(45*47*4);
+    for (int frame=0; frame<4; ++frame) {
+        clear();
+        for (int f=0; f<5; ++f) {
+            // the same bytes in each format
+            drawpixels(3+f*50, 10, 45, 47, formats[f], img);
+            // and another image per format
+            GLubyte *other = random_image(31*29*4);
+            memset(other, f*40, 64);
+            drawpixels(3+f*50, 100, 31, 29, formats[f], other);
+            free(other);
+        }
+        // changed in place
+        img[frame*5] ^= 0xff;
+        drawpixels(40, 160, 45, 47, GL_RGBA, img);
+        char what[32];
+        sprintf(what, "formats, frame %d", frame);
+        CHECK(!sw_compare(ref, what), "wrong formats");
+    }
+    free(img);
+}
+
+static void check_unpack() {
+    // row length, skip pixels and skip rows, with changes in the rows after the first rowlength*height pixels
+    const int width = 40, height = 30, rowlength = 53, skip_pixels = 5, skip_rows = 7;
+    GLubyte *img = random_image(rowlength*(height+skip_rows)*4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowlength);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, skip_pixels);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, skip_rows);
+    for (int frame=0; frame<4; ++frame) {
+        clear();
+        glWindowPos2i(20, 20);
+        glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, img);
+        ref_drawpixels(20, 20, width, height, GL_RGBA, img, rowlength, skip_pixels, skip_rows, 1);
+        char what[32];
+        sprintf(what, "unpack, frame %d", frame);
+        CHECK(!sw_compare(ref, what), "wrong unpacked image");
+        // a pixel of the last row
+        memset(img+4*(skip_pixels+frame+(skip_rows+height-1)*rowlength), frame*60, 4);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    free(img);
+}
+
+static void check_zoom() {
+    GLubyte *img = random_image(50*40*4);
+    for (int frame=0; frame<3; ++frame) {
+        clear();
+        glWindowPos2i(10, 10);
+        glPixelZoom(2.0f, 2.0f);
+        glDrawPixels(50, 40, GL_RGBA, GL_UNSIGNED_BYTE, img);
+        ref_drawpixels(10, 10, 50, 40, GL_RGBA, img, 0, 0, 0, 2);
+        glPixelZoom(1.0f, 1.0f);
+        drawpixels(150, 150, 50, 40, GL_RGBA, img);
+        char what[32];
+        sprintf(what, "zoom, frame %d", frame);
+        CHECK(!sw_compare(ref, what), "wrong zoomed image");
+    }
+    free(img);
+}
+
+// the image drawn directly (cached after the first time) must be the same as in a display list
+static void check_as_list(int width, int height, GLenum format, const GLubyte *img, const char *what) {
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    glDrawPixels(width, height, format, GL_UNSIGNED_BYTE, img);
+    glEndList();
+    GLubyte *expected = malloc(W*H*4);
+    clear();
+    glWindowPos2i(30, 30);
+    glCallList(list);
+    sw_read(expected);
+    for (int i=0; i<3; ++i) {
+        clear();
+        glWindowPos2i(30, 30);
+        glDrawPixels(width, height, format, GL_UNSIGNED_BYTE, img);
+        char w[64];
+        sprintf(w, "%s, draw %d", what, i);
+        CHECK(!sw_compare(expected, w), "%s: not the same as a display list", what);
+    }
+    glDeleteLists(list, 1);
+    free(expected);
+}
+
+static void check_transfer() {
+    GLubyte *img = random_image(64*64*4);
+    check_as_list(64, 64, GL_RGBA, img, "no transfer");
+    glPixelTransferf(GL_RED_SCALE, 0.5f);
+    check_as_list(64, 64, GL_RGBA, img, "red scale");
+    glPixelTransferf(GL_GREEN_BIAS, 0.25f);
+    check_as_list(64, 64, GL_RGBA, img, "red scale, green bias");
+    glPixelTransferf(GL_RED_SCALE, 1.0f);
+    glPixelTransferf(GL_GREEN_BIAS, 0.0f);
+    check_as_list(64, 64, GL_RGBA, img, "back to no transfer");
+    // and the CPU model, for the identity
+    clear();
+    drawpixels(30, 30, 64, 64, GL_RGBA, img);
+    CHECK(!sw_compare(ref, "back to no transfer"), "wrong image after the pixel transfer");
+    free(img);
+}
+
+static void check_pixelmap() {
+    GLubyte *img = random_image(64*64);
+    GLfloat map[4][256];
+    for (int pal=0; pal<3; ++pal) {
+        for (int c=0; c<4; ++c)
+            for (int i=0; i<256; ++i)
+                map[c][i] = (c==3)?1.0f:((i*(c+1)+pal*85)%256)/255.0f;
+        glPixelMapfv(GL_PIXEL_MAP_I_TO_R, 256, map[0]);
+        glPixelMapfv(GL_PIXEL_MAP_I_TO_G, 256, map[1]);
+        glPixelMapfv(GL_PIXEL_MAP_I_TO_B, 256, map[2]);
+        glPixelMapfv(GL_PIXEL_MAP_I_TO_A, 256, map[3]);
+        char what[32];
+        sprintf(what, "palette %d", pal);
+        check_as_list(64, 64, GL_COLOR_INDEX, img, what);
+        // and the CPU model
+        GLubyte *rgba = malloc(64*64*4);
+        for (int i=0; i<64*64; ++i)
+            for (int c=0; c<4; ++c)
+                rgba[i*4+c] = (GLubyte)(map[c][img[i]]*255.0f);
+        clear();
+        glWindowPos2i(30, 30);
+        glDrawPixels(64, 64, GL_COLOR_INDEX, GL_UNSIGNED_BYTE, img);
+        ref_drawpixels(30, 30, 64, 64, GL_RGBA, rgba, 0, 0, 0, 1);
+        free(rgba);
+        CHECK(!sw_compare(ref, what), "wrong colors for %s", what);
+    }
+    free(img);
+}
+
+static void check_eviction() {
+    // 80 256x256 images, each drawn twice so it's cached: more than the cache holds
+    #define NIMAGES 80
+    GLubyte *img[NIMAGES];
+    for (int i=0; i<NIMAGES; ++i)
+        img[i] = random_image(256*256*4);
+    for (int pass=0; pass<3; ++pass)
+        for (int n=0; n<NIMAGES; ++n) {
+            const int i = (pass==2)?(NIMAGES-1-n):n;
+            clear();
+            drawpixels(0, 0, 256, 256, GL_RGBA, img[i]);
+            drawpixels(0, 0, 256, 256, GL_RGBA, img[i]);
+            drawpixels(100, 100, 64, 64, GL_RGBA, img[(i*7)%NIMAGES]);
+            char what[32];
+            sprintf(what, "image %d, pass %d", i, pass);
+            if(sw_compare(ref, what)) {
+                CHECK(0, "wrong image %d, pass %d", i, pass);
+                break;
+            }
+        }
+    for (int i=0; i<NIMAGES; ++i)
+        free(img[i]);
+}
+
+static void check_list() {
+    GLubyte *img = random_image(32*32*4);
+    GLuint list = glGenLists(1);
+    glNewList(list, GL_COMPILE);
+    glDrawPixels(32, 32, GL_RGBA, GL_UNSIGNED_BYTE, img);
+    glEndList();
+    for (int frame=0; frame<3; ++frame) {
+        clear();
+        glWindowPos2i(10, 10);
+        glCallList(list);
+        ref_drawpixels(10, 10, 32, 32, GL_RGBA, img, 0, 0, 0, 1);
+        drawpixels(60, 10, 32, 32, GL_RGBA, img);
+        glWindowPos2i(110, 10);
+        glCallList(list);
+        ref_drawpixels(110, 10, 32, 32, GL_RGBA, img, 0, 0, 0, 1);
+        CHECK(!sw_compare(ref, "display list"), "wrong display list");
+    }
+    glDeleteLists(list, 1);
+    free(img);
+}
+
+int main(int argc, char **argv) {
+    if(!sw_init(W, H))
+        return SW_SKIP;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    check_formats();
+    check_unpack();
+    check_zoom();
+    check_transfer();
+    check_pixelmap();
+    check_eviction();
+    check_list();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,223 @@
+// glEvalMesh check and benchmark, against the GLES2 mock (mockgles.c) capturing what is drawn.
+//
+//   evalmesh          compare the meshes drawn by glEvalMesh (cached in VBOs after the first
+//                     draws) with the same meshes compiled in a display list (glEvalCoord path)
+//   evalmesh bench    time frames of 32 bicubic patches, static and animated
+//
+// Run it with LIBGL_NOSIMD=1 too, to check the scalar evaluator.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mockgles.h"
+
+// ---- scenes ----
+
+static GLfloat patch[4][4][3], rat[3][4][4], col[2][2][4], tex2[2][2][2], nrm[3][3][3], tex1[3];
+static GLfloat curve[4][3], ccol[2][4];
+
+static void set_maps() {
+    for (int i=0; i<4; ++i)
+        for (int j=0; j<4; ++j) {
+            patch[i][j][0] = i; patch[i][j][1] = j; patch[i][j][2] = sinf(i*1.3f+j*0.7f);
+        }
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<4; ++j) {
+            rat[i][j][0] = i; rat[i][j][1] = j*0.5f; rat[i][j][2] = cosf(i+j); rat[i][j][3] = 1.0f+0.3f*((i+j)&1);
+        }
+    for (int i=0; i<2; ++i)
+        for (int j=0; j<2; ++j) {
+            col[i][j][0] = i; col[i][j][1] = j; col[i][j][2] = 0.5f; col[i][j][3] = 1.0f;
+            tex2[i][j][0] = i*2; tex2[i][j][1] = j*3;
+        }
+    for (int i=0; i<3; ++i)
+        for (int j=0; j<3; ++j) {
+            nrm[i][j][0] = i*0.1f; nrm[i][j][1] = j*0.2f; nrm[i][j][2] = 1.0f;
+        }
+    tex1[0] = 0.0f; tex1[1] = 0.7f; tex1[2] = 1.0f;
+    for (int i=0; i<4; ++i) {
+        curve[i][0] = i; curve[i][1] = (i&1)?2.0f:-1.0f; curve[i][2] = i*0.25f;
+    }
+    ccol[0][0] = 1.0f; ccol[0][3] = 1.0f; ccol[1][2] = 1.0f; ccol[1][3] = 1.0f;
+    glMap2f(GL_MAP2_VERTEX_3, 0, 1, 3, 4, 0, 1, 12, 4, &patch[0][0][0]);
+    glMap2f(GL_MAP2_VERTEX_4, 0.2f, 0.9f, 4, 4, 0.1f, 0.8f, 16, 3, &rat[0][0][0]);
+    glMap2f(GL_MAP2_COLOR_4, 0, 1, 4, 2, 0, 1, 8, 2, &col[0][0][0]);
+    glMap2f(GL_MAP2_TEXTURE_COORD_2, 0, 1, 2, 2, 0, 1, 4, 2, &tex2[0][0][0]);
+    glMap2f(GL_MAP2_NORMAL, 0, 1, 3, 3, 0, 1, 9, 3, &nrm[0][0][0]);
+    glMap2f(GL_MAP2_TEXTURE_COORD_1, 0, 1, 1, 3, 0, 1, 3, 1, tex1);
+    glMap1f(GL_MAP1_VERTEX_3, 0, 1, 3, 4, &curve[0][0]);
+    glMap1f(GL_MAP1_COLOR_4, 0, 1, 4, 2, &ccol[0][0]);
+}
+
+static void reset() {
+    static const GLenum caps[] = {GL_MAP2_VERTEX_3, GL_MAP2_VERTEX_4, GL_MAP2_COLOR_4, GL_MAP2_NORMAL, GL_MAP2_TEXTURE_COORD_1,
+                                  GL_MAP2_TEXTURE_COORD_2, GL_MAP1_VERTEX_3, GL_MAP1_COLOR_4, GL_AUTO_NORMAL};
+    for (int i=0; i<sizeof(caps)/sizeof(caps[0]); ++i)
+        glDisable(caps[i]);
+}
+
+typedef struct {
+    const char *name;
+    GLenum enable[4];
+    int dims;
+    GLenum mode;
+    GLint un, i1, i2, vn, j1, j2;     // glMapGrid and glEvalMesh parameters
+    GLfloat u1, u2, v1, v2;
+} scene_t;
+
+static const scene_t scenes[] = {
+    {"plain",        {GL_MAP2_VERTEX_3}, 2, GL_FILL, 8, 0, 8, 6, 0, 6, 0, 1, 0, 1},
+    {"auto normal",  {GL_MAP2_VERTEX_3, GL_MAP2_COLOR_4, GL_MAP2_TEXTURE_COORD_2, GL_AUTO_NORMAL}, 2, GL_FILL, 10, 0, 10, 7, 0, 7, 0, 1, 0, 1},
+    {"rational",     {GL_MAP2_VERTEX_4, GL_AUTO_NORMAL}, 2, GL_FILL, 12, 2, 7, 9, 1, 5, 0.2f, 0.9f, 0.1f, 0.8f},
+    {"points",       {GL_MAP2_VERTEX_3, GL_MAP2_COLOR_4, GL_MAP2_TEXTURE_COORD_2, GL_AUTO_NORMAL}, 2, GL_POINT, 10, 0, 10, 7, 0, 7, 0, 1, 0, 1},
+    {"normal map",   {GL_MAP2_VERTEX_3, GL_MAP2_NORMAL, GL_MAP2_TEXTURE_COORD_1}, 2, GL_FILL, 5, 0, 5, 4, 0, 4, 0, 1, 0, 1},
+    {"lines",        {GL_MAP2_VERTEX_3, GL_MAP2_COLOR_4}, 2, GL_LINE, 6, 0, 6, 5, 0, 5, 0, 1, 0, 1},
+    {"curve",        {GL_MAP1_VERTEX_3, GL_MAP1_COLOR_4}, 1, GL_LINE, 20, 0, 20, 0, 0, 0, 0, 1, 0, 0},
+    {"curve points", {GL_MAP1_VERTEX_3}, 1, GL_POINT, 20, 3, 17, 0, 0, 0, 0, 1, 0, 0},
+};
+
+static void eval_mesh(const scene_t *sc) {
+    if(sc->dims==2)
+        glEvalMesh2(sc->mode, sc->i1, sc->i2, sc->j1, sc->j2);
+    else
+        glEvalMesh1(sc->mode, sc->i1, sc->i2);
+}
+
+// draw the scene and return the captured vertices (mock_captured() floats)
+static float* draw_scene(const scene_t *sc, int list) {
+    reset();
+    for (int i=0; i<4 && sc->enable[i]; ++i)
+        glEnable(sc->enable[i]);
+    if(sc->dims==2)
+        glMapGrid2f(sc->un, sc->u1, sc->u2, sc->vn, sc->v1, sc->v2);
+    else
+        glMapGrid1f(sc->un, sc->u1, sc->u2);
+    mock_capture(1);
+    if(list) {
+        // the mesh is evaluated when the list is compiled, through glEvalCoord / glEvalPoint
+        glNewList(1, GL_COMPILE);
+        eval_mesh(sc);
+        glEndList();
+        glCallList(1);
+    } else
+        eval_mesh(sc);
+    glFinish();
+    mock_capture(0);
+    float *ret = malloc(mock_captured()*sizeof(float)+1);
+    memcpy(ret, mock_capture_data(), mock_captured()*sizeof(float));
+    return ret;
+}
+
+static int check() {
+    int bad = 0;
+    for (int s=0; s<sizeof(scenes)/sizeof(scenes[0]); ++s) {
+        float *ref = draw_scene(&scenes[s], 1);
+        long ref_n = mock_captured();
+        // the first draws evaluate directly, the next ones are cached in a VBO
+        for (int d=0; d<3; ++d) {
+            float *got = draw_scene(&scenes[s], 0);
+            double worst = 0.0;
+            if(mock_captured()!=ref_n) {
+                printf("%s, draw %d: %ld vertices, expected %ld\n", scenes[s].name, d, mock_captured()/MOCK_CAP_SIZE, ref_n/MOCK_CAP_SIZE);
+                ++bad;
+                free(got);
+                continue;
+            }
+            for (long i=0; i<ref_n; ++i) {
+                if(got[i]==MOCK_NOT_ARRAY || ref[i]==MOCK_NOT_ARRAY) {
+                    // the vertex is always an array, the other attributes can be a current value in both
+                    if((got[i]==MOCK_NOT_ARRAY)!=(ref[i]==MOCK_NOT_ARRAY) && i%MOCK_CAP_SIZE>=4)
+                        worst = INFINITY;
+                    continue;
+                }
+                double diff = fabs(got[i]-ref[i])/(1.0+fabs(ref[i]));
+                if(diff>worst) worst = diff;
+            }
+            if(worst>2e-5) {
+                printf("%s, draw %d: max relative difference %g\n", scenes[s].name, d, worst);
+                ++bad;
+            }
+            free(got);
+        }
+        free(ref);
+    }
+    printf("%d mismatch(es)\n", bad);
+    return bad?1:0;
+}
+
+// ---- benchmark ----
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+// a teapot like frame: 32 bicubic patches, with the map set again before each mesh
+static GLfloat patches[32][4][4][3];
+static void frame(int grid) {
+    glEnable(GL_MAP2_VERTEX_3); glEnable(GL_MAP2_TEXTURE_COORD_2); glEnable(GL_AUTO_NORMAL);
+    glMapGrid2f(grid, 0, 1, grid, 0, 1);
+    for (int p=0; p<32; ++p) {
+        glMap2f(GL_MAP2_VERTEX_3, 0, 1, 3, 4, 0, 1, 12, 4, &patches[p][0][0][0]);
+        glEvalMesh2(GL_FILL, 0, grid, 0, grid);
+    }
+    glFinish();
+}
+
+static void bench() {
+    static const int grids[] = {8, 16, 32};
+    reset();
+    for (int p=0; p<32; ++p)
+        for (int i=0; i<4; ++i)
+            for (int j=0; j<4; ++j) {
+                patches[p][i][j][0] = i+p; patches[p][i][j][1] = j; patches[p][i][j][2] = sinf(p+i*1.3f+j*0.7f);
+            }
+    for (int g=0; g<3; ++g) {
+        const int n = 2000/grids[g];
+        for (int f=0; f<3; ++f)
+            frame(grids[g]);
+        long d0 = mock_draws, u0 = mock_uploaded;
+        double t0 = now();
+        for (int f=0; f<n; ++f)
+            frame(grids[g]);
+        double t1 = now();
+        printf("static %2dx%2d:   %8.1f us/frame, %.1f draws/frame, %ld bytes uploaded/frame\n",
+            grids[g], grids[g], (t1-t0)*1e6/n, (double)(mock_draws-d0)/n, (mock_uploaded-u0)/n);
+    }
+    // moving control points: every mesh is new, this is the evaluator cost
+    for (int g=0; g<3; ++g) {
+        const int n = 1000/grids[g];
+        long u0 = mock_uploaded;
+        double t0 = now();
+        for (int f=0; f<n; ++f) {
+            for (int p=0; p<32; ++p)
+                patches[p][1][1][2] = 0.001f*(f+1);
+            frame(grids[g]);
+        }
+        double t1 = now();
+        printf("animated %2dx%2d: %8.1f us/frame, %ld bytes uploaded/frame\n",
+            grids[g], grids[g], (t1-t0)*1e6/n, (mock_uploaded-u0)/n);
+    }
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    glViewport(0, 0, 64, 64);
+    // texcoords are only sent when texturing is on
+    GLuint tex;
+    static GLubyte pixels[16*16*4];
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glEnable(GL_TEXTURE_2D);
+    set_maps();
+    if(argc>1 && !strcmp(argv[1], "bench")) {
+        bench();
+        return 0;
+    }
+    return check();
+}
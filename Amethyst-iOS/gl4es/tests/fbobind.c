@@ -0,0 +1,148 @@
+// Framebuffer bind elision check, against the GLES2 mock (mockgles.c).
+//
+// gl4es only binds a framebuffer on GLES when it isn't the one bound there already (fbo.real_fb).
+// A random sequence of glGenFramebuffers, glBindFramebuffer (GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER and
+// GL_READ_FRAMEBUFFER), glReadPixels, glDeleteFramebuffers (of the bound one too), save / restore of
+// the current FBO and switches to another gl4es state must:
+// - always leave the framebuffer gl4es draws in bound on GLES (the main FBO for 0, with LIBGL_FB=2),
+//   and read glReadPixels from the read framebuffer
+// - never bind on GLES the framebuffer already bound there, but after a state switch and around
+//   the save / restore (done around the swap, where another library may change it)
+// Also run with LIBGL_RECYCLEFBO=1 (deleted framebuffers are kept for glGenFramebuffers, still bound
+// on GLES) and LIBGL_FB=2.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/framebuffers.h"
+#include "gl/gl4es.h"
+#include "gl/init.h"
+
+// from gl4es (see glx.c)
+void* NewGLState(void* shared_glstate, int es2only);
+void ActivateGLState(void* new_glstate);
+
+#define STEPS 4000
+#define MAX_FB 6
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static GLuint gles_fb = 0;  // framebuffer bound on GLES, followed in the log
+static GLuint read_fb;      // framebuffer bound at the last glReadPixels
+
+// follow the log, return the number of binds of the framebuffer already bound
+static int follow() {
+    int redundant = 0;
+    for (int i=0; i<mock_log_size(); ++i) {
+        unsigned a, b;
+        const char *l = mock_log_line(i);
+        if(sscanf(l, "glBindFramebuffer %u %u", &a, &b)==2) {
+            if(b==gles_fb)
+                ++redundant;
+            gles_fb = b;
+        } else if(sscanf(l, "glDeleteFramebuffers %u", &a)==1 && a==gles_fb)
+            gles_fb = 0;    // GLES falls back to 0
+        else if(!strncmp(l, "glReadPixels", 12))
+            read_fb = gles_fb;
+    }
+    mock_clear_log();
+    return redundant;
+}
+
+static void check_sequence() {
+    static const char *names[] = {"gen", "bind", "bind draw", "bind read", "read pixels", "delete", "switch state", "save / restore"};
+    GLuint fbs[MAX_FB], draw = 0, read = 0;
+    int nfb = 0;
+    const GLuint main = glstate->fbo.mainfbo_fbo;
+    void *main_state = glstate;
+    void *other = NewGLState(NULL, 0);
+    follow();
+    CHECK(gles_fb==main, "framebuffer %u bound, not %u", gles_fb, main);
+    for (int step=0; step<STEPS; ++step) {
+        int op = rnd()%8;
+        const GLuint x = (nfb && rnd()%4)?fbs[rnd()%nfb]:0;
+        switch (op) {
+            case 0:
+                if(nfb<MAX_FB)
+                    glGenFramebuffers(1, &fbs[nfb++]);
+                break;
+            case 1:
+                glBindFramebuffer(GL_FRAMEBUFFER, x);
+                draw = read = x;
+                break;
+            case 2:
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, x);
+                draw = x;
+                break;
+            case 3:
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, x);
+                read = x;
+                break;
+            case 4:
+                {
+                    GLubyte pixel[4];
+                    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+                }
+                break;
+            case 5:
+                if(nfb) {
+                    const int i = rnd()%nfb;
+                    const GLuint id = fbs[i];
+                    glDeleteFramebuffers(1, &id);
+                    fbs[i] = fbs[--nfb];
+                    if(draw==id) draw = 0;
+                    if(read==id) read = 0;
+                }
+                break;
+            case 6:
+                {
+                    // another state binds its own framebuffer on GLES
+                    ActivateGLState(other);
+                    GLuint fb;
+                    glGenFramebuffers(1, &fb);
+                    glBindFramebuffer(GL_FRAMEBUFFER, fb);
+                    glDeleteFramebuffers(1, &fb);
+                    ActivateGLState(main_state);
+                    follow();
+                    // then the current one must be bound again
+                    glBindFramebuffer(GL_FRAMEBUFFER, draw);
+                    read = draw;
+                }
+                break;
+            default:
+                gl4es_saveCurrentFBO();
+                gl4es_restoreCurrentFBO();
+                break;
+        }
+        const GLuint expected = draw?draw:main;
+        const int redundant = follow();
+        CHECK(gles_fb==expected, "step %d (%s): framebuffer %u bound on GLES, not %u", step, names[op], gles_fb, expected);
+        CHECK(op>=6 || !redundant, "step %d (%s): %d redundant bind(s)", step, names[op], redundant);
+        if(op==4) {
+            CHECK(read_fb==(read?read:main), "step %d: glReadPixels from framebuffer %u, not %u", step, read_fb, read?read:main);
+        }
+        if(bad>10)
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    if(globals4es.usefbo)
+        createMainFBO(320, 200);
+    check_sequence();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
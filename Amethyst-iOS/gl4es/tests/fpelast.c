@@ -0,0 +1,136 @@
+// Program resolution check (realize_glenv fast path), against the GLES2 mock (mockgles.c).
+//
+// - draws with the same fixed pipeline state must use the same GLES program, and each state
+//   the program it got the first time (a fresh resolution), for the fixed pipeline and for a
+//   GLSL program customized for GL_ALPHA_TEST
+// - a program relinked or deleted in a context sharing the programs must not leave a stale
+//   customized program in the other one
+
+#include <stdio.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+
+// from gl4es (see glx.c)
+void* NewGLState(void* shared_glstate, int es2only);
+void ActivateGLState(void* new_glstate);
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static const char *vertex_src = "attribute vec4 a0;\nvoid main() {\n gl_Position = a0;\n}\n";
+static const char *fragment_src[] = {
+    "void main() {\n gl_FragColor = vec4(1.0);\n}\n",
+    "void main() {\n gl_FragColor = vec4(0.5);\n}\n",
+};
+
+static const GLfloat vertices[] = {0.f, 0.f, 0.f, 1.f,  1.f, 0.f, 0.f, 1.f,  0.f, 1.f, 0.f, 1.f};
+
+static GLuint shader(GLenum type, const char *src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, NULL);
+    glCompileShader(s);
+    return s;
+}
+
+static GLuint make_program(int frag) {
+    GLuint p = glCreateProgram();
+    glAttachShader(p, shader(GL_VERTEX_SHADER, vertex_src));
+    glAttachShader(p, shader(GL_FRAGMENT_SHADER, fragment_src[frag]));
+    glLinkProgram(p);
+    return p;
+}
+
+#define NSTATES 4
+static void set_state(int state) {
+    switch (state) {
+        case 0: glDisable(GL_ALPHA_TEST); glDisable(GL_FOG); break;
+        case 1: glEnable(GL_ALPHA_TEST); glAlphaFunc(GL_GREATER, 0.5f); glDisable(GL_FOG); break;
+        case 2: glEnable(GL_ALPHA_TEST); glAlphaFunc(GL_LESS, 0.25f); glDisable(GL_FOG); break;
+        case 3: glDisable(GL_ALPHA_TEST); glEnable(GL_FOG); break;
+    }
+}
+
+// draw, and return the GLES program used
+static GLuint draw() {
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    CHECK(mock_program_alive(mock_program), "draw with program %u, deleted", mock_program);
+    return mock_program;
+}
+
+static void check_sequence(GLuint program) {
+    static const int sequence[] = {0, 0, 1, 1, 2, 1, 0, 3, 2, 2, 3, 3, 0, 1, 0, 2};
+    GLuint used[NSTATES] = {0};
+    glUseProgram(program);
+    for (int i=0; i<sizeof(sequence)/sizeof(sequence[0]); ++i) {
+        const int s = sequence[i];
+        set_state(s);
+        // a state change back and forth between draws is not a change
+        if(i&1) { glEnable(GL_BLEND); glDisable(GL_BLEND); }
+        GLuint p = draw();
+        if(!used[s])
+            used[s] = p;
+        CHECK(p==used[s], "program %u, draw %d: state %d used program %u, then %u", program, i, s, used[s], p);
+    }
+    if(program) {
+        CHECK(used[0]==program, "no customization, program %u used instead of %u", used[0], program);
+        CHECK(used[1]!=program && used[2]!=program && used[1]!=used[2], "alpha test: programs %u %u for %u", used[1], used[2], program);
+    } else
+        for (int s=1; s<NSTATES; ++s)
+            CHECK(used[s]!=used[0], "fixed pipeline: state %d uses the program of state 0", s);
+    set_state(0);
+}
+
+static void check_shared(void *ctx1, void *ctx2) {
+    ActivateGLState(ctx1);
+    GLuint program = make_program(0);
+    glUseProgram(program);
+    set_state(1);
+    GLuint custom = draw();
+    CHECK(custom!=program, "no customized program");
+    // relinked in the other context
+    ActivateGLState(ctx2);
+    GLuint s = shader(GL_FRAGMENT_SHADER, fragment_src[1]);
+    GLuint attached[2];
+    GLsizei n = 0;
+    glGetAttachedShaders(program, 2, &n, attached);
+    for (int i=0; i<n; ++i) glDetachShader(program, attached[i]);
+    glAttachShader(program, shader(GL_VERTEX_SHADER, vertex_src));
+    glAttachShader(program, s);
+    glLinkProgram(program);
+    ActivateGLState(ctx1);
+    glUseProgram(program);
+    GLuint p = draw();
+    CHECK(p!=program, "after a relink in the other context, program %u not customized", program);
+    // deleted in the other context, and a new one created (likely at the same address)
+    ActivateGLState(ctx2);
+    glUseProgram(0);
+    glDeleteProgram(program);
+    GLuint other = make_program(1);
+    ActivateGLState(ctx1);
+    glUseProgram(other);
+    p = draw();
+    CHECK(p!=other, "alpha test: program %u not customized", other);
+    set_state(0);
+    glUseProgram(0);
+    glDeleteProgram(other);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    void *ctx1 = NewGLState(NULL, 0);
+    void *ctx2 = NewGLState(ctx1, 0);
+    ActivateGLState(ctx1);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, vertices);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(4, GL_FLOAT, 0, vertices);
+    check_sequence(make_program(0));
+    check_sequence(0);
+    check_shared(ctx1, ctx2);
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,191 @@
+// Hardware probe cache check, against the GLES2 mock (mockgles.c).
+//
+// GetHardwareExtensions runs once per process, so each probe is done in a child process:
+// - without a cache file, the hardware is probed (a context is created) and the file written
+// - with the file, nothing is probed and the same capabilities (and vgpu_backport, for a driver
+//   without GLSL 300 es) are loaded
+// - a different driver, a setting that changes the probe, or a damaged file probe again
+// - LIBGL_NOHWCACHE=1 neither reads nor writes the file, LIBGL_NOHWCACHE=2 probes and writes it
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/init.h"
+#include "glx/hardext.h"
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+typedef struct {
+    hardext_t hardext;
+    int vgpu_backport;
+    int probed;         // number of eglCreateContext
+} probe_t;
+
+typedef struct {
+    const char *egl_vendor;
+    int nobgra;
+    int nohwcache;
+    const char *glsl_reject;
+} setup_t;
+
+static char cache_name[64];
+
+static probe_t probe(setup_t setup) {
+    probe_t ret;
+    memset(&ret, 0, sizeof(ret));
+    int fd[2];
+    if(pipe(fd)) {
+        perror("pipe");
+        exit(1);
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if(!pid) {
+        close(fd[0]);
+        mock_egl_vendor = setup.egl_vendor;
+        mock_glsl_reject = setup.glsl_reject;
+        globals4es.nobgra = setup.nobgra;
+        globals4es.nohwcache = setup.nohwcache;
+        globals4es.vgpu_backport = 0;
+        hardext_InitCache(cache_name);
+        memset(&hardext, 0, sizeof(hardext));
+        mock_clear_log();
+        GetHardwareExtensions(0);
+        memcpy(&ret.hardext, &hardext, sizeof(hardext));
+        ret.vgpu_backport = globals4es.vgpu_backport;
+        ret.probed = mock_count("eglCreateContext");
+        _exit(write(fd[1], &ret, sizeof(ret))==sizeof(ret)?0:1);
+    }
+    close(fd[1]);
+    int status = 0;
+    CHECK(read(fd[0], &ret, sizeof(ret))==sizeof(ret), "no result from the probe");
+    close(fd[0]);
+    waitpid(pid, &status, 0);
+    CHECK(WIFEXITED(status) && !WEXITSTATUS(status), "probe failed (status %d)", status);
+    return ret;
+}
+
+static int same(const probe_t *a, const probe_t *b) {
+    return !memcmp(&a->hardext, &b->hardext, sizeof(hardext_t)) && a->vgpu_backport==b->vgpu_backport;
+}
+
+static time_t mtime() {
+    struct stat st;
+    return stat(cache_name, &st)?0:st.st_mtime;
+}
+
+static void damage(long size) {
+    FILE *f = fopen(cache_name, "r+b");
+    fseek(f, 0, SEEK_END);
+    long l = ftell(f);
+    if(size<0) {
+        // flip a byte (of the capabilities)
+        fseek(f, l/2, SEEK_SET);
+        int c = fgetc(f);
+        fseek(f, l/2, SEEK_SET);
+        fputc(c^0x55, f);
+        fclose(f);
+    } else {
+        fclose(f);
+        CHECK(!truncate(cache_name, size), "cannot truncate");
+    }
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    mock_extensions = "GL_OES_texture_npot GL_EXT_blend_minmax GL_OES_depth_texture GL_EXT_texture_format_BGRA8888 GL_OES_standard_derivatives ";
+    mock_vendor = "Mock";
+    sprintf(cache_name, "/tmp/gl4es_hwcache_%d.hwc", (int)getpid());
+    remove(cache_name);
+    const setup_t base = {"Mock", 0, 0, NULL};
+
+    // no file: probed and written
+    probe_t first = probe(base);
+    CHECK(first.probed==1, "no file: %d context(s) created", first.probed);
+    CHECK(first.hardext.esversion==2 && first.hardext.npot && first.hardext.bgra8888 && first.hardext.depthtex,
+        "no file: extensions not detected");
+    CHECK(mtime(), "no file: cache not written");
+
+    // cache hit
+    probe_t p = probe(base);
+    CHECK(p.probed==0, "cache hit: %d context(s) created", p.probed);
+    CHECK(same(&p, &first), "cache hit: different capabilities");
+    CHECK(first.hardext.glsl300es && !first.vgpu_backport, "glsl300es %d, vgpu_backport %d", first.hardext.glsl300es, first.vgpu_backport);
+
+    // a driver without GLSL 300 es: vgpu_backport set by the probe, and by the cache
+    setup_t s = base;
+    s.egl_vendor = "Old";
+    s.glsl_reject = "#version 300 es";
+    p = probe(s);
+    CHECK(p.probed==1 && !p.hardext.glsl300es && p.vgpu_backport, "no GLSL 300 es: glsl300es %d, vgpu_backport %d", p.hardext.glsl300es, p.vgpu_backport);
+    probe_t old = p;
+    p = probe(s);
+    CHECK(p.probed==0, "no GLSL 300 es, again: %d context(s) created", p.probed);
+    CHECK(same(&p, &old), "no GLSL 300 es, again: different capabilities or vgpu_backport");
+
+    // another driver
+    s = base;
+    s.egl_vendor = "Other";
+    p = probe(s);
+    CHECK(p.probed==1, "other driver: %d context(s) created", p.probed);
+    p = probe(s);
+    CHECK(p.probed==0, "other driver, again: %d context(s) created", p.probed);
+    p = probe(base);
+    CHECK(p.probed==1, "back to the first driver: %d context(s) created", p.probed);
+
+    // a setting that changes the probe
+    s = base;
+    s.nobgra = 1;
+    p = probe(s);
+    CHECK(p.probed==1, "LIBGL_NOBGRA: %d context(s) created", p.probed);
+    p = probe(base);
+    CHECK(p.probed==1, "LIBGL_NOBGRA back: %d context(s) created", p.probed);
+    CHECK(same(&p, &first), "LIBGL_NOBGRA back: different capabilities");
+
+    // damaged files are probed again, and rewritten
+    damage(-1);
+    p = probe(base);
+    CHECK(p.probed==1, "damaged file: %d context(s) created", p.probed);
+    CHECK(same(&p, &first), "damaged file: different capabilities");
+    damage(40);
+    p = probe(base);
+    CHECK(p.probed==1, "truncated file: %d context(s) created", p.probed);
+    p = probe(base);
+    CHECK(p.probed==0, "rewritten file: %d context(s) created", p.probed);
+    CHECK(same(&p, &first), "rewritten file: different capabilities");
+
+    // LIBGL_NOHWCACHE=1: not read, not written
+    s = base;
+    s.nohwcache = 1;
+    s.egl_vendor = "Other";
+    p = probe(s);
+    CHECK(p.probed==1, "LIBGL_NOHWCACHE=1: %d context(s) created", p.probed);
+    p = probe(base);
+    CHECK(p.probed==0, "LIBGL_NOHWCACHE=1 wrote the cache");
+    s.egl_vendor = "Mock";
+    p = probe(s);
+    CHECK(p.probed==1, "LIBGL_NOHWCACHE=1 read the cache");
+    // LIBGL_NOHWCACHE=2: not read, written
+    s.nohwcache = 2;
+    s.egl_vendor = "Other";
+    p = probe(s);
+    CHECK(p.probed==1, "LIBGL_NOHWCACHE=2: %d context(s) created", p.probed);
+    p = probe(s);
+    CHECK(p.probed==1, "LIBGL_NOHWCACHE=2 read the cache");
+    s.nohwcache = 0;
+    p = probe(s);
+    CHECK(p.probed==0, "LIBGL_NOHWCACHE=2 did not write the cache");
+
+    remove(cache_name);
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,371 @@
+// Lighting check, on a software GLES driver (swgles.c).
+//
+// The light and material uniforms of a program are only set again when the light generation changed since
+// that program got them. So each step draws the same scene twice, from the same state: first as usual, then
+// with a new generation before each draw (every uniform set again). Both images must be the same. Between
+// the draws, random changes of lights, positions and spots (under a random modelview), attenuations, light
+// model, materials (also inside glBegin/glEnd), display lists, glPushAttrib/glPopAttrib, the same values set
+// again, and toggles that switch between the fixed pipeline programs (lights, fog, two side, color material).
+// The derived values (light products and scene color) are checked against a CPU model, with one
+// directional light on a flat quad. Also, generations made by many threads at once must all be different.
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "swgles.h"
+#include "gl/gl4es.h"
+#include "gl/light.h"
+
+#define W 64
+#define H 64
+#define NLIGHTS 4
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static float frnd(float a, float b) {
+    return a+(b-a)*(rnd()%1001)/1000.0f;
+}
+
+static void random_color(GLfloat *c, float max) {
+    for (int i=0; i<3; ++i)
+        c[i] = frnd(0.0f, max);
+    c[3] = frnd(0.5f, 1.0f);
+}
+
+static const GLenum faces[] = {GL_FRONT, GL_BACK, GL_FRONT_AND_BACK};
+
+static void random_light() {
+    const GLenum light = GL_LIGHT0+rnd()%NLIGHTS;
+    GLfloat v[4];
+    switch (rnd()%8) {
+        case 0: random_color(v, 0.3f); glLightfv(light, GL_AMBIENT, v); break;
+        case 1: random_color(v, 1.0f); glLightfv(light, GL_DIFFUSE, v); break;
+        case 2: random_color(v, 1.0f); glLightfv(light, GL_SPECULAR, v); break;
+        case 3:
+            // positions and spot directions are taken in eye space, with the current modelview
+            glPushMatrix();
+            glTranslatef(frnd(-20, 20), frnd(-20, 20), frnd(-20, 20));
+            glRotatef(frnd(0, 360), frnd(-1, 1), frnd(-1, 1), 1.0f);
+            // each light stays positional or directional, spot or not (see random_toggle)
+            v[0] = frnd(-40, 100); v[1] = frnd(-40, 100); v[2] = frnd(10, 100); v[3] = (light%2)?0.0f:1.0f;
+            glLightfv(light, GL_POSITION, v);
+            glPopMatrix();
+            break;
+        case 4:
+            glPushMatrix();
+            glRotatef(frnd(-30, 30), frnd(-1, 1), frnd(-1, 1), 0.2f);
+            v[0] = frnd(-1, 1); v[1] = frnd(-1, 1); v[2] = -1.0f;
+            glLightfv(light, GL_SPOT_DIRECTION, v);
+            glPopMatrix();
+            break;
+        case 5:
+            glLightf(light, GL_SPOT_CUTOFF, (light<GL_LIGHT2)?frnd(20, 90):180.0f);
+            glLightf(light, GL_SPOT_EXPONENT, frnd(0, 20));
+            break;
+        case 6:
+            glLightf(light, GL_CONSTANT_ATTENUATION, frnd(0.5f, 2.0f));
+            glLightf(light, GL_LINEAR_ATTENUATION, (rnd()%2)?frnd(0, 0.02f):0.0f);
+            glLightf(light, GL_QUADRATIC_ATTENUATION, (rnd()%2)?frnd(0, 0.0005f):0.0f);
+            break;
+        default:
+            // the same value again
+            glGetLightfv(light, GL_DIFFUSE, v);
+            glLightfv(light, GL_DIFFUSE, v);
+    }
+}
+
+static void random_material() {
+    static const GLenum pnames[] = {GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR, GL_EMISSION, GL_AMBIENT_AND_DIFFUSE};
+    const GLenum face = faces[rnd()%3];
+    GLfloat v[4];
+    if(rnd()%4==0) {
+        glMaterialf(face, GL_SHININESS, frnd(1, 64));
+        return;
+    }
+    const GLenum pname = pnames[rnd()%5];
+    random_color(v, (pname==GL_EMISSION)?0.3f:1.0f);
+    glMaterialfv(face, pname, v);
+}
+
+// glPushAttrib doesn't save the local viewer, so it only changes between the steps (kept), not in the draws
+// of a step
+static void random_change(int kept) {
+    GLfloat v[4];
+    switch (rnd()%10) {
+        case 0: case 1: case 2: random_light(); break;
+        case 3: case 4: random_material(); break;
+        case 5:
+            random_color(v, 0.3f);
+            glLightModelfv(GL_LIGHT_MODEL_AMBIENT, v);
+            break;
+        case 6:
+            if(kept)
+                glLightModelf(GL_LIGHT_MODEL_LOCAL_VIEWER, rnd()%2);
+            break;
+        case 7:
+            glColor4f(frnd(0, 1), frnd(0, 1), frnd(0, 1), 1.0f);
+            break;
+        case 8:
+            {
+                // in a display list
+                GLuint list = glGenLists(1);
+                glNewList(list, GL_COMPILE);
+                random_material();
+                random_light();
+                glEndList();
+                glCallList(list);
+                glDeleteLists(list, 1);
+            }
+            break;
+        default:
+            // changed, then restored
+            glPushAttrib(GL_LIGHTING_BIT);
+            random_light();
+            random_material();
+            glPopAttrib();
+    }
+}
+
+// switch to another fixed pipeline program, the light uniforms don't change (each program is compiled by the
+// driver, so only a few of them: GL_LIGHT3 stays disabled, its changes must not show)
+static void random_toggle() {
+    const GLenum cap[] = {GL_LIGHT2, GL_FOG, GL_COLOR_MATERIAL};
+    if(rnd()%4==0) {
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, rnd()%2);
+        return;
+    }
+    const GLenum c = cap[rnd()%3];
+    if(glIsEnabled(c)) glDisable(c); else glEnable(c);
+}
+
+static void random_vertex() {
+    GLfloat n[3] = {frnd(-1, 1), frnd(-1, 1), frnd(0.1f, 1)};
+    glNormal3fv(n);
+    glVertex3f(frnd(0, W), frnd(0, H), frnd(-20, 20));
+}
+
+static void draw() {
+    glBegin(GL_POINTS);
+    for (int i=0; i<40; ++i)
+        random_vertex();
+    glEnd();
+    // and triangles, front and back facing
+    glBegin(GL_TRIANGLES);
+    if(rnd()%4==0) {
+        // taken as if it was before glBegin
+        GLfloat v[4];
+        random_color(v, 1.0f);
+        glMaterialfv(faces[rnd()%3], GL_DIFFUSE, v);
+    }
+    for (int i=0; i<6; ++i)
+        random_vertex();
+    glEnd();
+}
+
+// the same draws, from the same state and the same seed, with or without a new generation before each draw
+static void draw_step(unsigned step_seed, int new_generation, GLubyte *image) {
+    seed = step_seed;
+    glPushAttrib(GL_LIGHTING_BIT|GL_ENABLE_BIT|GL_CURRENT_BIT);
+    glClear(GL_COLOR_BUFFER_BIT);
+    for (int d=0; d<4; ++d) {
+        const int n = rnd()%3;
+        for (int i=0; i<n; ++i)
+            if(rnd()%2) random_change(0); else random_toggle();
+        if(new_generation)
+            glstate->light.generation = light_NewGeneration();
+        draw();
+    }
+    glPopAttrib();
+    sw_read(image);
+}
+
+static int count_colors(const GLubyte *image) {
+    int n = 0;
+    for (int i=0; i<W*H; ++i) {
+        int seen = 0;
+        for (int j=0; j<i && !seen; ++j)
+            seen = !memcmp(image+4*i, image+4*j, 4);
+        n += !seen;
+    }
+    return n;
+}
+
+static void check_random() {
+    static GLubyte image[2][W*H*4];
+    int colors = 0, diff = 0;
+    for (int step=0; step<1500 && diff<5; ++step) {
+        // a change kept for the next steps
+        for (int i=0; i<3; ++i)
+            random_change(1);
+        if(rnd()%2)
+            random_toggle();
+        const unsigned step_seed = rnd()*65536u+rnd();
+        draw_step(step_seed, 0, image[0]);
+        draw_step(step_seed, 1, image[1]);
+        if(memcmp(image[0], image[1], sizeof(image[0]))) {
+            for (int i=0; i<W*H; ++i)
+                if(memcmp(image[0]+i*4, image[1]+i*4, 4)) {
+                    const GLubyte *p = image[0]+i*4, *e = image[1]+i*4;
+                    CHECK(0, "step %d: pixel %d,%d is %d %d %d %d, expected %d %d %d %d", step, i%W, i/W,
+                        p[0], p[1], p[2], p[3], e[0], e[1], e[2], e[3]);
+                    break;
+                }
+            ++diff;
+        }
+        if(step%100==0)
+            colors += count_colors(image[0]);
+    }
+    // the scenes are lit, not all black or all the same color
+    CHECK(colors>200, "only %d colors", colors);
+}
+
+static GLubyte to_byte(float v) {
+    return (GLubyte)(((v<0.0f)?0.0f:(v>1.0f)?1.0f:v)*255.0f+0.5f);
+}
+
+static void check_model() {
+    glDisable(GL_LIGHT0);
+    glDisable(GL_LIGHT1);
+    glDisable(GL_LIGHT2);
+    glEnable(GL_LIGHT3);    // directional, no spot
+    glDisable(GL_FOG);
+    glDisable(GL_COLOR_MATERIAL);
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, 0);
+    glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, 0);
+    glLightf(GL_LIGHT3, GL_CONSTANT_ATTENUATION, 1.0f);
+    GLfloat la[4], ld[4], ls[4], dir[4], ma[4], md[4], ms[4], me[4], lm[4], shininess = 0;
+    for (int i=0; i<200; ++i) {
+        // one or two of the values changed each time
+        for (int n=0; n<1+i%2; ++n)
+            switch ((i==0)?n:rnd()%9) {
+                case 0:
+                    random_color(la, 0.3f); random_color(ld, 1.0f); random_color(ls, 1.0f);
+                    dir[0] = frnd(-1, 1); dir[1] = frnd(-1, 1); dir[2] = 1.0f; dir[3] = 0.0f;
+                    random_color(ma, 1.0f); random_color(md, 1.0f); random_color(ms, 1.0f); random_color(me, 0.3f);
+                    random_color(lm, 0.3f);
+                    shininess = frnd(1, 64);
+                    glLightfv(GL_LIGHT3, GL_AMBIENT, la);
+                    glLightfv(GL_LIGHT3, GL_DIFFUSE, ld);
+                    glLightfv(GL_LIGHT3, GL_SPECULAR, ls);
+                    glLightfv(GL_LIGHT3, GL_POSITION, dir);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ma);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, md);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, ms);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, me);
+                    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess);
+                    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lm);
+                    break;
+                case 1: random_color(la, 0.3f); glLightfv(GL_LIGHT3, GL_AMBIENT, la); break;
+                case 2: random_color(ld, 1.0f); glLightfv(GL_LIGHT3, GL_DIFFUSE, ld); break;
+                case 3: random_color(ls, 1.0f); glLightfv(GL_LIGHT3, GL_SPECULAR, ls); break;
+                case 4:
+                    dir[0] = frnd(-1, 1); dir[1] = frnd(-1, 1);
+                    glLightfv(GL_LIGHT3, GL_POSITION, dir);
+                    break;
+                case 5: random_color(ma, 1.0f); glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, ma); break;
+                case 6: random_color(md, 1.0f); glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, md); break;
+                case 7:
+                    random_color(me, 0.3f);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, me);
+                    random_color(ms, 1.0f);
+                    glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, ms);
+                    break;
+                default:
+                    random_color(lm, 0.3f);
+                    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lm);
+            }
+        glClear(GL_COLOR_BUFFER_BIT);
+        glNormal3f(0.0f, 0.0f, 1.0f);
+        glBegin(GL_QUADS);
+        glVertex2f(0, 0); glVertex2f(W, 0); glVertex2f(W, H); glVertex2f(0, H);
+        glEnd();
+        // the normal is +z and the viewer at +z infinity
+        const float len = sqrtf(dir[0]*dir[0]+dir[1]*dir[1]+1.0f);
+        const float ndotl = 1.0f/len;
+        const float h[3] = {dir[0]/len, dir[1]/len, 1.0f/len+1.0f};
+        const float ndoth = h[2]/sqrtf(h[0]*h[0]+h[1]*h[1]+h[2]*h[2]);
+        GLubyte expected[4], pixel[4];
+        for (int c=0; c<3; ++c)
+            expected[c] = to_byte(me[c]+ma[c]*lm[c]+ma[c]*la[c]+ndotl*md[c]*ld[c]+powf(ndoth, shininess)*ms[c]*ls[c]);
+        expected[3] = to_byte(md[3]);
+        glReadPixels(W/2, H/2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        int ok = 1;
+        for (int c=0; c<4; ++c)
+            ok &= (abs(pixel[c]-expected[c])<=2);
+        CHECK(ok, "draw %d: %d %d %d %d, expected %d %d %d %d", i,
+            pixel[0], pixel[1], pixel[2], pixel[3], expected[0], expected[1], expected[2], expected[3]);
+    }
+}
+
+#define NTHREADS 4
+#define NGENERATIONS 1000000
+
+static pthread_barrier_t start;
+
+static void* generations(void *arg) {
+    unsigned last = 0;
+    pthread_barrier_wait(&start);   // all at the same time
+    for (int i=0; i<NGENERATIONS; ++i) {
+        unsigned g = light_NewGeneration();
+        if(i && g<=last)
+            ++*(int*)arg;
+        last = g;
+    }
+    return NULL;
+}
+
+static void check_threads() {
+    pthread_t th[NTHREADS];
+    int wrong[NTHREADS] = {0};
+    pthread_barrier_init(&start, NULL, NTHREADS);
+    const unsigned first = light_NewGeneration();
+    for (int i=0; i<NTHREADS; ++i)
+        pthread_create(&th[i], NULL, generations, &wrong[i]);
+    for (int i=0; i<NTHREADS; ++i) {
+        pthread_join(th[i], NULL);
+        CHECK(!wrong[i], "thread %d got %d generations not after its previous one", i, wrong[i]);
+    }
+    pthread_barrier_destroy(&start);
+    const unsigned last = light_NewGeneration();
+    CHECK(last-first==NTHREADS*NGENERATIONS+1, "%u generations made, expected %u", last-first-1, NTHREADS*NGENERATIONS);
+}
+
+int main(int argc, char **argv) {
+    if(!sw_init(W, H))
+        return SW_SKIP;
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glMatrixMode(GL_PROJECTION);
+    glOrtho(0, W, 0, H, -100, 100);
+    glMatrixMode(GL_MODELVIEW);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_LIGHT1);
+    for (int i=0; i<NLIGHTS; ++i) {
+        const GLfloat pos[4] = {W/2, H/2, 50.0f, (i%2)?0.0f:1.0f};
+        glLightfv(GL_LIGHT0+i, GL_POSITION, pos);
+        glLightf(GL_LIGHT0+i, GL_SPOT_CUTOFF, (i<2)?45.0f:180.0f);
+    }
+    glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 10.0f);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_DIFFUSE);
+    glFogf(GL_FOG_MODE, GL_LINEAR);
+    glFogf(GL_FOG_START, -50.0f);
+    glFogf(GL_FOG_END, 100.0f);
+    check_random();
+    check_model();
+    check_threads();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,84 @@
+// Line stipple draw path check, against the GLES2 mock (mockgles.c), whose attributes are named "a<location>".
+//
+// Stippled strips and loops of the fixed pipeline go through the list path, which gives each vertex its
+// distance along the lines. A GLSL program is not stippled, so its strips and loops must be sent as they
+// are: the application's arrays and indices, not a copy.
+
+#include <stdio.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static const char *vertex_src = "attribute vec4 a5;\nvoid main() {\n gl_Position = a5;\n}\n";
+static const char *fragment_src = "void main() {\n gl_FragColor = vec4(1.0);\n}\n";
+
+static const GLfloat vertices[] = {0.f, 0.f, 0.f, 1.f,  0.5f, 0.f, 0.f, 1.f,  0.5f, 0.5f, 0.f, 1.f,  0.f, 0.5f, 0.f, 1.f};
+static const GLushort indices[] = {3, 2, 1, 0};
+
+static GLuint shader(GLenum type, const char *src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, NULL);
+    glCompileShader(s);
+    return s;
+}
+
+static void check_fixed() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(4, GL_FLOAT, 0, vertices);
+    glDrawArrays(GL_LINE_STRIP, 0, 4);
+    CHECK(mock_attrib_pointer(0)==vertices, "not stippled: the vertex array is a copy");
+    glEnable(GL_LINE_STIPPLE);
+    glLineStipple(2, 0x0f0f);
+    static const GLenum modes[] = {GL_LINE_STRIP, GL_LINE_LOOP};
+    for (int m=0; m<2; ++m) {
+        mock_clear_log();
+        glDrawArrays(modes[m], 0, 4);
+        CHECK(mock_count("glDrawArrays")==1 && mock_attrib_pointer(0)!=vertices, "mode 0x%04X: not drawn by the list path", modes[m]);
+    }
+    glDisable(GL_LINE_STIPPLE);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+static void check_program() {
+    GLuint p = glCreateProgram();
+    glAttachShader(p, shader(GL_VERTEX_SHADER, vertex_src));
+    glAttachShader(p, shader(GL_FRAGMENT_SHADER, fragment_src));
+    glLinkProgram(p);
+    glUseProgram(p);
+    const GLint pos = glGetAttribLocation(p, "a5");
+    CHECK(pos>=0, "no attribute location");
+    glEnableVertexAttribArray(pos);
+    glVertexAttribPointer(pos, 4, GL_FLOAT, GL_FALSE, 0, vertices);
+    glEnable(GL_LINE_STIPPLE);
+    glLineStipple(2, 0x0f0f);
+    static const GLenum modes[] = {GL_LINE_STRIP, GL_LINE_LOOP};
+    for (int m=0; m<2; ++m) {
+        mock_clear_log();
+        glDrawArrays(modes[m], 0, 4);
+        CHECK(mock_find("glDrawArrays", 0)>=0 && !strcmp(mock_log_line(mock_find("glDrawArrays", 0)), modes[m]==GL_LINE_STRIP?"glDrawArrays 3 0 4":"glDrawArrays 2 0 4"),
+            "mode 0x%04X: glDrawArrays not sent as it is", modes[m]);
+        CHECK(mock_attrib_pointer(pos)==vertices, "mode 0x%04X: the array is a copy", modes[m]);
+        mock_clear_log();
+        glDrawElements(modes[m], 4, GL_UNSIGNED_SHORT, indices);
+        CHECK(mock_count("glDrawElements")==1 && mock_indices==indices, "mode 0x%04X: the indices are a copy", modes[m]);
+        CHECK(mock_attrib_pointer(pos)==vertices, "mode 0x%04X: the array is a copy", modes[m]);
+    }
+    glDisable(GL_LINE_STIPPLE);
+    glDisableVertexAttribArray(pos);
+    glUseProgram(0);
+    glDeleteProgram(p);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    check_fixed();
+    check_program();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
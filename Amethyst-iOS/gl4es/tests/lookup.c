@@ -0,0 +1,142 @@
+// gl4es_GetProcAddress check, against the GLES2 mock (mockgles.c).
+//
+// Every name of gl_lookup.inc (and a few unknown ones) must resolve to what the old strcmp chain
+// (the MAP / STUB macros of gl_lookup.h, run on the same list) returns, for every combination of
+// the conditions of the list, changed after the table is built. The table is first filled by
+// several threads at once.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/attributes.h"
+#include "gl/wrap/gl4es.h"
+#include "gl/wrap/stub.h"
+#include "gl/directstate.h"
+#include "gl/framebuffers.h"
+#include "gl/init.h"
+#include "gl/line.h"
+#include "gl/loader.h"
+#include "gl/render.h"
+#include "gl/texgen.h"
+#include "gl/vertexattrib.h"
+#include "gl/oldprogram.h"
+#include "glx/hardext.h"
+
+void gl4es_Stub(void *x, ...);
+#define STUB_FCT gl4es_Stub
+#include "gl/gl_lookup.h"
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+// the conditions as the old chain tested them
+static int old_condition(int c) {
+    switch (c) {
+        case LOOKUP_FBO: return hardext.fbo;
+        case LOOKUP_BLENDCOLOR: return globals4es.blendcolor || hardext.blendcolor;
+        case LOOKUP_BLENDEQ: return hardext.blendeq;
+        case LOOKUP_BLENDFUNC: return hardext.blendfunc;
+        case LOOKUP_ES2: return hardext.esversion>1;
+        case LOOKUP_QUERIES: return globals4es.queries;
+    }
+    printf("unknown condition %d\n", c);
+    ++bad;
+    return 0;
+}
+
+#define LOOKUP_IF(c) if(old_condition(c))
+static void* old_lookup(const char *name) {
+    #include "gl/gl_lookup.inc"
+    return NULL;
+}
+#undef LOOKUP_IF
+
+// all the names of the list
+#define MAX_NAMES 4096
+static const char *names[MAX_NAMES];
+static int nnames = 0;
+
+static void add_name(const char *name) {
+    if(nnames<MAX_NAMES)
+        names[nnames++] = name;
+}
+
+#undef MAP
+#define MAP(func_name, func) add_name(func_name);
+#undef STUB
+#define STUB(func_name) add_name(#func_name);
+#define LOOKUP_IF(c)
+static void collect_names() {
+    #include "gl/gl_lookup.inc"
+    add_name("glNotAFunction");
+    add_name("glVertex");
+    add_name("glVertex3fEXT");
+    add_name("");
+}
+#undef LOOKUP_IF
+
+#define NTHREADS 8
+static void* results[NTHREADS][MAX_NAMES];
+
+static void* resolve_all(void *arg) {
+    void **r = (void**)arg;
+    for (int i=0; i<nnames; ++i)
+        r[i] = gl4es_GetProcAddress(names[i]);
+    return NULL;
+}
+
+static void set_conditions(int c) {
+    hardext.fbo = (c&LOOKUP_FBO)?1:0;
+    hardext.blendcolor = 0;
+    globals4es.blendcolor = (c&LOOKUP_BLENDCOLOR)?1:0;
+    hardext.blendeq = (c&LOOKUP_BLENDEQ)?1:0;
+    hardext.blendfunc = (c&LOOKUP_BLENDFUNC)?1:0;
+    hardext.esversion = (c&LOOKUP_ES2)?2:1;
+    globals4es.queries = (c&LOOKUP_QUERIES)?1:0;
+}
+
+static int compare(const char *when) {
+    int diff = 0;
+    for (int i=0; i<nnames; ++i) {
+        void *got = gl4es_GetProcAddress(names[i]), *expected = old_lookup(names[i]);
+        if(got!=expected && diff++<5)
+            printf("%s: \"%s\" resolved to %p, expected %p\n", when, names[i], got, expected);
+    }
+    return diff;
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    collect_names();
+    CHECK(nnames>1000 && nnames<MAX_NAMES, "%d names", nnames);
+    // build the table from several threads
+    pthread_t threads[NTHREADS];
+    for (int t=0; t<NTHREADS; ++t)
+        pthread_create(&threads[t], NULL, resolve_all, results[t]);
+    for (int t=0; t<NTHREADS; ++t)
+        pthread_join(threads[t], NULL);
+    for (int t=1; t<NTHREADS; ++t)
+        CHECK(!memcmp(results[t], results[0], nnames*sizeof(void*)), "thread %d resolved other functions", t);
+    int diff = compare("initial conditions");
+    CHECK(!diff, "%d names resolved differently", diff);
+    for (int c=0; c<64; ++c) {
+        char when[64];
+        sprintf(when, "conditions 0x%02x", c);
+        set_conditions(c);
+        diff = compare(when);
+        CHECK(!diff, "%s: %d names resolved differently", when, diff);
+    }
+    // with blendcolor from the hardware
+    set_conditions(0);
+    hardext.blendcolor = 1;
+    diff = compare("hardext.blendcolor");
+    CHECK(!diff, "hardext.blendcolor: %d names resolved differently", diff);
+    printf("%d names, %d error(s)\n", nnames, bad);
+    return bad?1:0;
+}
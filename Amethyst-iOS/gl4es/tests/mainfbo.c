@@ -0,0 +1,94 @@
+// Main FBO swap check, against the GLES2 mock (mockgles.c), with LIBGL_FB=2 (and LIBGL_FBORING).
+//
+// A swap (as in glXSwapBuffers) is unbindMainFBO, blitMainFBO and bindMainFBO. In that order, on GLES:
+// - the main FBO is unbound before the blit, which draws in the window framebuffer (0)
+// - the blit reads the color buffer of the FBO the frame was rendered in, not the next one of the ring
+// - the next FBO of the ring is set up after the blit, and is bound for the next frame
+// - with a ring of n color buffers, frame k renders in the FBO of frame k-n, and in another one
+//   than the n-1 frames before it
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/framebuffers.h"
+#include "gl/gl4es.h"
+#include "gl/init.h"
+
+#define W 320
+#define H 200
+#define FRAMES 12
+#define MAX_NAMES 256
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+// GLES state, followed in the log
+static GLuint bound_fb = 0, bound_tex = 0;
+static GLuint fb_color[MAX_NAMES];  // texture attached to each framebuffer
+
+// follow the log from line "from" to line "to" (excluded)
+static void follow(int from, int to) {
+    for (int i=from; i<to; ++i) {
+        unsigned a, b, c, d;
+        const char *l = mock_log_line(i);
+        if(sscanf(l, "glBindFramebuffer %u %u", &a, &b)==2)
+            bound_fb = b;
+        else if(sscanf(l, "glBindTexture %u %u", &a, &b)==2 && a==GL_TEXTURE_2D)
+            bound_tex = b;
+        else if(sscanf(l, "glFramebufferTexture2D %u %u %u %u", &a, &b, &c, &d)==4 && b==GL_COLOR_ATTACHMENT0 && bound_fb<MAX_NAMES)
+            fb_color[bound_fb] = d;
+    }
+}
+
+static void check_swaps() {
+    const int ring = (globals4es.fbo_ring>1)?globals4es.fbo_ring:1;
+    GLuint frame_fb[FRAMES];
+    mock_clear_log();
+    createMainFBO(W, H);
+    follow(0, mock_log_size());
+    CHECK(glstate->fbo.mainfbo_fbo && bound_fb==glstate->fbo.mainfbo_fbo, "main FBO %u not bound (%u)", glstate->fbo.mainfbo_fbo, bound_fb);
+    for (int frame=0; frame<FRAMES; ++frame) {
+        frame_fb[frame] = bound_fb;
+        mock_clear_log();
+        glClear(GL_COLOR_BUFFER_BIT);
+        // the swap
+        unbindMainFBO();
+        blitMainFBO(0, 0, 0, 0);
+        bindMainFBO();
+        glClear(GL_COLOR_BUFFER_BIT);
+        const int draw = mock_find("glDrawArrays", 0), next = mock_find("glClear", mock_find("glDrawArrays", 0));
+        CHECK(draw>=0 && next>draw, "frame %d: no blit", frame);
+        if(draw<0 || next<draw)
+            break;
+        const GLuint color = (frame_fb[frame]<MAX_NAMES)?fb_color[frame_fb[frame]]:0;
+        follow(0, draw);
+        CHECK(bound_fb==0, "frame %d: blit in framebuffer %u", frame, bound_fb);
+        CHECK(color && bound_tex==color, "frame %d: blit of texture %u, the frame is in texture %u", frame, bound_tex, color);
+        const int bind = mock_find("glBindFramebuffer", draw);
+        CHECK(bind>draw && bind<next, "frame %d: the next FBO isn't bound after the blit", frame);
+        follow(draw, next);
+        CHECK(bound_fb==glstate->fbo.mainfbo_fbo, "frame %d: next frame in framebuffer %u, the main FBO is %u", frame, bound_fb, glstate->fbo.mainfbo_fbo);
+        follow(next, mock_log_size());
+        // the ring
+        if(frame>=ring) {
+            CHECK(frame_fb[frame]==frame_fb[frame-ring], "frame %d: in FBO %u, frame %d was in %u", frame, frame_fb[frame], frame-ring, frame_fb[frame-ring]);
+        }
+        for (int i=1; i<ring && i<=frame; ++i) {
+            CHECK(frame_fb[frame]!=frame_fb[frame-i], "frame %d: in the FBO of frame %d", frame, frame-i);
+        }
+    }
+    deleteMainFBO(glstate);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    CHECK(globals4es.usefbo, "LIBGL_FB=2 not set");
+    check_swaps();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
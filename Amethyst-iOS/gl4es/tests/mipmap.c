@@ -0,0 +1,216 @@
+// Mipmap generation check, against the GLES2 mock (mockgles.c).
+//
+// - pixel_halfscale, with its GL_UNSIGNED_BYTE fast path (SIMD, and split between the worker
+//   threads), must give the exact same bytes as the generic path: half_pixel on each 2x2 block,
+//   with gl4es own generic path for the 4 bytes formats. Odd sizes, 1xN / Nx1, random and
+//   extreme values, every byte format.
+// - glTexImage2D with GL_GENERATE_MIPMAP: the CPU chain uploaded must be the reference chain,
+//   and glGenerateMipmap must only be used when GLES can build the same chain.
+//
+// Run it with LIBGL_NOSIMD=1 and LIBGL_THREADS too.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/pixel.h"
+#include "glx/hardext.h"
+
+#ifndef GL_GENERATE_MIPMAP
+#define GL_GENERATE_MIPMAP 0x8191
+#endif
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+// not exported: same layouts as get_color_map in pixel.c
+static const colorlayout_t layouts[] = {
+    {GL_RED, 0, -1, -1, -1, 0},
+    {GL_RG, 0, 1, -1, -1, 0},
+    {GL_RGBA, 0, 1, 2, 3, 3},
+    {GL_RGB, 0, 1, 2, -1, 2},
+    {GL_BGRA, 2, 1, 0, 3, 3},
+    {GL_BGR, 2, 1, 0, -1, 2},
+    {GL_LUMINANCE_ALPHA, 0, 0, 0, 1, 1},
+    {GL_LUMINANCE, 0, 0, 0, -1, 0},
+    {GL_ALPHA, -1, -1, -1, 0, 0},
+};
+static const int bpps[] = {1, 2, 4, 3, 4, 3, 2, 1, 1};
+#define NFORMATS (sizeof(layouts)/sizeof(layouts[0]))
+
+// the GL_UNSIGNED_BYTE case of half_pixel (static in pixel.c), and the generic pixel_halfscale loop
+static void reference_half_pixel(const GLubyte *s0, const GLubyte *s1, const GLubyte *s2, const GLubyte *s3, GLubyte *d, const colorlayout_t *l) {
+    const GLint idx[4] = {l->red, l->green, l->blue, l->alpha};
+    for (int k=0; k<4; ++k)
+        if(idx[k]>=0) {
+            const int i = idx[k];
+            const GLfloat v = (s0[i] / 255.0f + s1[i] / 255.0f + s2[i] / 255.0f + s3[i] / 255.0f) * 0.25f;
+            d[i] = v * 255.0;
+        }
+}
+
+static GLubyte* reference_halfscale(const GLubyte *src, int width, int height, int f) {
+    const int bpp = bpps[f];
+    const int nw = width>1?width/2:1, nh = height>1?height/2:1;
+    const int dx = (width>1)?1:0, dy = (height>1)?1:0;
+    GLubyte *dst = malloc(nw*nh*bpp+1), *pos = dst;
+    for (int y=0; y<nh; ++y)
+        for (int x=0; x<nw; ++x, pos+=bpp) {
+            const GLubyte *p0 = src+((x*(dx+1))+(y*(dy+1))*width)*bpp;
+            reference_half_pixel(p0, p0+dx*bpp, p0+dy*width*bpp, p0+(dx+dy*width)*bpp, pos, &layouts[f]);
+        }
+    return dst;
+}
+
+// gl4es own generic path, still used for GL_UNSIGNED_INT_8_8_8_8: on little endian, that's the
+// same components with the bytes of each pixel reversed
+static GLubyte* generic_halfscale(const GLubyte *src, int width, int height, GLenum format) {
+    GLubyte *rev = malloc(width*height*4);
+    for (int i=0; i<width*height*4; ++i)
+        rev[i] = src[(i&~3)+3-(i&3)];
+    GLvoid *out = NULL;
+    pixel_halfscale(rev, &out, width, height, format, GL_UNSIGNED_INT_8_8_8_8);
+    GLubyte *ret = out;
+    const int n = (width>1?width/2:1)*(height>1?height/2:1)*4;
+    for (int i=0; i<n; i+=4) {
+        GLubyte t = ret[i]; ret[i] = ret[i+3]; ret[i+3] = t;
+        t = ret[i+1]; ret[i+1] = ret[i+2]; ret[i+2] = t;
+    }
+    free(rev);
+    return ret;
+}
+
+static unsigned seed = 12345;
+static int rnd() { seed = seed*1103515245+12345; return (seed>>16)&0x7fff; }
+
+static void fill(GLubyte *p, int n, int pattern) {
+    for (int i=0; i<n; ++i)
+        switch (pattern) {
+            case 0: p[i] = rnd()&0xff; break;
+            case 1: p[i] = (rnd()&1)?255:0; break;              // extremes
+            case 2: p[i] = 250+(rnd()%6); break;                // close to the top
+            default: p[i] = (i*7+(i>>5))&0xff; break;           // ramps
+        }
+}
+
+static void check_halfscale() {
+    static const int sizes[][2] = {{1,1}, {1,7}, {7,1}, {2,2}, {3,3}, {5,3}, {33,17}, {64,64}, {257,131}, {1024,96}};
+    for (int f=0; f<NFORMATS; ++f)
+        for (int s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s)
+            for (int pattern=0; pattern<4; ++pattern) {
+                const int w = sizes[s][0], h = sizes[s][1];
+                GLubyte *src = malloc(w*h*bpps[f]);
+                fill(src, w*h*bpps[f], pattern);
+                GLvoid *got = NULL;
+                pixel_halfscale(src, &got, w, h, layouts[f].type, GL_UNSIGNED_BYTE);
+                GLubyte *ref = reference_halfscale(src, w, h, f);
+                const int n = (w>1?w/2:1)*(h>1?h/2:1)*bpps[f];
+                int first = -1;
+                for (int i=0; i<n && first<0; ++i)
+                    if(((GLubyte*)got)[i]!=ref[i])
+                        first = i;
+                CHECK(first<0, "format 0x%04X %dx%d pattern %d: byte %d is %d, expected %d", layouts[f].type, w, h, pattern,
+                    first, first<0?0:((GLubyte*)got)[first], first<0?0:ref[first]);
+#ifndef __BIG_ENDIAN__
+                if(bpps[f]==4) {
+                    GLubyte *gen = generic_halfscale(src, w, h, layouts[f].type);
+                    CHECK(!memcmp(gen, got, n), "format 0x%04X %dx%d pattern %d: differs from the generic path", layouts[f].type, w, h, pattern);
+                    free(gen);
+                }
+#endif
+                free(got); free(ref); free(src);
+            }
+}
+
+// all the 4-tuples of a few values, where the float rounding of the average matters
+static void check_sweep() {
+    static const GLubyte v[] = {0, 1, 2, 3, 63, 64, 127, 128, 129, 191, 192, 253, 254, 255};
+    const int nv = sizeof(v), n = nv*nv*nv*nv;
+    // one 2x2 block per tuple, in a 2x(2n) LUMINANCE image, and the same in RGBA
+    GLubyte *lum = malloc(4*n), *rgba = malloc(16*n);
+    for (int i=0; i<n; ++i) {
+        const GLubyte t[4] = {v[i%nv], v[(i/nv)%nv], v[(i/nv/nv)%nv], v[i/nv/nv/nv]};
+        lum[2*i] = t[0]; lum[2*i+1] = t[1]; lum[2*n+2*i] = t[2]; lum[2*n+2*i+1] = t[3];
+        for (int c=0; c<4; ++c) {
+            rgba[(2*i)*4+c] = t[(c+0)&3]; rgba[(2*i+1)*4+c] = t[(c+1)&3];
+            rgba[(2*n+2*i)*4+c] = t[(c+2)&3]; rgba[(2*n+2*i+1)*4+c] = t[(c+3)&3];
+        }
+    }
+    const int fl = 7, fr = 2;   // LUMINANCE and RGBA in layouts
+    GLvoid *got;
+    pixel_halfscale(lum, &got, 2*n, 2, GL_LUMINANCE, GL_UNSIGNED_BYTE);
+    GLubyte *ref = reference_halfscale(lum, 2*n, 2, fl);
+    CHECK(!memcmp(got, ref, n), "LUMINANCE sweep differs");
+    free(got); free(ref);
+    pixel_halfscale(rgba, &got, 2*n, 2, GL_RGBA, GL_UNSIGNED_BYTE);
+    ref = reference_halfscale(rgba, 2*n, 2, fr);
+    CHECK(!memcmp(got, ref, 4*n), "RGBA sweep differs");
+    free(ref);
+#ifndef __BIG_ENDIAN__
+    ref = generic_halfscale(rgba, 2*n, 2, GL_RGBA);
+    CHECK(!memcmp(got, ref, 4*n), "RGBA sweep differs from the generic path");
+    free(ref);
+#endif
+    free(got);
+    free(lum); free(rgba);
+}
+
+// upload a texture with GL_GENERATE_MIPMAP, check what reaches GLES
+static void check_upload(GLenum format, int w, int h, int expect_gpu) {
+    const int f = (format==GL_RGBA)?2:(format==GL_RGB)?3:7;
+    GLubyte *src = malloc(w*h*bpps[f]);
+    fill(src, w*h*bpps[f], 0);
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    mock_clear_log();
+    glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, format, GL_UNSIGNED_BYTE, src);
+    const int gpu = mock_count("glGenerateMipmap");
+    CHECK(gpu==expect_gpu, "format 0x%04X %dx%d: %d glGenerateMipmap, expected %d", format, w, h, gpu, expect_gpu);
+    if(gpu) {
+        CHECK(mock_count("glTexImage2D")==1, "format 0x%04X %dx%d: %d glTexImage2D with glGenerateMipmap", format, w, h, mock_count("glTexImage2D"));
+    } else {
+        // compare every level with the reference chain
+        GLubyte *ref = src;
+        int lw = w, lh = h, level = 0;
+        for (;;) {
+            int gw, gh; GLenum gf, gt;
+            const GLubyte *got = mock_tex_level(level, &gw, &gh, &gf, &gt);
+            CHECK(got && gw==lw && gh==lh && gf==format && gt==GL_UNSIGNED_BYTE, "format 0x%04X %dx%d: level %d is %dx%d 0x%04X, expected %dx%d",
+                format, w, h, level, got?gw:0, got?gh:0, got?gf:0, lw, lh);
+            if(!got || gw!=lw || gh!=lh || gf!=format) break;
+            CHECK(!memcmp(got, ref, lw*lh*bpps[f]), "format 0x%04X %dx%d: level %d differs", format, w, h, level);
+            if(lw==1 && lh==1) break;
+            GLubyte *next = reference_halfscale(ref, lw, lh, f);
+            if(ref!=src) free(ref);
+            ref = next;
+            lw = lw>1?lw/2:1; lh = lh>1?lh/2:1; ++level;
+        }
+        if(ref!=src) free(ref);
+    }
+    glDeleteTextures(1, &tex);
+    free(src);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    check_halfscale();
+    check_sweep();
+    hardext.npot = 2;
+    hardext.rgba8 = 1;
+    check_upload(GL_RGBA, 64, 32, 1);
+    check_upload(GL_RGB, 16, 16, 1);
+    check_upload(GL_LUMINANCE, 64, 16, 0);
+    check_upload(GL_LUMINANCE, 37, 11, 0);
+    hardext.rgba8 = 0;      // RGBA8 is not renderable
+    check_upload(GL_RGBA, 32, 32, 0);
+    check_upload(GL_RGB, 20, 12, 0);
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,635 @@
+#include "mockgles.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gl4esinit.h>
+
+#define MAX_BUFFERS 4096
+
+long mock_draws = 0;
+long mock_uploaded = 0;
+const void *mock_indices = NULL;
+
+static unsigned next_id = 1;
+
+// ---- call log ----
+
+static char **log_lines = NULL;
+static int log_n = 0, log_max = 0;
+
+static void mock_log(const char *fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if(log_n==log_max) {
+        log_max = log_max*2+256;
+        log_lines = realloc(log_lines, log_max*sizeof(char*));
+    }
+    log_lines[log_n++] = strdup(buf);
+}
+
+void mock_clear_log(void) {
+    for (int i=0; i<log_n; ++i)
+        free(log_lines[i]);
+    log_n = 0;
+}
+
+int mock_log_size(void) { return log_n; }
+const char* mock_log_line(int i) { return (i>=0 && i<log_n)?log_lines[i]:NULL; }
+
+static int is_call(const char *line, const char *name) {
+    int l = strlen(name);
+    return !strncmp(line, name, l) && (line[l]==' ' || line[l]=='\0');
+}
+
+int mock_count(const char *name) {
+    int n = 0;
+    for (int i=0; i<log_n; ++i)
+        if(is_call(log_lines[i], name))
+            ++n;
+    return n;
+}
+
+int mock_find(const char *name, int from) {
+    for (int i=(from<0)?0:from; i<log_n; ++i)
+        if(is_call(log_lines[i], name))
+            return i;
+    return -1;
+}
+
+void mock_dump_log(void) {
+    for (int i=0; i<log_n; ++i)
+        printf("  %4d %s\n", i, log_lines[i]);
+}
+
+// ---- objects ----
+
+static long m_stub() { return 0; }
+static unsigned m_create() { return next_id++; }
+static void m_gen(GLsizei n, GLuint *ids) { for (int i=0; i<n; ++i) ids[i] = next_id++; }
+const char *mock_glsl_reject = NULL;
+static int rejected = 0;    // of the last glShaderSource
+static void m_shadersource(GLuint shader, GLsizei count, const char *const *string, const GLint *length) {
+    rejected = 0;
+    if(mock_glsl_reject)
+        for (int i=0; i<count; ++i)
+            if(string[i] && strstr(string[i], mock_glsl_reject))
+                rejected = 1;
+}
+static void m_getiv(GLuint obj, GLenum pname, GLint *v) {
+    switch (pname) {
+        case 0x8B81: // GL_COMPILE_STATUS
+            *v = !rejected; break;
+        case 0x8B82: // GL_LINK_STATUS
+            *v = 1; break;
+        case 0x8B89: // GL_ACTIVE_ATTRIBUTES
+            *v = MOCK_MAX_ATTRIBS; break;
+        case 0x8B8A: // GL_ACTIVE_ATTRIBUTE_MAX_LENGTH
+            *v = 32; break;
+        case 0x8B86: // GL_ACTIVE_UNIFORMS
+            *v = mock_num_uniforms; break;
+        case 0x8B87: // GL_ACTIVE_UNIFORM_MAX_LENGTH
+            *v = 64; break;
+        default:
+            *v = 0;
+    }
+}
+const char *mock_extensions = "";
+const char *mock_vendor = "";
+static const GLubyte* m_getstring(GLenum name) {
+    switch (name) {
+        case GL_EXTENSIONS: return (const GLubyte*)mock_extensions;
+        case GL_VENDOR: return (const GLubyte*)mock_vendor;
+    }
+    return (const GLubyte*)"";
+}
+// attributes are named "a<location>"
+static void m_activeattrib(GLuint prog, GLuint index, GLsizei bufsize, GLsizei *len, GLint *size, GLenum *type, char *name) {
+    *size = 1;
+    *type = GL_FLOAT_VEC4;
+    snprintf(name, bufsize, "a%u", index);
+    if(len) *len = strlen(name);
+}
+static GLint m_location(GLuint prog, const char *name) {
+    if(name[0]=='a' && name[1]>='0' && name[1]<='9')
+        return atoi(name+1);
+    return 1;
+}
+
+// ---- uniforms ----
+// uniform i is at location 100*(i+1), its elements at the next ones
+
+#define MAX_UNIFORM_VALUES 1024
+
+const mock_uniform_t *mock_uniforms = NULL;
+int mock_num_uniforms = 0;
+static struct { GLuint program; GLint location; float v[16]; } uniform_values[MAX_UNIFORM_VALUES];
+static int nuniform_values = 0;
+
+static void m_activeuniform(GLuint prog, GLuint index, GLsizei bufsize, GLsizei *len, GLint *size, GLenum *type, char *name) {
+    *size = mock_uniforms[index].size;
+    *type = mock_uniforms[index].type;
+    snprintf(name, bufsize, "%s%s", mock_uniforms[index].name, (*size>1)?"[0]":"");
+    if(len) *len = strlen(name);
+}
+static GLint m_uniformlocation(GLuint prog, const char *name) {
+    for (int i=0; i<mock_num_uniforms; ++i)
+        if(!strcmp(name, mock_uniforms[i].name))
+            return 100*(i+1);
+    return m_location(prog, name);
+}
+
+static float* uniform_value(GLuint program, GLint location) {
+    for (int i=0; i<nuniform_values; ++i)
+        if(uniform_values[i].program==program && uniform_values[i].location==location)
+            return uniform_values[i].v;
+    if(nuniform_values==MAX_UNIFORM_VALUES)
+        return NULL;
+    uniform_values[nuniform_values].program = program;
+    uniform_values[nuniform_values].location = location;
+    memset(uniform_values[nuniform_values].v, 0, sizeof(uniform_values[0].v));
+    return uniform_values[nuniform_values++].v;
+}
+const float* mock_uniform(GLuint program, GLint location) {
+    for (int i=0; i<nuniform_values; ++i)
+        if(uniform_values[i].program==program && uniform_values[i].location==location)
+            return uniform_values[i].v;
+    return NULL;
+}
+
+static void set_uniform(const char *func, GLint location, GLsizei count, int n, const GLfloat *fv, const GLint *iv) {
+    mock_log("%s %d %d", func, location, count);
+    for (int e=0; e<count; ++e) {
+        float *v = uniform_value(mock_program, location+e);
+        if(v)
+            for (int i=0; i<n; ++i)
+                v[i] = fv?fv[e*n+i]:iv[e*n+i];
+    }
+}
+#define UNIFORMFV(N) \
+    static void m_uniform##N##fv(GLint location, GLsizei count, const GLfloat *v) { set_uniform("glUniform" #N "fv", location, count, N, v, NULL); } \
+    static void m_uniform##N##iv(GLint location, GLsizei count, const GLint *v) { set_uniform("glUniform" #N "iv", location, count, N, NULL, v); }
+UNIFORMFV(1) UNIFORMFV(2) UNIFORMFV(3) UNIFORMFV(4)
+#undef UNIFORMFV
+#define UNIFORMMATRIX(N) \
+    static void m_uniformmatrix##N##fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *v) { set_uniform("glUniformMatrix" #N "fv", location, count, N*N, v, NULL); }
+UNIFORMMATRIX(2) UNIFORMMATRIX(3) UNIFORMMATRIX(4)
+#undef UNIFORMMATRIX
+
+// ---- GLES state ----
+// what the setters below received, read back by glGet / glIsEnabled (16 for everything else,
+// the limits like GL_MAX_TEXTURE_SIZE)
+
+#define MAX_VALUES 64
+#define MAX_CAPS 64
+
+static struct { GLenum pname; GLfloat v[4]; } values[MAX_VALUES];
+static int nvalues = 0;
+static GLenum caps[MAX_CAPS];
+static int ncaps = 0;
+
+static GLfloat* value(GLenum pname) {
+    for (int i=0; i<nvalues; ++i)
+        if(values[i].pname==pname)
+            return values[i].v;
+    return NULL;
+}
+static void set_value(GLenum pname, GLfloat a, GLfloat b, GLfloat c, GLfloat d) {
+    GLfloat *v = value(pname);
+    if(!v) {
+        if(nvalues==MAX_VALUES) return;
+        values[nvalues].pname = pname;
+        v = values[nvalues++].v;
+    }
+    v[0] = a; v[1] = b; v[2] = c; v[3] = d;
+}
+static void m_getintegerv(GLenum pname, GLint *v) {
+    const GLfloat *f = value(pname);
+    if(!f) { *v = 16; return; }
+    for (int i=0; i<4; ++i) v[i] = f[i];
+}
+static void m_getfloatv(GLenum pname, GLfloat *v) {
+    const GLfloat *f = value(pname);
+    if(!f) { *v = 16.0f; return; }
+    memcpy(v, f, 4*sizeof(GLfloat));
+}
+static void m_getbooleanv(GLenum pname, GLboolean *v) {
+    const GLfloat *f = value(pname);
+    if(!f) { *v = GL_TRUE; return; }
+    for (int i=0; i<4; ++i) v[i] = f[i]?GL_TRUE:GL_FALSE;
+}
+static GLboolean m_isenabled(GLenum cap) {
+    for (int i=0; i<ncaps; ++i)
+        if(caps[i]==cap)
+            return GL_TRUE;
+    return GL_FALSE;
+}
+static void m_enable(GLenum cap) {
+    mock_log("glEnable %u", cap);
+    if(!m_isenabled(cap) && ncaps<MAX_CAPS)
+        caps[ncaps++] = cap;
+}
+static void m_disable(GLenum cap) {
+    mock_log("glDisable %u", cap);
+    for (int i=0; i<ncaps; ++i)
+        if(caps[i]==cap)
+            caps[i] = caps[--ncaps];
+}
+static void m_blendfunc(GLenum src, GLenum dst) {
+    mock_log("glBlendFunc %u %u", src, dst);
+    set_value(0x80CB, src, 0, 0, 0); set_value(0x80C9, src, 0, 0, 0);  // GL_BLEND_SRC_ALPHA / RGB
+    set_value(0x80CA, dst, 0, 0, 0); set_value(0x80C8, dst, 0, 0, 0);  // GL_BLEND_DST_ALPHA / RGB
+}
+static void m_depthfunc(GLenum func) { mock_log("glDepthFunc %u", func); set_value(GL_DEPTH_FUNC, func, 0, 0, 0); }
+static void m_depthmask(GLboolean mask) { mock_log("glDepthMask %u", mask); set_value(GL_DEPTH_WRITEMASK, mask, 0, 0, 0); }
+static void m_depthrangef(GLfloat n, GLfloat f) { mock_log("glDepthRangef %g %g", n, f); set_value(GL_DEPTH_RANGE, n, f, 0, 0); }
+static void m_colormask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) { mock_log("glColorMask %u %u %u %u", r, g, b, a); set_value(GL_COLOR_WRITEMASK, r, g, b, a); }
+static void m_clearcolor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) { mock_log("glClearColor %g %g %g %g", r, g, b, a); set_value(GL_COLOR_CLEAR_VALUE, r, g, b, a); }
+static void m_cleardepthf(GLfloat d) { mock_log("glClearDepthf %g", d); set_value(GL_DEPTH_CLEAR_VALUE, d, 0, 0, 0); }
+static void m_clearstencil(GLint s) { mock_log("glClearStencil %d", s); set_value(GL_STENCIL_CLEAR_VALUE, s, 0, 0, 0); }
+static void m_linewidth(GLfloat w) { mock_log("glLineWidth %g", w); set_value(GL_LINE_WIDTH, w, 0, 0, 0); }
+static void m_viewport(GLint x, GLint y, GLsizei w, GLsizei h) { mock_log("glViewport %d %d %d %d", x, y, w, h); set_value(GL_VIEWPORT, x, y, w, h); }
+static void m_scissor(GLint x, GLint y, GLsizei w, GLsizei h) { mock_log("glScissor %d %d %d %d", x, y, w, h); set_value(GL_SCISSOR_BOX, x, y, w, h); }
+static void m_stencilfunc(GLenum func, GLint ref, GLuint mask) {
+    mock_log("glStencilFunc %u %d %u", func, ref, mask);
+    set_value(GL_STENCIL_FUNC, func, 0, 0, 0); set_value(GL_STENCIL_REF, ref, 0, 0, 0); set_value(GL_STENCIL_VALUE_MASK, mask, 0, 0, 0);
+}
+static void m_stencilop(GLenum sfail, GLenum dpfail, GLenum dppass) {
+    mock_log("glStencilOp %u %u %u", sfail, dpfail, dppass);
+    set_value(GL_STENCIL_FAIL, sfail, 0, 0, 0); set_value(GL_STENCIL_PASS_DEPTH_FAIL, dpfail, 0, 0, 0); set_value(GL_STENCIL_PASS_DEPTH_PASS, dppass, 0, 0, 0);
+}
+
+// GLES initial state
+static void __attribute__((constructor)) init_state(void) {
+    m_blendfunc(GL_ONE, GL_ZERO);
+    m_depthfunc(GL_LESS);
+    m_depthmask(GL_TRUE);
+    m_depthrangef(0.0f, 1.0f);
+    m_colormask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    m_clearcolor(0.0f, 0.0f, 0.0f, 0.0f);
+    m_cleardepthf(1.0f);
+    m_clearstencil(0);
+    m_linewidth(1.0f);
+    m_viewport(0, 0, 0, 0);
+    m_scissor(0, 0, 0, 0);
+    m_stencilfunc(GL_ALWAYS, 0, ~0u);
+    m_stencilop(GL_KEEP, GL_KEEP, GL_KEEP);
+    m_enable(GL_DITHER);
+    mock_clear_log();
+}
+
+// ---- textures ----
+// the last image uploaded for each level, whatever the texture
+
+#define MAX_LEVELS 16
+
+static struct {
+    GLsizei w, h;
+    GLenum format, type;
+    GLubyte *data;
+} levels[MAX_LEVELS];
+
+static int m_pixelsize(GLenum format, GLenum type) {
+    if(type!=GL_UNSIGNED_BYTE)
+        return (type==GL_FLOAT)?16:2;
+    switch (format) {
+        case GL_RGBA: return 4;
+        case GL_RGB: return 3;
+        case GL_LUMINANCE_ALPHA: return 2;
+        default: return 1;
+    }
+}
+
+static void m_bindtexture(GLenum target, GLuint tex) { mock_log("glBindTexture %u %u", target, tex); }
+static void m_teximage2d(GLenum target, GLint level, GLint internalformat, GLsizei w, GLsizei h, GLint border, GLenum format, GLenum type, const void *pixels) {
+    mock_log("glTexImage2D %u %d %d %d %u %u%s", target, level, w, h, format, type, pixels?"":" NULL");
+    if(level<0 || level>=MAX_LEVELS) return;
+    const int size = w*h*m_pixelsize(format, type);
+    levels[level].w = w; levels[level].h = h;
+    levels[level].format = format; levels[level].type = type;
+    levels[level].data = realloc(levels[level].data, size+1);
+    if(pixels)
+        memcpy(levels[level].data, pixels, size);
+    else
+        memset(levels[level].data, 0, size);
+}
+static void m_texsubimage2d(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void *pixels) {
+    mock_log("glTexSubImage2D %u %d %d %d %d %d %u %u", target, level, x, y, w, h, format, type);
+    if(level<0 || level>=MAX_LEVELS || !levels[level].data) return;
+    const int bpp = m_pixelsize(format, type);
+    for (int j=0; j<h && y+j<levels[level].h; ++j)
+        memcpy(levels[level].data+((y+j)*levels[level].w+x)*bpp, (const GLubyte*)pixels+j*w*bpp, w*bpp);
+}
+
+const void* mock_tex_level(int level, int *w, int *h, GLenum *format, GLenum *type) {
+    if(level<0 || level>=MAX_LEVELS || !levels[level].data) return NULL;
+    *w = levels[level].w; *h = levels[level].h;
+    *format = levels[level].format; *type = levels[level].type;
+    return levels[level].data;
+}
+
+// ---- buffers and vertex attributes ----
+
+typedef struct {
+    unsigned char *data;
+    long size;
+} mbuf_t;
+
+typedef struct {
+    int size, stride, enabled;
+    unsigned buf;
+    const void *ptr;
+} mattrib_t;
+
+static mbuf_t buffers[MAX_BUFFERS];
+static mattrib_t attribs[MOCK_MAX_ATTRIBS];
+static unsigned cur_array = 0, cur_elem = 0;
+
+static unsigned* m_bound(GLenum target) { return (target==GL_ELEMENT_ARRAY_BUFFER)?&cur_elem:&cur_array; }
+static void m_bindbuffer(GLenum target, GLuint buf) { *m_bound(target) = buf; }
+static void m_bufferdata(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+    unsigned b = *m_bound(target);
+    mock_log("glBufferData %u %ld", b, (long)size);
+    mock_uploaded += size;
+    if(b>=MAX_BUFFERS) return;
+    buffers[b].data = realloc(buffers[b].data, size);
+    buffers[b].size = size;
+    if(data) memcpy(buffers[b].data, data, size);
+}
+static void m_buffersubdata(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+    unsigned b = *m_bound(target);
+    mock_log("glBufferSubData %u %ld %ld", b, (long)offset, (long)size);
+    mock_uploaded += size;
+    if(b>=MAX_BUFFERS) return;
+    memcpy(buffers[b].data+offset, data, size);
+}
+static void m_attribpointer(GLuint i, GLint size, GLenum type, GLboolean norm, GLsizei stride, const void *ptr) {
+    if(i>=MOCK_MAX_ATTRIBS) return;
+    attribs[i].size = size;
+    attribs[i].stride = stride?stride:size*sizeof(GLfloat);
+    attribs[i].buf = cur_array;
+    attribs[i].ptr = ptr;
+}
+static void m_enableattrib(GLuint i) { if(i<MOCK_MAX_ATTRIBS) attribs[i].enabled = 1; }
+static void m_disableattrib(GLuint i) { if(i<MOCK_MAX_ATTRIBS) attribs[i].enabled = 0; }
+
+const void* mock_attrib_pointer(int index) {
+    return attribs[index].enabled?attribs[index].ptr:NULL;
+}
+
+// ---- draw capture ----
+
+static const int cap_attribs[4] = {0, 2, 3, 8};   // fixed pipeline attributes locations
+static int capturing = 0;
+static float *cap = NULL;
+static long cap_n = 0, cap_max = 0;
+
+void mock_capture(int on) {
+    capturing = on;
+    if(on)
+        cap_n = 0;
+}
+long mock_captured(void) { return cap_n; }
+const float* mock_capture_data(void) { return cap; }
+
+static void cap_vertex(unsigned idx) {
+    if(cap_n+MOCK_CAP_SIZE>cap_max) {
+        cap_max = cap_max*2+4096;
+        cap = realloc(cap, cap_max*sizeof(float));
+    }
+    for (int a=0; a<4; ++a) {
+        mattrib_t *v = &attribs[cap_attribs[a]];
+        float *o = cap+cap_n+a*4;
+        if(!v->enabled) {
+            o[0] = o[1] = o[2] = o[3] = MOCK_NOT_ARRAY;
+            continue;
+        }
+        const unsigned char *base = v->buf?buffers[v->buf].data+(uintptr_t)v->ptr:(const unsigned char*)v->ptr;
+        const float *f = (const float*)(base+(long)idx*v->stride);
+        o[0] = o[1] = o[2] = 0.0f; o[3] = 1.0f;
+        for (int k=0; k<v->size; ++k)
+            o[k] = f[k];
+    }
+    cap_n += MOCK_CAP_SIZE;
+}
+static void capture(GLenum mode, GLsizei count, GLenum type, const void *indices, GLint first) {
+    // type is 0 for glDrawArrays
+    const unsigned char *ind = cur_elem?buffers[cur_elem].data+(uintptr_t)indices:(const unsigned char*)indices;
+    #define V(i) cap_vertex(type?((type==GL_UNSIGNED_SHORT)?((const GLushort*)ind)[i]:((const GLuint*)ind)[i]):(unsigned)(first+(i)))
+    switch (mode) {
+        case GL_POINTS:
+        case GL_LINES:
+        case GL_TRIANGLES:
+            for (int i=0; i<count; ++i) V(i);
+            break;
+        case GL_LINE_STRIP:
+            for (int i=0; i+1<count; ++i) { V(i); V(i+1); }
+            break;
+        case GL_TRIANGLE_STRIP:
+            for (int i=0; i+2<count; ++i)
+                if(i&1) { V(i+1); V(i); V(i+2); } else { V(i); V(i+1); V(i+2); }
+            break;
+        case GL_TRIANGLE_FAN:
+            for (int i=1; i+1<count; ++i) { V(0); V(i); V(i+1); }
+            break;
+        default:
+            printf("capture: unexpected mode 0x%04X\n", mode);
+    }
+    #undef V
+}
+static void m_drawarrays(GLenum mode, GLint first, GLsizei count) {
+    mock_log("glDrawArrays %u %d %d", mode, first, count);
+    ++mock_draws;
+    if(capturing) capture(mode, count, 0, NULL, first);
+}
+static void m_drawelements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+    mock_log("glDrawElements %u %d %u", mode, count, type);
+    ++mock_draws;
+    mock_indices = indices;
+    if(capturing) capture(mode, count, type, indices, 0);
+}
+
+// ---- framebuffers ----
+// gl4es looks these ones up directly in the GLES library (LIBGL_GLES), so they are exported
+// with their GLES names (the GL/gl.h prototypes are only the GL 1.x ones)
+
+void glGenFramebuffers(GLsizei n, GLuint *ids) { m_gen(n, ids); }
+void glGenRenderbuffers(GLsizei n, GLuint *ids) { m_gen(n, ids); }
+void glDeleteFramebuffers(GLsizei n, const GLuint *ids) { for (int i=0; i<n; ++i) mock_log("glDeleteFramebuffers %u", ids[i]); }
+void glDeleteRenderbuffers(GLsizei n, const GLuint *ids) { for (int i=0; i<n; ++i) mock_log("glDeleteRenderbuffers %u", ids[i]); }
+void glBindFramebuffer(GLenum target, GLuint fb) { mock_log("glBindFramebuffer %u %u", target, fb); }
+void glBindRenderbuffer(GLenum target, GLuint rb) { mock_log("glBindRenderbuffer %u %u", target, rb); }
+GLboolean glIsFramebuffer(GLuint fb) { return fb?GL_TRUE:GL_FALSE; }
+GLenum glCheckFramebufferStatus(GLenum target) { mock_log("glCheckFramebufferStatus %u", target); return 0x8CD5; } // GL_FRAMEBUFFER_COMPLETE
+void glFramebufferTexture2D(GLenum target, GLenum attach, GLenum textarget, GLuint tex, GLint level) { mock_log("glFramebufferTexture2D %u %u %u %u %d", target, attach, textarget, tex, level); }
+void glFramebufferRenderbuffer(GLenum target, GLenum attach, GLenum rbtarget, GLuint rb) { mock_log("glFramebufferRenderbuffer %u %u %u %u", target, attach, rbtarget, rb); }
+void glRenderbufferStorage(GLenum target, GLenum format, GLsizei w, GLsizei h) { mock_log("glRenderbufferStorage %u %u %d %d", target, format, w, h); }
+void glGetFramebufferAttachmentParameteriv(GLenum target, GLenum attach, GLenum pname, GLint *v) { *v = 0; }
+void glGetRenderbufferParameteriv(GLenum target, GLenum pname, GLint *v) { *v = 0; }
+void glGenerateMipmap(GLenum target) { mock_log("glGenerateMipmap %u", target); }
+void glBlendFuncSeparate(GLenum srgb, GLenum drgb, GLenum salpha, GLenum dalpha) { }
+void glBlendEquation(GLenum mode) { }
+void glBlendEquationSeparate(GLenum rgb, GLenum alpha) { }
+void glStencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask) { }
+void glStencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass) { }
+void glStencilMaskSeparate(GLenum face, GLuint mask) { }
+// also called while gl4es initializes, before set_getprocaddress
+void glGetIntegerv(GLenum pname, GLint *v) { m_getintegerv(pname, v); }
+
+// ---- occlusion queries (GL_EXT_occlusion_query_boolean) ----
+
+#define MAX_QUERIES 256
+
+int mock_query_result = 1;
+int mock_query_delay = 0;
+static int query_polls[MAX_QUERIES];
+
+static void m_genqueries(GLsizei n, GLuint *ids) {
+    for (int i=0; i<n; ++i) {
+        ids[i] = next_id++;
+        mock_log("glGenQueries %u", ids[i]);
+    }
+}
+static void m_deletequeries(GLsizei n, const GLuint *ids) { for (int i=0; i<n; ++i) mock_log("glDeleteQueries %u", ids[i]); }
+static void m_beginquery(GLenum target, GLuint id) {
+    mock_log("glBeginQuery %u %u", target, id);
+    if(id<MAX_QUERIES) query_polls[id] = 0;
+}
+static void m_endquery(GLenum target) { mock_log("glEndQuery %u", target); }
+static void m_getqueryobjectuiv(GLuint id, GLenum pname, GLuint *v) {
+    mock_log("glGetQueryObjectuiv %u %u", id, pname);
+    if(pname==0x8867) { // GL_QUERY_RESULT_AVAILABLE
+        *v = (id<MAX_QUERIES && query_polls[id]++>=mock_query_delay)?GL_TRUE:GL_FALSE;
+    } else
+        *v = mock_query_result;
+}
+
+// ---- programs ----
+
+#define MAX_PROGRAMS 1024
+
+GLuint mock_program = 0;
+static char programs[MAX_PROGRAMS];    // 1 for the programs created and not deleted
+
+static unsigned m_createprogram() {
+    unsigned id = next_id++;
+    if(id<MAX_PROGRAMS) programs[id] = 1;
+    mock_log("glCreateProgram %u", id);
+    return id;
+}
+static void m_deleteprogram(GLuint id) {
+    if(id<MAX_PROGRAMS) programs[id] = 0;
+    mock_log("glDeleteProgram %u", id);
+}
+static void m_useprogram(GLuint id) {
+    mock_program = id;
+    mock_log("glUseProgram %u", id);
+}
+int mock_program_alive(GLuint id) { return id<MAX_PROGRAMS && programs[id]; }
+
+// ---- EGL, for the hardware probe ----
+// one display, one config, one pbuffer and one context, all handle 1
+
+const char *mock_egl_vendor = "Mock";
+
+static unsigned m_egltrue() { return 1; }
+static void* m_eglhandle() { return (void*)1; }
+static unsigned m_eglchooseconfig(void *dpy, const int *attribs, void **configs, int size, int *num) {
+    if(configs && size) configs[0] = (void*)1;
+    *num = 1;
+    return 1;
+}
+static void* m_eglcreatecontext(void *dpy, void *config, void *share, const int *attribs) {
+    mock_log("eglCreateContext");
+    return (void*)1;
+}
+static const char* m_eglquerystring(void *dpy, int name) {
+    switch (name) {
+        case 0x3053: return mock_egl_vendor;    // EGL_VENDOR
+        case 0x3054: return "1.4";              // EGL_VERSION
+        case 0x308D: return "OpenGL_ES";        // EGL_CLIENT_APIS
+    }
+    return "";
+}
+
+// ---- other logged calls, name only ----
+
+#define LOGGED(name) static long m_##name() { mock_log(#name); return 0; }
+#define LOGGED_LIST \
+    _(glBlendColor) _(glClear) _(glCullFace) _(glFrontFace) _(glPolygonOffset) _(glStencilMask) _(glHint) _(glActiveTexture) _(glTexParameteri) \
+    _(glTexParameterf) _(glPixelStorei) _(glReadPixels) _(glFlush) _(glFinish)
+#define _(name) LOGGED(name)
+LOGGED_LIST
+#undef _
+
+// ---- lookup ----
+
+static const struct { const char *name; void *proc; } procs[] = {
+    {"glCreateProgram", m_createprogram}, {"glDeleteProgram", m_deleteprogram}, {"glUseProgram", m_useprogram},
+    {"glCreateShader", m_create},
+    {"glGenBuffers", m_gen}, {"glGenTextures", m_gen}, {"glGenFramebuffers", glGenFramebuffers}, {"glGenRenderbuffers", glGenRenderbuffers},
+    {"glGetShaderiv", m_getiv}, {"glGetProgramiv", m_getiv},
+    {"glGetIntegerv", m_getintegerv}, {"glGetFloatv", m_getfloatv}, {"glGetBooleanv", m_getbooleanv},
+    {"glIsEnabled", m_isenabled}, {"glEnable", m_enable}, {"glDisable", m_disable}, {"glBlendFunc", m_blendfunc},
+    {"glDepthFunc", m_depthfunc}, {"glDepthMask", m_depthmask}, {"glDepthRangef", m_depthrangef},
+    {"glColorMask", m_colormask}, {"glClearColor", m_clearcolor}, {"glClearDepthf", m_cleardepthf},
+    {"glClearStencil", m_clearstencil}, {"glLineWidth", m_linewidth}, {"glViewport", m_viewport},
+    {"glScissor", m_scissor}, {"glStencilFunc", m_stencilfunc}, {"glStencilOp", m_stencilop},
+    {"glBindTexture", m_bindtexture}, {"glTexImage2D", m_teximage2d}, {"glTexSubImage2D", m_texsubimage2d},
+    {"glGetString", m_getstring},
+    {"glGetActiveAttrib", m_activeattrib},
+    {"glGetAttribLocation", m_location}, {"glGetUniformLocation", m_uniformlocation}, {"glGetActiveUniform", m_activeuniform},
+    {"glUniform1fv", m_uniform1fv}, {"glUniform2fv", m_uniform2fv}, {"glUniform3fv", m_uniform3fv}, {"glUniform4fv", m_uniform4fv},
+    {"glUniform1iv", m_uniform1iv}, {"glUniform2iv", m_uniform2iv}, {"glUniform3iv", m_uniform3iv}, {"glUniform4iv", m_uniform4iv},
+    {"glUniformMatrix2fv", m_uniformmatrix2fv}, {"glUniformMatrix3fv", m_uniformmatrix3fv}, {"glUniformMatrix4fv", m_uniformmatrix4fv},
+    {"glBindBuffer", m_bindbuffer}, {"glBufferData", m_bufferdata}, {"glBufferSubData", m_buffersubdata},
+    {"glVertexAttribPointer", m_attribpointer},
+    {"glEnableVertexAttribArray", m_enableattrib}, {"glDisableVertexAttribArray", m_disableattrib},
+    {"glDrawArrays", m_drawarrays}, {"glDrawElements", m_drawelements},
+    {"glBindFramebuffer", glBindFramebuffer}, {"glBindRenderbuffer", glBindRenderbuffer},
+    {"glDeleteFramebuffers", glDeleteFramebuffers}, {"glDeleteRenderbuffers", glDeleteRenderbuffers},
+    {"glCheckFramebufferStatus", glCheckFramebufferStatus}, {"glFramebufferTexture2D", glFramebufferTexture2D},
+    {"glShaderSource", m_shadersource},
+    {"eglGetDisplay", m_eglhandle}, {"eglInitialize", m_egltrue}, {"eglBindAPI", m_egltrue},
+    {"eglChooseConfig", m_eglchooseconfig}, {"eglCreateContext", m_eglcreatecontext},
+    {"eglCreatePbufferSurface", m_eglhandle}, {"eglMakeCurrent", m_egltrue}, {"eglQueryString", m_eglquerystring},
+    {"eglDestroySurface", m_egltrue}, {"eglDestroyContext", m_egltrue}, {"eglTerminate", m_egltrue},
+    {"glGenQueries", m_genqueries}, {"glDeleteQueries", m_deletequeries},
+    {"glBeginQuery", m_beginquery}, {"glEndQuery", m_endquery}, {"glGetQueryObjectuiv", m_getqueryobjectuiv},
+    #define _(name) {#name, m_##name},
+    LOGGED_LIST
+    #undef _
+};
+
+static void *mock_proc(const char *name);
+// extensions functions are looked up with their suffix
+static void *m_eglgetprocaddress(const char *name) {
+    char buf[128];
+    int l = strlen(name);
+    if(l>3 && l<sizeof(buf) && (!strcmp(name+l-3, "EXT") || !strcmp(name+l-3, "OES"))) {
+        strcpy(buf, name);
+        buf[l-3] = '\0';
+        return mock_proc(buf);
+    }
+    return mock_proc(name);
+}
+
+static void *mock_proc(const char *name) {
+    if(!strcmp(name, "eglGetProcAddress"))
+        return m_eglgetprocaddress;
+    for (int i=0; i<sizeof(procs)/sizeof(procs[0]); ++i)
+        if(!strcmp(name, procs[i].name))
+            return procs[i].proc;
+    return m_stub;
+}
+
+void mock_init(void) {
+    set_getprocaddress(mock_proc);
+    initialize_gl4es();     // does nothing if it already ran as a constructor
+}
@@ -0,0 +1,75 @@
+#ifndef _GL4ES_TESTS_MOCKGLES_H_
+#define _GL4ES_TESTS_MOCKGLES_H_
+
+// Small GLES2 mock for the unit tests: gl4es gets its GLES functions through set_getprocaddress(),
+// and the tests run with LIBGL_GLES pointing to libmockgles, so no system GLES library is used
+// (see CMakeLists.txt).
+// The mock logs the calls it implements, and keeps what is needed to check the results.
+
+#include <GL/gl.h>
+
+#define MOCK_MAX_ATTRIBS 16
+
+// set the mock as the GLES backend and initialize gl4es, call it before any GL call
+void mock_init(void);
+
+// ---- call log ----
+// each logged call is a line like "glBindFramebuffer 36160 3"
+void mock_clear_log(void);
+int mock_log_size(void);
+const char* mock_log_line(int i);
+// number of calls of function "name" logged since the last mock_clear_log
+int mock_count(const char *name);
+// index of the first call of function "name" logged at or after "from", or -1
+int mock_find(const char *name, int from);
+// print the log, for debugging failing tests
+void mock_dump_log(void);
+
+// ---- state ----
+extern long mock_draws;            // glDrawArrays + glDrawElements
+extern long mock_uploaded;         // bytes sent with glBufferData / glBufferSubData
+extern int mock_query_result;      // result of the hardware occlusion queries (default 1)
+extern int mock_query_delay;       // GL_QUERY_RESULT_AVAILABLE polls answering GL_FALSE after glBeginQuery (default 0)
+extern const void *mock_indices;   // indices argument of the last glDrawElements
+// pointer argument of the last glVertexAttribPointer for that location, NULL if that array isn't enabled
+const void* mock_attrib_pointer(int index);
+
+// ---- strings ----
+extern const char *mock_extensions;    // glGetString(GL_EXTENSIONS) (default "")
+extern const char *mock_vendor;        // glGetString(GL_VENDOR) (default "")
+extern const char *mock_glsl_reject;   // the shaders with that string (of the last glShaderSource) don't compile (default NULL)
+extern const char *mock_egl_vendor;    // eglQueryString(EGL_VENDOR) (default "Mock"), eglCreateContext is logged
+
+// ---- programs ----
+extern GLuint mock_program;        // last glUseProgram
+int mock_program_alive(GLuint id); // created with glCreateProgram, and not deleted
+
+// ---- uniforms ----
+// the active uniforms of the programs linked from now on (none by default): uniform i is at
+// location 100*(i+1) and its elements at the next locations. The glUniform*v calls are logged
+// like "glUniform4fv <location> <count>"
+typedef struct {
+    const char *name;
+    GLenum type;
+    int size;
+} mock_uniform_t;
+extern const mock_uniform_t *mock_uniforms;
+extern int mock_num_uniforms;
+// last value sent to the uniform at location of program (ints as floats), NULL if never set
+const float* mock_uniform(GLuint program, GLint location);
+
+// ---- textures ----
+// last image uploaded with glTexImage2D (and updated by glTexSubImage2D) for that level, of any
+// texture, NULL if none
+const void* mock_tex_level(int level, int *w, int *h, GLenum *format, GLenum *type);
+
+// ---- draw capture ----
+// when capturing, every vertex of every primitive drawn is recorded, primitives expanded to
+// points / lines / triangles: vertex, normal, color and texcoord0 (4 floats each)
+#define MOCK_CAP_SIZE 16
+#define MOCK_NOT_ARRAY -999.0f     // the attribute is not an array (current value)
+void mock_capture(int on);
+long mock_captured(void);          // number of floats captured since mock_capture(1)
+const float* mock_capture_data(void);
+
+#endif // _GL4ES_TESTS_MOCKGLES_H_
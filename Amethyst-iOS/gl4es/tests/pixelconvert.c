@@ -0,0 +1,289 @@
+// Pixel conversion and scaling check, against the GLES2 mock (mockgles.c).
+//
+// - pixel_convert: for every pair with a SIMD row converter, the output must be byte identical
+//   with the scalar conversion (LIBGL_NOSIMD=1 path, switched at run time here). Every 16-bit
+//   value, random bytes, random / out of range / special floats, odd widths, align 1 and 4.
+// - half floats: 16F -> 32F must match IEEE for all 65536 values, 32F -> 16F must truncate.
+// - RGBA8 -> 5551 takes the alpha bit from the top bit of alpha.
+// - pixel_quarterscale fast path must give the same bytes as the generic path.
+//
+// Run it with LIBGL_THREADS too.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/pixel.h"
+#include "gl/init.h"
+
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static unsigned seed = 12345;
+static unsigned rnd() { seed = seed*1103515245+12345; return (seed>>16)&0x7fff; }
+
+typedef struct {
+    GLenum src_format, src_type, dst_format, dst_type;
+} pair_t;
+
+static const pair_t pairs[] = {
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_BGRA, GL_UNSIGNED_BYTE},
+    {GL_RGB, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_BGR, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_LUMINANCE, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGB, GL_UNSIGNED_SHORT_5_6_5, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGB, GL_UNSIGNED_SHORT_5_6_5},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1},
+    {GL_BGRA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1},
+    {GL_RGBA, GL_FLOAT, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_HALF_FLOAT_OES, GL_RGBA, GL_UNSIGNED_BYTE},
+    {GL_RGBA, GL_HALF_FLOAT_OES, GL_RGBA, GL_FLOAT},
+    {GL_RGBA, GL_FLOAT, GL_RGBA, GL_HALF_FLOAT_OES},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_HALF_FLOAT_OES},
+    {GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_FLOAT},
+};
+
+static int components(GLenum format) {
+    switch (format) {
+        case GL_RGBA: case GL_BGRA: return 4;
+        case GL_RGB: case GL_BGR: return 3;
+        case GL_LUMINANCE_ALPHA: return 2;
+        default: return 1;
+    }
+}
+
+static int pixel_size(GLenum format, GLenum type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE: return components(format);
+        case GL_FLOAT: return 4*components(format);
+        case GL_HALF_FLOAT_OES: return 2*components(format);
+        default: return 2;
+    }
+}
+
+static void fill(GLubyte *p, int size, GLenum type) {
+    switch (type) {
+        case GL_FLOAT: {
+            static const float specials[] = {0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 1.0f/255.0f, 254.5f/255.0f, 2.0f, 1e30f, -1e30f, 1e-40f, INFINITY, -INFINITY, NAN};
+            float *f = (float*)p;
+            for (int i=0; i<size/4; ++i)
+                f[i] = (i%3==0)?specials[(i/3)%(sizeof(specials)/sizeof(specials[0]))]:(rnd()/32767.0f)*2.0f-0.5f;
+            break;
+        }
+        case GL_UNSIGNED_BYTE:
+            for (int i=0; i<size; ++i)
+                p[i] = (i&1)?rnd():i;
+            break;
+        default:
+            // every 16-bit value
+            for (int i=0; i<size/2; ++i)
+                ((GLushort*)p)[i] = i;
+    }
+}
+
+#define GUARD 64
+
+static void check_pairs() {
+    static const int widths[] = {1, 3, 4, 5, 7, 17, 64, 257};
+    for (int p=0; p<sizeof(pairs)/sizeof(pairs[0]); ++p)
+        for (int w=0; w<sizeof(widths)/sizeof(widths[0]); ++w)
+            for (int align=1; align<=4; align+=3) {
+                const pair_t *pr = &pairs[p];
+                const int width = widths[w];
+                const int ssize = pixel_size(pr->src_format, pr->src_type);
+                // enough rows for all the 16-bit values
+                const int height = (ssize*width*8<65536*2)?(65536*2/(ssize*width))+1:8;
+                const int src_line = (width*ssize+align-1)&~(align-1);
+                GLubyte *src = malloc(src_line*height);
+                fill(src, src_line*height, pr->src_type);
+                const int dsize = pixel_size(pr->dst_format, pr->dst_type);
+                const int dst_line = (width*dsize+align-1)&~(align-1);
+                // a guard after the output, that must not be written
+                GLvoid *simd = malloc(dst_line*height+GUARD), *scalar = malloc(dst_line*height+GUARD);
+                memset(simd, 0xAA, dst_line*height+GUARD);
+                memset(scalar, 0xAA, dst_line*height+GUARD);
+                globals4es.nosimd = 0;
+                int ok1 = pixel_convert(src, &simd, width, height, pr->src_format, pr->src_type, pr->dst_format, pr->dst_type, 0, align);
+                globals4es.nosimd = 1;
+                int ok2 = pixel_convert(src, &scalar, width, height, pr->src_format, pr->src_type, pr->dst_format, pr->dst_type, 0, align);
+                globals4es.nosimd = 0;
+                int guard = 0;
+                for (int i=0; i<GUARD; ++i)
+                    if(((GLubyte*)simd)[dst_line*height+i]!=0xAA || ((GLubyte*)scalar)[dst_line*height+i]!=0xAA)
+                        guard = 1;
+                CHECK(!guard, "0x%04X/0x%04X -> 0x%04X/0x%04X, width %d, align %d: written past the end",
+                    pr->src_format, pr->src_type, pr->dst_format, pr->dst_type, width, align);
+                int first = -1;
+                // the padding at the end of the rows is not written
+                for (int y=0; y<height && first<0; ++y)
+                    for (int i=0; i<width*dsize && first<0; ++i)
+                        if(((GLubyte*)simd)[y*dst_line+i]!=((GLubyte*)scalar)[y*dst_line+i])
+                            first = y*dst_line+i;
+                CHECK(ok1 && ok2 && first<0, "0x%04X/0x%04X -> 0x%04X/0x%04X, width %d, align %d: byte %d is 0x%02X, scalar 0x%02X",
+                    pr->src_format, pr->src_type, pr->dst_format, pr->dst_type, width, align, first,
+                    first<0?0:((GLubyte*)simd)[first], first<0?0:((GLubyte*)scalar)[first]);
+                free(simd); free(scalar); free(src);
+            }
+}
+
+// IEEE half -> float
+static float half_to_float(GLushort h) {
+    const int e = (h>>10)&0x1f, m = h&0x3ff;
+    float v;
+    if(e==0) v = ldexpf(m, -24);
+    else if(e==31) v = m?NAN:INFINITY;
+    else v = ldexpf(m|0x400, e-25);
+    return (h&0x8000)?-v:v;
+}
+
+static void check_half() {
+    for (int nosimd=0; nosimd<2; ++nosimd) {
+        globals4es.nosimd = nosimd;
+        GLushort *h = malloc(65536*2);
+        for (int i=0; i<65536; ++i) h[i] = i;
+        GLvoid *out = NULL;
+        pixel_convert(h, &out, 4, 65536/16, GL_RGBA, GL_HALF_FLOAT_OES, GL_RGBA, GL_FLOAT, 0, 1);
+        const float *f = out;
+        int wrong = 0;
+        for (int i=0; i<65536; ++i) {
+            const float r = half_to_float(i);
+            if(isnan(r)?!isnan(f[i]):(memcmp(&r, &f[i], 4)!=0)) {
+                if(!wrong) printf("half 0x%04X -> %g, expected %g\n", i, f[i], r);
+                ++wrong;
+            }
+        }
+        CHECK(!wrong, "nosimd=%d: %d wrong 16F -> 32F conversions", nosimd, wrong);
+        // float -> half: exact for every normal half, truncated in between, denormals flushed to 0
+        float *in = malloc(65536*2*4);
+        int n = 0;
+        for (int i=0; i<65536; ++i) {
+            const int e = (i>>10)&0x1f;
+            if(e==0 || e==31) continue;
+            in[n++] = half_to_float(i);
+            in[n++] = half_to_float(i)*(1.0f+1.0f/4096.0f);     // between this half and the next one
+        }
+        GLvoid *hout = NULL;
+        pixel_convert(in, &hout, 4, n/16, GL_RGBA, GL_FLOAT, GL_RGBA, GL_HALF_FLOAT_OES, 0, 1);
+        const GLushort *ho = hout;
+        wrong = 0;
+        for (int i=0, k=0; i<65536; ++i) {
+            const int e = (i>>10)&0x1f;
+            if(e==0 || e==31) continue;
+            if(ho[k]!=i || ho[k+1]!=i) {
+                if(!wrong) printf("%g -> 0x%04X and %g -> 0x%04X, expected 0x%04X\n", in[k], ho[k], in[k+1], ho[k+1], i);
+                ++wrong;
+            }
+            k += 2;
+        }
+        CHECK(!wrong, "nosimd=%d: %d wrong 32F -> 16F conversions", nosimd, wrong);
+        const float denormals[4] = {1e-6f, -1e-6f, 3e-5f, -4e-5f};
+        GLushort dn[4];
+        GLvoid *dp = dn;
+        pixel_convert(denormals, &dp, 1, 1, GL_RGBA, GL_FLOAT, GL_RGBA, GL_HALF_FLOAT_OES, 0, 1);
+        CHECK(!(dn[0]&0x7fff) && !(dn[1]&0x7fff) && !(dn[2]&0x7fff) && !(dn[3]&0x7fff), "nosimd=%d: denormals not flushed", nosimd);
+        free(h); free(out); free(in); free(hout);
+    }
+    globals4es.nosimd = 0;
+}
+
+static void check_5551() {
+    for (int nosimd=0; nosimd<2; ++nosimd) {
+        globals4es.nosimd = nosimd;
+        GLubyte rgba[8*4];
+        for (int i=0; i<8; ++i) {
+            rgba[i*4] = rgba[i*4+1] = rgba[i*4+2] = 0;
+            rgba[i*4+3] = (i&1)?0x80+i:0x7f-i;
+        }
+        GLvoid *out = NULL;
+        pixel_convert(rgba, &out, 8, 1, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 0, 1);
+        for (int i=0; i<8; ++i)
+            CHECK((((GLushort*)out)[i]&1)==(i&1), "nosimd=%d: alpha 0x%02X gave alpha bit %d", nosimd, rgba[i*4+3], ((GLushort*)out)[i]&1);
+        free(out);
+    }
+    globals4es.nosimd = 0;
+}
+
+// quarterscale: the GL_UNSIGNED_BYTE fast path, against gl4es own generic path (still used for
+// GL_UNSIGNED_INT_8_8_8_8, the same components with the bytes of each pixel reversed on little
+// endian) and, for the other formats, the GL_UNSIGNED_BYTE case of quarter_pixel (static)
+static GLubyte* reference_quarterscale(const GLubyte *src, int width, int height, int bpp, const int *idx) {
+    const int nw = width>3?width/4:1, nh = height>3?height/4:1;
+    const int dxs[4] = {0, width>1?1:0, width>2?2:0, width>3?3:width>1?1:0};
+    const int dys[4] = {0, height>1?1:0, height>2?2:0, height>3?3:height>1?1:0};
+    GLubyte *dst = malloc(nw*nh*bpp+1);
+    for (int y=0; y<nh; ++y)
+        for (int x=0; x<nw; ++x)
+            for (int k=0; k<4; ++k) {
+                if(idx[k]<0) continue;
+                GLfloat v = 0.0f;
+                for (int dy=0; dy<4; ++dy)
+                    for (int dx=0; dx<4; ++dx)
+                        v += src[((x*4+dxs[dx])+(y*4+dys[dy])*width)*bpp+idx[k]] / 255.0f;
+                dst[(y*nw+x)*bpp+idx[k]] = v * 0.0625f * 255.0;
+            }
+    return dst;
+}
+
+static void check_quarterscale() {
+    static const struct { GLenum format; int bpp; int idx[4]; } formats[] = {
+        {GL_RGBA, 4, {0, 1, 2, 3}}, {GL_BGRA, 4, {2, 1, 0, 3}}, {GL_RGB, 3, {0, 1, 2, -1}},
+        {GL_LUMINANCE_ALPHA, 2, {0, 0, 0, 1}}, {GL_LUMINANCE, 1, {0, 0, 0, -1}}, {GL_ALPHA, 1, {-1, -1, -1, 0}},
+    };
+    static const int sizes[][2] = {{1,1}, {2,3}, {3,2}, {4,4}, {5,9}, {1,16}, {16,1}, {33,17}, {256,64}, {1030,21}, {1024,256}};
+    for (int nosimd=0; nosimd<2; ++nosimd)
+    for (int f=0; f<sizeof(formats)/sizeof(formats[0]); ++f)
+        for (int s=0; s<sizeof(sizes)/sizeof(sizes[0]); ++s) {
+            globals4es.nosimd = nosimd;
+            const int w = sizes[s][0], h = sizes[s][1], bpp = formats[f].bpp;
+            const int n = (w>3?w/4:1)*(h>3?h/4:1)*bpp;
+            GLubyte *src = malloc(w*h*bpp);
+            fill(src, w*h*bpp, GL_UNSIGNED_BYTE);
+            GLvoid *got = NULL;
+            pixel_quarterscale(src, &got, w, h, formats[f].format, GL_UNSIGNED_BYTE);
+            GLubyte *ref;
+            if(bpp==4) {
+                GLubyte *rev = malloc(w*h*4);
+                for (int i=0; i<w*h*4; ++i)
+                    rev[i] = src[(i&~3)+3-(i&3)];
+                GLvoid *out = NULL;
+                pixel_quarterscale(rev, &out, w, h, formats[f].format, GL_UNSIGNED_INT_8_8_8_8);
+                ref = out;
+                for (int i=0; i<n; i+=4) {
+                    GLubyte t = ref[i]; ref[i] = ref[i+3]; ref[i+3] = t;
+                    t = ref[i+1]; ref[i+1] = ref[i+2]; ref[i+2] = t;
+                }
+                free(rev);
+            } else
+                ref = reference_quarterscale(src, w, h, bpp, formats[f].idx);
+            CHECK(!memcmp(got, ref, n), "nosimd=%d: quarterscale 0x%04X %dx%d differs", nosimd, formats[f].format, w, h);
+            free(got); free(ref); free(src);
+        }
+    globals4es.nosimd = 0;
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    check_pairs();
+    check_half();
+    check_5551();
+    check_quarterscale();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,229 @@
+// glPushAttrib / glPopAttrib check, against the GLES2 mock (mockgles.c).
+//
+// glPopAttrib only restores the groups modified since the glPushAttrib. For every mask and
+// every piece of state below: push the mask (inside a glPushAttrib(GL_ALL_ATTRIB_BITS)), change
+// the state, pop, and compare all the state with what it was before the push, like a pop that
+// restores everything would leave it. Then pop the outer push, and check everything is back.
+
+#include <stdio.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include <gl4eshint.h>
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static GLuint tex;
+static const GLfloat v4a[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+
+// how the state is read back
+enum { ENABLED, INT, FLOAT, LIGHT, MATERIAL, TEXGEN };
+
+typedef struct {
+    const char *name;
+    GLbitfield groups;      // the groups that restore this state
+    int kind;
+    GLenum pname;
+    int n;                  // values read
+} state_t;
+
+#define ENABLE(cap, groups) {#cap, GL_ENABLE_BIT|(groups), ENABLED, cap, 1}
+
+static const state_t states[] = {
+    ENABLE(GL_BLEND, GL_COLOR_BUFFER_BIT),
+    ENABLE(GL_ALPHA_TEST, GL_COLOR_BUFFER_BIT),
+    ENABLE(GL_DEPTH_TEST, GL_DEPTH_BUFFER_BIT),
+    ENABLE(GL_CULL_FACE, 0),
+    ENABLE(GL_LIGHTING, GL_LIGHTING_BIT),
+    ENABLE(GL_LIGHT1, GL_LIGHTING_BIT),
+    ENABLE(GL_FOG, GL_FOG_BIT),
+    ENABLE(GL_SCISSOR_TEST, GL_SCISSOR_BIT),
+    ENABLE(GL_STENCIL_TEST, GL_STENCIL_BUFFER_BIT),
+    ENABLE(GL_LINE_SMOOTH, GL_LINE_BIT),
+    ENABLE(GL_POINT_SMOOTH, GL_POINT_BIT),
+    ENABLE(GL_NORMALIZE, GL_TRANSFORM_BIT),
+    ENABLE(GL_TEXTURE_2D, 0),
+    ENABLE(GL_POLYGON_OFFSET_FILL, 0),
+    {"glBlendFunc", GL_COLOR_BUFFER_BIT, INT, GL_BLEND_SRC, 1},
+    {"glAlphaFunc", GL_COLOR_BUFFER_BIT, INT, GL_ALPHA_TEST_FUNC, 1},
+    {"glClearColor", GL_COLOR_BUFFER_BIT, FLOAT, GL_COLOR_CLEAR_VALUE, 4},
+    {"glColorMask", GL_COLOR_BUFFER_BIT, INT, GL_COLOR_WRITEMASK, 4},
+    {"glDepthFunc", GL_DEPTH_BUFFER_BIT, INT, GL_DEPTH_FUNC, 1},
+    {"glDepthMask", GL_DEPTH_BUFFER_BIT, INT, GL_DEPTH_WRITEMASK, 1},
+    {"glClearDepth", GL_DEPTH_BUFFER_BIT, FLOAT, GL_DEPTH_CLEAR_VALUE, 1},
+    {"glFog", GL_FOG_BIT, FLOAT, GL_FOG_DENSITY, 1},
+    {"glHint", GL_HINT_BIT, INT, GL_ALPHAHACK_HINT_GL4ES, 1},    // the GL hints are not tracked on GLES2
+    {"glShadeModel", GL_LIGHTING_BIT, INT, GL_SHADE_MODEL, 1},
+    {"glLightModel", GL_LIGHTING_BIT, FLOAT, GL_LIGHT_MODEL_AMBIENT, 4},
+    {"glLight", GL_LIGHTING_BIT, LIGHT, GL_DIFFUSE, 4},
+    {"glMaterial", GL_LIGHTING_BIT, MATERIAL, GL_AMBIENT, 4},
+    {"glLineWidth", GL_LINE_BIT, FLOAT, GL_LINE_WIDTH, 1},
+    {"glPointSize", GL_POINT_BIT, FLOAT, GL_POINT_SIZE, 1},
+    {"glScissor", GL_SCISSOR_BIT, INT, GL_SCISSOR_BOX, 4},
+    {"glStencilFunc", GL_STENCIL_BUFFER_BIT, INT, GL_STENCIL_FUNC, 1},
+    {"glStencilOp", GL_STENCIL_BUFFER_BIT, INT, GL_STENCIL_FAIL, 1},
+    {"glClearStencil", GL_STENCIL_BUFFER_BIT, INT, GL_STENCIL_CLEAR_VALUE, 1},
+    {"glBindTexture", GL_TEXTURE_BIT, INT, GL_TEXTURE_BINDING_2D, 1},
+    {"glTexGen", GL_TEXTURE_BIT, TEXGEN, GL_TEXTURE_GEN_MODE, 1},
+    {"glPixelZoom", GL_PIXEL_MODE_BIT, FLOAT, GL_ZOOM_X, 1},
+    {"glPixelTransfer", GL_PIXEL_MODE_BIT, FLOAT, GL_RED_SCALE, 1},
+    {"glMatrixMode", GL_TRANSFORM_BIT, INT, GL_MATRIX_MODE, 1},
+    {"glViewport", GL_VIEWPORT_BIT, INT, GL_VIEWPORT, 4},
+    {"glDepthRange", GL_VIEWPORT_BIT, FLOAT, GL_DEPTH_RANGE, 2},
+};
+#define NSTATES (sizeof(states)/sizeof(states[0]))
+
+// change state i to something else than its default
+static void modify(int i) {
+    const state_t *st = &states[i];
+    if(st->kind==ENABLED) {
+        glEnable(st->pname);
+        return;
+    }
+    switch (st->pname) {
+        case GL_BLEND_SRC: glBlendFunc(GL_SRC_ALPHA, GL_ONE); break;
+        case GL_ALPHA_TEST_FUNC: glAlphaFunc(GL_GREATER, 0.5f); break;
+        case GL_COLOR_CLEAR_VALUE: glClearColor(0.1f, 0.2f, 0.3f, 0.4f); break;
+        case GL_COLOR_WRITEMASK: glColorMask(GL_FALSE, GL_TRUE, GL_FALSE, GL_TRUE); break;
+        case GL_DEPTH_FUNC: glDepthFunc(GL_GREATER); break;
+        case GL_DEPTH_WRITEMASK: glDepthMask(GL_FALSE); break;
+        case GL_DEPTH_CLEAR_VALUE: glClearDepth(0.25); break;
+        case GL_FOG_DENSITY: glFogf(GL_FOG_DENSITY, 0.3f); break;
+        case GL_ALPHAHACK_HINT_GL4ES: glHint(GL_ALPHAHACK_HINT_GL4ES, 1); break;
+        case GL_SHADE_MODEL: glShadeModel(GL_FLAT); break;
+        case GL_LIGHT_MODEL_AMBIENT: glLightModelfv(GL_LIGHT_MODEL_AMBIENT, v4a); break;
+        case GL_DIFFUSE: glLightfv(GL_LIGHT0, GL_DIFFUSE, v4a); break;
+        case GL_AMBIENT: glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, v4a); break;
+        case GL_LINE_WIDTH: glLineWidth(3.0f); break;
+        case GL_POINT_SIZE: glPointSize(4.0f); break;
+        case GL_SCISSOR_BOX: glScissor(1, 2, 3, 4); break;
+        case GL_STENCIL_FUNC: glStencilFunc(GL_EQUAL, 3, 0xff); break;
+        case GL_STENCIL_FAIL: glStencilOp(GL_ZERO, GL_INCR, GL_DECR); break;
+        case GL_STENCIL_CLEAR_VALUE: glClearStencil(2); break;
+        case GL_TEXTURE_BINDING_2D: glBindTexture(GL_TEXTURE_2D, tex); break;
+        case GL_TEXTURE_GEN_MODE: glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP); break;
+        case GL_ZOOM_X: glPixelZoom(2.0f, 3.0f); break;
+        case GL_RED_SCALE: glPixelTransferf(GL_RED_SCALE, 2.0f); break;
+        case GL_MATRIX_MODE: glMatrixMode(GL_PROJECTION); break;
+        case GL_VIEWPORT: glViewport(1, 2, 30, 40); break;
+        case GL_DEPTH_RANGE: glDepthRange(0.2, 0.8); break;
+    }
+}
+
+static void read_state(int i, GLfloat *v) {
+    const state_t *st = &states[i];
+    GLint iv[4] = {0};
+    memset(v, 0, 4*sizeof(GLfloat));
+    switch (st->kind) {
+        case ENABLED: v[0] = glIsEnabled(st->pname); break;
+        case INT:
+            glGetIntegerv(st->pname, iv);
+            for (int k=0; k<st->n; ++k) v[k] = iv[k];
+            break;
+        case FLOAT: glGetFloatv(st->pname, v); break;
+        case LIGHT: glGetLightfv(GL_LIGHT0, st->pname, v); break;
+        case MATERIAL: glGetMaterialfv(GL_FRONT, st->pname, v); break;
+        case TEXGEN: glGetTexGeniv(GL_S, st->pname, iv); v[0] = iv[0]; break;
+    }
+}
+
+static void snapshot(GLfloat s[NSTATES][4]) {
+    for (int i=0; i<NSTATES; ++i)
+        read_state(i, s[i]);
+}
+
+static int same(const GLfloat *a, const GLfloat *b) { return !memcmp(a, b, 4*sizeof(GLfloat)); }
+
+// compare the whole state, except "skip"
+static void compare(const char *when, GLbitfield mask, int modified, GLfloat ref[NSTATES][4], int skip) {
+    GLfloat s[NSTATES][4];
+    snapshot(s);
+    for (int i=0; i<NSTATES; ++i)
+        if(i!=skip && !same(s[i], ref[i]))
+            printf("%s, mask 0x%05X, %s modified: %s is %g %g %g %g, expected %g %g %g %g\n", when, mask, states[modified].name, states[i].name,
+                s[i][0], s[i][1], s[i][2], s[i][3], ref[i][0], ref[i][1], ref[i][2], ref[i][3]), ++bad;
+}
+
+static const GLbitfield masks[] = {
+    GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT, GL_ENABLE_BIT, GL_FOG_BIT, GL_HINT_BIT, GL_LIGHTING_BIT,
+    GL_LIST_BIT, GL_LINE_BIT, GL_POINT_BIT, GL_SCISSOR_BIT, GL_STENCIL_BUFFER_BIT, GL_TEXTURE_BIT,
+    GL_PIXEL_MODE_BIT, GL_TRANSFORM_BIT, GL_VIEWPORT_BIT, GL_CURRENT_BIT,
+    GL_ENABLE_BIT|GL_COLOR_BUFFER_BIT|GL_TEXTURE_BIT, GL_ALL_ATTRIB_BITS,
+};
+
+static void check_restore() {
+    GLfloat ref[NSTATES][4], changed[4];
+    snapshot(ref);
+    for (int i=0; i<NSTATES; ++i) {
+        // make sure the state is tracked, or the test checks nothing
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        modify(i);
+        read_state(i, changed);
+        CHECK(!same(changed, ref[i]), "%s is not modified, or not read back", states[i].name);
+        glPopAttrib();
+        compare("push all", GL_ALL_ATTRIB_BITS, i, ref, -1);
+        for (int m=0; m<sizeof(masks)/sizeof(masks[0]); ++m) {
+            const int restored = (states[i].groups & masks[m])!=0;
+            glPushAttrib(GL_ALL_ATTRIB_BITS);
+            glPushAttrib(masks[m]);
+            modify(i);
+            glPopAttrib();
+            // the rest of the state is untouched, the modified one is back only if its group was pushed
+            compare("inner pop", masks[m], i, ref, restored?-1:i);
+            if(!restored) {
+                read_state(i, changed);
+                CHECK(!same(changed, ref[i]), "%s restored by mask 0x%05X", states[i].name, masks[m]);
+            }
+            // the outer pop has to restore what the inner one did not
+            glPopAttrib();
+            compare("outer pop", masks[m], i, ref, -1);
+        }
+    }
+    // deeper: the modification is only seen by the outermost pop
+    for (int i=0; i<NSTATES; ++i) {
+        glPushAttrib(states[i].groups);
+        glPushAttrib(GL_CURRENT_BIT);
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        glPopAttrib();
+        modify(i);
+        glPushAttrib(GL_ALL_ATTRIB_BITS);
+        glPopAttrib();
+        glPopAttrib();
+        glPopAttrib();
+        compare("nested pops", states[i].groups, i, ref, -1);
+    }
+}
+
+// a pop with nothing modified sends nothing to GLES
+static void check_calls() {
+    glEnable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    mock_clear_log();
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glPushAttrib(GL_ENABLE_BIT|GL_COLOR_BUFFER_BIT|GL_TEXTURE_BIT);
+    glPopAttrib();
+    glPopAttrib();
+    CHECK(mock_log_size()==0, "%d GLES calls for push/pop without modification", mock_log_size());
+    if(mock_log_size()) mock_dump_log();
+    // only the modified group is restored
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+    glDepthFunc(GL_ALWAYS);
+    mock_clear_log();
+    glPopAttrib();
+    CHECK(mock_count("glDepthFunc")==1, "glDepthFunc not restored");
+    CHECK(mock_count("glBlendFunc")==0, "%d glBlendFunc calls, blend was not modified", mock_count("glBlendFunc"));
+    glDisable(GL_DEPTH_TEST);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    glGenTextures(1, &tex);
+    check_restore();
+    check_calls();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,179 @@
+// Query objects check, against the GLES2 mock (mockgles.c).
+//
+// Covers name allocation and recycling, the growth of the dense table, names used with
+// glBeginQuery without glGenQueries (small, past the dense table, and up to 0xffffffff),
+// the emulated GL_SAMPLES_PASSED, and the hardware path (GL_EXT_occlusion_query_boolean).
+
+#include <stdio.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "glx/hardext.h"
+#include "gl/queries.h"
+
+#ifndef GL_ANY_SAMPLES_PASSED
+#define GL_ANY_SAMPLES_PASSED 0x8C2F
+#endif
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+#define CHECK_ERROR(expected) \
+    { GLenum e = glGetError(); CHECK(e==(expected), "error 0x%04X, expected 0x%04X", e, expected); }
+
+static GLuint result(GLuint id) {
+    GLuint v = 12345;
+    glGetQueryObjectuiv(id, GL_QUERY_RESULT, &v);
+    return v;
+}
+
+static void check_names() {
+    GLuint ids[8];
+    glGenQueries(4, ids);
+    CHECK_ERROR(GL_NO_ERROR);
+    for (int i=0; i<4; ++i)
+        CHECK(ids[i]==i+1, "glGenQueries gave %u, expected %d", ids[i], i+1);
+    // a name only becomes a query with glBeginQuery
+    CHECK(!glIsQuery(ids[0]), "%u is a query before glBeginQuery", ids[0]);
+    // deleted names are recycled, lowest first
+    glDeleteQueries(1, &ids[2]);
+    glDeleteQueries(1, &ids[1]);
+    glGenQueries(3, ids+4);
+    CHECK(ids[4]==2 && ids[5]==3 && ids[6]==5, "recycled names %u %u %u, expected 2 3 5", ids[4], ids[5], ids[6]);
+    // grow the dense table a few times
+    static GLuint many[1000];
+    glGenQueries(1000, many);
+    CHECK_ERROR(GL_NO_ERROR);
+    for (int i=0; i<1000; ++i)
+        CHECK(many[i]==i+6, "glGenQueries gave %u, expected %d", many[i], i+6);
+    glDeleteQueries(1000, many);
+    GLuint dense[] = {1, 2, 3, 4, 5};
+    glDeleteQueries(5, dense);
+    CHECK_ERROR(GL_NO_ERROR);
+    glGenQueries(1, ids);
+    CHECK(ids[0]==1, "glGenQueries gave %u after deleting everything", ids[0]);
+    glDeleteQueries(1, ids);
+    CHECK(!glIsQuery(0), "0 is a query");
+}
+
+// names never returned by glGenQueries: GL before 3.0 allows them in glBeginQuery
+static void check_unreserved(GLenum target, GLuint id, GLuint expected) {
+    mock_clear_log();
+    CHECK(!glIsQuery(id), "%u is a query before glBeginQuery", id);
+    glBeginQuery(target, id);
+    CHECK_ERROR(GL_NO_ERROR);
+    GLint cur = 0;
+    glGetQueryiv(target, GL_CURRENT_QUERY, &cur);
+    CHECK((GLuint)cur==id, "GL_CURRENT_QUERY is %u, expected %u", (GLuint)cur, id);
+    glEndQuery(target);
+    CHECK_ERROR(GL_NO_ERROR);
+    CHECK(glIsQuery(id), "%u is not a query after glBeginQuery", id);
+    GLuint r = result(id);
+    CHECK_ERROR(GL_NO_ERROR);
+    CHECK(r==expected, "query %u result %u, expected %u", id, r, expected);
+    // the same name again
+    glBeginQuery(target, id);
+    glEndQuery(target);
+    CHECK_ERROR(GL_NO_ERROR);
+    CHECK(mock_count("glGenQueries")==(hardext.occlusionquery?1:0), "%d hardware queries created for %u", mock_count("glGenQueries"), id);
+    glDeleteQueries(1, &id);
+    CHECK(!glIsQuery(id), "%u is still a query after glDeleteQueries", id);
+    CHECK(mock_count("glDeleteQueries")==(hardext.occlusionquery?1:0), "%d hardware queries deleted for %u", mock_count("glDeleteQueries"), id);
+}
+
+static void check_errors() {
+    GLuint ids[2], v;
+    glGenQueries(2, ids);
+    glBeginQuery(GL_SAMPLES_PASSED, ids[0]);
+    CHECK_ERROR(GL_NO_ERROR);
+    // reading the active query, or starting another one
+    glGetQueryObjectuiv(ids[0], GL_QUERY_RESULT, &v);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glBeginQuery(GL_SAMPLES_PASSED, ids[1]);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glEndQuery(GL_SAMPLES_PASSED);
+    CHECK_ERROR(GL_NO_ERROR);
+    // the target of a query cannot change, and it cannot be read before glBeginQuery
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, ids[0]);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glGetQueryObjectuiv(ids[1], GL_QUERY_RESULT, &v);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glBeginQuery(GL_SAMPLES_PASSED, 0);
+    CHECK_ERROR(GL_INVALID_OPERATION);
+    glDeleteQueries(2, ids);
+}
+
+static void check_hardware() {
+    GLuint id, v;
+    glGenQueries(1, &id);
+    mock_query_result = 1;
+    mock_query_delay = 2;
+    mock_clear_log();
+    glBeginQuery(GL_SAMPLES_PASSED, id);
+    glEndQuery(GL_SAMPLES_PASSED);
+    int begin = mock_find("glBeginQuery", 0);
+    CHECK(mock_count("glGenQueries")==1 && begin>=0 && !strncmp(mock_log_line(begin), "glBeginQuery 35887 ", 19),
+        "GL_SAMPLES_PASSED not started as GL_ANY_SAMPLES_PASSED");
+    // polling never blocks, and the result is kept once available
+    for (int i=0; i<2; ++i) {
+        glGetQueryObjectuiv(id, GL_QUERY_RESULT_AVAILABLE, &v);
+        CHECK(v==GL_FALSE, "result available after %d polls", i+1);
+    }
+    glGetQueryObjectuiv(id, GL_QUERY_RESULT_AVAILABLE, &v);
+    CHECK(v==GL_TRUE, "result not available after 3 polls");
+    int reads = mock_count("glGetQueryObjectuiv");
+    CHECK(result(id)==1, "hardware result not returned");
+    glGetQueryObjectuiv(id, GL_QUERY_RESULT_AVAILABLE, &v);
+    CHECK(mock_count("glGetQueryObjectuiv")==reads, "result read again from the driver");
+    // a new glBeginQuery reuses the hardware query
+    mock_query_delay = 0;
+    mock_query_result = 0;
+    mock_clear_log();
+    glBeginQuery(GL_SAMPLES_PASSED, id);
+    glEndQuery(GL_SAMPLES_PASSED);
+    CHECK(mock_count("glGenQueries")==0, "hardware query created again");
+    CHECK(result(id)==0, "stale hardware result");
+    // deleting the active query ends it
+    mock_clear_log();
+    glBeginQuery(GL_SAMPLES_PASSED, id);
+    glDeleteQueries(1, &id);
+    int end = mock_find("glEndQuery", 0), del = mock_find("glDeleteQueries", 0);
+    CHECK(end>=0 && del>end, "active query deleted without glEndQuery");
+    GLint cur = 1;
+    glGetQueryiv(GL_SAMPLES_PASSED, GL_CURRENT_QUERY, &cur);
+    CHECK(cur==0, "GL_CURRENT_QUERY is %d after deleting the active query", cur);
+    CHECK_ERROR(GL_NO_ERROR);
+}
+
+static void run(const char *name) {
+    printf("%s\n", name);
+    check_names();
+    check_errors();
+    GLuint expected = hardext.occlusionquery?mock_query_result:0;
+    check_unreserved(GL_SAMPLES_PASSED, 7, expected);
+    check_unreserved(GL_SAMPLES_PASSED, QUERY_DENSE_MAX-1, expected);
+    check_unreserved(GL_SAMPLES_PASSED, QUERY_DENSE_MAX, expected);
+    check_unreserved(GL_ANY_SAMPLES_PASSED, 0x80000000u, expected);
+    check_unreserved(GL_SAMPLES_PASSED, 0xffffffffu, expected);
+    // the unreserved names don't change the names given by glGenQueries
+    GLuint id;
+    glGenQueries(1, &id);
+    CHECK(id==1, "glGenQueries gave %u", id);
+    glDeleteQueries(1, &id);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    hardext.occlusionquery = 0;
+    run("emulated");
+    hardext.occlusionquery = 1;
+    run("hardware");
+    check_hardware();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
@@ -0,0 +1,395 @@
+// GL_SELECT check, against the GLES2 mock (mockgles.c): nothing is drawn in select mode.
+//
+// The hit records must be the ones of the plain algorithm, done here for each draw: every vertex of
+// the draw transformed with vector_matrix and divided by w, every primitive tested with the full
+// viewscreen tests, z ranges from those vertices. gl4es keeps the transformed vertices between the
+// draws (and transforms them with SIMD), and skips the primitives with all their vertices on the same
+// side: none of that may change a record. Checked for pick matrices over objects of one big array
+// (drawn with glDrawArrays and glDrawElements, also sharing vertices), every primitive mode, vertices
+// near the viewscreen border, huge ones, w<=0, arrays changed in place, other vertex types, nested
+// names and a too small select buffer.
+//
+// Run it with LIBGL_NOSIMD=1 too, to check the scalar transform.
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/matvec.h"
+
+GLboolean select_point_in_viewscreen(const GLfloat *a);
+GLboolean select_segment_in_viewscreen(const GLfloat *a, const GLfloat *b);
+GLboolean select_triangle_in_viewscreen(const GLfloat *a, const GLfloat *b, const GLfloat *c);
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+static float frnd(float a, float b) {
+    return a+(b-a)*(rnd()%10001)/10000.0f;
+}
+
+// ---- reference ----
+
+#define BUFSIZE 8192
+
+static struct {
+    GLuint buffer[BUFSIZE];
+    int size, pos, count, overflow, hit;
+    GLuint names[64];
+    int top;
+    float zmin, zmax, zminoverall, zmaxoverall;
+    float mvp[16];
+} ref;
+
+static void ref_push_hit() {
+    if(ref.hit) {
+        if(!ref.overflow) {
+            if(ref.zmaxoverall-ref.zminoverall!=0.0f) {
+                ref.zmin = (ref.zmin-ref.zminoverall)/(ref.zmaxoverall-ref.zminoverall);
+                ref.zmax = (ref.zmax-ref.zminoverall)/(ref.zmaxoverall-ref.zminoverall);
+            }
+            GLuint rec[3+64];
+            rec[0] = ref.top;
+            rec[1] = (unsigned int)(ref.zmin*INT_MAX);
+            rec[2] = (unsigned int)(ref.zmax*INT_MAX);
+            memcpy(rec+3, ref.names, ref.top*sizeof(GLuint));
+            int tocopy = ref.top+3;
+            if(tocopy+ref.pos>ref.size) {
+                ref.overflow = 1;
+                tocopy = ref.size-ref.pos;
+            }
+            memcpy(ref.buffer+ref.pos, rec, tocopy*sizeof(GLuint));
+            ref.count++;
+            ref.pos += tocopy;
+        }
+        ref.hit = 0;
+    }
+    ref.zmin = ref.zminoverall = 1e10f;
+    ref.zmax = ref.zmaxoverall = -1e10f;
+}
+
+static void zminmax(float *zmin, float *zmax, const float *v) {
+    if(v[2]<*zmin) *zmin = v[2];
+    if(v[2]>*zmax) *zmax = v[2];
+}
+
+// vertices are float[4] (already converted), vertex i of the draw is ind[i], or first+i
+static void ref_draw(const float *src, GLenum mode, int count, int first, int last, const GLuint *ind, float zmax) {
+    float *v = malloc((last-first)*4*sizeof(float));
+    for (int i=first; i<last; ++i) {
+        float *a = v+(i-first)*4;
+        vector_matrix(src+i*4, ref.mvp, a);
+        a[0] /= a[3];
+        a[1] /= a[3];
+        a[2] /= a[3];
+        zminmax(&ref.zminoverall, &ref.zmaxoverall, a);
+    }
+    #define V(i) (v+((ind?ind[i]:first+(i))-first)*4)
+    float zmin = 1e10f;
+    int found = 0;
+    switch (mode) {
+        case GL_POINTS:
+            for (int i=0; i<count; ++i)
+                if(select_point_in_viewscreen(V(i))) {
+                    zminmax(&zmin, &zmax, V(i));
+                    found = 1;
+                }
+            break;
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:      // without the closing segment, like gl4es
+            for (int i=1; i<count; i+=(mode==GL_LINES)?2:1)
+                if(select_segment_in_viewscreen(V(i-1), V(i))) {
+                    zminmax(&zmin, &zmax, V(i-1));
+                    zminmax(&zmin, &zmax, V(i));
+                    found = 1;
+                }
+            break;
+        default:
+            for (int i=2; i<count; i+=(mode==GL_TRIANGLES)?3:1) {
+                const int i0 = (mode==GL_TRIANGLE_FAN)?0:i-2;
+                if(select_triangle_in_viewscreen(V(i0), V(i-1), V(i))) {
+                    zminmax(&zmin, &zmax, V(i0));
+                    zminmax(&zmin, &zmax, V(i-1));
+                    zminmax(&zmin, &zmax, V(i));
+                    found = 1;
+                }
+            }
+    }
+    #undef V
+    if(found) {
+        ref.hit = 1;
+        if(zmin<ref.zmin) ref.zmin = zmin;
+        if(zmax>ref.zmax) ref.zmax = zmax;
+    }
+    free(v);
+}
+
+// ---- scene ----
+
+#define NVERTS 2400
+#define NOBJ 300
+
+static float verts[NVERTS*4];       // what is drawn, as float[4] (for the reference)
+static float arr3[NVERTS*3];        // the GL_FLOAT array, size 3 (or 4, then it's verts)
+static const float *drawn;          // the reference vertices of the current array
+static GLuint sel[BUFSIZE];
+
+static const GLenum modes[] = {GL_POINTS, GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP, GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN};
+
+static void random_vertex(float *v, int with_w) {
+    const int kind = rnd()%20;
+    for (int c=0; c<3; ++c)
+        v[c] = frnd(-3.0f, 3.0f);
+    v[3] = 1.0f;
+    if(kind==0) {
+        // huge
+        v[rnd()%3] *= 1e6f;
+    } else if(kind==1) {
+        // tiny object around the center
+        for (int c=0; c<3; ++c)
+            v[c] *= 0.01f;
+    } else if(kind==2 && with_w) {
+        v[3] = (rnd()&1)?0.0f:frnd(-2.0f, -0.1f);
+    } else if(kind==3 && with_w) {
+        v[3] = frnd(0.1f, 4.0f);
+    }
+}
+
+static void fill_arrays(int with_w) {
+    for (int i=0; i<NVERTS; ++i) {
+        random_vertex(verts+i*4, with_w);
+        memcpy(arr3+i*3, verts+i*4, 3*sizeof(float));
+    }
+}
+
+// objects of 8 vertices, drawn with mode modes[obj%7], with glDrawArrays, or glDrawElements (short or
+// int indices) over the object and some of its neighbours
+static void draw_object(int obj) {
+    const GLenum mode = modes[obj%7];
+    const int first = (obj*8)%NVERTS;
+    int count = 8;
+    if(mode==GL_TRIANGLES) count = 6;
+    switch ((obj/7)%3) {
+        case 0:
+            glDrawArrays(mode, first, count);
+            ref_draw(drawn, mode, count, first, first+count, NULL, -1e10f);
+            break;
+        default: {
+            GLuint ui[8];
+            GLushort us[8];
+            int lo = first-8<0?0:first-8, hi = first+16>NVERTS?NVERTS:first+16;
+            int min = INT_MAX, max = 0;
+            for (int i=0; i<count; ++i) {
+                ui[i] = lo+rnd()%(hi-lo);
+                us[i] = ui[i];
+                if(ui[i]<min) min = ui[i];
+                if(ui[i]>max) max = ui[i];
+            }
+            if((obj/7)%3==1)
+                glDrawElements(mode, count, GL_UNSIGNED_SHORT, us);
+            else
+                glDrawElements(mode, count, GL_UNSIGNED_INT, ui);
+            ref_draw(drawn, mode, count, min, max+1, ui, -10e6f);
+        }
+    }
+}
+
+static void ref_start(int size) {
+    memset(&ref, 0, sizeof(ref));
+    ref.size = size;
+    ref.zmin = ref.zminoverall = 1e10f;
+    ref.zmax = ref.zmaxoverall = -1e10f;
+    float p[16], mv[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, p);
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    matrix_mul(p, mv, ref.mvp);
+}
+
+static void load_name(GLuint name) {
+    glLoadName(name);
+    ref_push_hit();
+    ref.names[ref.top-1] = name;
+}
+
+static void push_name(GLuint name) {
+    glPushName(name);
+    ref_push_hit();
+    ref.names[ref.top++] = name;
+}
+
+static void pop_name() {
+    glPopName();
+    ref_push_hit();
+    ref.top--;
+}
+
+static void compare(const char *what) {
+    const int count = glRenderMode(GL_RENDER);
+    ref_push_hit();
+    CHECK(count==ref.count, "%s: %d hit(s), expected %d", what, count, ref.count);
+    for (int i=0; i<ref.pos; ++i)
+        if(sel[i]!=ref.buffer[i]) {
+            CHECK(0, "%s: select buffer differs at %d: %u, expected %u", what, i, sel[i], ref.buffer[i]);
+            break;
+        }
+}
+
+// gluPickMatrix, for a 256x256 viewport, then a perspective or an orthographic projection
+static void pick(float x, float y, float size, int ortho) {
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glTranslatef((256.0f-2.0f*x)/size, (256.0f-2.0f*y)/size, 0.0f);
+    glScalef(256.0f/size, 256.0f/size, 1.0f);
+    if(ortho)
+        glOrtho(-3.0, 3.0, -3.0, 3.0, -10.0, 10.0);
+    else
+        glFrustum(-1.0, 1.0, -1.0, 1.0, 1.0, 100.0);
+    glMatrixMode(GL_MODELVIEW);
+}
+
+static void select_objects(int first, int last, int size) {
+    glSelectBuffer(size, sel);
+    memset(sel, 0, sizeof(sel));
+    glRenderMode(GL_SELECT);
+    ref_start(size);
+    glInitNames();
+    push_name(0);
+    for (int obj=first; obj<last; ++obj) {
+        load_name(obj);
+        draw_object(obj);
+    }
+}
+
+static void check_picks(const char *what) {
+    char w[96];
+    for (int p=0; p<12; ++p) {
+        const float x = (p<4)?128.0f:frnd(0.0f, 256.0f), y = (p<4)?128.0f:frnd(0.0f, 256.0f);
+        pick(x, y, (p%3==2)?40.0f:4.0f, p&1);
+        glLoadIdentity();
+        glTranslatef(0.0f, 0.0f, (p&1)?0.0f:-6.0f);
+        glRotatef(p*37.0f, 0.3f, 1.0f, 0.2f);
+        // the same pick twice: the second one from the transformed vertices of the first
+        for (int again=0; again<2; ++again) {
+            select_objects(0, NOBJ, BUFSIZE);
+            sprintf(w, "%s, pick %d%s", what, p, again?" again":"");
+            compare(w);
+        }
+    }
+}
+
+static void check_float(int size) {
+    fill_arrays(size==4);
+    drawn = verts;
+    glVertexPointer(size, GL_FLOAT, 0, (size==4)?verts:arr3);
+    check_picks(size==4?"float[4]":"float[3]");
+}
+
+static void check_changed() {
+    // vertices changed in place between the objects, and between the picks
+    fill_arrays(0);
+    drawn = verts;
+    glVertexPointer(3, GL_FLOAT, 0, arr3);
+    pick(128.0f, 128.0f, 40.0f, 1);
+    glLoadIdentity();
+    char w[64];
+    for (int pass=0; pass<4; ++pass) {
+        glSelectBuffer(BUFSIZE, sel);
+        glRenderMode(GL_SELECT);
+        ref_start(BUFSIZE);
+        glInitNames();
+        push_name(0);
+        for (int obj=0; obj<NOBJ; ++obj) {
+            if(obj%5==pass) {
+                // move a vertex of this object (or of the next one) to the center, or away
+                const int i = ((obj+pass%2)*8+rnd()%8)%NVERTS;
+                for (int c=0; c<3; ++c)
+                    verts[i*4+c] = arr3[i*3+c] = (obj&1)?0.0f:5.0f;
+            }
+            load_name(obj);
+            draw_object(obj);
+        }
+        sprintf(w, "changed in place, pass %d", pass);
+        compare(w);
+    }
+}
+
+static void check_types() {
+    // GL_SHORT size 2, and GL_DOUBLE size 3 with padding
+    static GLshort s2[NVERTS*2];
+    static GLdouble d4[NVERTS*4];
+    for (int i=0; i<NVERTS; ++i) {
+        s2[i*2+0] = (GLshort)(rnd()%9)-4;
+        s2[i*2+1] = (GLshort)(rnd()%9)-4;
+        verts[i*4+0] = s2[i*2+0];
+        verts[i*4+1] = s2[i*2+1];
+        verts[i*4+2] = 0.0f;
+        verts[i*4+3] = 1.0f;
+    }
+    drawn = verts;
+    glVertexPointer(2, GL_SHORT, 0, s2);
+    check_picks("short[2]");
+    for (int i=0; i<NVERTS; ++i) {
+        random_vertex(verts+i*4, 0);
+        for (int c=0; c<3; ++c) {
+            d4[i*4+c] = verts[i*4+c];
+            verts[i*4+c] = (float)d4[i*4+c];
+        }
+        d4[i*4+3] = -7.0;   // padding, not a coordinate
+    }
+    glVertexPointer(3, GL_DOUBLE, 4*sizeof(GLdouble), d4);
+    check_picks("double[3], stride 32");
+}
+
+static void check_names() {
+    // nested names, and a select buffer too small for all the records
+    fill_arrays(0);
+    drawn = verts;
+    glVertexPointer(3, GL_FLOAT, 0, arr3);
+    pick(128.0f, 128.0f, 40.0f, 1);
+    glLoadIdentity();
+    for (int size=BUFSIZE; size>=7; size/=9) {
+        glSelectBuffer(size, sel);
+        glRenderMode(GL_SELECT);
+        ref_start(size);
+        glInitNames();
+        for (int group=0; group<NOBJ/10; ++group) {
+            push_name(1000+group);
+            push_name(0);
+            for (int obj=group*10; obj<group*10+10; ++obj) {
+                load_name(obj);
+                draw_object(obj);
+            }
+            pop_name();
+            draw_object(group);
+            pop_name();
+        }
+        char w[64];
+        sprintf(w, "nested names, buffer of %d", size);
+        compare(w);
+    }
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    glViewport(0, 0, 256, 256);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    check_float(3);
+    check_float(4);
+    check_changed();
+    check_types();
+    check_names();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
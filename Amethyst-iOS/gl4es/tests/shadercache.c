@@ -0,0 +1,68 @@
+// Converted shaders cache check, against the GLES2 mock (mockgles.c).
+//
+// The cache is capped: once full, the least recently used shaders are dropped first, and
+// a shader found in the cache becomes the most recently used one.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/shaderconv_cache.h"
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+#define SHADER_SIZE 16384
+#define NSHADERS    1024     // 32MB of sources and converted shaders, far over the cap
+
+static char* source(int i) {
+    char *s = malloc(SHADER_SIZE+1);
+    int n = sprintf(s, "// shader %d\nvoid main() {}\n", i);
+    memset(s+n, ' ', SHADER_SIZE-n);
+    s[SHADER_SIZE] = '\0';
+    return s;
+}
+
+static int cached(int i) {
+    char *s = source(i);
+    shaderconv_need_t need = {0};
+    char *conv = shaderconv_GetCache(s, 1, &need, 0);
+    int ret = conv && !strcmp(conv, s);
+    free(conv);
+    free(s);
+    return ret;
+}
+
+static void add(int i) {
+    char *s = source(i);
+    shaderconv_need_t need = {0};
+    shaderconv_AddCache(s, 1, &need, &need, 0, s);
+    free(s);
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    for (int i=0; i<NSHADERS; ++i) {
+        add(i);
+        // shader 0 is used all the time
+        CHECK(cached(0), "shader 0 dropped after adding shader %d", i);
+    }
+    CHECK(cached(NSHADERS-1), "last shader not in the cache");
+    CHECK(!cached(1), "shader 1 still in the cache");
+    int n = 0;
+    for (int i=0; i<NSHADERS; ++i)
+        n += cached(i);
+    CHECK(n>10 && n<NSHADERS/4, "%d shaders in the cache", n);
+    // the ones kept are the most recent
+    for (int i=NSHADERS-n+1; i<NSHADERS; ++i)
+        CHECK(cached(i), "recent shader %d not in the cache", i);
+    // same source again replaces the entry
+    add(NSHADERS-1);
+    CHECK(cached(NSHADERS-1), "replaced shader not in the cache");
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
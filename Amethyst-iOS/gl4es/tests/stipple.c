@@ -0,0 +1,287 @@
+// Line stipple check, on a software GLES driver (swgles.c).
+//
+// The stipple pattern is tested in the fixed pipeline fragment shader on GLES2, and with a 16x1 alpha
+// texture on GLES 1.1: both must give what a CPU model gives. As in gl4es, the model takes the distance
+// along the lines of a draw (GL_LINES segments too), interpolated at each pixel center, in units of one
+// pattern length. The pixels near the ends of the segments and those too close to a pattern bit edge are
+// not compared. Neither are the closing and first segments of a loop: a vertex has only one distance, the
+// start of the loop is 0, or the end of the closing segment when the draw was merged with the previous one.
+// Checked for GL_LINES, GL_LINE_STRIP and GL_LINE_LOOP, drawn with glBegin/glEnd, glDrawArrays,
+// glDrawElements and display lists, with the pattern and factor changed between the draws.
+// Also, with a GLSL program, strips and loops are drawn as they are (not stippled, and with the
+// program's own vertex attribute).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "swgles.h"
+#include "glx/hardext.h"
+
+#define W 128
+#define H 128
+#define BAND 16
+#define MAXV 16
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static GLubyte ref[W*H];     // 255 for a drawn pixel
+static GLubyte care[W*H];    // 0 for a pixel that is not compared
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+static void clear() {
+    glClear(GL_COLOR_BUFFER_BIT);
+    memset(ref, 0, sizeof(ref));
+    memset(care, 1, sizeof(care));
+}
+
+// an axis aligned segment, the vertices at +0.25 of a pixel corner, with the distance d0 to d1 along it
+// (not compared if negative)
+static void ref_segment(const float *a, const float *b, float d0, float d1, GLushort pattern) {
+    const int vertical = (a[0]==b[0]);
+    const int ax = vertical, len = abs((int)(b[ax]-a[ax]));
+    const int dir = (b[ax]>a[ax])?1:-1;
+    for (int i=-1; i<=len+1; ++i) {
+        int p[2] = {(int)a[0], (int)a[1]};
+        p[ax] += dir*i;
+        if(p[0]<0 || p[0]>=W || p[1]<0 || p[1]>=H)
+            continue;
+        const int o = p[0]+p[1]*W;
+        if(i<=1 || i>=len-1 || d0<0.0f) {
+            care[o] = 0;    // the ends of the segment, or a segment not compared
+            continue;
+        }
+        const float t = ((p[ax]+0.5f)-a[ax])/(b[ax]-a[ax]);
+        const float d = (d0+t*(d1-d0))*16.0f;
+        if(fabsf(d-floorf(d+0.5f))<0.05f) {
+            care[o] = 0;    // on a pattern bit edge
+            continue;
+        }
+        if(pattern&(1<<((int)floorf(d)%16)))
+            ref[o] = 255;
+    }
+}
+
+static float seg_len(const float *a, const float *b, int factor) {
+    return (fabsf(b[0]-a[0])+fabsf(b[1]-a[1]))/(16.0f*factor);
+}
+
+static void ref_draw(GLenum mode, const float *v, int n, GLushort pattern, int factor) {
+    float d = 0.0f;
+    if(mode==GL_LINES) {
+        for (int i=0; i+1<n; i+=2) {
+            const float l = seg_len(v+i*2, v+i*2+2, factor);
+            ref_segment(v+i*2, v+i*2+2, d, d+l, pattern);
+            d += l;
+        }
+        return;
+    }
+    for (int i=0; i+1<n; ++i) {
+        const float l = seg_len(v+i*2, v+i*2+2, factor);
+        ref_segment(v+i*2, v+i*2+2, (mode==GL_LINE_LOOP && !i)?-1.0f:d, d+l, pattern);
+        d += l;
+    }
+    if(mode==GL_LINE_LOOP)
+        ref_segment(v+(n-1)*2, v, -1.0f, -1.0f, pattern);
+}
+
+// the lines of a draw, in the band of rows from y0
+static int make_lines(GLenum mode, int y0, float *v) {
+    int n = 0;
+    if(mode==GL_LINES) {
+        // horizontal segments, on their own rows
+        for (int r=y0+2; r<y0+BAND-2 && n<MAXV; r+=3) {
+            const int x = 2+rnd()%40, l = 20+rnd()%(W-x-24);
+            v[n*2+0] = x+0.25f; v[n*2+1] = r+0.25f; ++n;
+            v[n*2+0] = x+l+0.25f; v[n*2+1] = r+0.25f; ++n;
+        }
+    } else if(mode==GL_LINE_LOOP) {
+        // a rectangle, the last side is the closing segment
+        const int x = 2+rnd()%40, l = 20+rnd()%(W-x-24), h = 6+rnd()%(BAND-10);
+        const float r[4][2] = {{x, y0+2}, {x+l, y0+2}, {x+l, y0+2+h}, {x, y0+2+h}};
+        for (n=0; n<4; ++n) {
+            v[n*2+0] = r[n][0]+0.25f; v[n*2+1] = r[n][1]+0.25f;
+        }
+    } else {
+        // a staircase, right and up
+        int x = 2+rnd()%20, y = y0+2;
+        v[0] = x+0.25f; v[1] = y+0.25f; n = 1;
+        while (n<MAXV) {
+            if(n%2) x += 6+rnd()%20; else y += 3+rnd()%3;
+            if(x>W-3 || y>y0+BAND-3)
+                break;
+            v[n*2+0] = x+0.25f; v[n*2+1] = y+0.25f; ++n;
+        }
+    }
+    return n;
+}
+
+static void draw(GLenum mode, const float *v, int n, int how) {
+    switch (how) {
+        case 0:
+            glBegin(mode);
+            for (int i=0; i<n; ++i)
+                glVertex2fv(v+i*2);
+            glEnd();
+            break;
+        case 1:
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glVertexPointer(2, GL_FLOAT, 0, v);
+            glDrawArrays(mode, 0, n);
+            glDisableClientState(GL_VERTEX_ARRAY);
+            break;
+        case 2:
+            {
+                // the vertices in reverse order in the array
+                float rv[MAXV*2];
+                GLushort ind[MAXV];
+                for (int i=0; i<n; ++i) {
+                    memcpy(rv+(n-1-i)*2, v+i*2, 2*sizeof(float));
+                    ind[i] = n-1-i;
+                }
+                glEnableClientState(GL_VERTEX_ARRAY);
+                glVertexPointer(2, GL_FLOAT, 0, rv);
+                glDrawElements(mode, n, GL_UNSIGNED_SHORT, ind);
+                glDisableClientState(GL_VERTEX_ARRAY);
+            }
+            break;
+        default:
+            {
+                GLuint list = glGenLists(1);
+                glNewList(list, GL_COMPILE);
+                glBegin(mode);
+                for (int i=0; i<n; ++i)
+                    glVertex2fv(v+i*2);
+                glEnd();
+                glEndList();
+                glCallList(list);
+                glDeleteLists(list, 1);
+            }
+    }
+}
+
+static int compare(const char *what) {
+    static GLubyte pixels[W*H*4];
+    sw_read(pixels);
+    int diff = 0;
+    for (int i=0; i<W*H; ++i)
+        if(care[i] && pixels[i*4+1]!=ref[i] && diff++<5)
+            printf("%s: pixel %d,%d is %d, expected %d\n", what, i%W, i/W, pixels[i*4+1], ref[i]);
+    if(diff)
+        printf("%s: %d pixel(s) differ\n", what, diff);
+    return diff;
+}
+
+static void check_random() {
+    static const GLenum modes[] = {GL_LINES, GL_LINE_STRIP, GL_LINE_LOOP};
+    static const char *hows[] = {"glBegin", "glDrawArrays", "glDrawElements", "display list"};
+    GLushort pattern = 0x0f0f;
+    int factor = 1;
+    glEnable(GL_LINE_STIPPLE);
+    for (int frame=0; frame<60; ++frame) {
+        clear();
+        char what[128] = "";
+        for (int b=0; b<H/BAND; ++b) {
+            if(rnd()%3) {
+                pattern = rnd();
+                factor = 1+rnd()%4;
+                glLineStipple(factor, pattern);
+            }
+            const GLenum mode = modes[rnd()%3];
+            const int how = rnd()%4;
+            float v[MAXV*2];
+            const int n = make_lines(mode, b*BAND, v);
+            draw(mode, v, n, how);
+            ref_draw(mode, v, n, pattern, factor);
+            sprintf(what+strlen(what), "%s%s", b?", ":"", hows[how]);
+        }
+        char w[160];
+        sprintf(w, "frame %d (%s)", frame, what);
+        CHECK(!compare(w), "wrong stipple, frame %d", frame);
+    }
+    // and not stippled
+    glDisable(GL_LINE_STIPPLE);
+    clear();
+    for (int b=0; b<H/BAND; ++b) {
+        const GLenum mode = modes[b%3];
+        float v[MAXV*2];
+        const int n = make_lines(mode, b*BAND, v);
+        draw(mode, v, n, b%4);
+        ref_draw(mode, v, n, 0xffff, 1);
+    }
+    CHECK(!compare("stipple disabled"), "wrong lines without stipple");
+}
+
+static GLuint compile(GLenum type, const char *src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, NULL);
+    glCompileShader(s);
+    return s;
+}
+
+static void check_program() {
+    // a GLSL program draws the lines with its own attribute, the stipple isn't emulated for it
+    const char *vs =
+        "attribute vec2 pos;\n"
+        "void main() {\n"
+        "    gl_Position = vec4(pos/64.0-1.0, 0.0, 1.0);\n"
+        "}\n";
+    const char *fs =
+        "void main() {\n"
+        "    gl_FragColor = vec4(1.0);\n"
+        "}\n";
+    GLuint prog = glCreateProgram();
+    glAttachShader(prog, compile(GL_VERTEX_SHADER, vs));
+    glAttachShader(prog, compile(GL_FRAGMENT_SHADER, fs));
+    glLinkProgram(prog);
+    GLint linked = 0;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    CHECK(linked, "program not linked");
+    const GLint pos = glGetAttribLocation(prog, "pos");
+    glUseProgram(prog);
+    glEnable(GL_LINE_STIPPLE);
+    glLineStipple(1, 0x00ff);
+    static const GLenum modes[] = {GL_LINE_STRIP, GL_LINE_LOOP};
+    for (int frame=0; frame<4; ++frame) {
+        clear();
+        for (int b=0; b<H/BAND; ++b) {
+            const GLenum mode = modes[(b+frame)%2];
+            float v[MAXV*2];
+            const int n = make_lines(mode, b*BAND, v);
+            glEnableVertexAttribArray(pos);
+            glVertexAttribPointer(pos, 2, GL_FLOAT, GL_FALSE, 0, v);
+            glDrawArrays(mode, 0, n);
+            glDisableVertexAttribArray(pos);
+            ref_draw(mode, v, n, 0xffff, 1);
+        }
+        CHECK(!compare("GLSL program"), "wrong lines with a GLSL program, frame %d", frame);
+    }
+    glDisable(GL_LINE_STIPPLE);
+    glUseProgram(0);
+    glDeleteProgram(prog);
+}
+
+int main(int argc, char **argv) {
+    if(!sw_init(W, H))
+        return SW_SKIP;
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glMatrixMode(GL_PROJECTION);
+    glOrtho(0, W, 0, H, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    check_random();
+    if(hardext.esversion>1)
+        check_program();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}
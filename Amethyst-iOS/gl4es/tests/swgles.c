@@ -0,0 +1,83 @@
+// Context on a software GLES driver for the rendering tests (see swgles.h).
+// The EGL functions are the ones gl4es loaded (LIBGL_EGL), so the test binaries don't link with EGL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "swgles.h"
+#include "gl/init.h"
+#include "gl/loader.h"
+
+void initialize_gl4es();
+
+static int sw_width, sw_height;
+
+int sw_init(int width, int height) {
+    initialize_gl4es();     // does nothing if it already ran as a constructor
+    if(!egl) {
+        printf("no EGL library, skipped\n");
+        return 0;
+    }
+    LOAD_EGL(eglGetDisplay);
+    LOAD_EGL(eglInitialize);
+    LOAD_EGL(eglBindAPI);
+    LOAD_EGL(eglChooseConfig);
+    LOAD_EGL(eglCreateContext);
+    LOAD_EGL(eglCreatePbufferSurface);
+    LOAD_EGL(eglMakeCurrent);
+    const int es1 = (hardext.esversion==1);
+    EGLint config_attribs[] = {
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 16, EGL_STENCIL_SIZE, 8,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, es1?EGL_OPENGL_ES_BIT:EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+    EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, es1?1:2, EGL_NONE};
+    EGLint surface_attribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    EGLConfig config;
+    EGLint n = 0;
+    EGLDisplay dpy = egl_eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(!dpy || !egl_eglInitialize(dpy, NULL, NULL)) {
+        printf("no EGL display, skipped\n");
+        return 0;
+    }
+    egl_eglBindAPI(EGL_OPENGL_ES_API);
+    if(!egl_eglChooseConfig(dpy, config_attribs, &config, 1, &n) || !n) {
+        printf("no RGBA pbuffer config, skipped\n");
+        return 0;
+    }
+    EGLContext ctx = egl_eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+    EGLSurface surf = egl_eglCreatePbufferSurface(dpy, config, surface_attribs);
+    if(!ctx || !surf || !egl_eglMakeCurrent(dpy, surf, surf, ctx)) {
+        printf("cannot create the GLES %d context, skipped\n", es1?1:2);
+        return 0;
+    }
+    sw_width = width;
+    sw_height = height;
+    glViewport(0, 0, width, height);
+    return 1;
+}
+
+void sw_read(GLubyte *pixels) {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, sw_width, sw_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+int sw_compare(const GLubyte *expected, const char *what) {
+    GLubyte *pixels = (GLubyte*)malloc(sw_width*sw_height*4);
+    sw_read(pixels);
+    int diff = 0;
+    for (int y=0; y<sw_height; ++y)
+        for (int x=0; x<sw_width; ++x) {
+            const GLubyte *p = pixels+4*(x+y*sw_width), *e = expected+4*(x+y*sw_width);
+            if(memcmp(p, e, 4) && diff++<5)
+                printf("%s: pixel %d,%d is %d %d %d %d, expected %d %d %d %d\n", what, x, y,
+                    p[0], p[1], p[2], p[3], e[0], e[1], e[2], e[3]);
+        }
+    free(pixels);
+    if(diff)
+        printf("%s: %d pixel(s) differ\n", what, diff);
+    return diff;
+}
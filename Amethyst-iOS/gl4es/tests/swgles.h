@@ -0,0 +1,23 @@
+#ifndef _GL4ES_TESTS_SWGLES_H_
+#define _GL4ES_TESTS_SWGLES_H_
+
+// Rendering tests on a real (software) GLES driver, like Mesa llvmpipe: the tests run with LIBGL_GLES /
+// LIBGL_EGL pointing to its libraries, and an EGL platform that needs no display (see CMakeLists.txt).
+// gl4es renders into a pbuffer, read back with glReadPixels to be compared with what GL would draw.
+
+#include <GL/gl.h>
+
+// create a width x height RGBA pbuffer, and make a context for the gl4es backend (GLES 1.1 or 2.0)
+// current on it. Return 0 if that's not possible (the test is then skipped)
+int sw_init(int width, int height);
+
+// read the whole pbuffer, as RGBA bytes, bottom row first
+void sw_read(GLubyte *pixels);
+
+// compare the pbuffer with the expected RGBA image, print the first differences and return their number
+int sw_compare(const GLubyte *expected, const char *what);
+
+// return code of a test that can't run here (see SKIP_RETURN_CODE in CMakeLists.txt)
+#define SW_SKIP 77
+
+#endif // _GL4ES_TESTS_SWGLES_H_
@@ -0,0 +1,341 @@
+// Uniform shadow cache check, against the GLES2 mock (mockgles.c).
+//
+// glUniform* only writes the program's shadow copy, the changed values are sent to GLES just before
+// the next draw, with the program bound:
+// - a value set again (the same as the shadow copy) is not sent, a value set many times between
+//   two draws is sent once, with the last value, before the draw
+// - at each draw of random glUniform* / glProgramUniform* / glUseProgram sequences over two
+//   programs, the GLES uniforms of the drawn program are the values set, and glGetUniform* too
+// - a link that can't get memory for the uniforms fails cleanly (GL_OUT_OF_MEMORY, not linked, no
+//   uniform), and the program links again after that
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "mockgles.h"
+#include "gl/program.h"
+
+static int bad = 0;
+
+#define CHECK(cond, ...) \
+    if(!(cond)) { printf("%s:%d: ", __FUNCTION__, __LINE__); printf(__VA_ARGS__); printf("\n"); ++bad; }
+
+static unsigned int seed = 1;
+static unsigned int rnd() {
+    seed = seed*1103515245u+12345u;
+    return seed>>16;
+}
+
+#ifdef __GLIBC__
+// the big uniform arrays can't be allocated while fail_big is set
+extern void *__libc_realloc(void *ptr, size_t size);
+static size_t fail_big = 0;
+void *realloc(void *ptr, size_t size) {
+    if(fail_big && size>=fail_big)
+        return NULL;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+static const mock_uniform_t layout[] = {
+    {"uColor", GL_FLOAT_VEC4, 1},
+    {"uMat", GL_FLOAT_MAT4, 1},
+    {"uOffs", GL_FLOAT_VEC2, 4},
+    {"uTex", GL_SAMPLER_2D, 1},
+    {"uCount", GL_INT, 1},
+    {"uScale", GL_FLOAT, 1},
+    {"uBig", GL_FLOAT_VEC4, 1000},     // only in the program that can't link
+};
+#define NUNIFORMS 6
+#define BIG 1000
+
+static const char *vertex_src =
+    "uniform vec4 uColor;\n"
+    "uniform mat4 uMat;\n"
+    "uniform vec2 uOffs[4];\n"
+    "uniform int uCount;\n"
+    "uniform float uScale;\n"
+    "void main() {\n"
+    "    gl_Position = uMat*gl_Vertex*uScale + vec4(uOffs[uCount], 0.0, 0.0);\n"
+    "    gl_FrontColor = uColor;\n"
+    "}\n";
+static const char *fragment_src =
+    "uniform sampler2D uTex;\n"
+    "void main() {\n"
+    "    gl_FragColor = gl_Color*texture2D(uTex, vec2(0.5));\n"
+    "}\n";
+
+static GLuint create_program() {
+    GLuint prog = glCreateProgram();
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER), fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(vs, 1, &vertex_src, NULL);
+    glCompileShader(vs);
+    glShaderSource(fs, 1, &fragment_src, NULL);
+    glCompileShader(fs);
+    glAttachShader(prog, vs);
+    glAttachShader(prog, fs);
+    glLinkProgram(prog);
+    return prog;
+}
+
+static const GLfloat tri[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+
+static void draw() {
+    glVertexPointer(3, GL_FLOAT, 0, tri);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+// number of GLES uniform calls logged for a location, before the draw (-1 if the draw is before one)
+static int sent(GLint location) {
+    int n = 0, draw = mock_find("glDrawArrays", 0);
+    for (int i=0; i<mock_log_size(); ++i) {
+        const char *l = mock_log_line(i);
+        const char *s = strchr(l, ' ');
+        if(!strncmp(l, "glUniform", 9) && s && atoi(s+1)==location) {
+            if(draw>=0 && i>draw)
+                return -1;
+            ++n;
+        }
+    }
+    return n;
+}
+
+static int same(const float *v, const float *expected, int n) {
+    static const float zero[16] = {0};
+    if(!v) v = zero;
+    return !memcmp(v, expected, n*sizeof(float));
+}
+
+static void check_redundant() {
+    mock_uniforms = layout;
+    mock_num_uniforms = NUNIFORMS;
+    GLuint prog = create_program();
+    glUseProgram(prog);
+    const GLint color = glGetUniformLocation(prog, "uColor");
+    const GLint scale = glGetUniformLocation(prog, "uScale");
+    CHECK(color>=0 && scale>=0, "uniforms not found: %d %d", color, scale);
+    mock_clear_log();
+    // set many times: nothing sent before the draw, then once with the last value
+    for (int i=0; i<5; ++i)
+        glUniform4f(color, i, 2*i, 3*i, 1.0f);
+    glUniform1f(scale, 2.0f);
+    CHECK(mock_count("glUniform4fv")==0 && mock_count("glUniform1fv")==0, "uniforms sent before the draw");
+    draw();
+    CHECK(sent(100)==1, "uColor sent %d time(s) for the draw", sent(100));
+    CHECK(sent(600)==1, "uScale sent %d time(s) for the draw", sent(600));
+    const float last[4] = {4, 8, 12, 1};
+    CHECK(same(mock_uniform(prog, 100), last, 4), "uColor is not the last value");
+    // set again with the same values: nothing sent
+    mock_clear_log();
+    glUniform4f(color, 4, 8, 12, 1.0f);
+    glUniform4fv(color, 1, last);
+    glUniform1f(scale, 2.0f);
+    draw();
+    CHECK(mock_count("glUniform4fv")==0 && mock_count("glUniform1fv")==0, "same values sent again");
+    // changed and changed back: at most once, with the same value
+    mock_clear_log();
+    glUniform4f(color, 0, 0, 0, 0);
+    glUniform4f(color, 4, 8, 12, 1.0f);
+    draw();
+    CHECK(sent(100)<=1, "uColor sent %d time(s)", sent(100));
+    CHECK(same(mock_uniform(prog, 100), last, 4), "wrong uColor");
+    // only the changed element of an array
+    const GLint offs2 = glGetUniformLocation(prog, "uOffs[2]");
+    mock_clear_log();
+    glUniform2f(offs2, 1.0f, 2.0f);
+    draw();
+    CHECK(mock_count("glUniform2fv")==1 && sent(302)==1, "uOffs[2] sent %d time(s), %d call(s)", sent(302), mock_count("glUniform2fv"));
+    glUseProgram(0);
+    glDeleteProgram(prog);
+}
+
+// ---- random sequences, against a model ----
+
+typedef struct {
+    GLuint id;
+    GLint location[NUNIFORMS];
+    float value[NUNIFORMS][4][16];      // what GLES must have, by uniform and element
+    int changed[NUNIFORMS][4];          // set to another value since the last draw
+} prog_t;
+
+static prog_t progs[2];
+static int current = -1;
+
+static int components(int u) {
+    switch (layout[u].type) {
+        case GL_FLOAT_VEC4: return 4;
+        case GL_FLOAT_MAT4: return 16;
+        case GL_FLOAT_VEC2: return 2;
+    }
+    return 1;
+}
+
+static void model_set(prog_t *p, int u, int e, int count, const float *v) {
+    const int n = components(u);
+    for (int i=0; i<count; ++i)
+        if(memcmp(p->value[u][e+i], v+i*n, n*sizeof(float))) {
+            memcpy(p->value[u][e+i], v+i*n, n*sizeof(float));
+            p->changed[u][e+i] = 1;
+        }
+}
+
+static void random_set() {
+    const int target = (current<0 || rnd()%4==0)?rnd()%2:current;
+    const int program = (target!=current);     // with glProgramUniform*
+    prog_t *p = &progs[target];
+    const int u = rnd()%NUNIFORMS;
+    const int e = (layout[u].size>1)?rnd()%layout[u].size:0;
+    const GLint loc = p->location[u]+e;
+    // few values, so that many sets are redundant
+    float v[4*16];
+    GLint iv[4];
+    const int count = (layout[u].size>1)?1+rnd()%(layout[u].size-e):1;
+    for (int i=0; i<count*components(u); ++i)
+        v[i] = (rnd()%3)*0.5f;
+    switch (layout[u].type) {
+        case GL_FLOAT_VEC4:
+            if(rnd()&1) {
+                if(program) glProgramUniform4f(p->id, loc, v[0], v[1], v[2], v[3]);
+                else glUniform4f(loc, v[0], v[1], v[2], v[3]);
+            } else {
+                if(program) glProgramUniform4fv(p->id, loc, 1, v);
+                else glUniform4fv(loc, 1, v);
+            }
+            break;
+        case GL_FLOAT_MAT4:
+            if(program) glProgramUniformMatrix4fv(p->id, loc, 1, GL_FALSE, v);
+            else glUniformMatrix4fv(loc, 1, GL_FALSE, v);
+            break;
+        case GL_FLOAT_VEC2:
+            if(program) glProgramUniform2fv(p->id, loc, count, v);
+            else glUniform2fv(loc, count, v);
+            break;
+        case GL_FLOAT:
+            if(program) glProgramUniform1f(p->id, loc, v[0]);
+            else glUniform1f(loc, v[0]);
+            break;
+        default:
+            iv[0] = rnd()%3;
+            v[0] = iv[0];
+            if(program) glProgramUniform1i(p->id, loc, iv[0]);
+            else glUniform1iv(loc, 1, iv);
+    }
+    model_set(p, u, e, count, v);
+}
+
+static void random_draw(int n) {
+    prog_t *p = &progs[current];
+    draw();
+    CHECK(mock_program==p->id, "draw %d: program %u bound, expected %u", n, mock_program, p->id);
+    // each call sent for the draw starts at its own location, and has a changed element
+    for (int i=0; i<mock_log_size(); ++i) {
+        GLint location, count;
+        if(strncmp(mock_log_line(i), "glUniform", 9) || sscanf(strchr(mock_log_line(i), ' '), "%d %d", &location, &count)!=2)
+            continue;
+        const int u = location/100-1, e = location%100;
+        CHECK(u>=0 && u<NUNIFORMS && e+count<=layout[u].size, "draw %d: %s for no uniform", n, mock_log_line(i));
+        if(u<0 || u>=NUNIFORMS || e+count>layout[u].size)
+            continue;
+        int changed = 0;
+        for (int j=e; j<e+count; ++j)
+            changed |= p->changed[u][j];
+        CHECK(changed, "draw %d: %s[%d] sent without a change", n, layout[u].name, e);
+    }
+    for (int u=0; u<NUNIFORMS; ++u)
+        for (int e=0; e<layout[u].size; ++e) {
+            const GLint gles = 100*(u+1)+e;
+            const int s = sent(gles);
+            // samplers are -1 in the shadow copy until set (so the first value is always sent)
+            CHECK(same(mock_uniform(p->id, gles), p->value[u][e], components(u)) || (layout[u].type==GL_SAMPLER_2D && !mock_uniform(p->id, gles)),
+                "draw %d: wrong value for %s[%d] of program %u", n, layout[u].name, e, p->id);
+            CHECK(s>=0 && s<=1, "draw %d: %s[%d] sent %d time(s)", n, layout[u].name, e, s);
+            p->changed[u][e] = 0;
+            GLfloat got[16];
+            glGetUniformfv(p->id, p->location[u]+e, got);
+            CHECK(!memcmp(got, p->value[u][e], components(u)*sizeof(float)),
+                "draw %d: glGetUniformfv %s[%d] is wrong", n, layout[u].name, e);
+        }
+    mock_clear_log();
+}
+
+static void check_random() {
+    mock_uniforms = layout;
+    mock_num_uniforms = NUNIFORMS;
+    memset(progs, 0, sizeof(progs));
+    for (int i=0; i<2; ++i) {
+        progs[i].id = create_program();
+        for (int u=0; u<NUNIFORMS; ++u)
+            progs[i].location[u] = glGetUniformLocation(progs[i].id, layout[u].name);
+        progs[i].value[3][0][0] = -1.0f;    // uTex
+    }
+    mock_clear_log();
+    current = -1;
+    for (int n=0; n<4000; ++n) {
+        if(current<0 || rnd()%8==0) {
+            current = rnd()%2;
+            glUseProgram(progs[current].id);
+        }
+        for (int i=rnd()%6; i>0; --i)
+            random_set();
+        random_draw(n);
+    }
+    glUseProgram(0);
+    for (int i=0; i<2; ++i)
+        glDeleteProgram(progs[i].id);
+}
+
+static void check_out_of_memory() {
+#ifdef __GLIBC__
+    mock_uniforms = layout;
+    mock_num_uniforms = NUNIFORMS+1;
+    GLuint prog = create_program();
+    CHECK(glGetUniformLocation(prog, "uBig")>=0, "uBig not found");
+    while (glGetError());
+    mock_clear_log();
+    fail_big = BIG*sizeof(uniform_t);
+    glLinkProgram(prog);
+    fail_big = 0;
+    CHECK(glGetError()==GL_OUT_OF_MEMORY, "no GL_OUT_OF_MEMORY");
+    GLint linked = 1;
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    CHECK(!linked, "linked without memory for the uniforms");
+    CHECK(glGetUniformLocation(prog, "uColor")==-1, "uniform found in a program that didn't link");
+    GLint active = -1;
+    glGetProgramiv(prog, GL_ACTIVE_UNIFORMS, &active);
+    CHECK(active==0, "%d active uniform(s) in a program that didn't link", active);
+    // nothing to send, and no crash
+    glUseProgram(prog);
+    glUniform4f(0, 1, 2, 3, 4);
+    CHECK(glGetError()!=GL_NO_ERROR, "no error setting a uniform of a program that didn't link");
+    draw();
+    CHECK(mock_count("glUniform4fv")==0, "uniform sent for a program that didn't link");
+    glUseProgram(0);
+    // and it links again
+    glLinkProgram(prog);
+    glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    CHECK(linked, "not linked again");
+    const GLint color = glGetUniformLocation(prog, "uColor");
+    const GLint big = glGetUniformLocation(prog, "uBig[999]");
+    CHECK(color>=0 && big>=0, "uniforms not found after the new link: %d %d", color, big);
+    glUseProgram(prog);
+    mock_clear_log();
+    glUniform4f(big, 1, 2, 3, 4);
+    draw();
+    const float v[4] = {1, 2, 3, 4};
+    CHECK(same(mock_uniform(prog, 700+999), v, 4), "uBig[999] not sent after the new link");
+    glUseProgram(0);
+    glDeleteProgram(prog);
+#endif
+}
+
+int main(int argc, char **argv) {
+    mock_init();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    check_redundant();
+    check_random();
+    check_out_of_memory();
+    printf("%d error(s)\n", bad);
+    return bad?1:0;
+}